@@ -15,6 +15,7 @@ foreach(LIBTOSIGN ${LIBSTOSIGN})
 endforeach()
 execute_process(COMMAND codesign --force --sign - "${APP_DIR}/GrandOrgue.app/Contents/MacOS/GrandOrguePerfTest")
 execute_process(COMMAND codesign --force --sign - "${APP_DIR}/GrandOrgue.app/Contents/MacOS/GrandOrgueTool")
+execute_process(COMMAND codesign --force --sign - "${APP_DIR}/GrandOrgue.app/Contents/MacOS/GrandOrgueOfflineRender")
 execute_process(COMMAND codesign --force --sign - "${APP_DIR}/GrandOrgue.app")
 message("Checking code signature...")
 execute_process(COMMAND codesign --verify --deep "${APP_DIR}/GrandOrgue.app")
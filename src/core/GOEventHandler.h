@@ -8,13 +8,24 @@
 #ifndef GOEVENTHANDLER_H
 #define GOEVENTHANDLER_H
 
+#include <vector>
+
 class GOMidiEvent;
+struct GOMidiRoute;
 
 class GOEventHandler {
 public:
   virtual ~GOEventHandler() {}
 
   virtual void ProcessMidi(const GOMidiEvent &event) = 0;
+  /**
+   * Lists the note, aftertouch and control change events ProcessMidi() may
+   * react on. Other such events are not passed to the handler
+   * @return false if the handler must receive all such events
+   */
+  virtual bool GetMidiRoutes(std::vector<GOMidiRoute> &routes) const {
+    return false;
+  }
   virtual void HandleKey(int key) = 0;
 };
 
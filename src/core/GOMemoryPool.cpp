@@ -1,6 +1,6 @@
 /*
  * Copyright 2006 Milan Digital Audio LLC
- * Copyright 2009-2023 GrandOrgue contributors (see AUTHORS)
+ * Copyright 2009-2026 GrandOrgue contributors (see AUTHORS)
  * License GPL-2.0 or later
  * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
  */
@@ -21,6 +21,10 @@
 #endif
 #include <errno.h>
 
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
 #include <wx/file.h>
 #include <wx/intl.h>
 #include <wx/log.h>
@@ -30,8 +34,127 @@
 
 static inline void touchMemory(const char *pos) { *(const volatile char *)pos; }
 
+// the alignment of the pool allocations
+static constexpr size_t ALIGNMENT = 16;
+// the chunks start at multiples of CHUNK_SIZE from the pool start
+static constexpr unsigned CHUNK_SHIFT = 22;
+// the usual size of the chunk an arena takes from the pool at once
+static constexpr size_t CHUNK_SIZE = (size_t)1 << CHUNK_SHIFT;
+
+static std::atomic_uint64_t s_NextEpoch(1);
+
+/* A fast hash of a block. The blocks with the same hash are compared */
+static uint64_t hashBlock(const void *data, size_t length) {
+  const unsigned char *p = (const unsigned char *)data;
+  uint64_t hash = length;
+  uint64_t word;
+
+  for (; length >= sizeof(word); p += sizeof(word), length -= sizeof(word)) {
+    memcpy(&word, p, sizeof(word));
+    hash = (hash ^ word) * 0x9E3779B97F4A7C15ull;
+    hash ^= hash >> 29;
+  }
+  for (; length; p++, length--)
+    hash = (hash ^ *p) * 0x100000001B3ull;
+  return hash;
+}
+
+class GOMemoryPool::Arena {
+public:
+  // the chunk the owning thread allocates from
+  Chunk *p_Chunk = nullptr;
+
+  std::atomic_size_t m_ReservedSize = 0;
+  std::atomic_size_t m_UsedSize = 0;
+  std::atomic_size_t m_FreedSize = 0;
+  std::atomic_size_t m_WastedSize = 0;
+  std::atomic_uint m_AllocCount = 0;
+};
+
+class GOMemoryPool::Chunk {
+private:
+  char *const p_Start;
+  const size_t m_Size;
+  Arena &r_Arena;
+  // changed only by the thread of the arena
+  std::atomic_size_t m_Used;
+  // the starts of all allocations ever made, one bit per ALIGNMENT bytes
+  std::unique_ptr<std::atomic_uint64_t[]> m_Starts;
+  // the starts of the allocations not freed yet
+  std::unique_ptr<std::atomic_uint64_t[]> m_Live;
+
+  static uint64_t bit(size_t index) { return (uint64_t)1 << (index % 64); }
+
+public:
+  Chunk(char *start, size_t size, Arena &arena)
+    : p_Start(start), m_Size(size), r_Arena(arena), m_Used(0) {
+    const size_t nWords = (m_Size / ALIGNMENT + 63) / 64;
+
+    m_Starts = std::make_unique<std::atomic_uint64_t[]>(nWords);
+    m_Live = std::make_unique<std::atomic_uint64_t[]>(nWords);
+  }
+
+  size_t GetFree() const { return m_Size - m_Used.load(); }
+
+  /* Called only by the thread of the arena. length must be a multiple of
+   * ALIGNMENT */
+  void *Alloc(size_t length) {
+    const size_t used = m_Used.load(std::memory_order_relaxed);
+    const size_t index = used / ALIGNMENT;
+
+    m_Starts[index / 64].fetch_or(bit(index), std::memory_order_relaxed);
+    m_Live[index / 64].fetch_or(bit(index), std::memory_order_relaxed);
+    m_Used.store(used + length, std::memory_order_release);
+    r_Arena.m_UsedSize += length;
+    r_Arena.m_AllocCount++;
+    return p_Start + used;
+  }
+
+  /**
+   * Marks the allocation starting at ptr as freed. May be called by any
+   * thread without locking
+   * @return false if ptr is not the start of an allocation not freed yet
+   */
+  bool Free(const void *ptr) {
+    const size_t offset = (const char *)ptr - p_Start;
+    const size_t index = offset / ALIGNMENT;
+
+    if (
+      offset >= m_Size || offset % ALIGNMENT
+      || !(m_Live[index / 64].fetch_and(~bit(index)) & bit(index)))
+      return false;
+
+    // the allocation ends at the start of the next one or at the used end
+    const size_t nUsed = m_Used.load(std::memory_order_acquire) / ALIGNMENT;
+    size_t next = index + 1;
+
+    while (next < nUsed) {
+      const uint64_t word = m_Starts[next / 64].load(std::memory_order_relaxed)
+        & ~(bit(next) - 1);
+
+      if (word) {
+        next = next / 64 * 64 + std::countr_zero(word);
+        break;
+      }
+      next = next / 64 * 64 + 64;
+    }
+
+    const size_t length = (std::min(next, nUsed) - index) * ALIGNMENT;
+
+    r_Arena.m_UsedSize -= length;
+    r_Arena.m_FreedSize += length;
+    r_Arena.m_AllocCount--;
+    return true;
+  }
+};
+
+thread_local GOMemoryPool::ThreadArena GOMemoryPool::t_ThreadArena
+  = {0, nullptr};
+
 GOMemoryPool::GOMemoryPool()
-  : m_PoolStart(0),
+  : m_Epoch(0),
+    m_CacheAllocCount(0),
+    m_PoolStart(0),
     m_PoolPtr(0),
     m_PoolEnd(0),
     m_CacheStart(0),
@@ -43,7 +166,9 @@ GOMemoryPool::GOMemoryPool()
     m_MemoryLimit(0),
     m_AllocError(0),
     m_TouchPos(0),
-    m_TouchCache(false) {
+    m_TouchCache(false),
+    m_IsHugePages(false),
+    m_IsLocked(false) {
   InitPool();
 }
 
@@ -57,37 +182,221 @@ bool inline GOMemoryPool::InMemoryPool(void *ptr) {
   return false;
 }
 
+GOMemoryPool::Arena *GOMemoryPool::GetThreadArena() {
+  if (t_ThreadArena.m_Epoch != m_Epoch) {
+    GOMutexLocker locker(m_mutex);
+
+    if (!m_PoolStart)
+      return nullptr;
+    m_Arenas.push_back(std::make_unique<Arena>());
+    t_ThreadArena.m_Epoch = m_Epoch;
+    t_ThreadArena.p_Arena = m_Arenas.back().get();
+  }
+  return t_ThreadArena.p_Arena;
+}
+
+GOMemoryPool::Chunk *GOMemoryPool::NewChunk(Arena &arena, size_t length) {
+  GOMutexLocker locker(m_mutex);
+  // whole slots, so each chunk starts at a slot. Only the last chunk of the
+  // pool may be shorter
+  const size_t slotsLength = std::max(
+    (length + CHUNK_SIZE - 1) >> CHUNK_SHIFT << CHUNK_SHIFT, CHUNK_SIZE);
+  const size_t left = m_PoolLimit - (m_PoolPtr - m_PoolStart);
+  const size_t size = left < length ? length : std::min(slotsLength, left);
+  char *start = (char *)PoolAlloc(size);
+
+  if (!start)
+    return nullptr;
+  m_Chunks.push_back(std::make_unique<Chunk>(start, size, arena));
+  arena.m_ReservedSize += size;
+
+  Chunk *const pChunk = m_Chunks.back().get();
+  const size_t offset = start - m_PoolStart;
+
+  // publishes the constructed chunk to Free() in the other threads
+  for (size_t slot = offset >> CHUNK_SHIFT; slot << CHUNK_SHIFT < offset + size;
+       slot++)
+    m_ChunkSlots[slot].store(pChunk, std::memory_order_release);
+  return pChunk;
+}
+
+void *GOMemoryPool::ArenaAlloc(size_t length) {
+  const size_t alignedLength
+    = std::max((length + ALIGNMENT - 1) & ~(ALIGNMENT - 1), ALIGNMENT);
+  Arena *pArena = GetThreadArena();
+
+  if (!pArena)
+    return NULL;
+
+  Chunk *pChunk = pArena->p_Chunk;
+
+  if (pChunk && pChunk->GetFree() >= alignedLength)
+    return pChunk->Alloc(alignedLength);
+
+  Chunk *pNewChunk = NewChunk(*pArena, alignedLength);
+
+  if (!pNewChunk)
+    return NULL;
+
+  void *data = pNewChunk->Alloc(alignedLength);
+
+  // the arena goes on with the chunk having more free space and leaves the
+  // other one. A big allocation may fill its chunk
+  if (pChunk && pChunk->GetFree() >= pNewChunk->GetFree())
+    pArena->m_WastedSize += pNewChunk->GetFree();
+  else {
+    if (pChunk)
+      pArena->m_WastedSize += pChunk->GetFree();
+    pArena->p_Chunk = pNewChunk;
+  }
+  return data;
+}
+
 void *GOMemoryPool::Alloc(size_t length, bool final) {
   if (m_MemoryLimit && m_CacheSize + m_PoolSize + m_MallocSize > m_MemoryLimit)
     return NULL;
   if (!final)
     return malloc(length);
-  GOMutexLocker locker(m_mutex);
-  void *data = PoolAlloc(length);
-  if (data) {
-    AddPoolAlloc(data);
+
+  void *data = ArenaAlloc(length);
+
+  if (data)
     return data;
-  }
   m_MallocSize += length;
   return malloc(length);
 }
 
 void GOMemoryPool::Free(void *data) {
-  if (!data)
+  if (!data || ReleaseShared(data))
     return;
-  if (InMemoryPool(data)) {
-    GOMutexLocker locker(m_mutex);
-    if (m_PoolAllocs.count(data)) {
-      /* Pool memory is not individually freed */
-      m_PoolAllocs.erase(m_PoolAllocs.find(data));
-      return;
-    } else
+  if (m_CacheStart <= data && data < m_CacheStart + m_CacheSize) {
+    /* The mapped cache is not individually freed */
+    m_CacheAllocCount--;
+    return;
+  }
+  if (m_PoolStart <= data && data < m_PoolStart + m_PoolLimit) {
+    // the slot of a chunk is set before any allocation from it is returned
+    Chunk *pChunk = m_ChunkSlots[((char *)data - m_PoolStart) >> CHUNK_SHIFT]
+                      .load(std::memory_order_acquire);
+
+    // the freed pool memory is not reused
+    if (!pChunk || !pChunk->Free(data))
       wxLogError(_("Invalid free of %p"), data);
     return;
   }
   free(data);
 }
 
+bool GOMemoryPool::ReleaseShared(void *data) {
+  GOMutexLocker locker(m_SharedMutex);
+  auto it = m_SharedBlocks.find(data);
+
+  if (it == m_SharedBlocks.end())
+    return false;
+  if (--it->second.m_RefCount)
+    return true;
+
+  auto range = m_SharedByHash.equal_range(it->second.m_Hash);
+
+  for (auto hashIt = range.first; hashIt != range.second; ++hashIt)
+    if (hashIt->second == data) {
+      m_SharedByHash.erase(hashIt);
+      break;
+    }
+  m_SharedBlocks.erase(it);
+  return false;
+}
+
+void *GOMemoryPool::AddSharedRef(
+  uint64_t hash, const void *data, size_t length) {
+  auto range = m_SharedByHash.equal_range(hash);
+
+  for (auto it = range.first; it != range.second; ++it) {
+    SharedBlock &block = m_SharedBlocks[it->second];
+
+    if (block.m_Length == length && !memcmp(it->second, data, length)) {
+      block.m_RefCount++;
+      return it->second;
+    }
+  }
+  return nullptr;
+}
+
+void *GOMemoryPool::MoveToPoolShared(
+  void *data, size_t length, bool &isShared) {
+  isShared = false;
+  // the mapped cache is shared by the page cache anyway
+  if (
+    !data || !length
+    || (m_CacheStart <= data && data < m_CacheStart + m_CacheSize))
+    return data;
+
+  const uint64_t hash = hashBlock(data, length);
+  void *shared;
+
+  {
+    GOMutexLocker locker(m_SharedMutex);
+
+    shared = AddSharedRef(hash, data, length);
+  }
+  if (shared) {
+    // the copy is freed before it has taken any pool memory
+    Free(data);
+    isShared = true;
+    return shared;
+  }
+
+  // the copying is done unlocked, so the loading threads do not wait for it
+  void *pooled = InMemoryPool(data) ? data : MoveToPool(data, length);
+
+  return pooled ? AddSharedBlock(hash, pooled, length, isShared) : NULL;
+}
+
+void *GOMemoryPool::CopyToPoolShared(
+  const void *data, size_t length, bool &isShared) {
+  isShared = false;
+  if (!length)
+    return Alloc(length, true);
+
+  const uint64_t hash = hashBlock(data, length);
+  void *shared;
+
+  {
+    GOMutexLocker locker(m_SharedMutex);
+
+    shared = AddSharedRef(hash, data, length);
+  }
+  if (shared) {
+    isShared = true;
+    return shared;
+  }
+
+  void *pooled = Alloc(length, true);
+
+  if (!pooled)
+    return NULL;
+  memcpy(pooled, data, length);
+  return AddSharedBlock(hash, pooled, length, isShared);
+}
+
+void *GOMemoryPool::AddSharedBlock(
+  uint64_t hash, void *pooled, size_t length, bool &isShared) {
+  GOMutexLocker locker(m_SharedMutex);
+
+  // another thread might have shared an identical block meanwhile
+  void *shared = AddSharedRef(hash, pooled, length);
+
+  if (!shared) {
+    m_SharedBlocks[pooled] = {hash, length, 1};
+    m_SharedByHash.emplace(hash, pooled);
+    return pooled;
+  }
+  locker.Unlock();
+  Free(pooled);
+  isShared = true;
+  return shared;
+}
+
 void *GOMemoryPool::MoveToPool(void *data, size_t length) {
   if (InMemoryPool(data)) {
     wxLogWarning(_("Element already in the pool"));
@@ -103,8 +412,6 @@ void *GOMemoryPool::MoveToPool(void *data, size_t length) {
   return new_data;
 }
 
-void GOMemoryPool::AddPoolAlloc(void *data) { m_PoolAllocs.insert(data); }
-
 void *GOMemoryPool::PoolAlloc(size_t length) {
   char *new_ptr;
 
@@ -114,7 +421,7 @@ void *GOMemoryPool::PoolAlloc(size_t length) {
     length++;
 
   new_ptr = m_PoolPtr + length;
-  if (m_PoolPtr <= new_ptr && new_ptr < m_PoolEnd) {
+  if (m_PoolPtr <= new_ptr && new_ptr <= m_PoolEnd) {
     void *data = m_PoolPtr;
     m_PoolPtr += length;
     m_AllocError = 0;
@@ -124,7 +431,7 @@ void *GOMemoryPool::PoolAlloc(size_t length) {
   GrowPool(length);
 
   new_ptr = m_PoolPtr + length;
-  if (m_PoolPtr <= new_ptr && new_ptr < m_PoolEnd) {
+  if (m_PoolPtr <= new_ptr && new_ptr <= m_PoolEnd) {
     void *data = m_PoolPtr;
     m_PoolPtr += length;
     m_AllocError = 0;
@@ -162,7 +469,7 @@ void *GOMemoryPool::GetCacheData(size_t offset, size_t length) {
       touchMemory(data + i);
     if (length)
       touchMemory(data + length - 1);
-    AddPoolAlloc(data);
+    m_CacheAllocCount++;
     return data;
   }
   return NULL;
@@ -183,10 +490,88 @@ size_t GOMemoryPool::GetPoolUsage() { return m_PoolSize; }
 
 size_t GOMemoryPool::GetMemoryLimit() { return m_MemoryLimit; }
 
+std::vector<GOMemoryPool::ArenaStatistic> GOMemoryPool::GetArenaStatistics() {
+  GOMutexLocker locker(m_mutex);
+  std::vector<ArenaStatistic> stats;
+
+  for (const std::unique_ptr<Arena> &arena : m_Arenas)
+    stats.push_back(
+      {arena->m_ReservedSize.load(),
+       arena->m_UsedSize.load(),
+       arena->m_FreedSize.load(),
+       arena->m_WastedSize.load(),
+       arena->m_AllocCount.load()});
+  return stats;
+}
+
 bool GOMemoryPool::IsPoolFull() { return m_AllocError > 0; }
 
 void GOMemoryPool::SetMemoryLimit(size_t limit) { m_MemoryLimit = limit; }
 
+void GOMemoryPool::SetResidency(bool isHugePages, bool isLocked) {
+  if (isHugePages != m_IsHugePages || isLocked != m_IsLocked) {
+    FreePool();
+    m_IsHugePages = isHugePages;
+    m_IsLocked = isLocked;
+    InitPool();
+  }
+}
+
+void GOMemoryPool::PrepareMemory(char *start, size_t length) {
+#ifdef __linux__
+  if (m_IsHugePages && madvise(start, length, MADV_HUGEPAGE) == -1) {
+    wxLogWarning(
+      _("Transparent huge pages are not available (error code %d)"), errno);
+    m_IsHugePages = false;
+  }
+#endif
+#if defined __linux__ || __WXMAC__
+  if (m_IsLocked && mlock(start, length) == -1) {
+    wxLogWarning(
+      _("Locking the sample memory in RAM failed with error code %d. Check "
+        "the limit of the locked memory (ulimit -l)"),
+      errno);
+    m_IsLocked = false;
+  }
+#endif
+}
+
+#if defined __linux__ || __WXMAC__
+static size_t residentSize(const char *start, size_t length, size_t pageSize) {
+#ifdef __WXMAC__
+  using PageFlag = char;
+#else
+  using PageFlag = unsigned char;
+#endif
+  // query the pages in slices to keep the vector small
+  const size_t sliceLength = 65536 * pageSize;
+  std::vector<PageFlag> pages(65536);
+  size_t size = 0;
+
+  for (size_t pos = 0; pos < length; pos += sliceLength) {
+    const size_t len = std::min(sliceLength, length - pos);
+    const size_t nPages = (len + pageSize - 1) / pageSize;
+
+    if (mincore((void *)(start + pos), len, pages.data()) == -1)
+      continue;
+    for (size_t i = 0; i < nPages; i++)
+      if (pages[i] & 1)
+        size += std::min(pageSize, len - i * pageSize);
+  }
+  return size;
+}
+#endif
+
+bool GOMemoryPool::GetResidentSize(size_t &size) {
+#if defined __linux__ || __WXMAC__
+  size = residentSize(m_PoolStart, m_PoolSize, m_PageSize)
+    + residentSize(m_CacheStart, m_CacheSize, m_PageSize);
+  return true;
+#else
+  return false;
+#endif
+}
+
 bool GOMemoryPool::SetCacheFile(wxFile &cache_file) {
   bool result = false;
   FreePool();
@@ -200,8 +585,10 @@ bool GOMemoryPool::SetCacheFile(wxFile &cache_file) {
     m_CacheSize = 0;
     wxLogError(
       _("Memory mapping of the cache file failed with error code %d"), errno);
-  } else
+  } else {
+    PrepareMemory(m_CacheStart, m_CacheSize);
     result = true;
+  }
 
 #endif
 #ifdef __WIN32__
@@ -327,8 +714,12 @@ void GOMemoryPool::CalculatePoolLimit() {
 
 bool GOMemoryPool::AllocatePool() {
 #if defined __linux__ || __WXMAC__
+  /* The shared anonymous memory gets huge pages only if the administrator has
+   * enabled them for shmem, so the private one is used for huge pages */
+  const int flags = m_IsHugePages ? MAP_PRIVATE : MAP_SHARED;
+
   m_PoolStart
-    = (char *)mmap(NULL, m_PoolLimit, PROT_NONE, MAP_SHARED | MAP_ANON, -1, 0);
+    = (char *)mmap(NULL, m_PoolLimit, PROT_NONE, flags | MAP_ANON, -1, 0);
   if (m_PoolStart == MAP_FAILED) {
     m_PoolStart = 0;
     return false;
@@ -344,6 +735,7 @@ bool GOMemoryPool::AllocatePool() {
 }
 
 void GOMemoryPool::InitPool() {
+  m_Epoch = s_NextEpoch++;
   m_AllocError = 0;
   m_PoolStart = 0;
   m_PoolSize = 0;
@@ -368,12 +760,26 @@ void GOMemoryPool::InitPool() {
   }
   m_PoolPtr = m_PoolStart;
   m_PoolEnd = m_PoolStart + m_PoolSize;
+  if (m_PoolStart)
+    m_ChunkSlots = std::make_unique<std::atomic<Chunk *>[]>(
+      m_PoolLimit / CHUNK_SIZE + 1);
 }
 
 void GOMemoryPool::FreePool() {
-  if (m_PoolAllocs.size()) {
+  unsigned nAllocs = m_CacheAllocCount;
+
+  for (const std::unique_ptr<Arena> &arena : m_Arenas)
+    nAllocs += arena->m_AllocCount;
+  if (nAllocs) {
     wxLogError(wxT("Freeing non-empty memory pool"));
   }
+  // the threads take new arenas after InitPool() changes m_Epoch
+  m_ChunkSlots.reset();
+  m_Chunks.clear();
+  m_Arenas.clear();
+  m_CacheAllocCount = 0;
+  m_SharedBlocks.clear();
+  m_SharedByHash.clear();
 #if defined __linux__ || __WXMAC__
   if (m_PoolStart)
     munmap(m_PoolStart, m_PoolLimit);
@@ -405,6 +811,7 @@ void GOMemoryPool::GrowPool(size_t length) {
 #if defined __linux__ || __WXMAC__
   if (mprotect(m_PoolStart, new_size, PROT_READ | PROT_WRITE) == -1)
     return;
+  PrepareMemory(m_PoolStart + m_PoolSize, new_size - m_PoolSize);
   m_PoolSize = new_size;
 #endif
 #ifdef __WIN32__
@@ -420,6 +827,9 @@ void GOMemoryPool::GrowPool(size_t length) {
 }
 
 void GOMemoryPool::TouchMemory(std::atomic_bool &stop) {
+  // the locked memory cannot be paged out
+  if (m_IsLocked)
+    return;
   if (m_TouchCache) {
     for (int i = 0; m_TouchPos < m_CacheSize; m_TouchPos += m_PageSize, i++) {
       touchMemory(m_CacheStart + m_TouchPos);
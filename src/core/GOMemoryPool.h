@@ -1,6 +1,6 @@
 /*
  * Copyright 2006 Milan Digital Audio LLC
- * Copyright 2009-2023 GrandOrgue contributors (see AUTHORS)
+ * Copyright 2009-2026 GrandOrgue contributors (see AUTHORS)
  * License GPL-2.0 or later
  * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
  */
@@ -8,15 +8,81 @@
 #ifndef GOMEMORYPOOL_H_
 #define GOMEMORYPOOL_H_
 
-#include <set>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 
 #include "threading/GOMutex.h"
 
 class wxFile;
 
+/**
+ * The memory for the sample data.
+ *
+ * The final allocations are taken from a reserved address range. Each thread
+ * allocates from its own arena without locking: an arena takes chunks of the
+ * pool under m_mutex and bump-allocates inside them. The chunks are aligned to
+ * the fixed size slots of the pool, so Free() finds the chunk by the address
+ * in a slot table. A chunk marks the start of each allocation in a bitmap and
+ * clears it atomically, so Free() never locks. Pool memory is never reused
+ * after Free().
+ *
+ * The pool and the mapped cache may be backed by transparent huge pages for
+ * fewer TLB misses while rendering, and locked in RAM so the audio threads
+ * never wait for page faults.
+ *
+ * Identical blocks may be shared when they are moved to the pool, so only one
+ * copy of them takes the pool memory. A shared block is freed when its last
+ * owner frees it.
+ */
 class GOMemoryPool {
+public:
+  struct ArenaStatistic {
+    // the size of the chunks taken by the arena
+    size_t m_ReservedSize;
+    // the size of the allocations not freed yet
+    size_t m_UsedSize;
+    // the size of the freed allocations. It is not reused
+    size_t m_FreedSize;
+    // the unused ends of the chunks the arena has left
+    size_t m_WastedSize;
+    unsigned m_AllocCount;
+  };
+
+private:
+  class Arena;
+  class Chunk;
+
+  struct ThreadArena {
+    uint64_t m_Epoch;
+    Arena *p_Arena;
+  };
+
+  struct SharedBlock {
+    uint64_t m_Hash;
+    size_t m_Length;
+    unsigned m_RefCount;
+  };
+
+  // the arena of the current thread in the pool with m_Epoch
+  static thread_local ThreadArena t_ThreadArena;
+
   GOMutex m_mutex;
-  std::set<void *> m_PoolAllocs;
+  // differs for each initialization of each pool
+  uint64_t m_Epoch;
+  std::vector<std::unique_ptr<Arena>> m_Arenas; // guarded by m_mutex
+  std::vector<std::unique_ptr<Chunk>> m_Chunks; // guarded by m_mutex
+  // the chunk of each slot of m_PoolLimit. Read by Free() without locking
+  std::unique_ptr<std::atomic<Chunk *>[]> m_ChunkSlots;
+  // the number of the blocks given from the mapped cache
+  std::atomic_uint m_CacheAllocCount;
+  GOMutex m_SharedMutex;
+  // the shared blocks by their address. Guarded by m_SharedMutex
+  std::unordered_map<const void *, SharedBlock> m_SharedBlocks;
+  // the addresses of the shared blocks by their hash
+  std::unordered_multimap<uint64_t, void *> m_SharedByHash;
   char *m_PoolStart;
   char *m_PoolPtr;
   char *m_PoolEnd;
@@ -26,17 +92,38 @@ class GOMemoryPool {
   size_t m_PoolIncrement;
   size_t m_PageSize;
   size_t m_CacheSize;
-  size_t m_MallocSize;
+  std::atomic_size_t m_MallocSize;
   size_t m_MemoryLimit;
   unsigned m_AllocError;
   size_t m_TouchPos;
   bool m_TouchCache;
+  bool m_IsHugePages;
+  bool m_IsLocked;
 
   void InitPool();
   void GrowPool(size_t size);
   void FreePool();
   void *PoolAlloc(size_t length);
-  void AddPoolAlloc(void *data);
+  Arena *GetThreadArena();
+  Chunk *NewChunk(Arena &arena, size_t length);
+  void *ArenaAlloc(size_t length);
+  void PrepareMemory(char *start, size_t length);
+  /**
+   * Finds a shared block identical to data and adds a reference to it. Called
+   * under m_SharedMutex
+   */
+  void *AddSharedRef(uint64_t hash, const void *data, size_t length);
+  /**
+   * Shares the pooled block unless an identical one has been shared
+   * meanwhile. Then pooled is freed and the shared block is returned
+   */
+  void *AddSharedBlock(
+    uint64_t hash, void *pooled, size_t length, bool &isShared);
+  /**
+   * Drops a reference to the block if it is shared
+   * @return true if the block is still used by another owner
+   */
+  bool ReleaseShared(void *data);
 
   static size_t GetVMALimit();
   static size_t GetSystemMemory();
@@ -48,11 +135,28 @@ public:
   GOMemoryPool();
   ~GOMemoryPool();
   void SetMemoryLimit(size_t limit);
+  /* Reinitializes the empty pool with the new backing of the memory */
+  void SetResidency(bool isHugePages, bool isLocked);
   void TouchMemory(std::atomic_bool &stop);
 
   void *Alloc(size_t length, bool final);
   void *MoveToPool(void *data, size_t length);
   void Free(void *data);
+  /**
+   * Moves the block to the pool like MoveToPool, but if an identical block has
+   * been shared before then it is used instead, and no pool memory is taken.
+   * The shared blocks must not be changed anymore
+   * @param isShared is set if the block shared before is returned
+   * @return the block to be used instead of data or NULL if out of memory
+   */
+  void *MoveToPoolShared(void *data, size_t length, bool &isShared);
+  /**
+   * Like MoveToPoolShared, but data is a temporary buffer of the caller. It
+   * is copied to the pool only if no identical block has been shared before,
+   * so a shared block costs no allocation and no copying
+   * @return the block to be used or NULL if out of memory
+   */
+  void *CopyToPoolShared(const void *data, size_t length, bool &isShared);
 
   void *GetCacheData(size_t offset, size_t length);
   bool SetCacheFile(wxFile &cache_file);
@@ -64,6 +168,12 @@ public:
   size_t GetPoolSize();
   size_t GetPoolUsage();
   size_t GetMemoryLimit();
+  std::vector<ArenaStatistic> GetArenaStatistics();
+  /**
+   * Calculates how much of the pool and of the mapped cache is in RAM
+   * @return false if it is not supported on this platform
+   */
+  bool GetResidentSize(size_t &size);
 
   static size_t GetSystemMemoryLimit();
   static size_t GetPageSize();
@@ -22,6 +22,12 @@ void GOSampleStatistic::Init() {
   m_Valid = true;
   m_MemorySize = 0;
   m_EndSegmentSize = 0;
+  m_SharedSize = 0;
+  m_LoopTailSize = 0;
+  m_ReleaseSize = 0;
+  m_PipeCount = 0;
+  m_AttackCount = 0;
+  m_ReleaseCount = 0;
   m_MinBitsPerSample = 0xff;
   m_MaxBitsPerSample = 0;
   m_UsedBits = 0;
@@ -34,6 +40,12 @@ void GOSampleStatistic::Cumulate(const GOSampleStatistic &stat) {
   Prepare();
   m_MemorySize += stat.m_MemorySize;
   m_EndSegmentSize += stat.m_EndSegmentSize;
+  m_SharedSize += stat.m_SharedSize;
+  m_LoopTailSize += stat.m_LoopTailSize;
+  m_ReleaseSize += stat.m_ReleaseSize;
+  m_PipeCount += stat.m_PipeCount;
+  m_AttackCount += stat.m_AttackCount;
+  m_ReleaseCount += stat.m_ReleaseCount;
   if (m_MinBitsPerSample > stat.m_MinBitsPerSample)
     m_MinBitsPerSample = stat.m_MinBitsPerSample;
   if (m_MaxBitsPerSample < stat.m_MaxBitsPerSample)
@@ -56,6 +68,25 @@ void GOSampleStatistic::SetEndSegmentSize(size_t size) {
   m_EndSegmentSize = size;
 }
 
+void GOSampleStatistic::SetSharedSize(size_t size) {
+  Prepare();
+  m_SharedSize = size;
+}
+
+void GOSampleStatistic::SetLoopTailSize(size_t size) {
+  Prepare();
+  m_LoopTailSize = size;
+}
+
+void GOSampleStatistic::SetSections(
+  unsigned attacks, unsigned releases, size_t releaseSize) {
+  Prepare();
+  m_PipeCount = 1;
+  m_AttackCount = attacks;
+  m_ReleaseCount = releases;
+  m_ReleaseSize = releaseSize;
+}
+
 void GOSampleStatistic::SetBitsPerSample(
   unsigned bits, unsigned samples, unsigned max_value) {
   if (bits < m_MinBitsPerSample)
@@ -68,6 +99,18 @@ void GOSampleStatistic::SetBitsPerSample(
 
 size_t GOSampleStatistic::GetEndSegmentSize() const { return m_EndSegmentSize; }
 
+size_t GOSampleStatistic::GetSharedSize() const { return m_SharedSize; }
+
+size_t GOSampleStatistic::GetLoopTailSize() const { return m_LoopTailSize; }
+
+size_t GOSampleStatistic::GetReleaseSize() const { return m_ReleaseSize; }
+
+unsigned GOSampleStatistic::GetPipeCount() const { return m_PipeCount; }
+
+unsigned GOSampleStatistic::GetAttackCount() const { return m_AttackCount; }
+
+unsigned GOSampleStatistic::GetReleaseCount() const { return m_ReleaseCount; }
+
 unsigned GOSampleStatistic::GetMinBitPerSample() const {
   return m_MinBitsPerSample;
 }
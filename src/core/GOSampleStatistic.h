@@ -15,6 +15,15 @@ private:
   bool m_Valid;
   size_t m_MemorySize;
   size_t m_EndSegmentSize;
+  // the memory saved by sharing identical data with other samples
+  size_t m_SharedSize;
+  // the memory of the samples after the first loop and of the other loops
+  size_t m_LoopTailSize;
+  // the memory of the separate release samples
+  size_t m_ReleaseSize;
+  unsigned m_PipeCount;
+  unsigned m_AttackCount;
+  unsigned m_ReleaseCount;
   unsigned m_MinBitsPerSample;
   unsigned m_MaxBitsPerSample;
   size_t m_AllocatedSamples;
@@ -31,11 +40,20 @@ public:
 
   void SetMemorySize(size_t size);
   void SetEndSegmentSize(size_t size);
+  void SetSharedSize(size_t size);
+  void SetLoopTailSize(size_t size);
+  void SetSections(unsigned attacks, unsigned releases, size_t releaseSize);
   void SetBitsPerSample(unsigned bits, unsigned samples, unsigned max_value);
 
   bool IsValid() const;
   size_t GetMemorySize() const;
   size_t GetEndSegmentSize() const;
+  size_t GetSharedSize() const;
+  size_t GetLoopTailSize() const;
+  size_t GetReleaseSize() const;
+  unsigned GetPipeCount() const;
+  unsigned GetAttackCount() const;
+  unsigned GetReleaseCount() const;
   unsigned GetMinBitPerSample() const;
   unsigned GetMaxBitPerSample() const;
   float GetUsedBits() const;
@@ -38,7 +38,7 @@ GOBuffer<uint8_t> GOWavPack::GetWrapper() { return std::move(m_Wrapper); }
 
 unsigned GOWavPack::GetOrigDataLen() { return m_OrigDataLen; }
 
-bool GOWavPack::Unpack() {
+bool GOWavPack::Unpack(bool isToUnpackSamples) {
   m_context
     = WavpackOpenFileInputEx(&m_Reader, this, NULL, NULL, OPEN_WRAPPER, 0);
   if (!m_context)
@@ -50,11 +50,13 @@ bool GOWavPack::Unpack() {
 
   unsigned channels = WavpackGetNumChannels(m_context);
   unsigned samples = WavpackGetNumSamples(m_context);
-  m_Samples.resize(channels * samples * 4);
-  unsigned res
-    = WavpackUnpackSamples(m_context, (int32_t *)m_Samples.get(), samples);
-  if (res != samples)
-    return false;
+  if (isToUnpackSamples) {
+    m_Samples.resize(channels * samples * 4);
+    unsigned res
+      = WavpackUnpackSamples(m_context, (int32_t *)m_Samples.get(), samples);
+    if (res != samples)
+      return false;
+  }
 
   m_OrigDataLen = channels * samples * WavpackGetBytesPerSample(m_context);
 
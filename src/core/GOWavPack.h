@@ -44,7 +44,8 @@ public:
   ~GOWavPack();
 
   static bool IsWavPack(const GOBuffer<uint8_t> &data);
-  bool Unpack();
+  /* isToUnpackSamples=false reads only the wrapper */
+  bool Unpack(bool isToUnpackSamples = true);
 
   GOBuffer<uint8_t> GetSamples();
   GOBuffer<uint8_t> GetWrapper();
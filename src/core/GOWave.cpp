@@ -7,6 +7,8 @@
 
 #include "GOWave.h"
 
+#include <algorithm>
+
 #include <wx/file.h>
 #include <wx/intl.h>
 #include <wx/log.h>
@@ -17,6 +19,15 @@
 #include "GOWavPackWriter.h"
 #include "GOWaveTypes.h"
 
+// the RIFF header and the WAVE type field
+static constexpr size_t RIFF_HEAD_LENGTH
+  = sizeof(GO_WAVECHUNKHEADER) + sizeof(GO_WAVETYPEFIELD);
+
+static bool is_chunk_to_load(uint32_t type) {
+  return type == WAVE_TYPE_FMT || type == WAVE_TYPE_CUE
+    || type == WAVE_TYPE_SAMPLE;
+}
+
 void GOWave::SetInvalid() {
   m_SampleData.free();
   m_Channels = 0;
@@ -114,22 +125,6 @@ void GOWave::LoadSamplerChunk(const uint8_t *ptr, unsigned long length) {
   m_PitchFract = sampler->dwMIDIPitchFraction / (double)UINT_MAX * 100.0;
 }
 
-void GOWave::Open(GOOpenedFile *file) {
-  const wxString fileName = file->GetName();
-
-  if (!file->Open())
-    throw wxString::Format(_("Failed to open file '%s'"), fileName);
-
-  // Allocate memory for wave and read it.
-  GOBuffer<uint8_t> content(file->GetSize());
-
-  if (!file->Read(content))
-    throw wxString::Format(_("Failed to read file '%s'"), fileName);
-
-  file->Close();
-  Open(content, fileName);
-}
-
 static void check_for_bounds(
   const wxString &fileName,
   GO_WAVECHUNKHEADER *pHeader,
@@ -154,7 +149,153 @@ static void check_for_bounds(
   }
 }
 
-void GOWave::Open(const GOBuffer<uint8_t> &content, const wxString fileName) {
+void GOWave::LoadChunk(
+  uint32_t type, const uint8_t *ptr, unsigned long length) {
+  if (type == WAVE_TYPE_FMT)
+    LoadFormatChunk(ptr, length);
+  else if (type == WAVE_TYPE_CUE)
+    LoadCueChunk(ptr, length);
+  else if (type == WAVE_TYPE_SAMPLE)
+    LoadSamplerChunk(ptr, length);
+}
+
+void GOWave::CheckSamples(const wxString &fileName) {
+  if (!m_SampleData.get() || !m_SampleData.GetSize())
+    throw wxString::Format(_("No samples found: %s"), fileName);
+
+  // learning lesson: never ever trust the range values of outside sources to
+  // be correct!
+  for (unsigned int i = 0; i < m_Loops.size(); i++) {
+    if (
+      (m_Loops[i].m_StartPosition >= m_Loops[i].m_EndPosition)
+      || (m_Loops[i].m_StartPosition >= GetLength())
+      || (m_Loops[i].m_EndPosition >= GetLength())
+      || (m_Loops[i].m_EndPosition == 0)) {
+      wxLogError(_("Invalid loop in the file: %s\n"), fileName);
+      m_Loops.erase(m_Loops.begin() + i);
+    }
+  }
+}
+
+void GOWave::Open(GOOpenedFile *file, bool isToLoadSamples) {
+  const wxString fileName = file->GetName();
+
+  if (!file->Open())
+    throw wxString::Format(_("Failed to open file '%s'"), fileName);
+
+  const size_t fileSize = file->GetSize();
+  GOBuffer<uint8_t> head(std::min(fileSize, RIFF_HEAD_LENGTH));
+
+  if (!file->Read(head))
+    throw wxString::Format(_("Failed to read file '%s'"), fileName);
+  if (GOWavPack::IsWavPack(head)) {
+    // WavPack is decoded from the whole file in memory
+    GOBuffer<uint8_t> content(fileSize);
+    const size_t remaining = fileSize - head.GetSize();
+
+    memcpy(content.get(), head.get(), head.GetSize());
+    if (file->Read(content.get() + head.GetSize(), remaining) != remaining)
+      throw wxString::Format(_("Failed to read file '%s'"), fileName);
+    file->Close();
+    Open(content, fileName, isToLoadSamples);
+    return;
+  }
+
+  /* Close any currently open wave data */
+  Close();
+
+  try {
+    if (head.GetSize() < RIFF_HEAD_LENGTH)
+      throw wxString::Format(_("Not a RIFF file: %s"), fileName);
+
+    const GO_WAVECHUNKHEADER *riffHeader
+      = (const GO_WAVECHUNKHEADER *)head.get();
+
+    if (riffHeader->fccChunk != WAVE_TYPE_RIFF)
+      throw wxString::Format(_("Invalid RIFF file: %s"), fileName);
+    if (
+      *(const GO_WAVETYPEFIELD *)(head.get() + sizeof(GO_WAVECHUNKHEADER))
+      != WAVE_TYPE_WAVE)
+      throw wxString::Format(_("Invalid RIFF/WAVE file: %s"), fileName);
+
+    /* The usable size of the file is truncated to the size of the RIFF chunk
+     * as in Open(content) */
+    const size_t length = std::min(fileSize, (size_t)riffHeader->dwSize + 8);
+    size_t offset = RIFF_HEAD_LENGTH;
+    bool hasFormat = false;
+
+    for (; offset + 8 <= length;) {
+      /* Read chunk header */
+      GO_WAVECHUNKHEADER header;
+      const size_t chunkOffset = offset;
+
+      if (file->Read(&header, sizeof(header)) != sizeof(header))
+        throw wxString::Format(_("Failed to read file '%s'"), fileName);
+
+      const unsigned long size = header.dwSize;
+      bool isRead;
+
+      // skip the header
+      offset += sizeof(GO_WAVECHUNKHEADER);
+
+      if (header.fccChunk == WAVE_TYPE_DATA) {
+        if (!hasFormat)
+          throw wxString::Format(
+            _("Malformed wave file '%s'. Format chunk must precede data "
+              "chunk."),
+            fileName);
+        check_for_bounds(fileName, &header, offset, length, chunkOffset);
+        if (isToLoadSamples) {
+          // the samples are read without an intermediate copy
+          m_SampleData.free();
+          m_SampleData.resize(size);
+          isRead = file->Read(m_SampleData);
+        } else
+          isRead = file->Skip(size);
+      } else if (is_chunk_to_load(header.fccChunk)) {
+        if (header.fccChunk == WAVE_TYPE_FMT)
+          hasFormat = true;
+        check_for_bounds(fileName, &header, offset, length, chunkOffset);
+
+        GOBuffer<uint8_t> chunk(size);
+
+        isRead = file->Read(chunk);
+        if (isRead)
+          LoadChunk(header.fccChunk, chunk.get(), size);
+      } else
+        // an invalid size is detected after the loop
+        isRead = file->Skip(std::min(length - offset, (size_t)size));
+      if (!isRead)
+        throw wxString::Format(_("Failed to read file '%s'"), fileName);
+
+      /* Move to next chunk respecting word alignment
+         Unless lack of final padding (non spec-compliant) */
+      offset += size;
+      if (offset < length && (size & 1)) {
+        if (!file->Skip(1))
+          throw wxString::Format(_("Failed to read file '%s'"), fileName);
+        offset++;
+      }
+    }
+
+    if (offset != length)
+      throw wxString::Format(_("Invalid WAV file: %s"), fileName);
+    if (isToLoadSamples)
+      CheckSamples(fileName);
+  } catch (...) {
+    /* Free any memory that was allocated by chunk loading procedures */
+    Close();
+
+    /* Rethrow the exception */
+    throw;
+  }
+  file->Close();
+}
+
+void GOWave::Open(
+  const GOBuffer<uint8_t> &content,
+  const wxString fileName,
+  bool isToLoadSamples) {
   /* Close any currently open wave data */
   Close();
 
@@ -171,7 +312,7 @@ void GOWave::Open(const GOBuffer<uint8_t> &content, const wxString fileName) {
 
     if (GOWavPack::IsWavPack(content)) {
       GOWavPack pack(content);
-      if (!pack.Unpack())
+      if (!pack.Unpack(isToLoadSamples))
         throw wxString::Format(
           _("Failed to decode WavePack data: %s"), fileName);
 
@@ -235,26 +376,17 @@ void GOWave::Open(const GOBuffer<uint8_t> &content, const wxString fileName) {
 
         if (m_isPacked)
           size = 0;
-        else {
+        else if (isToLoadSamples) {
           m_SampleData.free();
           check_for_bounds(fileName, header, offset, length, chunkOffset);
           m_SampleData.Append(ptr + offset, size);
         }
       }
-      if (header->fccChunk == WAVE_TYPE_FMT) {
+      if (header->fccChunk == WAVE_TYPE_FMT)
         hasFormat = true;
+      if (is_chunk_to_load(header->fccChunk)) {
         check_for_bounds(fileName, header, offset, length, chunkOffset);
-        LoadFormatChunk(ptr + offset, size);
-      }
-      if (header->fccChunk == WAVE_TYPE_CUE) { /* This used to only work if
-                                                !load m_pipe_percussive[i] */
-        check_for_bounds(fileName, header, offset, length, chunkOffset);
-        LoadCueChunk(ptr + offset, size);
-      }
-      if (header->fccChunk == WAVE_TYPE_SAMPLE) { /* This used to only work if
-                                                   !load m_pipe_percussive[i] */
-        check_for_bounds(fileName, header, offset, length, chunkOffset);
-        LoadSamplerChunk(ptr + offset, size);
+        LoadChunk(header->fccChunk, ptr + offset, size);
       }
       /* Move to next chunk respecting word alignment
          Unless lack of final padding (non spec-compliant) */
@@ -265,21 +397,8 @@ void GOWave::Open(const GOBuffer<uint8_t> &content, const wxString fileName) {
 
     if (offset != length)
       throw wxString::Format(_("Invalid WAV file: %s"), fileName);
-    if (!m_SampleData.get() || !m_SampleData.GetSize())
-      throw wxString::Format(_("No samples found: %s"), fileName);
-
-    // learning lesson: never ever trust the range values of outside sources to
-    // be correct!
-    for (unsigned int i = 0; i < m_Loops.size(); i++) {
-      if (
-        (m_Loops[i].m_StartPosition >= m_Loops[i].m_EndPosition)
-        || (m_Loops[i].m_StartPosition >= GetLength())
-        || (m_Loops[i].m_EndPosition >= GetLength())
-        || (m_Loops[i].m_EndPosition == 0)) {
-        wxLogError(_("Invalid loop in the file: %s\n"), fileName);
-        m_Loops.erase(m_Loops.begin() + i);
-      }
-    }
+    if (isToLoadSamples)
+      CheckSamples(fileName);
   } catch (...) {
     /* Free any memory that was allocated by chunk loading procedures */
     Close();
@@ -355,6 +474,10 @@ void GOWave::ReadSamples(
   ,
   int return_channels /** number of channels to return or if negative,
                          specific channel as mono*/
+  ,
+  unsigned from /** First block to read */
+  ,
+  unsigned nb_blocks /** Maximal number of blocks to read */
 ) const {
   if (m_SampleRate != sample_rate)
     throw(wxString) _("bad format!");
@@ -377,10 +500,17 @@ void GOWave::ReadSamples(
   if (select_channel != 0)
     merge_count = m_Channels;
 
-  const uint8_t *input = m_SampleData.get();
+  if (from > GetLength())
+    throw(wxString) _("Invalid sample range");
+  nb_blocks = std::min(nb_blocks, GetLength() - from);
+
+  // the unpacked samples are 32 bit
+  const unsigned input_bytes_per_sample = m_isPacked ? 4 : m_BytesPerSample;
+  const uint8_t *input
+    = m_SampleData.get() + from * m_Channels * input_bytes_per_sample;
   uint8_t *output = (uint8_t *)dest_buffer;
 
-  unsigned len = m_Channels * GetLength() / merge_count;
+  unsigned len = m_Channels * nb_blocks / merge_count;
   for (unsigned i = 0; i < len; i++) {
     int value
       = 0; /* Value will be stored with 24 fractional bits of precision */
@@ -8,6 +8,7 @@
 #ifndef GOWAVE_H
 #define GOWAVE_H
 
+#include <climits>
 #include <cstdint>
 #include <vector>
 
@@ -35,6 +36,9 @@ private:
   void LoadFormatChunk(const uint8_t *ptr, unsigned long length);
   void LoadCueChunk(const uint8_t *ptr, unsigned long length);
   void LoadSamplerChunk(const uint8_t *ptr, unsigned long length);
+  /* Loads a chunk other than the data one */
+  void LoadChunk(uint32_t type, const uint8_t *ptr, unsigned long length);
+  void CheckSamples(const wxString &fileName);
   template <class T> static void writeNext(uint8_t *&output, const T &value);
   template <class T> static T readNext(const uint8_t *&input);
 
@@ -63,8 +67,15 @@ public:
   GOWave();
   ~GOWave();
 
-  void Open(GOOpenedFile *file);
-  void Open(const GOBuffer<uint8_t> &content, const wxString fileName);
+  /* Reads a wave file chunk by chunk, so the samples are read straight into
+   * the sample buffer. A WavPack file is read as a whole.
+   * isToLoadSamples=false loads only the format and the markers, f.e. for
+   * the pitch. GetLength() returns 0 then */
+  void Open(GOOpenedFile *file, bool isToLoadSamples = true);
+  void Open(
+    const GOBuffer<uint8_t> &content,
+    const wxString fileName,
+    bool isToLoadSamples = true);
   bool Save(GOBuffer<uint8_t> &buf);
   void Close();
 
@@ -91,14 +102,17 @@ public:
   unsigned GetLength() const;
 
   /* ReadSamples()
-   * Reads all of the samples in the wave file into destBuffer at the
-   * specified read format and sample rate.
+   * Reads nb_blocks blocks starting from the block from of the wave file into
+   * destBuffer at the specified read format and sample rate. By default all
+   * of the samples are read.
    */
   void ReadSamples(
     void *dest_buffer,
     GOWave::SAMPLE_FORMAT read_format,
     unsigned sample_rate,
-    int channels) const;
+    int channels,
+    unsigned from = 0,
+    unsigned nb_blocks = UINT_MAX) const;
 
   unsigned GetSampleRate() const;
   unsigned GetBitsPerSample() const;
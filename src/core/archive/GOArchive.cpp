@@ -7,23 +7,37 @@
 
 #include "GOArchive.h"
 
+#ifdef __WIN32__
+#include <io.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <cstring>
+
 #include <wx/intl.h>
 #include <wx/log.h>
 
 #include "files/GOInvalidFile.h"
-#include "threading/GOMutexLocker.h"
 
 #include "GOArchiveEntryFile.h"
 #include "GOArchiveIndex.h"
 #include "GOArchiveReader.h"
 
 GOArchive::GOArchive(const wxString &cachePath)
-  : m_CachePath(cachePath), m_ID(), m_Dependencies(), m_Entries(), m_Path() {}
+  : m_CachePath(cachePath),
+    m_ID(),
+    m_Dependencies(),
+    m_Entries(),
+    m_NameIndex(),
+    m_Path() {}
 
 GOArchive::~GOArchive() { Close(); }
 
 bool GOArchive::OpenArchive(const wxString &path) {
   m_Entries.clear();
+  m_NameIndex.clear();
   m_Path = path;
   if (!m_File.Open(path, wxFile::read)) {
     wxLogError(_("Failed to open '%s'"), path.c_str());
@@ -31,7 +45,7 @@ bool GOArchive::OpenArchive(const wxString &path) {
   }
   {
     GOArchiveIndex index(m_CachePath, m_Path);
-    if (index.ReadIndex(m_ID, m_Entries))
+    if (index.ReadIndex(m_ID, m_Entries, m_NameIndex))
       return true;
   }
 
@@ -41,41 +55,68 @@ bool GOArchive::OpenArchive(const wxString &path) {
     return false;
   }
 
+  GOArchiveIndex::BuildNameIndex(m_Entries, m_NameIndex);
+
   GOArchiveIndex index(m_CachePath, m_Path);
-  index.WriteIndex(m_ID, m_Entries);
+  index.WriteIndex(m_ID, m_Entries, m_NameIndex);
   return true;
 }
 
 void GOArchive::Close() {
   m_File.Close();
   m_Entries.clear();
+  m_NameIndex.clear();
+}
+
+const GOArchiveEntry *GOArchive::FindEntry(const wxString &name) const {
+  return GOArchiveIndex::FindEntry(m_Entries, m_NameIndex, name);
 }
 
 bool GOArchive::containsFile(const wxString &name) {
-  for (unsigned i = 0; i < m_Entries.size(); i++)
-    if (m_Entries[i].name == name)
-      return true;
-  return false;
+  return FindEntry(name) != nullptr;
 }
 
 GOOpenedFile *GOArchive::OpenFile(const wxString &name) {
-  for (unsigned i = 0; i < m_Entries.size(); i++)
-    if (m_Entries[i].name == name) {
-      return new GOArchiveEntryFile(
-        this, m_Entries[i].name, m_Entries[i].offset, m_Entries[i].len);
-    }
+  const GOArchiveEntry *pEntry = FindEntry(name);
+
+  if (pEntry)
+    return new GOArchiveEntryFile(
+      this, pEntry->name, pEntry->offset, pEntry->len);
   return new GOInvalidFile(name);
 }
 
 size_t GOArchive::ReadContent(void *buffer, size_t offset, size_t len) {
-  GOMutexLocker lock(m_Mutex);
-  ssize_t pos = m_File.Seek(offset);
-  if (pos != (ssize_t)offset)
-    return 0;
-  ssize_t l = m_File.Read(buffer, len);
-  if (l == wxInvalidOffset)
-    return 0;
-  return l;
+  size_t done = 0;
+
+  while (done < len) {
+#ifdef __WIN32__
+    // the offset of an OVERLAPPED is used instead of the file position
+    OVERLAPPED overlapped;
+    const uint64_t pos = (uint64_t)offset + done;
+    DWORD l = 0;
+
+    memset(&overlapped, 0, sizeof(overlapped));
+    overlapped.Offset = (DWORD)pos;
+    overlapped.OffsetHigh = (DWORD)(pos >> 32);
+    if (!ReadFile(
+          (HANDLE)_get_osfhandle(m_File.fd()),
+          (char *)buffer + done,
+          (DWORD)(len - done),
+          &l,
+          &overlapped))
+      break;
+#else
+    const ssize_t l
+      = pread(m_File.fd(), (char *)buffer + done, len - done, offset + done);
+
+    if (l < 0)
+      break;
+#endif
+    if (!l)
+      break;
+    done += l;
+  }
+  return done;
 }
 
 const wxString &GOArchive::GetArchiveID() { return m_ID; }
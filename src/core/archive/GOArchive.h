@@ -13,21 +13,22 @@
 
 #include <vector>
 
-#include "threading/GOMutex.h"
-
 class GOOpenedFile;
 typedef struct _GOArchiveEntry GOArchiveEntry;
+typedef struct _GOArchiveNameHash GOArchiveNameHash;
 
 class GOArchive {
 private:
-  GOMutex m_Mutex;
   wxString m_CachePath;
   wxString m_ID;
   std::vector<wxString> m_Dependencies;
   std::vector<GOArchiveEntry> m_Entries;
+  std::vector<GOArchiveNameHash> m_NameIndex;
   wxFile m_File;
   wxString m_Path;
 
+  const GOArchiveEntry *FindEntry(const wxString &name) const;
+
 public:
   GOArchive(const wxString &cachePath);
   ~GOArchive();
@@ -38,6 +39,8 @@ public:
   bool containsFile(const wxString &name);
   GOOpenedFile *OpenFile(const wxString &name);
 
+  /* Reads without moving a shared file position, so it may be called from
+   * several threads at once */
   size_t ReadContent(void *buffer, size_t offset, size_t len);
 
   const wxString &GetArchiveID();
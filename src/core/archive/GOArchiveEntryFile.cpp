@@ -38,3 +38,10 @@ size_t GOArchiveEntryFile::Read(void *buffer, size_t len) {
   m_Pos += len;
   return len;
 }
+
+bool GOArchiveEntryFile::Skip(size_t len) {
+  if (len > m_Length - m_Pos)
+    return false;
+  m_Pos += len;
+  return true;
+}
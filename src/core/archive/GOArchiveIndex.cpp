@@ -7,6 +7,8 @@
 
 #include "GOArchiveIndex.h"
 
+#include <algorithm>
+
 #include <wx/filename.h>
 #include <wx/log.h>
 
@@ -16,7 +18,7 @@
 #include "GOHash.h"
 
 /* Value which is used to identify a valid cache index file. */
-#define GRANDORGUE_INDEX_MAGIC 0x43214321
+#define GRANDORGUE_INDEX_MAGIC 0x43214322
 
 GOArchiveIndex::GOArchiveIndex(const wxString &cachePath, const wxString &path)
   : m_CachePath(cachePath), m_Path(path), m_File() {}
@@ -29,6 +31,51 @@ wxString GOArchiveIndex::GenerateIndexFilename() {
     GOStdFileName::composeIndexFileName(GOArchiveFile::getArchiveHash(m_Path)));
 }
 
+uint64_t GOArchiveIndex::HashName(const wxString &name) {
+  // FNV-1a
+  uint64_t hash = 0xcbf29ce484222325ULL;
+
+  for (wxUniChar c : name) {
+    hash ^= c.GetValue();
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+void GOArchiveIndex::BuildNameIndex(
+  const std::vector<GOArchiveEntry> &entries,
+  std::vector<GOArchiveNameHash> &nameIndex) {
+  nameIndex.resize(entries.size());
+  for (unsigned i = 0; i < entries.size(); i++) {
+    nameIndex[i].hash = HashName(entries[i].name);
+    nameIndex[i].entry = i;
+  }
+  std::sort(
+    nameIndex.begin(),
+    nameIndex.end(),
+    [](const GOArchiveNameHash &a, const GOArchiveNameHash &b) {
+      return a.hash < b.hash;
+    });
+}
+
+const GOArchiveEntry *GOArchiveIndex::FindEntry(
+  const std::vector<GOArchiveEntry> &entries,
+  const std::vector<GOArchiveNameHash> &nameIndex,
+  const wxString &name) {
+  const uint64_t hash = HashName(name);
+  auto it = std::lower_bound(
+    nameIndex.begin(),
+    nameIndex.end(),
+    hash,
+    [](const GOArchiveNameHash &e, uint64_t h) { return e.hash < h; });
+
+  // different names may have the same hash
+  for (; it != nameIndex.end() && it->hash == hash; ++it)
+    if (entries[it->entry].name == name)
+      return &entries[it->entry];
+  return nullptr;
+}
+
 GOHashType GOArchiveIndex::GenerateHash() {
   GOHash hash;
   hash.Update(sizeof(wxString));
@@ -93,7 +140,9 @@ bool GOArchiveIndex::ReadEntry(GOArchiveEntry &e) {
 }
 
 bool GOArchiveIndex::ReadContent(
-  wxString &id, std::vector<GOArchiveEntry> &entries) {
+  wxString &id,
+  std::vector<GOArchiveEntry> &entries,
+  std::vector<GOArchiveNameHash> &nameIndex) {
   if (!ReadString(id))
     return false;
 
@@ -105,11 +154,21 @@ bool GOArchiveIndex::ReadContent(
     if (!ReadEntry(entries[i]))
       return false;
 
+  nameIndex.resize(cnt);
+  for (unsigned i = 0; i < nameIndex.size(); i++)
+    if (
+      !Read(&nameIndex[i].hash, sizeof(nameIndex[i].hash))
+      || !Read(&nameIndex[i].entry, sizeof(nameIndex[i].entry))
+      || nameIndex[i].entry >= cnt)
+      return false;
+
   return true;
 }
 
 bool GOArchiveIndex::WriteContent(
-  const wxString &id, const std::vector<GOArchiveEntry> &entries) {
+  const wxString &id,
+  const std::vector<GOArchiveEntry> &entries,
+  const std::vector<GOArchiveNameHash> &nameIndex) {
   int magic = GRANDORGUE_INDEX_MAGIC;
   if (!Write(&magic, sizeof(magic)))
     return false;
@@ -128,11 +187,19 @@ bool GOArchiveIndex::WriteContent(
     if (!WriteEntry(entries[i]))
       return false;
 
+  for (unsigned i = 0; i < nameIndex.size(); i++)
+    if (
+      !Write(&nameIndex[i].hash, sizeof(nameIndex[i].hash))
+      || !Write(&nameIndex[i].entry, sizeof(nameIndex[i].entry)))
+      return false;
+
   return true;
 }
 
 bool GOArchiveIndex::ReadIndex(
-  wxString &id, std::vector<GOArchiveEntry> &entries) {
+  wxString &id,
+  std::vector<GOArchiveEntry> &entries,
+  std::vector<GOArchiveNameHash> &nameIndex) {
   wxString name = GenerateIndexFilename();
   if (!wxFileExists(name))
     return false;
@@ -157,7 +224,7 @@ bool GOArchiveIndex::ReadIndex(
     return false;
   }
 
-  if (!ReadContent(id, entries)) {
+  if (!ReadContent(id, entries, nameIndex)) {
     m_File.Close();
     wxLogWarning(_("Failed to read '%s'"), name.c_str());
     return false;
@@ -168,7 +235,9 @@ bool GOArchiveIndex::ReadIndex(
 }
 
 bool GOArchiveIndex::WriteIndex(
-  const wxString &id, const std::vector<GOArchiveEntry> &entries) {
+  const wxString &id,
+  const std::vector<GOArchiveEntry> &entries,
+  const std::vector<GOArchiveNameHash> &nameIndex) {
   wxString name = GenerateIndexFilename();
   if (!m_File.Create(name, true) || !m_File.IsOpened()) {
     m_File.Close();
@@ -176,7 +245,7 @@ bool GOArchiveIndex::WriteIndex(
     return false;
   }
 
-  if (!WriteContent(id, entries)) {
+  if (!WriteContent(id, entries, nameIndex)) {
     m_File.Close();
     wxLogError(_("Failed to write content to '%s'"), name.c_str());
     return false;
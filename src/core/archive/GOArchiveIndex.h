@@ -11,6 +11,7 @@
 #include <wx/file.h>
 #include <wx/string.h>
 
+#include <cstdint>
 #include <vector>
 
 class GOSettingDirectory;
@@ -22,6 +23,12 @@ typedef struct _GOArchiveEntry {
   size_t len;
 } GOArchiveEntry;
 
+/* An entry of the name index. The name index is sorted by the hash */
+typedef struct _GOArchiveNameHash {
+  uint64_t hash;
+  unsigned entry;
+} GOArchiveNameHash;
+
 class GOArchiveIndex {
 private:
   wxString m_CachePath;
@@ -40,17 +47,38 @@ private:
   bool WriteEntry(const GOArchiveEntry &e);
   bool ReadEntry(GOArchiveEntry &e);
 
-  bool ReadContent(wxString &id, std::vector<GOArchiveEntry> &entries);
+  bool ReadContent(
+    wxString &id,
+    std::vector<GOArchiveEntry> &entries,
+    std::vector<GOArchiveNameHash> &nameIndex);
   bool WriteContent(
-    const wxString &id, const std::vector<GOArchiveEntry> &entries);
+    const wxString &id,
+    const std::vector<GOArchiveEntry> &entries,
+    const std::vector<GOArchiveNameHash> &nameIndex);
 
 public:
   GOArchiveIndex(const wxString &cachePath, const wxString &path);
   ~GOArchiveIndex();
 
-  bool ReadIndex(wxString &id, std::vector<GOArchiveEntry> &entries);
+  /* The hash of the name. It does not change between the program runs */
+  static uint64_t HashName(const wxString &name);
+  static void BuildNameIndex(
+    const std::vector<GOArchiveEntry> &entries,
+    std::vector<GOArchiveNameHash> &nameIndex);
+  /* Returns the entry with the name or nullptr if there is no such entry */
+  static const GOArchiveEntry *FindEntry(
+    const std::vector<GOArchiveEntry> &entries,
+    const std::vector<GOArchiveNameHash> &nameIndex,
+    const wxString &name);
+
+  bool ReadIndex(
+    wxString &id,
+    std::vector<GOArchiveEntry> &entries,
+    std::vector<GOArchiveNameHash> &nameIndex);
   bool WriteIndex(
-    const wxString &id, const std::vector<GOArchiveEntry> &entries);
+    const wxString &id,
+    const std::vector<GOArchiveEntry> &entries,
+    const std::vector<GOArchiveNameHash> &nameIndex);
 };
 
 #endif
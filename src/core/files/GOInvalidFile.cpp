@@ -21,3 +21,5 @@ bool GOInvalidFile::Open() { return false; }
 void GOInvalidFile::Close() {}
 
 size_t GOInvalidFile::Read(void *buffer, size_t len) { return 0; }
+
+bool GOInvalidFile::Skip(size_t len) { return false; }
@@ -23,6 +23,8 @@ public:
   virtual bool Open() = 0;
   virtual void Close() = 0;
   virtual size_t Read(void *buffer, size_t len) = 0;
+  /* Moves the read position len bytes forward without reading */
+  virtual bool Skip(size_t len) = 0;
 
   template <class T> bool Read(GOBuffer<T> &buf) {
     return Read(buf.get(), buf.GetSize()) == buf.GetSize();
@@ -39,3 +39,7 @@ size_t GOStandardFile::Read(void *buffer, size_t len) {
     return 0;
   return read;
 }
+
+bool GOStandardFile::Skip(size_t len) {
+  return m_File.Seek(len, wxFromCurrent) != wxInvalidOffset;
+}
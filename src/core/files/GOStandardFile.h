@@ -31,6 +31,7 @@ public:
   bool Open();
   void Close();
   size_t Read(void *buffer, size_t len);
+  bool Skip(size_t len);
 };
 
 #endif
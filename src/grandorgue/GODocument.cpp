@@ -164,8 +164,14 @@ void GODocument::OnMidiEvent(const GOMidiEvent &event) {
   if (!m_OrganFileReady)
     return;
 
-  if (m_OrganController)
+  if (m_OrganController) {
+    GOSoundEngine &engine = m_sound.GetEngine();
+
+    // the pipes started by the event sound from the moment of receiving it
+    engine.SetEventTime(event.GetReceiveTime());
     m_OrganController->ProcessMidi(event);
+    engine.SetEventTime(std::chrono::steady_clock::time_point());
+  }
 }
 
 void GODocument::ShowOrganSettingsDialog() {
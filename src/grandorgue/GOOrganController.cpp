@@ -13,6 +13,7 @@
 #include <wx/log.h>
 #include <wx/msgdlg.h>
 #include <wx/txtstrm.h>
+#include <wx/utils.h>
 #include <wx/wfstream.h>
 
 #include "archive/GOArchive.h"
@@ -44,9 +45,11 @@
 #include "gui/panels/GOGUIPanelCreator.h"
 #include "gui/panels/GOGUIRecorderPanel.h"
 #include "gui/panels/GOGUISequencerPanel.h"
+#include "loader/GOCacheLoadThread.h"
 #include "loader/GOLoadThread.h"
 #include "loader/GOLoaderFilename.h"
 #include "loader/cache/GOCache.h"
+#include "loader/cache/GOCacheIndex.h"
 #include "loader/cache/GOCacheWriter.h"
 #include "midi/GOMidi.h"
 #include "midi/GOMidiPlayer.h"
@@ -62,6 +65,7 @@
 #include "model/GOTremulant.h"
 #include "sound/GOSoundEngine.h"
 #include "sound/GOSoundReleaseAlignTable.h"
+#include "sound/GOSoundStreamStore.h"
 #include "temperaments/GOTemperament.h"
 #include "yaml/GOYamlModel.h"
 
@@ -76,8 +80,12 @@
 #include "GOOrgan.h"
 #include "go_path.h"
 
+class GOLoadAborted : public std::exception {};
+
 static const wxString WX_ORGAN = wxT("Organ");
 static const wxString WX_GRANDORGUE_VERSION = wxT("GrandOrgueVersion");
+// the number of threads reading the streamed samples from disk
+static constexpr unsigned STREAM_THREAD_COUNT = 4;
 
 GOOrganController::GOOrganController(GOConfig &config, bool isAppInitialized)
   : GOEventDistributor(this),
@@ -127,12 +135,15 @@ GOOrganController::GOOrganController(GOConfig &config, bool isAppInitialized)
   GOOrganModel::SetModelModificationListener(this);
   m_setter = new GOSetter(this);
   m_pool.SetMemoryLimit(m_config.MemoryLimit() * 1024 * 1024);
+  m_pool.SetResidency(m_config.MemoryHugePages(), m_config.MemoryLock());
 }
 
 GOOrganController::~GOOrganController() {
   p_OnStateButton = nullptr;
   m_FileStore.CloseArchives();
   GOEventHandlerList::Cleanup();
+  // the prefetch threads must not access the sections being freed
+  m_StreamStore.reset();
   // Just to be sure, that the sound providers are freed before the pool
   m_manuals.clear();
   m_tremulants.clear();
@@ -186,7 +197,7 @@ bool GOOrganController::IsCacheable() { return m_Cacheable; }
 GOHashType GOOrganController::GenerateCacheHash() {
   GOHash hash;
 
-  UpdateHash(hash);
+  // the objects are validated by their own keys (see GetCacheKey())
   hash.Update(sizeof(GOSoundAudioSection));
   hash.Update(sizeof(GOSoundingPipe));
   hash.Update(sizeof(GOSoundReleaseAlignTable));
@@ -199,6 +210,92 @@ GOHashType GOOrganController::GenerateCacheHash() {
   return hash.getHash();
 }
 
+unsigned GOOrganController::LoadFromCache(
+  GOCache &reader, GOProgressDialog *dlg, std::vector<bool> &isLoaded) {
+  const std::vector<GOCacheObject *> &objects = GetCacheObjects();
+  const GOHashType hash1 = GenerateCacheHash();
+  GOHashType hash2;
+
+  if (!reader.ReadHeader()) {
+    wxLogWarning(_("Cache file had bad magic bypassing cache."));
+    return 0;
+  }
+  if (
+    !reader.Read(&hash2, sizeof(hash2))
+    || memcmp(&hash1, &hash2, sizeof(hash1))) {
+    reader.FreeCacheFile();
+    wxLogWarning(_("Cache file had diffent hash bypassing cache."));
+    return 0;
+  }
+
+  GOCacheIndex index;
+
+  if (!index.Read(reader)) {
+    wxLogWarning(_("Cache file is truncated bypassing cache."));
+    return 0;
+  }
+
+  std::vector<GOHashType> keys;
+  std::vector<GOCacheLoadJob> jobs;
+
+  for (const GOCacheObject *pObj : objects)
+    keys.push_back(pObj->GetCacheKey());
+  for (const GOCacheIndex::Match &match : index.FindObjects(keys)) {
+    const unsigned i = match.m_ObjectIndex;
+
+    jobs.push_back({i, objects[i], match.m_offset, false});
+  }
+  if (jobs.size() < objects.size() && m_config.ManageCache())
+    // the cache file will be rewritten, so it must not remain mapped
+    reader.FreeCacheFile();
+  if (
+    m_StreamStore && jobs.size() == objects.size()
+    && !m_StreamStore->SetCacheFile(m_CacheFilename))
+    wxLogWarning(
+      _("Unable to stream the samples from the cache file %s"),
+      m_CacheFilename);
+
+  std::vector<GOCacheLoadJob *> jobPtrs;
+
+  for (GOCacheLoadJob &job : jobs)
+    jobPtrs.push_back(&job);
+
+  GOCacheLoadJobDistributor jobDistributor(jobPtrs);
+  GOCacheLoadWorker thisWorker(reader, m_pool, jobDistributor);
+  ptr_vector<GOCacheLoadThread> threads;
+  GOCacheLoadJob *pJob = nullptr;
+
+  /* The cache is loaded by several threads with own readers, so the packed
+   * blocks are unpacked in parallel */
+  for (unsigned i = 0; i < m_config.LoadConcurrency(); i++)
+    threads.push_back(
+      new GOCacheLoadThread(m_CacheFilename, reader, m_pool, jobDistributor));
+  for (unsigned i = 0; i < threads.size(); i++)
+    threads[i]->Run();
+
+  while (thisWorker.LoadNextObject(pJob))
+    // show the progress and process possible Cancel
+    if (
+      dlg
+      && !dlg->Update(jobDistributor.GetPos(), pJob->p_object->GetLoadTitle()))
+      throw GOLoadAborted(); // Skip the rest of the loading code
+  thisWorker.CheckOutOfMemory();
+  for (unsigned i = 0; i < threads.size(); i++)
+    threads[i]->CheckOutOfMemory();
+
+  unsigned nLoaded = 0;
+
+  for (const GOCacheLoadJob &job : jobs)
+    if (job.m_IsLoaded) {
+      isLoaded[job.m_ObjectIndex] = true;
+      nLoaded++;
+    } else
+      // the object will be loaded from the file later
+      wxLogWarning(
+        _("Cache load failure: %s"), job.p_object->GetLoadError());
+  return nLoaded;
+}
+
 void GOOrganController::ReadOrganFile(GOConfigReader &cfg) {
   /* load church info */
   cfg.ReadString(
@@ -349,8 +446,6 @@ wxString GOOrganController::GenerateCacheFileName() {
     + GOStdFileName::composeCacheFileName(GetOrganHash(), m_config.Preset());
 }
 
-class GOLoadAborted : public std::exception {};
-
 wxString GOOrganController::Load(
   GOProgressDialog *dlg,
   const GOOrgan &organ,
@@ -364,7 +459,8 @@ wxString GOOrganController::Load(
 
     m_ArchiveID = organ.GetArchiveID();
     if (m_ArchiveID != wxEmptyString) {
-      dlg->Setup(1, _("Loading sample set"), _("Parsing organ packages"));
+      if (dlg)
+        dlg->Setup(1, _("Loading sample set"), _("Parsing organ packages"));
 
       wxString errMsg1;
 
@@ -385,8 +481,9 @@ wxString GOOrganController::Load(
       m_FileStore.SetDirectory(go_get_path(m_odf));
     }
     m_hash = organ.GetOrganHash();
-    dlg->Setup(
-      1, _("Loading sample set"), _("Parsing sample set definition file"));
+    if (dlg)
+      dlg->Setup(
+        1, _("Loading sample set"), _("Parsing sample set definition file"));
     m_SettingFilename = GenerateSettingFileName();
     m_CacheFilename = GenerateCacheFileName();
     m_Cacheable = false;
@@ -494,62 +591,59 @@ wxString GOOrganController::Load(
         ResolveReferences();
 
         /* Figure out list of pipes to load */
-        GOCacheObjectDistributor objectDistributor(GetCacheObjects());
+        const std::vector<GOCacheObject *> &objects = GetCacheObjects();
+        // whether each object has been loaded from the cache
+        std::vector<bool> isLoaded(objects.size(), false);
+        unsigned nFromCache = 0;
 
-        dlg->Reset(objectDistributor.GetNObjects());
+        if (dlg)
+          dlg->Reset(objects.size());
 
         GOCacheObject *obj = nullptr;
 
+        if (m_config.SampleStreaming()) {
+          /* The sections missing in the cache are copied to the scratch file.
+           * The process id keeps apart several instances with the same organ */
+          wxFileName scratchFileName(m_CacheFilename);
+
+          scratchFileName.SetName(wxString::Format(
+            wxT("%s-%lu"), scratchFileName.GetName(), wxGetProcessId()));
+          scratchFileName.SetExt(wxT("stream"));
+          m_StreamStore.reset(new GOSoundStreamStore(
+            scratchFileName.GetFullPath(),
+            m_config.StreamHeadLength(),
+            m_config.PolyphonyLimit(),
+            STREAM_THREAD_COUNT));
+        }
+
         /* Load pipes */
+        for (GOCacheObject *pObj : objects)
+          pObj->StampSources(m_FileStore);
         if (wxFileExists(m_CacheFilename)) {
           wxFile cache_file(m_CacheFilename);
-          GOCache reader(cache_file, m_pool);
-          cache_ok = cache_file.IsOpened();
-
-          if (cache_ok) {
-            GOHashType hash1, hash2;
-            if (!reader.ReadHeader()) {
-              cache_ok = false;
-              wxLogWarning(_("Cache file had bad magic bypassing cache."));
-            }
-            hash1 = GenerateCacheHash();
-            if (
-              !reader.Read(&hash2, sizeof(hash2))
-              || memcmp(&hash1, &hash2, sizeof(hash1))) {
-              cache_ok = false;
-              reader.FreeCacheFile();
-              wxLogWarning(_("Cache file had diffent hash bypassing cache."));
-            }
-          }
-
-          GOCacheObject *obj = nullptr;
+          GOCache reader(cache_file, m_pool, !m_StreamStore);
 
-          if (cache_ok) {
-            while ((obj = objectDistributor.FetchNext())) {
-              if (!obj->LoadFromCacheWithoutExc(m_pool, reader)) {
-                wxLogWarning(_("Cache load failure: %s"), obj->GetLoadError());
-                break;
-              }
-              if (!dlg->Update(objectDistributor.GetPos(), obj->GetLoadTitle()))
-                throw GOLoadAborted(); // Skip the rest of the loading code
-            }
-            if (!obj)
-              m_Cacheable = true;
-            else
-              // obj points to an object with a load error. We will try to load
-              // it from the file later
-              cache_ok = false;
-          }
-
-          if (!cache_ok && !m_config.ManageCache())
+          if (cache_file.IsOpened())
+            nFromCache = LoadFromCache(reader, dlg, isLoaded);
+          if (nFromCache < objects.size() && !m_config.ManageCache())
             wxLogWarning(
               _("The cache for this organ is outdated. Please update "
                 "or delete it."));
 
           reader.Close();
         }
-
-        if (!cache_ok) {
+        cache_ok = nFromCache == objects.size();
+        if (cache_ok)
+          m_Cacheable = true;
+        else {
+          // only the objects missing in the cache are loaded from the files
+          std::vector<GOCacheObject *> objectsToLoad;
+
+          for (unsigned i = 0; i < objects.size(); i++)
+            if (!isLoaded[i])
+              objectsToLoad.push_back(objects[i]);
+
+          GOCacheObjectDistributor objectDistributor(objectsToLoad);
           GOLoadWorker thisWorker(m_FileStore, m_pool, objectDistributor);
           ptr_vector<GOLoadThread> threads;
 
@@ -560,13 +654,12 @@ wxString GOOrganController::Load(
           for (unsigned i = 0; i < threads.size(); i++)
             threads[i]->Run();
 
-          // try to load the object that we could not load from cache
-          if (obj)
-            thisWorker.LoadObjectNoExc(obj);
-
           while (thisWorker.LoadNextObject(obj))
             // show the progress and process possible Cancel
-            if (!dlg->Update(objectDistributor.GetPos(), obj->GetLoadTitle()))
+            if (
+              dlg
+              && !dlg->Update(
+                nFromCache + objectDistributor.GetPos(), obj->GetLoadTitle()))
               throw GOLoadAborted(); // skip the rest of loading code
           // rethrow exception if any occured in thisWorker.LoadNextObject
           bool wereExceptions = thisWorker.WereExceptions();
@@ -700,12 +793,22 @@ bool GOOrganController::CachePresent() { return wxFileExists(m_CacheFilename); }
 bool GOOrganController::UpdateCache(GOProgressDialog *dlg, bool compress) {
   bool isOk = false;
 
+  // the cache file must not be rewritten while the samples are read from it
+  if (m_StreamStore && m_StreamStore->IsCacheFileUsed()) {
+    wxLogWarning(
+      _("The sample cache cannot be updated while the samples are streamed "
+        "from it. Reload the organ without the sample streaming first."));
+    return false;
+  }
+
   DeleteCache();
 
   /* Figure out the list of pipes to save */
-  GOCacheObjectDistributor objectDistributor(GetCacheObjects());
+  const std::vector<GOCacheObject *> &objects = GetCacheObjects();
+  GOCacheObjectDistributor objectDistributor(objects);
 
-  dlg->Setup(objectDistributor.GetNObjects(), _("Creating sample cache"));
+  if (dlg)
+    dlg->Setup(objectDistributor.GetNObjects(), _("Creating sample cache"));
 
   wxFileOutputStream file(m_CacheFilename);
 
@@ -719,22 +822,32 @@ bool GOOrganController::UpdateCache(GOProgressDialog *dlg, bool compress) {
     if (!writer.Write(&hash, sizeof(hash)))
       isOk = false;
 
+    /* Each object is found by its key in the table of the objects, so only the
+     * changed objects are loaded from the files next time */
+    GOCacheIndex index;
+
     while (isOk) {
       GOCacheObject *obj = objectDistributor.FetchNext();
 
       if (!obj)
         break;
+      index.Add(obj->GetCacheKey(), writer.GetPos());
       if (!obj->SaveCache(writer)) {
         isOk = false;
         wxLogError(
           _("Save of %s to the cache failed"), obj->GetLoadTitle().c_str());
       }
-      if (!dlg->Update(objectDistributor.GetPos(), obj->GetLoadTitle())) {
+      if (
+        dlg && !dlg->Update(objectDistributor.GetPos(), obj->GetLoadTitle())) {
         writer.Close();
         DeleteCache();
         isOk = false;
       }
     }
+
+    // the table follows the objects, so they are written in one pass
+    if (isOk && !index.Write(writer))
+      isOk = false;
     writer.Close();
     if (!isOk)
       DeleteCache();
@@ -115,6 +115,13 @@ private:
 
   void ReadOrganFile(GOConfigReader &cfg);
   GOHashType GenerateCacheHash();
+  /**
+   * Loads the objects having records with their keys in the cache
+   * @param isLoaded is set for each object loaded from the cache
+   * @return the number of the objects loaded from the cache
+   */
+  unsigned LoadFromCache(
+    GOCache &reader, GOProgressDialog *dlg, std::vector<bool> &isLoaded);
   wxString GenerateSettingFileName();
   wxString GenerateCacheFileName();
   void SetTemperament(const GOTemperament &temperament);
@@ -147,6 +154,14 @@ public:
     m_FileStore.SetDirectory(dir);
   }
 
+  /**
+   * Loads the organ
+   * @param dlg the progress dialog. nullptr for loading without GUI
+   * @param organ the organ to load
+   * @param cmb the combination file or an empty string
+   * @param isGuiOnly whether not to load the samples
+   * @return an empty string if successed otherwise the error message
+   */
   wxString Load(
     GOProgressDialog *dlg,
     const GOOrgan &organ,
@@ -310,6 +310,8 @@ GOConfig::GOConfig(wxString instance)
     ManagePolyphony(this, GENERAL, wxT("ManagePolyphony"), true),
     ScaleRelease(this, GENERAL, wxT("ScaleRelease"), true),
     RandomizeSpeaking(this, GENERAL, wxT("RandomizeSpeaking"), true),
+    SubmixBuses(this, GENERAL, wxT("SubmixBuses"), true),
+    InaudibleLevel(this, GENERAL, wxT("InaudibleLevel"), -140, 0, -90),
     ReverbEnabled(this, wxT("Reverb"), wxT("ReverbEnabled"), false),
     ReverbDirect(this, wxT("Reverb"), wxT("ReverbDirect"), true),
     ReverbChannel(this, wxT("Reverb"), wxT("ReverbChannel"), 1, 4, 1),
@@ -326,6 +328,10 @@ GOConfig::GOConfig(wxString instance)
       0,
       1024 * 1024,
       GOMemoryPool::GetSystemMemoryLimit()),
+    MemoryHugePages(this, GENERAL, wxT("MemoryHugePages"), false),
+    MemoryLock(this, GENERAL, wxT("MemoryLock"), false),
+    SampleStreaming(this, GENERAL, wxT("SampleStreaming"), false),
+    StreamHeadLength(this, GENERAL, wxT("StreamHeadLength"), 50, 5000, 250),
     SamplesPerBuffer(
       this,
       GENERAL,
@@ -335,6 +341,7 @@ GOConfig::GOConfig(wxString instance)
       SAMPLES_PER_BUFFER_DEFAULT),
     SampleRate(
       this, GENERAL, wxT("SampleRate"), 1000, 192000, SAMPLE_RATE_DEFAULT),
+    RenderSampleRate(this, GENERAL, wxT("RenderSampleRate"), 0, 192000, 0),
     Volume(this, GENERAL, wxT("Volume"), -120, 20, -15),
     PolyphonyLimit(
       this, GENERAL, wxT("PolyphonyLimit"), 0, MAX_POLYPHONY, 2048),
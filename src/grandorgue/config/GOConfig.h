@@ -110,6 +110,9 @@ public:
   GOSettingBool ManagePolyphony;
   GOSettingBool ScaleRelease;
   GOSettingBool RandomizeSpeaking;
+  GOSettingBool SubmixBuses;
+  // the level in dBFS the release voices are retired below. 0 means never
+  GOSettingInteger InaudibleLevel;
   GOSettingBool ReverbEnabled;
   GOSettingBool ReverbDirect;
   GOSettingUnsigned ReverbChannel;
@@ -120,8 +123,14 @@ public:
   GOSettingFile ReverbFile;
 
   GOSettingFloat MemoryLimit;
+  GOSettingBool MemoryHugePages;
+  GOSettingBool MemoryLock;
+  GOSettingBool SampleStreaming;
+  // the length of the resident head of each streamed sample in ms
+  GOSettingUnsigned StreamHeadLength;
   GOSettingUnsigned SamplesPerBuffer;
   GOSettingUnsigned SampleRate;
+  GOSettingUnsigned RenderSampleRate;
   GOSettingInteger Volume;
   GOSettingUnsigned PolyphonyLimit;
   GOSettingUnsigned Preset;
@@ -7,6 +7,10 @@
 
 #include "GOEventDistributor.h"
 
+#include <algorithm>
+
+#include "midi/elements/GOMidiReceiver.h"
+#include "midi/events/GOMidiRoute.h"
 #include "model/GOCacheObject.h"
 #include "model/GOEventHandlerList.h"
 #include "sound/GOSoundStateHandler.h"
@@ -15,9 +19,81 @@
 #include "GOEventHandler.h"
 #include "GOSaveableObject.h"
 
+static uint64_t pack_route(
+  unsigned device, GOMidiEvent::MidiType type, int channel, int key) {
+  return ((uint64_t)device << 24) | ((uint64_t)(type & 0xFF) << 16)
+    | ((uint64_t)((channel + 1) & 0xFF) << 8) | (uint64_t)((key + 1) & 0xFF);
+}
+
+void GOEventDistributor::BuildRouteIndex() {
+  const auto &handlers = p_model->GetMidiEventHandlers();
+  std::vector<GOMidiRoute> routes;
+
+  m_RoutedHandlers.clear();
+  m_UnroutedHandlers.clear();
+  for (unsigned i = 0; i < handlers.size(); i++) {
+    routes.clear();
+    if (handlers[i]->GetMidiRoutes(routes))
+      for (const auto &route : routes) {
+        auto &indices = m_RoutedHandlers[pack_route(
+          route.device, route.type, route.channel, route.key)];
+
+        // the routes of one handler are added together
+        if (indices.empty() || indices.back() != i)
+          indices.push_back(i);
+      }
+    else
+      m_UnroutedHandlers.push_back(i);
+  }
+  m_HandlersVersion = p_model->GetMidiEventHandlersVersion();
+  m_MatchingVersion = GOMidiReceiver::getMatchingVersion();
+  m_IsRouteIndexValid = true;
+}
+
 void GOEventDistributor::SendMidi(const GOMidiEvent &event) {
-  for (auto handler : p_model->GetMidiEventHandlers())
-    handler->ProcessMidi(event);
+  const GOMidiEvent::MidiType type = event.GetMidiType();
+
+  if (!GOMidiRoute::isRoutedType(type)) {
+    for (auto handler : p_model->GetMidiEventHandlers())
+      handler->ProcessMidi(event);
+    // the sysex setup changes the events matched by the receivers
+    if (
+      type == GOMidiEvent::MIDI_SYSEX_GO_CLEAR
+      || type == GOMidiEvent::MIDI_SYSEX_GO_SAMPLESET
+      || type == GOMidiEvent::MIDI_SYSEX_GO_SETUP)
+      m_IsRouteIndexValid = false;
+    return;
+  }
+  if (
+    !m_IsRouteIndexValid
+    || m_HandlersVersion != p_model->GetMidiEventHandlersVersion()
+    || m_MatchingVersion != GOMidiReceiver::getMatchingVersion())
+    BuildRouteIndex();
+
+  // a handler may send midi events too
+  std::vector<unsigned> matched;
+
+  matched.swap(m_MatchedHandlers);
+  matched = m_UnroutedHandlers;
+  for (unsigned device : {event.GetDevice(), 0u})
+    for (int channel : {event.GetChannel(), -1})
+      for (int key : {event.GetKey(), -1}) {
+        auto it = m_RoutedHandlers.find(pack_route(device, type, channel, key));
+
+        if (it != m_RoutedHandlers.end())
+          matched.insert(matched.end(), it->second.begin(), it->second.end());
+      }
+  // keep the order of the handlers
+  std::sort(matched.begin(), matched.end());
+  matched.erase(std::unique(matched.begin(), matched.end()), matched.end());
+
+  const auto &handlers = p_model->GetMidiEventHandlers();
+
+  for (unsigned i : matched)
+    if (i < handlers.size())
+      handlers[i]->ProcessMidi(event);
+  matched.clear();
+  m_MatchedHandlers.swap(matched);
 }
 
 void GOEventDistributor::HandleKey(int key) {
@@ -40,14 +116,11 @@ void GOEventDistributor::ResolveReferences() {
     obj->InitWithoutExc();
 }
 
-void GOEventDistributor::UpdateHash(GOHash &hash) {
-  for (auto obj : p_model->GetCacheObjects())
-    obj->UpdateHash(hash);
-}
-
 void GOEventDistributor::PreparePlayback(GOSoundEngine *pSoundEngine) {
   for (auto handler : p_model->GetSoundStateHandlers())
     handler->PreparePlaybackExt(pSoundEngine);
+  // the receivers have reset their sysex setup
+  m_IsRouteIndexValid = false;
 }
 
 void GOEventDistributor::StartPlayback() {
@@ -8,12 +8,13 @@
 #ifndef GOEVENTDISTRIBUTOR_H
 #define GOEVENTDISTRIBUTOR_H
 
+#include <cstdint>
+#include <unordered_map>
 #include <vector>
 
 class GOConfigReader;
 class GOConfigWriter;
 class GOEventHandlerList;
-class GOHash;
 class GOMidiEvent;
 class GOSoundEngine;
 
@@ -21,6 +22,18 @@ class GOEventDistributor {
 private:
   GOEventHandlerList *p_model;
 
+  // the indices of the handlers by the packed routes
+  std::unordered_map<uint64_t, std::vector<unsigned>> m_RoutedHandlers;
+  // the indices of the handlers receiving all events
+  std::vector<unsigned> m_UnroutedHandlers;
+  // a reusable buffer for the handlers of one event
+  std::vector<unsigned> m_MatchedHandlers;
+  bool m_IsRouteIndexValid;
+  unsigned m_HandlersVersion;
+  unsigned m_MatchingVersion;
+
+  void BuildRouteIndex();
+
 protected:
   void SendMidi(const GOMidiEvent &event);
 
@@ -28,7 +41,6 @@ protected:
   void Save(GOConfigWriter &cfg);
 
   void ResolveReferences();
-  void UpdateHash(GOHash &hash);
 
   void PreparePlayback(GOSoundEngine *pSoundEngine);
   void StartPlayback();
@@ -36,7 +48,11 @@ protected:
   void PrepareRecording();
 
 public:
-  GOEventDistributor(GOEventHandlerList *pModel) { p_model = pModel; }
+  GOEventDistributor(GOEventHandlerList *pModel)
+    : p_model(pModel),
+      m_IsRouteIndexValid(false),
+      m_HandlersVersion(0),
+      m_MatchingVersion(0) {}
   ~GOEventDistributor() { p_model = nullptr; }
 
   void HandleKey(int key);
@@ -171,6 +171,45 @@ GOPropertiesDialog::GOPropertiesDialog(
     wxTOP,
     5);
 
+  const std::vector<GOMemoryPool::ArenaStatistic> arenaStats
+    = m_OrganController->GetMemoryPool().GetArenaStatistics();
+  size_t used = 0, freed = 0, wasted = 0;
+
+  for (const GOMemoryPool::ArenaStatistic &stat : arenaStats) {
+    used += stat.m_UsedSize;
+    freed += stat.m_FreedSize;
+    wasted += stat.m_WastedSize;
+  }
+  sizer->Add(GOPropertiesText(this, 0, _("Memory pool arenas")), 0, wxTOP, 5);
+  sizer->Add(
+    GOPropertiesText(
+      this,
+      0,
+      wxString::Format(
+        _("%u arenas: %.3f MB used, %.3f MB freed, %.3f MB wasted"),
+        (unsigned)arenaStats.size(),
+        used / (1024.0 * 1024.0),
+        freed / (1024.0 * 1024.0),
+        wasted / (1024.0 * 1024.0))),
+    0,
+    wxTOP,
+    5);
+
+  size_t residentSize;
+
+  if (m_OrganController->GetMemoryPool().GetResidentSize(residentSize)) {
+    sizer->Add(
+      GOPropertiesText(this, 0, _("Resident sample memory")), 0, wxTOP, 5);
+    sizer->Add(
+      GOPropertiesText(
+        this,
+        0,
+        wxString::Format(_("%.3f MB"), residentSize / (1024.0 * 1024.0))),
+      0,
+      wxTOP,
+      5);
+  }
+
   sizer->Add(GOPropertiesText(this, 0, _("ODF Path")), 0, wxTOP, 5);
   sizer->Add(
     GOPropertiesText(this, 300, m_OrganController->GetOrganPathInfo()),
@@ -7,6 +7,9 @@
 
 #include "GOOrganSettingsPipesTab.h"
 
+#include <climits>
+
+#include <wx/button.h>
 #include <wx/checkbox.h>
 #include <wx/choicdlg.h>
 #include <wx/choice.h>
@@ -14,12 +17,14 @@
 #include <wx/gbsizer.h>
 #include <wx/log.h>
 #include <wx/msgdlg.h>
+#include <wx/numdlg.h>
 #include <wx/spinbutt.h>
 #include <wx/stattext.h>
 #include <wx/treebase.h>
 #include <wx/treectrl.h>
 
 #include "model/GOOrganModel.h"
+#include "model/pipe-config/GOMemoryBudgetPlanner.h"
 #include "model/pipe-config/GOPipeConfigNode.h"
 
 #include "GOEvent.h"
@@ -65,7 +70,8 @@ enum {
   ID_EVENT_CHANNELS,
   ID_EVENT_LOOP_LOAD,
   ID_EVENT_ATTACK_LOAD,
-  ID_EVENT_RELEASE_LOAD
+  ID_EVENT_RELEASE_LOAD,
+  ID_EVENT_FIT_MEMORY
 };
 
 DEFINE_LOCAL_EVENT_TYPE(wxEVT_TREE_UPDATED)
@@ -110,12 +116,14 @@ EVT_CHOICE(ID_EVENT_CHANNELS, GOOrganSettingsPipesTab::OnChannelsChanged)
 EVT_CHOICE(ID_EVENT_LOOP_LOAD, GOOrganSettingsPipesTab::OnLoopLoadChanged)
 EVT_CHOICE(ID_EVENT_ATTACK_LOAD, GOOrganSettingsPipesTab::OnAttackLoadChanged)
 EVT_CHOICE(ID_EVENT_RELEASE_LOAD, GOOrganSettingsPipesTab::OnReleaseLoadChanged)
+EVT_BUTTON(ID_EVENT_FIT_MEMORY, GOOrganSettingsPipesTab::OnFitMemory)
 END_EVENT_TABLE()
 
 GOOrganSettingsPipesTab::GOOrganSettingsPipesTab(
   GOOrganModel &organModel, GOOrganSettingsDialogBase *pDlg)
   : GOOrganSettingsTab(pDlg, WX_TAB_CODE, WX_TAB_TITLE),
     r_config(organModel.GetConfig()),
+    r_OrganModel(organModel),
     r_RootNode(organModel.GetRootPipeConfigNode()),
     p_LastTreeItemData(nullptr),
     m_LoadChangeCnt(0) {
@@ -157,6 +165,11 @@ GOOrganSettingsPipesTab::GOOrganSettingsPipesTab(
   m_BitDisplay = new wxStaticText(this, wxID_ANY, wxEmptyString);
   grid->Add(m_BitDisplay);
   box1->Add(grid, 0, wxEXPAND | wxALL, 5);
+  box1->Add(
+    new wxButton(this, ID_EVENT_FIT_MEMORY, _("Fit to memory...")),
+    0,
+    wxLEFT | wxRIGHT | wxBOTTOM,
+    5);
   mainSizer->Add(
     box1, wxGBPosition(0, 1), wxDefaultSpan, wxEXPAND | wxRIGHT, 5);
 
@@ -516,10 +529,17 @@ void GOOrganSettingsPipesTab::Load(bool isForce) {
     m_MemoryDisplay->SetLabel(_("--- MB (--- MB end)"));
     m_BitDisplay->SetLabel(_("-- bits (- used)"));
   } else {
-    m_MemoryDisplay->SetLabel(wxString::Format(
-      _("%.3f MB  (%.3f MB end)"),
-      stat.GetMemorySize() / (1024.0 * 1024.0),
-      stat.GetEndSegmentSize() / (1024.0 * 1024.0)));
+    if (stat.GetSharedSize())
+      m_MemoryDisplay->SetLabel(wxString::Format(
+        _("%.3f MB  (%.3f MB end, %.3f MB shared)"),
+        stat.GetMemorySize() / (1024.0 * 1024.0),
+        stat.GetEndSegmentSize() / (1024.0 * 1024.0),
+        stat.GetSharedSize() / (1024.0 * 1024.0)));
+    else
+      m_MemoryDisplay->SetLabel(wxString::Format(
+        _("%.3f MB  (%.3f MB end)"),
+        stat.GetMemorySize() / (1024.0 * 1024.0),
+        stat.GetEndSegmentSize() / (1024.0 * 1024.0)));
     wxString buf;
     if (stat.GetMinBitPerSample() == stat.GetMaxBitPerSample())
       buf = wxString::Format(_("%d bits"), stat.GetMinBitPerSample());
@@ -941,6 +961,64 @@ void GOOrganSettingsPipesTab::OnReleaseLoadChanged(wxCommandEvent &e) {
   NotifyModified();
 }
 
+void GOOrganSettingsPipesTab::OnFitMemory(wxCommandEvent &e) {
+  if (CheckForUnapplied())
+    return;
+
+  GOMemoryBudgetPlanner planner(r_OrganModel);
+  const long currentMb = planner.GetCurrentSize() / (1024 * 1024);
+
+  if (!currentMb) {
+    GOMessageBox(
+      _("No sample memory usage is known. Load the organ first."),
+      _("Error"),
+      wxOK | wxICON_ERROR,
+      this);
+    return;
+  }
+
+  const long targetMb = wxGetNumberFromUser(
+    wxString::Format(
+      _("The samples use %ld MB now. The loading settings of the ranks\n"
+        "will be reduced, the least audible reductions first."),
+      currentMb),
+    _("Memory target (MB):"),
+    _("Fit to memory"),
+    currentMb,
+    1,
+    LONG_MAX,
+    this);
+
+  if (targetMb <= 0)
+    return;
+
+  const int compressAnswer = wxMessageBox(
+    _("May lossless compression be used?\n"
+      "It saves memory but needs more CPU time for playing."),
+    _("Fit to memory"),
+    wxYES_NO | wxCANCEL | wxICON_QUESTION,
+    this);
+
+  if (compressAnswer == wxCANCEL)
+    return;
+
+  const bool isFit
+    = planner.Plan((size_t)targetMb * 1024 * 1024, compressAnswer == wxYES);
+  wxString report = planner.GetReport();
+
+  if (!isFit)
+    report += wxT("\n") + _("The target cannot be reached.");
+  report += wxT("\n\n")
+    + _("Apply these settings? They take effect after reloading the organ.");
+  if (
+    wxMessageBox(report, _("Fit to memory"), wxYES_NO | wxICON_QUESTION, this)
+    == wxYES) {
+    planner.Apply();
+    p_LastTreeItemData = NULL;
+    Load(true);
+  }
+}
+
 void GOOrganSettingsPipesTab::DistributeAudio() {
   if (CheckForUnapplied())
     return;
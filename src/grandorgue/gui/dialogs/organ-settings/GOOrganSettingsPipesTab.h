@@ -34,6 +34,7 @@ private:
   class TreeItemData;
 
   GOConfig &r_config;
+  GOOrganModel &r_OrganModel;
   GOPipeConfigNode &r_RootNode;
 
   wxTreeCtrl *m_Tree;
@@ -108,6 +109,7 @@ private:
   void OnLoopLoadChanged(wxCommandEvent &e);
   void OnAttackLoadChanged(wxCommandEvent &e);
   void OnReleaseLoadChanged(wxCommandEvent &e);
+  void OnFitMemory(wxCommandEvent &e);
 
 public:
   GOOrganSettingsPipesTab(
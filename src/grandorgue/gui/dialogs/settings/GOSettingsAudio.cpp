@@ -122,6 +122,12 @@ GOSettingsAudio::GOSettingsAudio(
     0,
     wxALIGN_CENTER_VERTICAL | wxALIGN_RIGHT);
   gridOutput->Add(m_SampleRate = new wxChoice(this, ID_SAMPLE_RATE));
+  gridOutput->Add(
+    new wxStaticText(this, wxID_ANY, _("Render sample rate:")),
+    0,
+    wxALIGN_CENTER_VERTICAL | wxALIGN_RIGHT);
+  gridOutput->Add(
+    m_RenderSampleRate = new wxChoice(this, ID_RENDER_SAMPLE_RATE));
   gridOutput->Add(
     new wxStaticText(this, wxID_ANY, _("Samples per buffer:")),
     0,
@@ -209,6 +215,16 @@ bool GOSettingsAudio::TransferDataToWindow() {
       wxString::Format(wxT("%d"), m_config.SampleRate())
       == m_SampleRate->GetString(i))
       m_SampleRate->Select(i);
+  m_RenderSampleRate->Append(_("Same as output"));
+  m_RenderSampleRate->Append(wxT("44100"));
+  m_RenderSampleRate->Append(wxT("48000"));
+  m_RenderSampleRate->Append(wxT("96000"));
+  m_RenderSampleRate->Select(0);
+  for (unsigned i = 1; i < m_RenderSampleRate->GetCount(); i++)
+    if (
+      wxString::Format(wxT("%d"), m_config.RenderSampleRate())
+      == m_RenderSampleRate->GetString(i))
+      m_RenderSampleRate->Select(i);
   m_SamplesPerBuffer->SetRange(1, MAX_FRAME_SIZE);
   m_SamplesPerBuffer->SetValue(m_config.SamplesPerBuffer());
 
@@ -771,6 +787,14 @@ bool GOSettingsAudio::TransferDataFromWindow() {
     m_config.SampleRate(sample_rate);
   else
     wxLogError(_("Invalid sample rate"));
+
+  unsigned long renderSampleRate = 0;
+
+  if (
+    m_RenderSampleRate->GetSelection() > 0
+    && !m_RenderSampleRate->GetStringSelection().ToULong(&renderSampleRate))
+    renderSampleRate = 0;
+  m_config.RenderSampleRate(renderSampleRate);
   m_config.SamplesPerBuffer(m_SamplesPerBuffer->GetValue());
 
   m_config.SetSoundPortsConfig(RenewPortsConfig());
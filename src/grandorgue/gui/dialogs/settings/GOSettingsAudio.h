@@ -35,6 +35,7 @@ class GOSettingsAudio : public wxPanel, GOSettingsPorts {
     ID_AUDIOGROUP_DEL,
     ID_AUDIOGROUP_RENAME,
     ID_SAMPLE_RATE,
+    ID_RENDER_SAMPLE_RATE,
     ID_SAMPLES_PER_BUFFER,
     ID_SOND_PORTS,
     ID_OUTPUT_LIST,
@@ -56,6 +57,7 @@ private:
   wxButton *m_RenameGroup;
 
   wxChoice *m_SampleRate;
+  wxChoice *m_RenderSampleRate;
   wxSpinCtrl *m_SamplesPerBuffer;
 
   wxTreeCtrl *m_AudioOutput;
@@ -33,6 +33,10 @@ GOSettingsOptions::GOSettingsOptions(GOConfig &settings, wxWindow *parent)
   m_OldLoopLoad = m_config.LoopLoad();
   m_OldAttackLoad = m_config.AttackLoad();
   m_OldReleaseLoad = m_config.ReleaseLoad();
+  m_OldSampleStreaming = m_config.SampleStreaming();
+  m_OldMemoryHugePages = m_config.MemoryHugePages();
+  m_OldMemoryLock = m_config.MemoryLock();
+  m_OldStreamHeadLength = m_config.StreamHeadLength();
 
   wxBoxSizer *topSizer = new wxBoxSizer(wxVERTICAL);
   wxBoxSizer *item0 = new wxBoxSizer(wxHORIZONTAL);
@@ -120,6 +124,12 @@ GOSettingsOptions::GOSettingsOptions(GOConfig &settings, wxWindow *parent)
     0,
     wxEXPAND | wxALL,
     5);
+  item6->Add(
+    m_SubmixBuses
+    = new wxCheckBox(this, wxID_ANY, _("Mix the pipes of a rank on a bus")),
+    0,
+    wxEXPAND | wxALL,
+    5);
   item6->Add(
     m_LoadLastFile = new GOChoice<GOInitialLoadType>(this, ID_LOAD_LAST_FILE),
     0,
@@ -135,6 +145,7 @@ GOSettingsOptions::GOSettingsOptions(GOConfig &settings, wxWindow *parent)
   m_LoadLastFile->SetCurrentValue(m_config.LoadLastFile());
   m_Scale->SetValue(m_config.ScaleRelease());
   m_Random->SetValue(m_config.RandomizeSpeaking());
+  m_SubmixBuses->SetValue(m_config.SubmixBuses());
 
   wxFlexGridSizer *grid = new wxFlexGridSizer(2, 5, 5);
   item6 = new wxStaticBoxSizer(wxVERTICAL, this, _("&Sound Engine"));
@@ -228,6 +239,19 @@ GOSettingsOptions::GOSettingsOptions(GOConfig &settings, wxWindow *parent)
     wxALL);
   m_Volume->SetRange(-120, 20);
   m_Volume->SetValue(m_config.Volume());
+
+  grid->Add(
+    new wxStaticText(
+      this, wxID_ANY, _("Retire releases below (dBFS, 0 = never):")),
+    0,
+    wxALIGN_CENTER_VERTICAL | wxALIGN_RIGHT);
+  grid->Add(
+    m_InaudibleLevel = new wxSpinCtrl(
+      this, wxID_ANY, wxEmptyString, wxDefaultPosition, SPINCTRL_SIZE),
+    0,
+    wxALL);
+  m_InaudibleLevel->SetRange(-140, 0);
+  m_InaudibleLevel->SetValue(m_config.InaudibleLevel());
   item6->Add(grid, 0, wxEXPAND | wxALL, 5);
   item9->Add(item6, 0, wxEXPAND | wxALL, 5);
 
@@ -336,12 +360,51 @@ GOSettingsOptions::GOSettingsOptions(GOConfig &settings, wxWindow *parent)
     wxALL);
   m_MemoryLimit->SetRange(0, 1024 * 1024);
 
+  grid->Add(
+    new wxStaticText(
+      this, wxID_ANY, _("Resident head of streamed samples (ms):")),
+    0,
+    wxALIGN_CENTER_VERTICAL | wxALIGN_RIGHT);
+  grid->Add(
+    m_StreamHeadLength = new wxSpinCtrl(
+      this,
+      wxID_ANY,
+      wxEmptyString,
+      wxDefaultPosition,
+      wxSize(150, wxDefaultCoord)),
+    0,
+    wxALL);
+  m_StreamHeadLength->SetRange(50, 5000);
+
   m_Channels->Select(m_config.LoadChannels());
   m_BitsPerSample->Select((m_config.BitsPerSample() - 8) / 4);
   m_LoopLoad->Select(m_config.LoopLoad());
   m_AttackLoad->Select(m_config.AttackLoad());
   m_ReleaseLoad->Select(m_config.ReleaseLoad());
   m_MemoryLimit->SetValue(m_config.MemoryLimit());
+  m_StreamHeadLength->SetValue(m_config.StreamHeadLength());
+
+  item6->Add(
+    m_SampleStreaming = new wxCheckBox(
+      this, wxID_ANY, _("Stream samples from disk (for large sample sets)")),
+    0,
+    wxEXPAND | wxALL,
+    5);
+  m_SampleStreaming->SetValue(m_config.SampleStreaming());
+  item6->Add(
+    m_MemoryHugePages = new wxCheckBox(
+      this, wxID_ANY, _("Back the sample memory with huge pages")),
+    0,
+    wxEXPAND | wxALL,
+    5);
+  m_MemoryHugePages->SetValue(m_config.MemoryHugePages());
+  item6->Add(
+    m_MemoryLock
+    = new wxCheckBox(this, wxID_ANY, _("Lock the sample memory in RAM")),
+    0,
+    wxEXPAND | wxALL,
+    5);
+  m_MemoryLock->SetValue(m_config.MemoryLock());
 
   item6 = new wxStaticBoxSizer(wxVERTICAL, this, _("&Cache"));
   item9->Add(item6, 0, wxEXPAND | wxALL, 5);
@@ -438,6 +501,8 @@ bool GOSettingsOptions::TransferDataFromWindow() {
   m_config.Volume(m_Volume->GetValue());
   m_config.ScaleRelease(m_Scale->IsChecked());
   m_config.RandomizeSpeaking(m_Random->IsChecked());
+  m_config.SubmixBuses(m_SubmixBuses->IsChecked());
+  m_config.InaudibleLevel(m_InaudibleLevel->GetValue());
   m_config.Concurrency(m_Concurrency->GetSelection() + 1);
   m_config.ReleaseConcurrency(m_ReleaseConcurrency->GetSelection() + 1);
   m_config.LoadConcurrency(m_LoadConcurrency->GetSelection());
@@ -449,6 +514,10 @@ bool GOSettingsOptions::TransferDataFromWindow() {
   m_config.LoadChannels(m_Channels->GetSelection());
   m_config.m_InterpolationType(m_Interpolation->GetSelection());
   m_config.MemoryLimit(m_MemoryLimit->GetValue());
+  m_config.SampleStreaming(m_SampleStreaming->IsChecked());
+  m_config.MemoryHugePages(m_MemoryHugePages->IsChecked());
+  m_config.MemoryLock(m_MemoryLock->IsChecked());
+  m_config.StreamHeadLength(m_StreamHeadLength->GetValue());
   m_config.MetronomeBPM(m_MetronomeBPM->GetValue());
   m_config.MetronomeMeasure(m_MetronomeMeasure->GetValue());
   m_config.CheckForUpdatesAtStartup(m_CheckForUpdatesAtStartup->GetValue());
@@ -467,6 +536,10 @@ bool GOSettingsOptions::NeedReload() {
     || m_OldLoopLoad != m_config.LoopLoad()
     || m_OldAttackLoad != m_config.AttackLoad()
     || m_OldReleaseLoad != m_config.ReleaseLoad()
+    || m_OldSampleStreaming != m_config.SampleStreaming()
+    || m_OldMemoryHugePages != m_config.MemoryHugePages()
+    || m_OldMemoryLock != m_config.MemoryLock()
+    || m_OldStreamHeadLength != m_config.StreamHeadLength()
     || m_OldChannels != m_config.LoadChannels();
 }
 
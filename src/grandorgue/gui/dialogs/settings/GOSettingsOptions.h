@@ -59,10 +59,12 @@ private:
   GOChoice<GOInitialLoadType> *m_LoadLastFile;
   wxCheckBox *m_Scale;
   wxCheckBox *m_Random;
+  wxCheckBox *m_SubmixBuses;
   wxCheckBox *m_ODFCheck;
   wxCheckBox *m_ODFHw1Check;
   wxCheckBox *m_RecordDownmix;
   wxSpinCtrl *m_Volume;
+  wxSpinCtrl *m_InaudibleLevel;
   wxChoice *m_BitsPerSample;
   wxChoice *m_LoopLoad;
   wxChoice *m_AttackLoad;
@@ -70,6 +72,10 @@ private:
   wxChoice *m_Channels;
   wxChoice *m_Interpolation;
   wxSpinCtrl *m_MemoryLimit;
+  wxCheckBox *m_SampleStreaming;
+  wxCheckBox *m_MemoryHugePages;
+  wxCheckBox *m_MemoryLock;
+  wxSpinCtrl *m_StreamHeadLength;
   wxChoice *m_Language;
   wxSpinCtrl *m_MetronomeMeasure;
   wxSpinCtrl *m_MetronomeBPM;
@@ -82,6 +88,10 @@ private:
   unsigned m_OldLoopLoad;
   unsigned m_OldAttackLoad;
   unsigned m_OldReleaseLoad;
+  bool m_OldSampleStreaming;
+  bool m_OldMemoryHugePages;
+  bool m_OldMemoryLock;
+  unsigned m_OldStreamHeadLength;
 
 public:
   GOSettingsOptions(GOConfig &settings, wxWindow *parent);
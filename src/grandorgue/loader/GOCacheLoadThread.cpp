@@ -0,0 +1,35 @@
+/*
+ * Copyright 2006 Milan Digital Audio LLC
+ * Copyright 2009-2025 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#include "GOCacheLoadThread.h"
+
+GOCacheLoadThread::GOCacheLoadThread(
+  const wxString &cacheFilename,
+  GOCache &mainReader,
+  GOMemoryPool &pool,
+  GOCacheLoadJobDistributor &distributor)
+  : m_File(cacheFilename),
+    m_cache(m_File, mainReader),
+    m_worker(m_cache, pool, distributor) {}
+
+void GOCacheLoadThread::Run() {
+  // without an own reader the other workers do the jobs
+  if (m_File.IsOpened() && m_cache.ReadHeader())
+    Start();
+}
+
+void GOCacheLoadThread::CheckOutOfMemory() {
+  Wait();
+  m_worker.CheckOutOfMemory();
+}
+
+void GOCacheLoadThread::Entry() {
+  GOCacheLoadJob *pJob = nullptr;
+
+  while (!ShouldStop() && m_worker.LoadNextObject(pJob)) {
+  }
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright 2006 Milan Digital Audio LLC
+ * Copyright 2009-2025 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#ifndef GOCACHELOADTHREAD_H
+#define GOCACHELOADTHREAD_H
+
+#include <wx/file.h>
+
+#include "loader/cache/GOCache.h"
+#include "threading/GOThread.h"
+
+#include "GOCacheLoadWorker.h"
+
+class GOCacheLoadThread : private GOThread {
+private:
+  wxFile m_File;
+  GOCache m_cache;
+  GOCacheLoadWorker m_worker;
+
+  /* the main loading loop. It takes jobs concurrently with other threads and
+   * loads the objects from their cache records
+   */
+  void Entry() override;
+
+public:
+  /**
+   * Opens an additional reader of the cache file
+   * @param mainReader - the reader the cache file has been opened with
+   */
+  GOCacheLoadThread(
+    const wxString &cacheFilename,
+    GOCache &mainReader,
+    GOMemoryPool &pool,
+    GOCacheLoadJobDistributor &distributor);
+  ~GOCacheLoadThread() { Stop(); }
+
+  void Run();
+
+  /**
+   * Waits for completion
+   * Rethrows GOOutOfMemory if it occured
+   */
+  void CheckOutOfMemory();
+};
+
+#endif /* GOCACHELOADTHREAD_H */
@@ -0,0 +1,43 @@
+/*
+ * Copyright 2006 Milan Digital Audio LLC
+ * Copyright 2009-2025 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#include "GOCacheLoadWorker.h"
+
+#include "loader/cache/GOCache.h"
+#include "model/GOCacheObject.h"
+
+#include "GOAlloc.h"
+#include "GOMemoryPool.h"
+
+GOCacheLoadWorker::GOCacheLoadWorker(
+  GOCache &cache, GOMemoryPool &pool, GOCacheLoadJobDistributor &distributor)
+  : r_cache(cache),
+    m_pool(pool),
+    m_distributor(distributor),
+    m_OutOfMemory(false) {}
+
+bool GOCacheLoadWorker::LoadNextObject(GOCacheLoadJob *&pJob) {
+  if (
+    !m_OutOfMemory && !m_pool.IsPoolFull()
+    && (pJob = m_distributor.FetchNext())) {
+    try {
+      // a failed job leaves the object for loading from the files
+      pJob->m_IsLoaded = r_cache.Seek(pJob->m_offset)
+        && pJob->p_object->LoadFromCacheWithoutExc(m_pool, r_cache);
+    } catch (GOOutOfMemory e) {
+      m_OutOfMemory = true;
+      // the other workers stop too
+      m_distributor.Break();
+    }
+  }
+  return pJob && !m_OutOfMemory;
+}
+
+void GOCacheLoadWorker::CheckOutOfMemory() const {
+  if (m_OutOfMemory)
+    throw GOOutOfMemory();
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright 2006 Milan Digital Audio LLC
+ * Copyright 2009-2025 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#ifndef GOCACHELOADWORKER_H
+#define GOCACHELOADWORKER_H
+
+#include <cstdint>
+
+#include "GOObjectDistributor.h"
+
+class GOCache;
+class GOCacheObject;
+class GOMemoryPool;
+
+/* An object to be loaded from its record in the cache */
+struct GOCacheLoadJob {
+  // the index of the object in the organ cache objects
+  unsigned m_ObjectIndex;
+  GOCacheObject *p_object;
+  // the position of the record in the cache
+  uint64_t m_offset;
+  bool m_IsLoaded;
+};
+
+using GOCacheLoadJobDistributor = GOObjectDistributor<GOCacheLoadJob>;
+
+/**
+ * A class for loading objects from the cache records taken from
+ * GOCacheLoadJobDistributor. Each worker has its own reader of the cache, so
+ * several workers may load objects from one cache in parallel
+ */
+
+class GOCacheLoadWorker {
+private:
+  GOCache &r_cache;
+  GOMemoryPool &m_pool;
+  GOCacheLoadJobDistributor &m_distributor;
+
+  bool m_OutOfMemory;
+
+public:
+  GOCacheLoadWorker(
+    GOCache &cache, GOMemoryPool &pool, GOCacheLoadJobDistributor &distributor);
+
+  /**
+   * Takes a next job from m_distributor that has not been taken by any worker
+   *   and loads the object from the cache record. Sets m_IsLoaded of the job
+   * @param pJob - the job tried to be done
+   * @return true if the loading may continue
+   *   false if there are no more jobs or there was GOOutOfMemory
+   */
+  bool LoadNextObject(GOCacheLoadJob *&pJob);
+
+  /**
+   * If there was GOOutOfMemory then rethrows it
+   * Otherwise does nothing
+   */
+  void CheckOutOfMemory() const;
+};
+
+#endif /* GOCACHELOADWORKER_H */
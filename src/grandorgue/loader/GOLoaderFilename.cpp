@@ -32,18 +32,15 @@ void GOLoaderFilename::Hash(GOHash &hash) const {
   hash.Update(m_path);
 }
 
-std::unique_ptr<GOOpenedFile> GOLoaderFilename::Open(
+wxString GOLoaderFilename::GenerateHostPath(
   const GOFileStore &fileStore) const {
-  GOOpenedFile *file;
+  wxString res;
 
-  assert(m_RootKind != ROOT_UNKNOWN);
   if (m_RootKind == ROOT_ODF && fileStore.AreArchivesUsed()) {
     GOArchive *const archive = fileStore.FindArchiveContaining(m_path);
 
-    if (!archive)
-      throw wxString::Format(
-        _("File %s is not found in the organ package archives"), m_path);
-    file = archive->OpenFile(m_path);
+    if (archive)
+      res = archive->GetPath();
   } else {
     wxString baseDir;
 
@@ -51,8 +48,37 @@ std::unique_ptr<GOOpenedFile> GOLoaderFilename::Open(
       baseDir = fileStore.GetDirectory();
     else if (m_RootKind == ROOT_RESOURCE)
       baseDir = fileStore.GetResourceDirectory();
+    res = generateFullPath(m_path, baseDir);
+  }
+  return res;
+}
+
+void GOLoaderFilename::HashStamp(
+  const GOFileStore &fileStore, GOHash &hash) const {
+  const wxFileName hostFile(GenerateHostPath(fileStore));
+
+  // a missing file is hashed as empty, so it is reported at loading
+  if (hostFile.IsOk() && hostFile.FileExists()) {
+    hash.Update((unsigned long long)hostFile.GetSize().GetValue());
+    hash.Update(
+      (long long)hostFile.GetModificationTime().GetValue().GetValue());
+  }
+}
 
-    wxString fullPath = generateFullPath(m_path, baseDir);
+std::unique_ptr<GOOpenedFile> GOLoaderFilename::Open(
+  const GOFileStore &fileStore) const {
+  GOOpenedFile *file;
+
+  assert(m_RootKind != ROOT_UNKNOWN);
+  if (m_RootKind == ROOT_ODF && fileStore.AreArchivesUsed()) {
+    GOArchive *const archive = fileStore.FindArchiveContaining(m_path);
+
+    if (!archive)
+      throw wxString::Format(
+        _("File %s is not found in the organ package archives"), m_path);
+    file = archive->OpenFile(m_path);
+  } else {
+    wxString fullPath = GenerateHostPath(fileStore);
 
     if (fullPath.IsEmpty())
       throw _("File name is empty");
@@ -38,6 +38,10 @@ private:
 
   void Assign(const RootKind rootKind, const wxString &path);
 
+  /* Returns the path of the file in the host filesystem or the path of the
+   * archive containing the file */
+  wxString GenerateHostPath(const GOFileStore &fileStore) const;
+
 public:
   void Assign(const wxString &path) { Assign(ROOT_ODF, path); }
   void AssignResource(const wxString &path) { Assign(ROOT_RESOURCE, path); }
@@ -46,6 +50,13 @@ public:
   const wxString &GetPath() const { return m_path; }
   void Hash(GOHash &hash) const;
 
+  /**
+   * Adds the size and the modification time of the file to the hash, so the
+   * hash changes when the file is replaced. The archive file is used for the
+   * files inside the archives
+   */
+  void HashStamp(const GOFileStore &fileStore, GOHash &hash) const;
+
   /**
    * Opens Searches the file and opens it. If the file does not exist then
    *   throws an exception
@@ -1,6 +1,6 @@
 /*
  * Copyright 2006 Milan Digital Audio LLC
- * Copyright 2009-2023 GrandOrgue contributors (see AUTHORS)
+ * Copyright 2009-2026 GrandOrgue contributors (see AUTHORS)
  * License GPL-2.0 or later
  * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
  */
@@ -8,68 +8,90 @@
 #include "GOCache.h"
 
 #include <wx/wfstream.h>
-#include <wx/zstream.h>
+#include <zlib.h>
 
 #include "GOAlloc.h"
 #include "GOMemoryPool.h"
 #include "go_defs.h"
 
-GOCache::GOCache(wxFile &cache_file, GOMemoryPool &pool)
+// the length of the magic
+static constexpr wxFileOffset HEADER_LENGTH = sizeof(int);
+
+GOCache::GOCache(
+  wxFile &cache_file, GOMemoryPool &pool, bool isMappingAllowed)
   : m_stream(0),
-    m_fstream(0),
-    m_zstream(0),
     m_pool(pool),
     m_Mapable(false),
-    m_OK(false) {
+    m_IsPacked(false),
+    m_OK(false),
+    m_Pos(0) {
   int magic;
 
-  m_stream = m_fstream = new wxFileInputStream(cache_file);
-
-  m_fstream->Read(&magic, sizeof(magic));
-  if (
-    m_fstream->LastRead() == sizeof(magic) && magic == GRANDORGUE_CACHE_MAGIC) {
-    m_Mapable = true;
-    m_OK = true;
-  } else {
-    m_fstream->SeekI(0, wxFromStart);
-    m_stream = m_zstream = new wxZlibInputStream(*m_fstream);
-    if (m_fstream->IsOk() && m_zstream->IsOk()) {
-      m_zstream->Read(&magic, sizeof(magic));
-      if (
-        m_zstream->LastRead() == sizeof(magic)
-        && magic == GRANDORGUE_CACHE_MAGIC) {
-        m_Mapable = false;
-        m_OK = true;
-      }
-    }
+  m_stream = new wxFileInputStream(cache_file);
+  m_stream->Read(&magic, sizeof(magic));
+  if (m_stream->LastRead() == sizeof(magic)) {
+    m_IsPacked = magic == GRANDORGUE_CACHE_MAGIC_PACKED;
+    m_OK = m_IsPacked || magic == GRANDORGUE_CACHE_MAGIC;
   }
 
-  if (!m_OK || m_stream->TellI() == wxInvalidOffset)
-    m_Mapable = false;
+  // only the raw blocks may be used directly from the mapped file
+  m_Mapable = m_OK && !m_IsPacked && isMappingAllowed
+    && m_stream->TellI() != wxInvalidOffset;
   if (m_Mapable)
     m_Mapable = m_pool.SetCacheFile(cache_file);
 }
 
+GOCache::GOCache(wxFile &cache_file, const GOCache &mainReader)
+  : m_stream(0),
+    m_pool(mainReader.m_pool),
+    m_Mapable(mainReader.m_Mapable),
+    m_IsPacked(mainReader.m_IsPacked),
+    m_OK(false),
+    m_Pos(0) {
+  int magic;
+
+  m_stream = new wxFileInputStream(cache_file);
+  m_stream->Read(&magic, sizeof(magic));
+  m_OK = mainReader.m_OK && m_stream->LastRead() == sizeof(magic)
+    && magic
+      == (m_IsPacked ? GRANDORGUE_CACHE_MAGIC_PACKED : GRANDORGUE_CACHE_MAGIC);
+  if (!m_OK)
+    m_Mapable = false;
+}
+
 GOCache::~GOCache() { Close(); }
 
 bool GOCache::ReadHeader() { return m_OK; }
 
 void GOCache::Close() {
-  if (m_zstream)
-    delete m_zstream;
-  m_zstream = 0;
-  if (m_fstream)
-    delete m_fstream;
-  m_fstream = 0;
+  if (m_stream)
+    delete m_stream;
+  m_stream = 0;
 }
 
 bool GOCache::Read(void *data, unsigned length) {
   m_stream->Read(data, length);
+  m_Pos += m_stream->LastRead();
   if (m_stream->LastRead() != length)
     return false;
   return true;
 }
 
+uint64_t GOCache::GetLength() const {
+  const wxFileOffset length = m_stream->GetLength();
+
+  return length > HEADER_LENGTH ? length - HEADER_LENGTH : 0;
+}
+
+bool GOCache::Seek(uint64_t pos) {
+  if (
+    m_stream->SeekI(HEADER_LENGTH + (wxFileOffset)pos, wxFromStart)
+    == wxInvalidOffset)
+    return false;
+  m_Pos = pos;
+  return true;
+}
+
 void GOCache::FreeCacheFile() {
   m_Mapable = false;
   m_pool.FreeCacheFile();
@@ -80,6 +102,7 @@ void *GOCache::ReadBlock(unsigned length) {
     void *data = m_pool.GetCacheData(m_stream->TellI(), length);
     if (data) {
       m_stream->SeekI(length, wxFromCurrent);
+      m_Pos += length;
       return data;
     }
   }
@@ -87,10 +110,71 @@ void *GOCache::ReadBlock(unsigned length) {
   if (data == NULL)
     throw GOOutOfMemory();
 
-  m_stream->Read(data, length);
-  if (m_stream->LastRead() != length) {
+  if (!ReadBlock(data, length)) {
     m_pool.Free(data);
     return NULL;
   }
   return data;
 }
+
+void *GOCache::ReadSharedBlock(unsigned length, bool &isShared) {
+  isShared = false;
+  if (m_Mapable)
+    // the mapped cache is shared by the page cache anyway
+    return ReadBlock(length);
+
+  // read into the reused buffer, so only a new block is allocated and copied
+  if (m_SharedBuffer.size() < length)
+    m_SharedBuffer.resize(length);
+  if (!ReadBlock(m_SharedBuffer.data(), length))
+    return NULL;
+
+  void *data = m_pool.CopyToPoolShared(m_SharedBuffer.data(), length, isShared);
+
+  if (data == NULL)
+    throw GOOutOfMemory();
+  return data;
+}
+
+bool GOCache::SkipRawBlock(unsigned length, uint64_t &filePos) {
+  const uint64_t blockPos = m_Pos;
+
+  if (m_IsPacked) {
+    uint32_t packedLength;
+
+    if (!Read(&packedLength, sizeof(packedLength)) || packedLength != length) {
+      Seek(blockPos);
+      return false;
+    }
+  }
+  filePos = HEADER_LENGTH + m_Pos;
+  if (m_Pos + length > GetLength()) {
+    Seek(blockPos);
+    return false;
+  }
+  return Seek(m_Pos + length);
+}
+
+bool GOCache::ReadBlock(void *data, unsigned length) {
+  if (!m_IsPacked)
+    return Read(data, length);
+
+  uint32_t packedLength;
+
+  if (!Read(&packedLength, sizeof(packedLength)))
+    return false;
+  if (packedLength == length)
+    // the block has been stored as is
+    return Read(data, length);
+  if (m_PackedBuffer.size() < packedLength)
+    m_PackedBuffer.resize(packedLength);
+
+  // unpack straight into the destination
+  uLongf unpackedLength = length;
+
+  return Read(m_PackedBuffer.data(), packedLength)
+    && uncompress(
+         (Bytef *)data, &unpackedLength, m_PackedBuffer.data(), packedLength)
+    == Z_OK
+    && unpackedLength == length;
+}
@@ -1,6 +1,6 @@
 /*
  * Copyright 2006 Milan Digital Audio LLC
- * Copyright 2009-2023 GrandOrgue contributors (see AUTHORS)
+ * Copyright 2009-2026 GrandOrgue contributors (see AUTHORS)
  * License GPL-2.0 or later
  * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
  */
@@ -8,20 +8,35 @@
 #ifndef GOCACHE_H_
 #define GOCACHE_H_
 
+#include <cstdint>
+#include <vector>
+
 class GOMemoryPool;
 class wxFile;
 class wxInputStream;
 
 class GOCache {
   wxInputStream *m_stream;
-  wxInputStream *m_fstream;
-  wxInputStream *m_zstream;
   GOMemoryPool &m_pool;
   bool m_Mapable;
+  // whether the blocks are compressed one by one
+  bool m_IsPacked;
   bool m_OK;
+  // the number of bytes read after the header
+  uint64_t m_Pos;
+  // the packed data of the block being read
+  std::vector<unsigned char> m_PackedBuffer;
+  // the unpacked data of the block being shared
+  std::vector<unsigned char> m_SharedBuffer;
 
 public:
-  GOCache(wxFile &cache_file, GOMemoryPool &pool);
+  /* isMappingAllowed=false prevents mapping the whole uncompressed cache file
+   * into the memory, f.e. when the samples are streamed */
+  GOCache(
+    wxFile &cache_file, GOMemoryPool &pool, bool isMappingAllowed = true);
+  /* Creates an additional reader of the same cache file for loading in
+   * parallel. It uses the mapping of the main reader */
+  GOCache(wxFile &cache_file, const GOCache &mainReader);
   virtual ~GOCache();
 
   bool ReadHeader();
@@ -30,6 +45,35 @@ public:
   bool Read(void *data, unsigned length);
   /* Allocate and read a block written by WriteBlock */
   void *ReadBlock(unsigned length);
+  /**
+   * Reads a block written by WriteBlock like ReadBlock, but a block identical
+   * to one shared before does not take the pool memory again (see
+   * GOMemoryPool::CopyToPoolShared). The block must not be changed
+   * @param isShared is set if the block shared before is returned
+   */
+  void *ReadSharedBlock(unsigned length, bool &isShared);
+  /* Read a block written by WriteBlock into the buffer of length bytes */
+  bool ReadBlock(void *data, unsigned length);
+
+  /**
+   * Skips a block written by WriteBlock if it is stored unpacked, so it may be
+   * read directly from the cache file later
+   * @param filePos the offset of the data from the beginning of the file
+   * @return false and remains at the block if it is packed or truncated
+   */
+  bool SkipRawBlock(unsigned length, uint64_t &filePos);
+
+  /* The current position in the cache counted from the end of the header */
+  uint64_t GetPos() const { return m_Pos; }
+
+  /* The length of the cache counted from the end of the header */
+  uint64_t GetLength() const;
+
+  /**
+   * Moves the reader to the position
+   * @return false if the position is not reachable
+   */
+  bool Seek(uint64_t pos);
 
   void Close();
 };
@@ -12,6 +12,7 @@
 #include <wx/filename.h>
 #include <wx/intl.h>
 #include <wx/log.h>
+#include <wx/utils.h>
 
 #include "GOOrgan.h"
 #include "archive/GOArchiveFile.h"
@@ -60,6 +61,11 @@ void GOCacheCleaner::Cleanup() {
           } else if (fn.GetExt() == wxT("cache")) {
             if (organs.Index(fn.GetName().Mid(0, 40)) == wxNOT_FOUND)
               wxRemoveFile(dir.GetNameWithSep() + name);
+          } else if (fn.GetExt() == wxT("stream")) {
+            // a stream file of a crashed session: the own one is still in use
+            if (!fn.GetName().EndsWith(
+                  wxString::Format(wxT("-%lu"), wxGetProcessId())))
+              wxRemoveFile(dir.GetNameWithSep() + name);
           } else
             wxLogError(
               _("Unexpected file in the cache directory: %s"), name.c_str());
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2026 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#include "GOCacheIndex.h"
+
+#include <string>
+#include <unordered_map>
+
+#include "GOCache.h"
+#include "GOCacheWriter.h"
+
+static std::string key_to_string(const GOHashType &key) {
+  return std::string((const char *)key.hash, sizeof(key.hash));
+}
+
+void GOCacheIndex::Add(const GOHashType &key, uint64_t offset) {
+  m_records.push_back({key, offset});
+}
+
+bool GOCacheIndex::Write(GOCacheWriter &writer) const {
+  const uint64_t tablePos = writer.GetPos();
+  const unsigned nRecords = m_records.size();
+
+  if (!writer.Write(&nRecords, sizeof(nRecords)))
+    return false;
+  for (const Record &record : m_records)
+    if (
+      !writer.Write(&record.m_key, sizeof(record.m_key))
+      || !writer.Write(&record.m_offset, sizeof(record.m_offset)))
+      return false;
+  return writer.Write(&tablePos, sizeof(tablePos));
+}
+
+bool GOCacheIndex::Read(GOCache &reader) {
+  uint64_t tablePos;
+  unsigned nRecords;
+
+  m_records.clear();
+  if (
+    reader.GetLength() < sizeof(tablePos)
+    || !reader.Seek(reader.GetLength() - sizeof(tablePos))
+    || !reader.Read(&tablePos, sizeof(tablePos)) || !reader.Seek(tablePos)
+    || !reader.Read(&nRecords, sizeof(nRecords)))
+    return false;
+  // each record takes at least a key, so a broken count is not allocated
+  if (nRecords > (reader.GetLength() - tablePos) / sizeof(GOHashType))
+    return false;
+  m_records.resize(nRecords);
+  for (Record &record : m_records)
+    if (
+      !reader.Read(&record.m_key, sizeof(record.m_key))
+      || !reader.Read(&record.m_offset, sizeof(record.m_offset))) {
+      m_records.clear();
+      return false;
+    }
+  return true;
+}
+
+std::vector<GOCacheIndex::Match> GOCacheIndex::FindObjects(
+  const std::vector<GOHashType> &keys) const {
+  // the indices of the objects waiting for a record with their key
+  std::unordered_map<std::string, std::vector<unsigned>> waitingObjects;
+  std::vector<Match> matches;
+
+  for (unsigned i = keys.size(); i > 0; i--)
+    waitingObjects[key_to_string(keys[i - 1])].push_back(i - 1);
+  for (const Record &record : m_records) {
+    auto it = waitingObjects.find(key_to_string(record.m_key));
+
+    if (it != waitingObjects.end() && !it->second.empty()) {
+      matches.push_back({it->second.back(), record.m_offset});
+      it->second.pop_back();
+    }
+  }
+  return matches;
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright 2026 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#ifndef GOCACHEINDEX_H_
+#define GOCACHEINDEX_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "GOHash.h"
+
+class GOCache;
+class GOCacheWriter;
+
+/**
+ * The table of the objects stored in the cache. Each object is found by its
+ * key, so only the changed objects are loaded from the files.
+ * The table follows the objects, and the last value of the cache is the
+ * position of the table
+ */
+class GOCacheIndex {
+public:
+  // an object found in the cache
+  struct Match {
+    // the index of the object in the list passed to FindObjects()
+    unsigned m_ObjectIndex;
+    // the position of the object data in the cache
+    uint64_t m_offset;
+  };
+
+private:
+  struct Record {
+    GOHashType m_key;
+    uint64_t m_offset;
+  };
+
+  std::vector<Record> m_records;
+
+public:
+  unsigned GetNRecords() const { return m_records.size(); }
+
+  /* Adds an object stored at the position of the cache */
+  void Add(const GOHashType &key, uint64_t offset);
+
+  /* Writes the table at the current position of the cache */
+  bool Write(GOCacheWriter &writer) const;
+
+  /* Reads the table from the end of the cache */
+  bool Read(GOCache &reader);
+
+  /**
+   * Finds the records of the objects with the keys. Several objects with the
+   * same key get different records
+   * @return the objects found in the order of their records
+   */
+  std::vector<Match> FindObjects(const std::vector<GOHashType> &keys) const;
+};
+
+#endif
@@ -7,46 +7,71 @@
 
 #include "GOCacheWriter.h"
 
-#include <wx/zstream.h>
+#include <wx/stream.h>
+#include <zlib.h>
 
 #include "go_defs.h"
 
 GOCacheWriter::GOCacheWriter(wxOutputStream &stream, bool compressed)
-  : m_zstream(0), m_stream(&stream) {
-  if (compressed) {
-    m_zstream = new wxZlibOutputStream(stream);
-    m_stream = m_zstream;
-  }
-}
+  : m_stream(&stream), m_IsPacked(compressed), m_Pos(0) {}
 
 GOCacheWriter::~GOCacheWriter() { Close(); }
 
 bool GOCacheWriter::WriteHeader() {
-  int magic = GRANDORGUE_CACHE_MAGIC;
+  int magic
+    = m_IsPacked ? GRANDORGUE_CACHE_MAGIC_PACKED : GRANDORGUE_CACHE_MAGIC;
   if (!Write(&magic, sizeof(magic)))
     return false;
+  m_Pos = 0;
   return true;
 }
 
 bool GOCacheWriter::Write(const void *data, unsigned length) {
   m_stream->Write(data, length);
+  m_Pos += m_stream->LastWrite();
   if (m_stream->LastWrite() != length)
     return false;
   return true;
 }
 
-bool GOCacheWriter::WriteBlock(const void *data, unsigned length) {
-  m_stream->Write(data, length);
-  if (m_stream->LastWrite() != length)
-    return false;
-  return true;
+bool GOCacheWriter::WriteBlock(
+  const void *data, unsigned length, bool isToPack) {
+  if (!m_IsPacked)
+    return Write(data, length);
+  if (!isToPack) {
+    uint32_t storedLength = length;
+
+    return Write(&storedLength, sizeof(storedLength)) && Write(data, length);
+  }
+
+  /* Each block is preceded with its packed length. A block that does not
+   * become shorter is stored as is with the packed length equal to length */
+  uLongf packedLength = compressBound(length);
+
+  if (m_PackedBuffer.size() < packedLength)
+    m_PackedBuffer.resize(packedLength);
+  if (
+    compress2(
+      m_PackedBuffer.data(),
+      &packedLength,
+      (const Bytef *)data,
+      length,
+      Z_BEST_SPEED)
+      != Z_OK
+    || packedLength >= length) {
+    uint32_t storedLength = length;
+
+    return Write(&storedLength, sizeof(storedLength)) && Write(data, length);
+  }
+
+  uint32_t storedLength = packedLength;
+
+  return Write(&storedLength, sizeof(storedLength))
+    && Write(m_PackedBuffer.data(), storedLength);
 }
 
 void GOCacheWriter::Close() {
   if (m_stream)
     m_stream->Close();
-  if (m_zstream)
-    delete m_zstream;
-  m_zstream = 0;
   m_stream = 0;
 }
@@ -8,20 +8,34 @@
 #ifndef GOCACHEWRITER_H_
 #define GOCACHEWRITER_H_
 
+#include <cstdint>
+#include <vector>
+
 class wxOutputStream;
 
 class GOCacheWriter {
-  wxOutputStream *m_zstream;
   wxOutputStream *m_stream;
+  // whether the blocks are compressed one by one
+  bool m_IsPacked;
+  // the number of bytes written after the header
+  uint64_t m_Pos;
+  std::vector<unsigned char> m_PackedBuffer;
 
 public:
+  /* compressed=true compresses each block written by WriteBlock separately,
+   * so the metadata remains uncompressed and the blocks can be unpacked in
+   * parallel */
   GOCacheWriter(wxOutputStream &stream, bool compressed);
   virtual ~GOCacheWriter();
 
   bool WriteHeader();
   bool Write(const void *data, unsigned length);
-  /* Write an bigger malloced block */
-  bool WriteBlock(const void *data, unsigned length);
+  /* Write an bigger malloced block. isToPack=false stores it unpacked even in
+   * a compressed cache, so it may be read directly from the cache file */
+  bool WriteBlock(const void *data, unsigned length, bool isToPack = true);
+
+  /* The current position in the cache counted from the end of the header */
+  uint64_t GetPos() const { return m_Pos; }
 
   void Close();
 };
@@ -7,11 +7,14 @@
 
 #include "GOMidiReceiver.h"
 
+#include <algorithm>
+
 #include "config/GOConfig.h"
 #include "config/GOConfigReader.h"
 #include "config/GOConfigWriter.h"
 #include "midi/GOMidiMap.h"
 #include "midi/events/GOMidiEvent.h"
+#include "midi/events/GOMidiRoute.h"
 #include "midi/events/GORodgers.h"
 #include "yaml/go-wx-yaml.h"
 
@@ -64,6 +67,8 @@ static const GOConfigEnum MIDI_RECEIVE_TYPES({
   {wxT("NoteNormal"), MIDI_M_NOTE_NORMAL},
 });
 
+std::atomic_uint GOMidiReceiver::s_MatchingVersion(0);
+
 GOMidiReceiver::GOMidiReceiver(GOMidiReceiverType type)
   : GOMidiReceiverEventPatternList(type), m_ElementID(-1) {}
 
@@ -190,6 +195,7 @@ void GOMidiReceiver::Load(
             127));
     }
   }
+  s_MatchingVersion.fetch_add(1);
 }
 
 void GOMidiReceiver::Save(
@@ -373,6 +379,7 @@ void GOMidiReceiver::FromYaml(
       }
     }
   }
+  s_MatchingVersion.fetch_add(1);
 }
 
 bool GOMidiReceiver::hasChannel(GOMidiReceiverMessageType type) {
@@ -588,6 +595,71 @@ unsigned GOMidiReceiver::createInternal(unsigned device) {
   return pos;
 }
 
+bool GOMidiReceiver::RenewFrom(const GOMidiReceiverEventPatternList &newList) {
+  const bool result = GOMidiReceiverEventPatternList::RenewFrom(newList);
+
+  if (result)
+    s_MatchingVersion.fetch_add(1);
+  return result;
+}
+
+static bool is_note_type(GOMidiReceiverMessageType type) {
+  return type == MIDI_M_NOTE || type == MIDI_M_NOTE_ON
+    || type == MIDI_M_NOTE_OFF || type == MIDI_M_NOTE_ON_OFF
+    || type == MIDI_M_NOTE_FIXED_ON || type == MIDI_M_NOTE_FIXED_OFF;
+}
+
+static bool is_ctrl_type(GOMidiReceiverMessageType type) {
+  return type == MIDI_M_CTRL_CHANGE || type == MIDI_M_CTRL_CHANGE_ON
+    || type == MIDI_M_CTRL_CHANGE_OFF || type == MIDI_M_CTRL_CHANGE_ON_OFF
+    || type == MIDI_M_CTRL_CHANGE_FIXED || type == MIDI_M_CTRL_CHANGE_FIXED_ON
+    || type == MIDI_M_CTRL_CHANGE_FIXED_OFF
+    || type == MIDI_M_CTRL_CHANGE_FIXED_ON_OFF || type == MIDI_M_CTRL_BIT;
+}
+
+static bool is_manual_note_type(GOMidiReceiverMessageType type) {
+  return type == MIDI_M_NOTE || type == MIDI_M_NOTE_NO_VELOCITY
+    || type == MIDI_M_NOTE_SHORT_OCTAVE || type == MIDI_M_NOTE_NORMAL;
+}
+
+bool GOMidiReceiver::GetRoutes(std::vector<GOMidiRoute> &routes) const {
+  // the events set up with sysex are not indexed
+  if (!m_Internal.empty())
+    return false;
+  // must follow the pattern checks of Match()
+  for (const auto &pattern : m_events) {
+    const bool isChannelChecked
+      = pattern.channel != -1 && hasChannel(pattern.type);
+    const int channel = isChannelChecked ? pattern.channel : -1;
+    const unsigned device = pattern.deviceId;
+
+    if (m_type == MIDI_RECV_MANUAL) {
+      if (is_manual_note_type(pattern.type)) {
+        for (int key = std::max(pattern.low_key, 0);
+             key <= std::min(pattern.high_key, 127);
+             key++) {
+          routes.emplace_back(device, GOMidiEvent::MIDI_NOTE, channel, key);
+          routes.emplace_back(
+            device, GOMidiEvent::MIDI_AFTERTOUCH, channel, key);
+        }
+        routes.emplace_back(
+          device, GOMidiEvent::MIDI_CTRL_CHANGE, channel, MIDI_CTRL_NOTES_OFF);
+        routes.emplace_back(
+          device, GOMidiEvent::MIDI_CTRL_CHANGE, channel, MIDI_CTRL_SOUNDS_OFF);
+      }
+    } else if (m_type == MIDI_RECV_ENCLOSURE) {
+      if (pattern.type == MIDI_M_CTRL_CHANGE)
+        routes.emplace_back(
+          device, GOMidiEvent::MIDI_CTRL_CHANGE, channel, pattern.key);
+    } else if (is_note_type(pattern.type))
+      routes.emplace_back(device, GOMidiEvent::MIDI_NOTE, channel, pattern.key);
+    else if (is_ctrl_type(pattern.type))
+      routes.emplace_back(
+        device, GOMidiEvent::MIDI_CTRL_CHANGE, channel, pattern.key);
+  }
+  return true;
+}
+
 GOMidiMatchType GOMidiReceiver::Match(const GOMidiEvent &e) {
   int key;
   int value;
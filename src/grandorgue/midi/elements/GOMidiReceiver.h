@@ -8,7 +8,9 @@
 #ifndef GOMIDIRECEIVER_H
 #define GOMIDIRECEIVER_H
 
+#include <atomic>
 #include <cstdint>
+#include <vector>
 
 #include "config/GOConfigEnum.h"
 #include "midi/events/GOMidiMatchType.h"
@@ -21,6 +23,7 @@ class GOConfigReader;
 class GOConfigWriter;
 class GOMidiEvent;
 class GOMidiMap;
+struct GOMidiRoute;
 
 class GOMidiReceiver : public GOMidiReceiverEventPatternList,
                        public GOMidiElement {
@@ -36,6 +39,9 @@ private:
     int key;
   } midi_internal_match;
 
+  // is incremented on each change of the events any receiver may match
+  static std::atomic_uint s_MatchingVersion;
+
   int m_ElementID;
   std::vector<GOTime> m_last;
   std::vector<midi_internal_match> m_Internal;
@@ -69,6 +75,17 @@ public:
 
   void SetElementID(int id) { m_ElementID = id; }
 
+  bool RenewFrom(const GOMidiReceiverEventPatternList &newList);
+
+  static unsigned getMatchingVersion() { return s_MatchingVersion.load(); }
+
+  /**
+   * Lists the note, aftertouch and control change events Match() may match
+   * @param routes the list to add the routes to
+   * @return false if the receiver may match any such event
+   */
+  bool GetRoutes(std::vector<GOMidiRoute> &routes) const;
+
   GOMidiMatchType Match(const GOMidiEvent &e);
   GOMidiMatchType Match(
     const GOMidiEvent &e,
@@ -19,6 +19,7 @@ GOMidiEvent::GOMidiEvent()
     m_key(-1),
     m_value(-1),
     m_time(0),
+    m_ReceiveTime(),
     m_string(),
     m_data(),
     m_IsToUseNoteOff(true),
@@ -31,6 +32,7 @@ GOMidiEvent::GOMidiEvent(const GOMidiEvent &e)
     m_value(e.m_value),
     m_device(e.m_device),
     m_time(e.m_time),
+    m_ReceiveTime(e.m_ReceiveTime),
     m_string(e.m_string.Clone()),
     m_data(e.m_data),
     m_IsToUseNoteOff(e.m_IsToUseNoteOff),
@@ -8,6 +8,7 @@
 #ifndef GOMIDIEVENT_H
 #define GOMIDIEVENT_H
 
+#include <chrono>
 #include <cstdint>
 #include <vector>
 
@@ -53,6 +54,8 @@ private:
   int m_channel, m_key, m_value;
   unsigned m_device;
   GOTime m_time;
+  // the precise moment of receiving the event from the midi port
+  std::chrono::steady_clock::time_point m_ReceiveTime;
   wxString m_string;
   std::vector<uint8_t> m_data;
   bool m_IsToUseNoteOff;
@@ -85,6 +88,13 @@ public:
   GOTime GetTime() const { return m_time; }
   void SetTime(GOTime t) { m_time = t; }
 
+  std::chrono::steady_clock::time_point GetReceiveTime() const {
+    return m_ReceiveTime;
+  }
+  void SetReceiveTime(std::chrono::steady_clock::time_point t) {
+    m_ReceiveTime = t;
+  }
+
   const wxString &GetString() const { return m_string; }
   void SetString(const wxString &str) { m_string = str; }
   void SetString(const wxString &str, unsigned length);
@@ -0,0 +1,36 @@
+/*
+ * Copyright 2026 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#ifndef GOMIDIROUTE_H
+#define GOMIDIROUTE_H
+
+#include "GOMidiEvent.h"
+
+/**
+ * A set of midi events an event handler may react on. The frequent events
+ * (notes, aftertouch and control changes) are dispatched only to the handlers
+ * having a matching route
+ */
+struct GOMidiRoute {
+  // 0 means any device
+  unsigned device;
+  GOMidiEvent::MidiType type;
+  // -1 means any channel
+  int channel;
+  int key;
+
+  GOMidiRoute(
+    unsigned routeDevice, GOMidiEvent::MidiType routeType, int ch, int k)
+    : device(routeDevice), type(routeType), channel(ch), key(k) {}
+
+  static bool isRoutedType(GOMidiEvent::MidiType type) {
+    return type == GOMidiEvent::MIDI_NOTE
+      || type == GOMidiEvent::MIDI_AFTERTOUCH
+      || type == GOMidiEvent::MIDI_CTRL_CHANGE;
+  }
+};
+
+#endif /* GOMIDIROUTE_H */
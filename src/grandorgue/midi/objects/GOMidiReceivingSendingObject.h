@@ -63,6 +63,9 @@ protected:
 
 private:
   void ProcessMidi(const GOMidiEvent &event) override;
+  bool GetMidiRoutes(std::vector<GOMidiRoute> &routes) const override {
+    return m_receiver.GetRoutes(routes);
+  }
 
 protected:
   virtual void OnMidiReceived(
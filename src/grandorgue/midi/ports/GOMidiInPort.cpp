@@ -35,6 +35,7 @@ void GOMidiInPort::Receive(const std::vector<unsigned char> msg) {
     return;
   e.SetDevice(GetID());
   e.SetTime(wxGetLocalTimeMillis());
+  e.SetReceiveTime(std::chrono::steady_clock::now());
 
   if (!m_merger.Process(e))
     return;
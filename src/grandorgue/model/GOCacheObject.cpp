@@ -37,6 +37,21 @@ const wxString GOCacheObject::GenerateMessage(const wxString &srcMsg) const {
   return res;
 }
 
+void GOCacheObject::StampSources(const GOFileStore &fileStore) {
+  GOHash hash;
+
+  UpdateSourceHash(fileStore, hash);
+  m_SourceHash = hash.getHash();
+}
+
+GOHashType GOCacheObject::GetCacheKey() const {
+  GOHash hash;
+
+  UpdateHash(hash);
+  hash.Update(&m_SourceHash, sizeof(m_SourceHash));
+  return hash.getHash();
+}
+
 bool GOCacheObject::InitWithoutExc() {
   InitBeforeLoad();
   try {
@@ -57,6 +72,8 @@ bool GOCacheObject::InitWithoutExc() {
 bool GOCacheObject::LoadFromFileWithoutExc(
   const GOFileStore &fileStore, GOMemoryPool &pool) {
   InitBeforeLoad();
+  // before loading, so a file changed meanwhile does not match the cache
+  StampSources(fileStore);
   try {
     LoadData(fileStore, pool);
     m_IsReady = true;
@@ -12,10 +12,11 @@
 
 #include "loader/GOLoaderFilename.h"
 
+#include "GOHash.h"
+
 class GOCache;
 class GOCacheWriter;
 class GOFileStore;
-class GOHash;
 class GOMemoryPool;
 
 class GOCacheObject {
@@ -30,6 +31,9 @@ private:
 
   wxString m_LoadError;
 
+  // the state of the source files when the object was loaded
+  GOHashType m_SourceHash = {};
+
   void InitBeforeLoad();
 
 protected:
@@ -38,6 +42,10 @@ protected:
   virtual void LoadData(const GOFileStore &fileStore, GOMemoryPool &pool) = 0;
   virtual bool LoadCache(GOMemoryPool &pool, GOCache &cache) = 0;
 
+  /* Adds the sizes and the modification times of the source files */
+  virtual void UpdateSourceHash(
+    const GOFileStore &fileStore, GOHash &hash) const {}
+
 public:
   virtual ~GOCacheObject() {}
 
@@ -70,6 +78,18 @@ public:
 
   virtual bool SaveCache(GOCacheWriter &cache) const = 0;
   virtual void UpdateHash(GOHash &hash) const = 0;
+
+  /**
+   * Remembers the state of the source files before loading the object from
+   * them or from the cache. Called by LoadFromFileWithoutExc()
+   */
+  void StampSources(const GOFileStore &fileStore);
+
+  /**
+   * Returns the key the object is stored in the cache under. It changes when
+   * the settings of the object or its source files change
+   */
+  GOHashType GetCacheKey() const;
   virtual const wxString &GetLoadTitle() const = 0;
 
   // Returns the message string prefixed with group and keyPrefix
@@ -20,6 +20,7 @@ void GOEventHandlerList::Cleanup() {
   m_ControlChangedHandlers.Clear();
   m_MidiObjects.Clear();
   m_MidiEventHandlers.Clear();
+  m_MidiEventHandlersVersion++;
   m_SoundStateHandlers.Clear();
   m_SaveableObjects.Clear();
 }
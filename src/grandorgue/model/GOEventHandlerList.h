@@ -65,6 +65,8 @@ private:
   UPVector<GOEventHandler> m_MidiEventHandlers;
   UPVector<GOSoundStateHandler> m_SoundStateHandlers;
   UPVector<GOSaveableObject> m_SaveableObjects;
+  // is incremented on each change of m_MidiEventHandlers
+  unsigned m_MidiEventHandlersVersion = 0;
 
 public:
   const std::vector<GOCacheObject *> &GetCacheObjects() const {
@@ -83,6 +85,9 @@ public:
   const std::vector<GOEventHandler *> &GetMidiEventHandlers() const {
     return m_MidiEventHandlers.AsVector();
   }
+  unsigned GetMidiEventHandlersVersion() const {
+    return m_MidiEventHandlersVersion;
+  }
   const std::vector<GOSoundStateHandler *> &GetSoundStateHandlers() const {
     return m_SoundStateHandlers.AsVector();
   }
@@ -124,10 +129,12 @@ public:
 
   void RegisterEventHandler(GOEventHandler *handler) {
     m_MidiEventHandlers.Add(handler);
+    m_MidiEventHandlersVersion++;
   }
 
   void UnRegisterEventHandler(GOEventHandler *handler) {
     m_MidiEventHandlers.Remove(handler);
+    m_MidiEventHandlersVersion++;
   }
 
   void RegisterSoundStateHandler(GOSoundStateHandler *handler) {
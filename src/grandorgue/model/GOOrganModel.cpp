@@ -15,6 +15,7 @@
 #include "control/GOPistonControl.h"
 #include "midi/objects/GOMidiObjectContext.h"
 #include "modification/GOModificationListener.h"
+#include "sound/GOSoundStreamStore.h"
 
 #include "GODivisionalCoupler.h"
 #include "GOEnclosure.h"
@@ -8,6 +8,7 @@
 #ifndef GOORGANMODEL_H
 #define GOORGANMODEL_H
 
+#include <memory>
 #include <set>
 
 #include "ptrvector.h"
@@ -30,6 +31,7 @@ class GOGeneralButtonControl;
 class GOManual;
 class GOPistonControl;
 class GORank;
+class GOSoundStreamStore;
 class GOSwitch;
 class GOTremulant;
 class GOWindchest;
@@ -79,6 +81,8 @@ protected:
   unsigned m_FirstManual;
   unsigned m_ODFManualCount;
   unsigned m_ODFRankCount;
+  // exists only when the samples are streamed from disk
+  std::unique_ptr<GOSoundStreamStore> m_StreamStore;
 
   void Load(GOConfigReader &cfg);
 
@@ -136,6 +140,8 @@ public:
 
   GOPipeConfigNode &GetRootPipeConfigNode() { return m_RootPipeConfigNode; }
 
+  GOSoundStreamStore *GetStreamStore() const { return m_StreamStore.get(); }
+
   bool IsOrganModelModified() const { return m_OrganModelModified; }
   void SetOrganModelModified(bool modified);
   void NotifyPipeConfigModified() override { SetOrganModelModified(true); }
@@ -184,6 +190,7 @@ public:
   GOManual *GetManual(unsigned index);
 
   GORank *GetRank(unsigned index);
+  unsigned GetRankCount() const { return m_ranks.size(); }
   unsigned GetODFRankCount();
   void AddRank(GORank *rank);
 
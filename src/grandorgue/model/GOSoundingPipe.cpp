@@ -285,6 +285,7 @@ void GOSoundingPipe::Load(
 void GOSoundingPipe::LoadData(
   const GOFileStore &fileStore, GOMemoryPool &pool) {
   try {
+    m_SoundProvider.SetStreamStore(p_OrganModel->GetStreamStore());
     m_SoundProvider.LoadFromMultipleFiles(
       fileStore,
       pool,
@@ -309,6 +310,8 @@ void GOSoundingPipe::LoadData(
 
 bool GOSoundingPipe::LoadCache(GOMemoryPool &pool, GOCache &cache) {
   try {
+    m_SoundProvider.SetStreamStore(p_OrganModel->GetStreamStore());
+
     bool result = m_SoundProvider.LoadCache(pool, cache);
     if (result)
       Validate();
@@ -367,6 +370,14 @@ void GOSoundingPipe::UpdateHash(GOHash &hash) const {
   }
 }
 
+void GOSoundingPipe::UpdateSourceHash(
+  const GOFileStore &fileStore, GOHash &hash) const {
+  for (const auto &a : m_AttackFileInfos)
+    a.filename.HashStamp(fileStore, hash);
+  for (const auto &r : m_ReleaseFileInfos)
+    r.filename.HashStamp(fileStore, hash);
+}
+
 float GOSoundingPipe::GetManualTuningPitchOffset() const {
   return m_PipeConfigNode.GetEffectivePitchTuning()
     + m_PipeConfigNode.GetEffectiveManualTuning();
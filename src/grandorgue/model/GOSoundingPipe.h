@@ -80,6 +80,8 @@ private:
   void Initialize() override {}
   void LoadData(const GOFileStore &fileStore, GOMemoryPool &pool) override;
   bool LoadCache(GOMemoryPool &pool, GOCache &cache) override;
+  void UpdateSourceHash(
+    const GOFileStore &fileStore, GOHash &hash) const override;
   bool SaveCache(GOCacheWriter &cache) const override;
   void UpdateHash(GOHash &hash) const override;
 
@@ -1,6 +1,6 @@
 /*
  * Copyright 2006 Milan Digital Audio LLC
- * Copyright 2009-2025 GrandOrgue contributors (see AUTHORS)
+ * Copyright 2009-2026 GrandOrgue contributors (see AUTHORS)
  * License GPL-2.0 or later
  * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
  */
@@ -134,3 +134,9 @@ void GOTremulant::StartPlayback() {
 }
 
 GOTremulantType GOTremulant::GetTremulantType() { return m_TremulantType; }
+
+float GOTremulant::GetMaxGain() const {
+  return m_TremulantType == GOSynthTrem && m_TremProvider
+    ? ((const GOSoundProviderSynthedTrem *)m_TremProvider)->GetMaxGain()
+    : 1.0f;
+}
@@ -1,6 +1,6 @@
 /*
  * Copyright 2006 Milan Digital Audio LLC
- * Copyright 2009-2025 GrandOrgue contributors (see AUTHORS)
+ * Copyright 2009-2026 GrandOrgue contributors (see AUTHORS)
  * License GPL-2.0 or later
  * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
  */
@@ -54,6 +54,9 @@ public:
   using GODrawstop::Load; // Avoiding a compilation warning
   void Load(GOConfigReader &cfg, const wxString &group, unsigned tremulantN);
   GOTremulantType GetTremulantType();
+  /* The highest gain the tremulant may apply to the voices. 1 if it does not
+   * modulate them */
+  float GetMaxGain() const;
 };
 
 #endif /* GOTREMULANT_H_ */
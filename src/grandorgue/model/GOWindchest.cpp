@@ -1,6 +1,6 @@
 /*
  * Copyright 2006 Milan Digital Audio LLC
- * Copyright 2009-2025 GrandOrgue contributors (see AUTHORS)
+ * Copyright 2009-2026 GrandOrgue contributors (see AUTHORS)
  * License GPL-2.0 or later
  * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
  */
@@ -93,6 +93,14 @@ unsigned GOWindchest::GetTremulantCount() { return m_tremulant.size(); }
 
 unsigned GOWindchest::GetTremulantId(unsigned no) { return m_tremulant[no]; }
 
+float GOWindchest::GetMaxTremulantGain() {
+  float gain = 1.0f;
+
+  for (unsigned id : m_tremulant)
+    gain *= r_OrganModel.GetTremulant(id)->GetMaxGain();
+  return gain;
+}
+
 unsigned GOWindchest::GetRankCount() { return m_ranks.size(); }
 
 GORank *GOWindchest::GetRank(unsigned index) {
@@ -1,6 +1,6 @@
 /*
  * Copyright 2006 Milan Digital Audio LLC
- * Copyright 2009-2025 GrandOrgue contributors (see AUTHORS)
+ * Copyright 2009-2026 GrandOrgue contributors (see AUTHORS)
  * License GPL-2.0 or later
  * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
  */
@@ -52,6 +52,8 @@ public:
   float GetVolume();
   unsigned GetTremulantCount();
   unsigned GetTremulantId(unsigned index);
+  /* The product of the highest gains of the tremulants */
+  float GetMaxTremulantGain();
   unsigned GetRankCount();
   GORank *GetRank(unsigned index);
   void AddRank(GORank *rank);
@@ -0,0 +1,283 @@
+/*
+ * Copyright 2006 Milan Digital Audio LLC
+ * Copyright 2009-2025 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#include "GOMemoryBudgetPlanner.h"
+
+#include <algorithm>
+#include <functional>
+
+#include <wx/arrstr.h>
+#include <wx/intl.h>
+
+#include "model/GOOrganModel.h"
+#include "model/GORank.h"
+
+#include "GOPipeConfigNode.h"
+
+// the loop loading with the earliest ending loop only
+static constexpr unsigned LOOP_LOAD_FIRST = 0;
+// a typical size of the losslessly compressed organ samples
+static constexpr double COMPRESSION_RATIO = 0.6;
+
+static unsigned stored_bytes(unsigned bits) {
+  return bits <= 8 ? 1 : bits <= 16 ? 2 : 3;
+}
+
+static double bytes_per_sample(unsigned bits, bool isCompressed) {
+  return isCompressed ? bits * COMPRESSION_RATIO / 8 : stored_bytes(bits);
+}
+
+static double mb(size_t size) { return size / (1024.0 * 1024.0); }
+
+GOMemoryBudgetPlanner::GOMemoryBudgetPlanner()
+  : m_CurrentSize(0), m_PlannedSize(0) {}
+
+GOMemoryBudgetPlanner::GOMemoryBudgetPlanner(GOOrganModel &organModel)
+  : GOMemoryBudgetPlanner() {
+  for (unsigned i = 0; i < organModel.GetRankCount(); i++) {
+    GORank *pRank = organModel.GetRank(i);
+    const GOPipeConfigNode &node = pRank->GetPipeConfig();
+    const GOSampleStatistic stat = node.GetStatistic();
+    Settings current;
+
+    current.m_Bits = std::min<unsigned>(
+      node.GetEffectiveBitsPerSample(), stat.GetMaxBitPerSample());
+    current.m_IsCompressed = node.GetEffectiveCompress() && current.m_Bits > 8;
+    current.m_LoopLoad = node.GetEffectiveLoopLoad();
+    current.m_IsAllAttacks = node.GetEffectiveAttackLoad();
+    current.m_IsAllReleases = node.GetEffectiveReleaseLoad();
+    AddRank(pRank, stat, current);
+  }
+}
+
+void GOMemoryBudgetPlanner::AddRank(
+  GORank *pRank, const GOSampleStatistic &stat, const Settings &current) {
+  if (!stat.IsValid() || !stat.GetMemorySize())
+    return;
+
+  RankPlan rank;
+
+  rank.p_Rank = pRank;
+  rank.m_Stat = stat;
+  rank.m_Current = current;
+  rank.m_Planned = current;
+  rank.m_PlannedSize = stat.GetMemorySize();
+  m_CurrentSize += rank.m_PlannedSize;
+  m_PlannedSize = m_CurrentSize;
+  m_Ranks.push_back(rank);
+}
+
+size_t GOMemoryBudgetPlanner::estimateSize(
+  const RankPlan &rank, const Settings &settings) {
+  const GOSampleStatistic &stat = rank.m_Stat;
+  const Settings &current = rank.m_Current;
+  const double memorySize = stat.GetMemorySize();
+  double releaseSize = std::min<double>(stat.GetReleaseSize(), memorySize);
+  double attackSize = memorySize - releaseSize;
+  double loopTailSize = stat.GetLoopTailSize();
+
+  if (
+    current.m_IsAllAttacks && !settings.m_IsAllAttacks
+    && stat.GetAttackCount() > stat.GetPipeCount()) {
+    const double ratio = (double)stat.GetPipeCount() / stat.GetAttackCount();
+
+    attackSize *= ratio;
+    loopTailSize *= ratio;
+  }
+  if (
+    current.m_IsAllReleases && !settings.m_IsAllReleases
+    && stat.GetReleaseCount() > stat.GetPipeCount())
+    releaseSize *= (double)stat.GetPipeCount() / stat.GetReleaseCount();
+  if (
+    current.m_LoopLoad > LOOP_LOAD_FIRST
+    && settings.m_LoopLoad == LOOP_LOAD_FIRST)
+    attackSize = std::max(attackSize - loopTailSize, 0.0);
+
+  // the end segments are never compressed
+  const double size = attackSize + releaseSize;
+  const double endSize = size * stat.GetEndSegmentSize() / memorySize;
+
+  return (size - endSize)
+    * bytes_per_sample(settings.m_Bits, settings.m_IsCompressed)
+    / bytes_per_sample(current.m_Bits, current.m_IsCompressed)
+    + endSize * stored_bytes(settings.m_Bits) / stored_bytes(current.m_Bits);
+}
+
+bool GOMemoryBudgetPlanner::Plan(size_t targetSize, bool isCompressionAllowed) {
+  /* A reduction changes the settings and returns whether it has changed
+   * anything. They are ordered from the least audible one */
+  using Reduction = std::function<bool(Settings &)>;
+  auto reduceBits = [](unsigned bits) {
+    return [bits](Settings &s) {
+      const bool isChanged = s.m_Bits > bits;
+
+      if (isChanged)
+        s.m_Bits = bits;
+      return isChanged;
+    };
+  };
+  const std::vector<Reduction> reductions = {
+    [isCompressionAllowed](Settings &s) {
+      const bool isChanged
+        = isCompressionAllowed && !s.m_IsCompressed && s.m_Bits > 8;
+
+      if (isChanged)
+        s.m_IsCompressed = true;
+      return isChanged;
+    },
+    reduceBits(20),
+    [](Settings &s) {
+      const bool isChanged = s.m_IsAllReleases;
+
+      s.m_IsAllReleases = false;
+      return isChanged;
+    },
+    reduceBits(16),
+    [](Settings &s) {
+      const bool isChanged = s.m_LoopLoad > LOOP_LOAD_FIRST;
+
+      s.m_LoopLoad = LOOP_LOAD_FIRST;
+      return isChanged;
+    },
+    [](Settings &s) {
+      const bool isChanged = s.m_IsAllAttacks;
+
+      s.m_IsAllAttacks = false;
+      return isChanged;
+    },
+    reduceBits(12),
+  };
+  struct Candidate {
+    RankPlan *p_Rank;
+    Settings m_Settings;
+    size_t m_Size;
+  };
+
+  for (RankPlan &rank : m_Ranks) {
+    rank.m_Planned = rank.m_Current;
+    rank.m_PlannedSize = rank.m_Stat.GetMemorySize();
+  }
+  m_PlannedSize = m_CurrentSize;
+  for (const Reduction &reduce : reductions) {
+    if (m_PlannedSize <= targetSize)
+      break;
+
+    std::vector<Candidate> candidates;
+
+    for (RankPlan &rank : m_Ranks) {
+      Candidate candidate = {&rank, rank.m_Planned, 0};
+
+      if (reduce(candidate.m_Settings)) {
+        candidate.m_Size = estimateSize(rank, candidate.m_Settings);
+        if (candidate.m_Size < rank.m_PlannedSize)
+          candidates.push_back(candidate);
+      }
+    }
+    // the biggest savings first, so the fewest ranks are reduced
+    std::sort(
+      candidates.begin(),
+      candidates.end(),
+      [](const Candidate &a, const Candidate &b) {
+        return a.p_Rank->m_PlannedSize - a.m_Size
+          > b.p_Rank->m_PlannedSize - b.m_Size;
+      });
+    for (const Candidate &candidate : candidates) {
+      if (m_PlannedSize <= targetSize)
+        break;
+      m_PlannedSize -= candidate.p_Rank->m_PlannedSize - candidate.m_Size;
+      candidate.p_Rank->m_Planned = candidate.m_Settings;
+      candidate.p_Rank->m_PlannedSize = candidate.m_Size;
+    }
+  }
+  return m_PlannedSize <= targetSize;
+}
+
+wxString GOMemoryBudgetPlanner::GetReport() const {
+  wxString report;
+
+  for (const RankPlan &rank : m_Ranks) {
+    const Settings &current = rank.m_Current;
+    const Settings &planned = rank.m_Planned;
+
+    if (planned == current)
+      continue;
+
+    wxArrayString changes;
+
+    if (planned.m_IsCompressed != current.m_IsCompressed)
+      changes.Add(_("lossless compression"));
+    if (planned.m_Bits != current.m_Bits)
+      changes.Add(wxString::Format(_("%u bits"), planned.m_Bits));
+    if (planned.m_IsAllReleases != current.m_IsAllReleases)
+      changes.Add(_("single release"));
+    if (planned.m_LoopLoad != current.m_LoopLoad)
+      changes.Add(_("first loop"));
+    if (planned.m_IsAllAttacks != current.m_IsAllAttacks)
+      changes.Add(_("single attack"));
+    report += wxString::Format(
+      _("%s: %.1f MB -> %.1f MB (%s)\n"),
+      rank.p_Rank->GetPipeConfig().GetName(),
+      mb(rank.m_Stat.GetMemorySize()),
+      mb(rank.m_PlannedSize),
+      wxJoin(changes, wxT(',')));
+  }
+  if (report.IsEmpty())
+    report = _("No changes are needed.\n");
+  report += wxString::Format(
+    _("Total: %.1f MB -> %.1f MB (estimated)"),
+    mb(m_CurrentSize),
+    mb(m_PlannedSize));
+  return report;
+}
+
+void GOMemoryBudgetPlanner::Apply() {
+  for (const RankPlan &rank : m_Ranks) {
+    const Settings &current = rank.m_Current;
+    const Settings &planned = rank.m_Planned;
+    GOPipeConfigNode &node = rank.p_Rank->GetPipeConfig();
+    GOPipeConfig &config = node.GetPipeConfig();
+
+    if (planned == current)
+      continue;
+    if (planned.m_Bits != current.m_Bits)
+      config.SetBitsPerSample(planned.m_Bits);
+    if (planned.m_IsCompressed != current.m_IsCompressed)
+      config.SetCompress(BOOL3_TRUE);
+    if (planned.m_LoopLoad != current.m_LoopLoad)
+      config.SetLoopLoad(planned.m_LoopLoad);
+    if (planned.m_IsAllAttacks != current.m_IsAllAttacks)
+      config.SetAttackLoad(BOOL3_FALSE);
+    if (planned.m_IsAllReleases != current.m_IsAllReleases)
+      config.SetReleaseLoad(BOOL3_FALSE);
+
+    // the pipes overriding the rank settings must not keep more memory
+    for (unsigned i = 0; i < node.GetChildCount(); i++) {
+      GOPipeConfig &pipeConfig = node.GetChild(i)->GetPipeConfig();
+
+      if (
+        planned.m_Bits != current.m_Bits
+        && pipeConfig.GetBitsPerSample() > (int)planned.m_Bits)
+        pipeConfig.SetBitsPerSample(-1);
+      if (
+        planned.m_IsCompressed != current.m_IsCompressed
+        && pipeConfig.GetCompress() == BOOL3_FALSE)
+        pipeConfig.SetCompress(BOOL3_DEFAULT);
+      if (
+        planned.m_LoopLoad != current.m_LoopLoad
+        && pipeConfig.GetLoopLoad() > (int)planned.m_LoopLoad)
+        pipeConfig.SetLoopLoad(-1);
+      if (
+        planned.m_IsAllAttacks != current.m_IsAllAttacks
+        && pipeConfig.GetAttackLoad() == BOOL3_TRUE)
+        pipeConfig.SetAttackLoad(BOOL3_DEFAULT);
+      if (
+        planned.m_IsAllReleases != current.m_IsAllReleases
+        && pipeConfig.GetReleaseLoad() == BOOL3_TRUE)
+        pipeConfig.SetReleaseLoad(BOOL3_DEFAULT);
+    }
+  }
+}
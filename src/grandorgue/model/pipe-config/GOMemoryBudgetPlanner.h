@@ -0,0 +1,97 @@
+/*
+ * Copyright 2006 Milan Digital Audio LLC
+ * Copyright 2009-2025 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#ifndef GOMEMORYBUDGETPLANNER_H
+#define GOMEMORYBUDGETPLANNER_H
+
+#include <cstddef>
+#include <vector>
+
+#include <wx/string.h>
+
+#include "GOSampleStatistic.h"
+
+class GOOrganModel;
+class GORank;
+
+/**
+ * Chooses the sample loading settings of the ranks so that the samples fit
+ * into a memory target.
+ *
+ * The footprint of each rank under other settings is estimated from the
+ * statistic of the current load. The reductions are taken from the least
+ * audible one: lossless compression, 20 bits, a single release, 16 bits, the
+ * earliest ending loop only, a single attack and 12 bits. Each reduction is
+ * applied to the ranks with the biggest savings first until the target is
+ * reached.
+ */
+class GOMemoryBudgetPlanner {
+public:
+  // the loading settings of a rank
+  struct Settings {
+    // the bits per sample of the loaded samples
+    unsigned m_Bits;
+    bool m_IsCompressed;
+    unsigned m_LoopLoad;
+    bool m_IsAllAttacks;
+    bool m_IsAllReleases;
+
+    bool operator==(const Settings &other) const = default;
+  };
+
+private:
+  struct RankPlan {
+    GORank *p_Rank;
+    GOSampleStatistic m_Stat;
+    Settings m_Current;
+    Settings m_Planned;
+    size_t m_PlannedSize;
+  };
+
+  std::vector<RankPlan> m_Ranks;
+  size_t m_CurrentSize;
+  size_t m_PlannedSize;
+
+  static size_t estimateSize(const RankPlan &rank, const Settings &settings);
+
+public:
+  GOMemoryBudgetPlanner();
+  /* Collects the statistic of the loaded ranks */
+  GOMemoryBudgetPlanner(GOOrganModel &organModel);
+
+  /* Adds a rank loaded with the settings. The ranks without samples are
+   * skipped */
+  void AddRank(
+    GORank *pRank, const GOSampleStatistic &stat, const Settings &current);
+
+  size_t GetCurrentSize() const { return m_CurrentSize; }
+  size_t GetPlannedSize() const { return m_PlannedSize; }
+  unsigned GetRankCount() const { return m_Ranks.size(); }
+  const Settings &GetPlannedSettings(unsigned index) const {
+    return m_Ranks[index].m_Planned;
+  }
+  size_t GetPlannedSize(unsigned index) const {
+    return m_Ranks[index].m_PlannedSize;
+  }
+
+  /**
+   * Plans the reductions of the ranks
+   * @param targetSize the memory target in bytes
+   * @param isCompressionAllowed whether more CPU time may be spent for
+   *   decompressing the samples while playing
+   * @return whether the estimated size fits into the target
+   */
+  bool Plan(size_t targetSize, bool isCompressionAllowed);
+
+  /* Describes the planned changes of each rank */
+  wxString GetReport() const;
+
+  /* Writes the planned settings to the pipe config nodes of the ranks */
+  void Apply();
+};
+
+#endif /* GOMEMORYBUDGETPLANNER_H */
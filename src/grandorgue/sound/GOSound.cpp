@@ -49,9 +49,11 @@ void GOSound::StartThreads() {
 
   unsigned n_cpus = m_config.Concurrency();
 
+  GetEngine().GetScheduler().SetWorkerCount(n_cpus);
+
   GOMutexLocker thread_locker(m_thread_lock);
   for (unsigned i = 0; i < n_cpus; i++)
-    m_Threads.push_back(new GOSoundThread(&GetEngine().GetScheduler()));
+    m_Threads.push_back(new GOSoundThread(&GetEngine().GetScheduler(), i));
 
   for (unsigned i = 0; i < m_Threads.size(); i++)
     m_Threads[i]->Run();
@@ -116,15 +118,27 @@ void GOSound::OpenSound() {
   }
   m_SamplesPerBuffer = m_config.SamplesPerBuffer();
   m_SoundEngine.SetSamplesPerBuffer(m_SamplesPerBuffer);
+
+  unsigned sample_rate = m_config.SampleRate();
+
+  GetEngine().SetSampleRate(sample_rate);
+  if (!GetEngine().SetRenderSampleRate(m_config.RenderSampleRate()))
+    wxLogWarning(
+      _("The render sample rate %u is not compatible with the sample rate %u "
+        "and %u samples per buffer. The sample rate is used for rendering"),
+      m_config.RenderSampleRate(),
+      sample_rate,
+      m_SamplesPerBuffer);
   m_SoundEngine.SetPolyphonyLimiting(m_config.ManagePolyphony());
   m_SoundEngine.SetHardPolyphony(m_config.PolyphonyLimit());
   m_SoundEngine.SetScaledReleases(m_config.ScaleRelease());
   m_SoundEngine.SetRandomizeSpeaking(m_config.RandomizeSpeaking());
+  m_SoundEngine.SetSubmixBuses(m_config.SubmixBuses());
+  m_SoundEngine.SetInaudibleLevel(m_config.InaudibleLevel());
   m_SoundEngine.SetInterpolationType(m_config.m_InterpolationType());
+  m_SoundEngine.SetConcurrency(m_config.Concurrency());
   m_SoundEngine.SetAudioGroupCount(audio_group_count);
-  unsigned sample_rate = m_config.SampleRate();
   m_AudioRecorder.SetBytesPerSample(m_config.WaveFormatBytesPerSample());
-  GetEngine().SetSampleRate(sample_rate);
   m_AudioRecorder.SetSampleRate(sample_rate);
   m_SoundEngine.SetAudioOutput(engine_config);
   m_SoundEngine.SetupReverb(m_config);
@@ -159,7 +173,7 @@ void GOSound::OpenSound() {
       m_AudioOutputs[i].port = pPort;
       pPort->Init(
         deviceConfig.GetChannels(),
-        GetEngine().GetSampleRate(),
+        GetEngine().GetOutputSampleRate(),
         m_SamplesPerBuffer,
         deviceConfig.GetDesiredLatency(),
         i);
@@ -427,7 +441,7 @@ wxString GOSound::getState() {
   wxString result = wxString::Format(
     _("%d samples per buffer, %d Hz\n"),
     m_SamplesPerBuffer,
-    m_SoundEngine.GetSampleRate());
+    m_SoundEngine.GetOutputSampleRate());
   for (unsigned i = 0; i < m_AudioOutputs.size(); i++)
     result = result + _("\n") + m_AudioOutputs[i].port->getPortState();
   return result;
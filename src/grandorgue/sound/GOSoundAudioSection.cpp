@@ -7,6 +7,8 @@
 
 #include "GOSoundAudioSection.h"
 
+#include <algorithm>
+
 #include <wx/intl.h>
 #include <wx/log.h>
 
@@ -33,22 +35,28 @@ static constexpr unsigned DEFAULT_END_SEG_LENGTH = MAX_READAHEAD * 2;
 
 const unsigned GOSoundAudioSection::getMaxReadAhead() { return MAX_READAHEAD; }
 
-GOSoundAudioSection::GOSoundAudioSection(GOMemoryPool &pool)
+GOSoundAudioSection::GOSoundAudioSection(
+  GOMemoryPool &pool, GOSoundStreamStore *pStreamStore)
   : m_data(NULL),
     m_ReleaseAligner(NULL),
     m_ReleaseStartSegment(0),
-    m_Pool(pool) {
+    m_Pool(pool),
+    p_StreamStore(pStreamStore),
+    m_IsStreamed(false),
+    m_StreamFile(GOSoundStreamStore::STREAM_FILE_SCRATCH),
+    m_StreamOffset(0) {
   ClearData();
 }
 
 void GOSoundAudioSection::ClearData() {
   m_AllocSize = 0;
+  m_SharedSize = 0;
   m_SampleCount = 0;
   m_SampleRate = 0;
   m_BitsPerSample = 0;
   m_BytesPerSample = 0;
   m_WaveTremulantStateFor = BOOL3_DEFAULT;
-  m_IsCompressed = false;
+  m_CompressionType = GO_COMPRESSION_NONE;
   m_channels = 0;
   if (m_data) {
     m_Pool.Free(m_data);
@@ -66,6 +74,43 @@ void GOSoundAudioSection::ClearData() {
   }
   m_StartSegments.clear();
   m_ReleaseCrossfadeLength = 0;
+  m_Envelope.clear();
+  for (const StreamIsland &island : m_StreamIslands)
+    m_Pool.Free(island.frames);
+  m_StreamIslands.clear();
+  m_IsStreamed = false;
+  m_StreamFile = GOSoundStreamStore::STREAM_FILE_SCRATCH;
+  m_StreamOffset = 0;
+}
+
+void GOSoundAudioSection::ShareBlock(unsigned char *&data, unsigned length) {
+  bool isShared;
+
+  data = (unsigned char *)m_Pool.MoveToPoolShared(data, length, isShared);
+  if (!data)
+    throw GOOutOfMemory();
+  if (isShared)
+    m_SharedSize += length;
+}
+
+unsigned char *GOSoundAudioSection::ReadSharedBlock(
+  GOCache &cache, unsigned length) {
+  bool isShared;
+  unsigned char *data
+    = (unsigned char *)cache.ReadSharedBlock(length, isShared);
+
+  if (isShared)
+    m_SharedSize += length;
+  return data;
+}
+
+void GOSoundAudioSection::ShareData(bool isMainDataResident) {
+  if (isMainDataResident)
+    ShareBlock(m_data, m_AllocSize);
+  for (EndSegment &end : m_EndSegments) {
+    ShareBlock(end.end_data, end.end_size);
+    end.end_ptr = end.end_data - m_BytesPerSample * end.transition_offset;
+  }
 }
 
 bool GOSoundAudioSection::LoadCache(GOCache &cache) {
@@ -81,7 +126,9 @@ bool GOSoundAudioSection::LoadCache(GOCache &cache) {
     return false;
   if (!cache.Read(&m_WaveTremulantStateFor, sizeof(m_WaveTremulantStateFor)))
     return false;
-  if (!cache.Read(&m_IsCompressed, sizeof(m_IsCompressed)))
+  if (!cache.Read(&m_CompressionType, sizeof(m_CompressionType)))
+    return false;
+  if (m_CompressionType > GO_COMPRESSION_BLOCK)
     return false;
   if (!cache.Read(&m_channels, sizeof(m_channels)))
     return false;
@@ -93,9 +140,42 @@ bool GOSoundAudioSection::LoadCache(GOCache &cache) {
     return false;
   if (!cache.Read(&m_ReleaseCrossfadeLength, sizeof(m_ReleaseCrossfadeLength)))
     return false;
-  m_data = (unsigned char *)cache.ReadBlock(m_AllocSize);
-  if (!m_data)
+
+  unsigned envelopeSize;
+
+  if (!cache.Read(&envelopeSize, sizeof(envelopeSize)))
     return false;
+  m_Envelope.resize(envelopeSize);
+  if (envelopeSize && !cache.Read(m_Envelope.data(), envelopeSize))
+    return false;
+
+  // whether the main data is streamed from the cache file
+  bool isInCache = false;
+
+  if (p_StreamStore) {
+    uint64_t cachePos;
+
+    if (
+      p_StreamStore->IsCacheFileUsed()
+      && m_CompressionType != GO_COMPRESSION_PREDICTIVE
+      && m_channels <= GOSoundStreamStore::MAX_CHANNELS
+      && cache.SkipRawBlock(m_AllocSize, cachePos)) {
+      m_StreamFile = GOSoundStreamStore::STREAM_FILE_CACHE;
+      m_StreamOffset = cachePos;
+      isInCache = true;
+    } else {
+      // keep the main data out of the pool until MoveToStream()
+      m_data = (unsigned char *)m_Pool.Alloc(m_AllocSize, false);
+      if (!m_data)
+        throw GOOutOfMemory();
+      if (!cache.ReadBlock(m_data, m_AllocSize))
+        return false;
+    }
+  } else {
+    m_data = ReadSharedBlock(cache, m_AllocSize);
+    if (!m_data)
+      return false;
+  }
 
   unsigned temp;
   if (!cache.Read(&temp, sizeof(temp)))
@@ -116,7 +196,7 @@ bool GOSoundAudioSection::LoadCache(GOCache &cache) {
           static_cast<EndSegmentDescription *>(&s),
           sizeof(EndSegmentDescription)))
       return false;
-    s.end_data = (unsigned char *)cache.ReadBlock(s.end_size);
+    s.end_data = ReadSharedBlock(cache, s.end_size);
     if (!s.end_data)
       return false;
     s.end_ptr = s.end_data - m_BytesPerSample * s.transition_offset;
@@ -133,7 +213,9 @@ bool GOSoundAudioSection::LoadCache(GOCache &cache) {
     if (!m_ReleaseAligner->Load(cache))
       return false;
   }
-
+  // the start segments are needed for choosing the resident heads
+  if (isInCache && !StreamFromCache())
+    return false;
   return true;
 }
 
@@ -150,7 +232,7 @@ bool GOSoundAudioSection::SaveCache(GOCacheWriter &cache) const {
     return false;
   if (!cache.Write(&m_WaveTremulantStateFor, sizeof(m_WaveTremulantStateFor)))
     return false;
-  if (!cache.Write(&m_IsCompressed, sizeof(m_IsCompressed)))
+  if (!cache.Write(&m_CompressionType, sizeof(m_CompressionType)))
     return false;
   if (!cache.Write(&m_channels, sizeof(m_channels)))
     return false;
@@ -162,7 +244,23 @@ bool GOSoundAudioSection::SaveCache(GOCacheWriter &cache) const {
     return false;
   if (!cache.Write(&m_ReleaseCrossfadeLength, sizeof(m_ReleaseCrossfadeLength)))
     return false;
-  if (!cache.WriteBlock(m_data, m_AllocSize))
+
+  const unsigned envelopeSize = m_Envelope.size();
+
+  if (!cache.Write(&envelopeSize, sizeof(envelopeSize)))
+    return false;
+  if (envelopeSize && !cache.Write(m_Envelope.data(), envelopeSize))
+    return false;
+  if (m_IsStreamed) {
+    std::vector<unsigned char> data(m_AllocSize);
+
+    // stored raw, so the section is streamed from the cache next time
+    if (
+      !p_StreamStore->ReadBack(
+        m_StreamFile, m_StreamOffset, data.data(), m_AllocSize)
+      || !cache.WriteBlock(data.data(), m_AllocSize, false))
+      return false;
+  } else if (!cache.WriteBlock(m_data, m_AllocSize))
     return false;
 
   unsigned temp;
@@ -262,15 +360,21 @@ void GOSoundAudioSection::GetMaxAmplitudeAndDerivative() {
   m_MaxAbsAmplitude = 0;
   m_MaxAbsDerivative = 0;
 
+  std::vector<unsigned> peaks(
+    (m_SampleCount + ENVELOPE_FRAMES - 1) / ENVELOPE_FRAMES, 0);
   int f_p = 0; /* to avoid compiler warning */
   for (unsigned int i = 0; i < m_SampleCount; i++) {
     /* Get sum of amplitudes in channels */
     int f = 0;
+    unsigned &peak = peaks[i / ENVELOPE_FRAMES];
+
     for (unsigned int j = 0; j < m_channels; j++) {
       int val = GetSample(i, j, &cache);
       f += val;
       if (abs(val) > m_MaxAmplitude)
         m_MaxAmplitude = abs(val);
+      if ((unsigned)abs(val) > peak)
+        peak = abs(val);
     }
 
     if (abs(f) > m_MaxAbsAmplitude)
@@ -284,6 +388,45 @@ void GOSoundAudioSection::GetMaxAmplitudeAndDerivative() {
     }
     f_p = f;
   }
+  BuildEnvelope(peaks);
+}
+
+void GOSoundAudioSection::BuildEnvelope(std::vector<unsigned> &peaks) {
+  // the peak from each window on to the end
+  for (unsigned i = peaks.size(); i > 1; i--)
+    peaks[i - 2] = std::max(peaks[i - 2], peaks[i - 1]);
+
+  // a looped stream returns to the loop start, so it may play the whole loop
+  unsigned loopStart = m_SampleCount;
+
+  for (const EndSegment &end : m_EndSegments)
+    if (end.next_start_segment_index >= 0)
+      loopStart = std::min(
+        loopStart,
+        m_StartSegments[end.next_start_segment_index].start_offset);
+  for (unsigned i = loopStart / ENVELOPE_FRAMES + 1; i < peaks.size(); i++)
+    peaks[i] = peaks[loopStart / ENVELOPE_FRAMES];
+
+  const float fullScale = scalbnf(1.0f, m_SampleFracBits);
+
+  m_Envelope.resize(peaks.size());
+  for (unsigned i = 0; i < peaks.size(); i++)
+    // rounded down, so the level is never underestimated
+    m_Envelope[i] = peaks[i]
+      ? (uint8_t)std::clamp(
+        floorf(-20.0f * log10f(peaks[i] / fullScale)), 0.0f, 255.0f)
+      : 255;
+}
+
+float GOSoundAudioSection::GetRemainingAmplitude(unsigned position) const {
+  if (m_Envelope.empty())
+    // not known
+    return scalbnf(1.0f, m_SampleFracBits);
+
+  const unsigned index = std::min(
+    position / ENVELOPE_FRAMES, (unsigned)m_Envelope.size() - 1);
+
+  return scalbnf(powf(10.0f, m_Envelope[index] * -0.05f), m_SampleFracBits);
 }
 
 void GOSoundAudioSection::DoCrossfade(
@@ -321,6 +464,39 @@ void GOSoundAudioSection::Setup(
   bool compress,
   unsigned loopCrossfadeLength,
   unsigned releaseCrossfadeLength) {
+  const unsigned bytesPerFrame
+    = wave_bytes_per_sample(pcm_data_format) * pcm_data_channels;
+
+  Setup(
+    pObjectFor,
+    pLoaderFilename,
+    [pcm_data, bytesPerFrame](void *pDest, unsigned nSamples) {
+      memcpy(pDest, pcm_data, nSamples * bytesPerFrame);
+    },
+    pcm_data_format,
+    pcm_data_channels,
+    pcm_data_sample_rate,
+    pcm_data_nb_samples,
+    loop_points,
+    waveTremulantStateFor,
+    compress,
+    loopCrossfadeLength,
+    releaseCrossfadeLength);
+}
+
+void GOSoundAudioSection::Setup(
+  const GOCacheObject *pObjectFor,
+  const GOLoaderFilename *pLoaderFilename,
+  const PcmReader &readPcm,
+  const GOWave::SAMPLE_FORMAT pcm_data_format,
+  const unsigned pcm_data_channels,
+  const unsigned pcm_data_sample_rate,
+  const unsigned pcm_data_nb_samples,
+  const std::vector<GOWaveLoop> *loop_points,
+  GOBool3 waveTremulantStateFor,
+  bool compress,
+  unsigned loopCrossfadeLength,
+  unsigned releaseCrossfadeLength) {
   if (pcm_data_channels < 1 || pcm_data_channels > 2)
     throw(wxString) _("< More than 2 channels in");
 
@@ -338,6 +514,29 @@ void GOSoundAudioSection::Setup(
   m_BytesPerSample = bytes_per_sample * pcm_data_channels;
 
   unsigned total_alloc_samples = pcm_data_nb_samples;
+
+  if ((loop_points) && (loop_points->size() >= 1)) {
+    /* There is no need to store any samples after the end of the last loop. */
+    unsigned min_reqd_samples = 0;
+
+    for (const GOWaveLoop &loop : *loop_points)
+      if (loop.m_EndPosition + 1 > min_reqd_samples)
+        min_reqd_samples = loop.m_EndPosition + 1;
+    if (total_alloc_samples > min_reqd_samples)
+      total_alloc_samples = min_reqd_samples;
+  }
+
+  /* Read the main data blob. The end segments are filled from it. The blocks
+   * are moved to the pool by ShareData(), so the duplicates never take the
+   * pool memory */
+  m_AllocSize = total_alloc_samples * m_BytesPerSample;
+  m_data = (unsigned char *)m_Pool.Alloc(m_AllocSize, false);
+  if (m_data == NULL)
+    throw GOOutOfMemory();
+  readPcm(m_data, total_alloc_samples);
+
+  const unsigned char *pcm_data = m_data;
+
   /* Create a start segment */
   {
     StartSegment start_seg;
@@ -346,25 +545,23 @@ void GOSoundAudioSection::Setup(
   }
 
   if ((loop_points) && (loop_points->size() >= 1)) {
-    /* Setup the loops and find the amount of data we need to store in the
-     * main block. */
-    unsigned min_reqd_samples = 0;
-
+    /* Setup the loops */
     for (unsigned i = 0; i < loop_points->size(); i++) {
       StartSegment start_seg;
       EndSegment end_seg;
       const GOWaveLoop &loop = (*loop_points)[i];
 
-      if (loop.m_EndPosition + 1 > min_reqd_samples)
-        min_reqd_samples = loop.m_EndPosition + 1;
-
       start_seg.start_offset = loop.m_StartPosition;
       end_seg.end_pos = loop.m_EndPosition;
-      end_seg.next_start_segment_index = i + 1;
+      // the start segment of this loop is pushed below
+      end_seg.next_start_segment_index = m_StartSegments.size();
       const unsigned loop_length = end_seg.end_pos - start_seg.start_offset;
       wxString loopError;
 
-      if (fade_len > loop_length - 1)
+      if (end_seg.end_pos <= start_seg.start_offset)
+        loopError = wxString::Format(
+          _("The loop %u is ignored: it has no samples"), i + 1);
+      else if (fade_len >= loop_length)
         loopError = wxString::Format(
           _("The loop %u is ignored: it is too short for crossfade"), i + 1);
       else if (start_seg.start_offset < fade_len)
@@ -396,7 +593,7 @@ void GOSoundAudioSection::Setup(
 
         // Allocate the fade segment
         end_seg.end_data
-          = (unsigned char *)m_Pool.Alloc(end_seg.end_size, true);
+          = (unsigned char *)m_Pool.Alloc(end_seg.end_size, false);
         if (!end_seg.end_data)
           throw GOOutOfMemory();
 
@@ -439,13 +636,9 @@ void GOSoundAudioSection::Setup(
       } else
         wxLogWarning(GOCacheObject::generateMessage(
           pObjectFor, pLoaderFilename, loopError));
-      if (!m_EndSegments.size())
-        throw(wxString) _("No valid loops exist in the file");
     }
-
-    /* There is no need to store any samples after the end of the last loop. */
-    if (total_alloc_samples > min_reqd_samples)
-      total_alloc_samples = min_reqd_samples;
+    if (!m_EndSegments.size())
+      throw(wxString) _("No valid loops exist in the file");
   } else {
     /* Create a default end segment */
     EndSegment end_seg;
@@ -453,7 +646,7 @@ void GOSoundAudioSection::Setup(
     end_seg.end_pos = pcm_data_nb_samples;
     end_seg.next_start_segment_index = -1;
     end_seg.end_size = m_BytesPerSample * DEFAULT_END_SEG_LENGTH;
-    end_seg.end_data = (unsigned char *)m_Pool.Alloc(end_seg.end_size, true);
+    end_seg.end_data = (unsigned char *)m_Pool.Alloc(end_seg.end_size, false);
 
     if (!end_seg.end_data)
       throw GOOutOfMemory();
@@ -478,81 +671,252 @@ void GOSoundAudioSection::Setup(
     m_EndSegments.push_back(end_seg);
   }
 
-  m_AllocSize = total_alloc_samples * m_BytesPerSample;
-  m_data = (unsigned char *)m_Pool.Alloc(m_AllocSize, !compress);
-  if (m_data == NULL)
-    throw GOOutOfMemory();
   m_SampleRate = pcm_data_sample_rate;
   m_SampleCount = total_alloc_samples;
   m_SampleFracBits = m_BitsPerSample - 1;
-  m_IsCompressed = false;
+  m_CompressionType = GO_COMPRESSION_NONE;
   m_WaveTremulantStateFor = waveTremulantStateFor;
 
-  /* Store the main data blob. */
-  memcpy(m_data, pcm_data, m_AllocSize);
-
   GetMaxAmplitudeAndDerivative();
 
   if (compress)
-    Compress(m_BitsPerSample > 16);
+    Compress();
+  // MoveToStream() shares the main data if it remains resident
+  ShareData(!p_StreamStore);
 }
 
-void GOSoundAudioSection::Compress(bool format16) {
+void GOSoundAudioSection::Compress() {
   unsigned char *data = (unsigned char *)m_Pool.Alloc(m_AllocSize, false);
   if (data == NULL)
     throw GOOutOfMemory();
 
-  unsigned output_len = 0;
-  DecompressionCache state;
-  InitDecompressionCache(state);
+  /* The compressed data is useless if it is not smaller than the uncompressed
+   * one */
+  const unsigned outputLen = GOSoundBlockCompress::encode(
+    m_SampleCount,
+    m_channels,
+    [this](unsigned position, uint8_t channel) {
+      return GetSampleData(m_data, position, channel);
+    },
+    data,
+    m_AllocSize);
+
+  if (outputLen) {
+    m_Pool.Free(m_data);
+    m_data = data;
+    m_AllocSize = outputLen;
+    m_CompressionType = GO_COMPRESSION_BLOCK;
+    /* The block format is decoded from any block boundary, so the start
+     * segments do not need a decompression state */
+    for (StartSegment &startSegment : m_StartSegments)
+      InitDecompressionCache(startSegment.cache);
+  } else
+    m_Pool.Free(data);
+}
 
-  for (unsigned i = 0; i < m_SampleCount; i++) {
-    state.position = i;
-    state.ptr = (const unsigned char *)(intptr_t)output_len;
-    for (unsigned j = 0; j < m_StartSegments.size(); j++) {
-      if (m_StartSegments[j].start_offset == i) {
-        m_StartSegments[j].cache = state;
-      }
-    }
+void GOSoundAudioSection::DecodePcmBlock(
+  const unsigned char *pData, unsigned nFrames, int *pDst) const {
+  for (unsigned i = 0; i < nFrames; i++)
+    for (uint8_t j = 0; j < m_channels; j++)
+      *(pDst++) = GetSampleData(pData, i, j);
+  std::fill(pDst, pDst + (BLOCK_FRAMES - nFrames) * m_channels, 0);
+}
 
-    state.last[0] = state.prev[0];
-    state.last[1] = state.prev[1];
-    state.prev[0] = state.value[0];
-    state.prev[1] = state.value[1];
-
-    state.value[0] = GetSample(i, 0);
-    if (m_channels > 1)
-      state.value[1] = GetSample(i, 1);
-
-    for (unsigned j = 0; j < m_channels; j++) {
-      int val = state.value[j];
-      int encode = val - (state.prev[j] + (state.prev[j] - state.last[j]) / 2);
-
-      if (format16)
-        AudioWriteCompressed16(data, output_len, encode);
-      else
-        AudioWriteCompressed8(data, output_len, encode);
-
-      /* Early abort if the compressed data will be larger than the
-       * uncompressed data. */
-      if (output_len + 10 >= m_AllocSize) {
-        m_Pool.Free(data);
-        m_data = (unsigned char *)m_Pool.MoveToPool(m_data, m_AllocSize);
-        if (m_data == NULL)
-          throw GOOutOfMemory();
-        return;
+void GOSoundAudioSection::DecodeBlock(unsigned blockIndex, int *pDst) const {
+  const unsigned fromFrame = blockIndex * BLOCK_FRAMES;
+
+  if (m_CompressionType == GO_COMPRESSION_BLOCK)
+    GOSoundBlockCompress::decodeBlock(m_data, blockIndex, m_channels, pDst);
+  else
+    DecodePcmBlock(
+      m_data + fromFrame * m_BytesPerSample,
+      std::min(BLOCK_FRAMES, m_SampleCount - fromFrame),
+      pDst);
+}
+
+unsigned GOSoundAudioSection::GetNextStreamedBlock(unsigned blockIndex) const {
+  bool isResident;
+
+  // the islands may adjoin each other
+  do {
+    isResident = false;
+    for (const StreamIsland &island : m_StreamIslands)
+      if (
+        blockIndex >= island.first_block
+        && blockIndex - island.first_block < island.block_count) {
+        blockIndex = island.first_block + island.block_count;
+        isResident = true;
       }
+  } while (isResident);
+  return blockIndex;
+}
+
+bool GOSoundAudioSection::ReadStreamBlocks(
+  GOSoundStreamStore::Reader &reader,
+  unsigned firstBlock,
+  unsigned nBlocks,
+  int *pDst) const {
+  assert(nBlocks <= GOSoundStreamStore::SLOT_BLOCKS);
+  assert(firstBlock + nBlocks <= GetBlockCount());
+
+  if (m_CompressionType == GO_COMPRESSION_BLOCK) {
+    const bool isLastRead = firstBlock + nBlocks == GetBlockCount();
+    // the offsets of the blocks and of the end of the last one
+    uint32_t offsets[GOSoundStreamStore::SLOT_BLOCKS + 1];
+    const unsigned nOffsets = isLastRead ? nBlocks : nBlocks + 1;
+    const unsigned char *pOffsets = reader.Read(
+      m_StreamFile,
+      m_StreamOffset + GOSoundBlockCompress::getOffsetEntryPos(firstBlock),
+      sizeof(uint32_t) * nOffsets);
+
+    if (!pOffsets)
+      return false;
+    memcpy(offsets, pOffsets, sizeof(uint32_t) * nOffsets);
+    if (isLastRead)
+      offsets[nBlocks] = m_AllocSize - GOSoundBlockCompress::PADDING_SIZE;
+
+    // the unpacking reads up to PADDING_SIZE bytes after a block
+    const unsigned readTo = std::min(
+      offsets[nBlocks] + GOSoundBlockCompress::PADDING_SIZE, m_AllocSize);
+    const unsigned char *pBlocks = reader.Read(
+      m_StreamFile, m_StreamOffset + offsets[0], readTo - offsets[0]);
+
+    if (!pBlocks)
+      return false;
+    for (unsigned i = 0; i < nBlocks; i++)
+      GOSoundBlockCompress::decodeBlockAt(
+        pBlocks + (offsets[i] - offsets[0]),
+        m_channels,
+        pDst + i * GOSoundStreamStore::BLOCK_SAMPLES);
+  } else {
+    const unsigned fromFrame = firstBlock * BLOCK_FRAMES;
+    const unsigned nFrames
+      = std::min(nBlocks * BLOCK_FRAMES, m_SampleCount - fromFrame);
+    const unsigned char *pData = reader.Read(
+      m_StreamFile,
+      m_StreamOffset + (uint64_t)fromFrame * m_BytesPerSample,
+      nFrames * m_BytesPerSample);
+
+    if (!pData)
+      return false;
+    for (unsigned i = 0; i < nBlocks; i++) {
+      const unsigned blockFrom = i * BLOCK_FRAMES;
+
+      DecodePcmBlock(
+        pData + blockFrom * m_BytesPerSample,
+        std::min(BLOCK_FRAMES, limitedDiff(nFrames, blockFrom)),
+        pDst + i * GOSoundStreamStore::BLOCK_SAMPLES);
     }
   }
+  return true;
+}
+
+bool GOSoundAudioSection::PlanStreamIslands(
+  std::vector<StreamIsland> &islands) const {
+  const unsigned blockCount = GetBlockCount();
+  /* One block more because a start segment may begin in the middle of a
+   * block */
+  const unsigned headBlocks
+    = (p_StreamStore->GetHeadLength() * m_SampleRate / 1000 + BLOCK_FRAMES - 1)
+      / BLOCK_FRAMES
+    + 1;
+  unsigned residentBlocks = 0;
+
+  for (const StartSegment &start : m_StartSegments) {
+    StreamIsland island;
+
+    island.first_block = start.start_offset / BLOCK_FRAMES;
+    island.block_count
+      = std::min(headBlocks, limitedDiff(blockCount, island.first_block));
+    island.frames = nullptr;
+    islands.push_back(island);
+    residentBlocks += island.block_count;
+  }
+  /* Streaming of a short section does not save any memory */
+  return residentBlocks < blockCount;
+}
 
-  m_Pool.Free(m_data);
-  m_data = data;
-  m_AllocSize = output_len;
-  m_IsCompressed = true;
+bool GOSoundAudioSection::StreamFromCache() {
+  std::vector<StreamIsland> islands;
+  GOSoundStreamStore::Reader reader(*p_StreamStore);
 
-  m_data = (unsigned char *)m_Pool.MoveToPool(m_data, m_AllocSize);
-  if (m_data == NULL)
-    throw GOOutOfMemory();
+  if (!PlanStreamIslands(islands)) {
+    // the short section remains resident
+    const unsigned char *pData
+      = reader.Read(m_StreamFile, m_StreamOffset, m_AllocSize);
+
+    if (!pData)
+      return false;
+    // MoveToStream() puts the main data into the pool
+    m_data = (unsigned char *)m_Pool.Alloc(m_AllocSize, false);
+    if (!m_data)
+      throw GOOutOfMemory();
+    memcpy(m_data, pData, m_AllocSize);
+    return true;
+  }
+
+  const unsigned blockSamples = BLOCK_FRAMES * m_channels;
+  std::vector<int> buffer(
+    GOSoundStreamStore::SLOT_BLOCKS * GOSoundStreamStore::BLOCK_SAMPLES);
+
+  for (StreamIsland &island : islands) {
+    const unsigned nSamples = island.block_count * blockSamples;
+
+    island.frames = (int *)m_Pool.Alloc(sizeof(int) * nSamples, true);
+    if (!island.frames)
+      throw GOOutOfMemory();
+    m_StreamIslands.push_back(island);
+    for (unsigned i = 0; i < island.block_count;
+         i += GOSoundStreamStore::SLOT_BLOCKS) {
+      const unsigned nBlocks
+        = std::min(island.block_count - i, GOSoundStreamStore::SLOT_BLOCKS);
+
+      if (!ReadStreamBlocks(
+            reader, island.first_block + i, nBlocks, buffer.data()))
+        return false;
+      for (unsigned j = 0; j < nBlocks; j++)
+        memcpy(
+          island.frames + (i + j) * blockSamples,
+          buffer.data() + j * GOSoundStreamStore::BLOCK_SAMPLES,
+          sizeof(int) * blockSamples);
+    }
+  }
+  m_IsStreamed = true;
+  return true;
+}
+
+bool GOSoundAudioSection::MoveToStream() {
+  if (!p_StreamStore || m_IsStreamed || !m_data)
+    return m_IsStreamed;
+
+  std::vector<StreamIsland> islands;
+
+  if (
+    m_CompressionType != GO_COMPRESSION_PREDICTIVE
+    && m_channels <= GOSoundStreamStore::MAX_CHANNELS
+    && PlanStreamIslands(islands)
+    && p_StreamStore->Append(m_data, m_AllocSize, m_StreamOffset)) {
+    m_StreamFile = GOSoundStreamStore::STREAM_FILE_SCRATCH;
+    for (StreamIsland &island : islands) {
+      const unsigned nSamples = island.block_count * BLOCK_FRAMES * m_channels;
+
+      island.frames = (int *)m_Pool.Alloc(sizeof(int) * nSamples, true);
+      if (!island.frames)
+        throw GOOutOfMemory();
+      m_StreamIslands.push_back(island);
+      for (unsigned i = 0; i < island.block_count; i++)
+        DecodeBlock(
+          island.first_block + i,
+          island.frames + i * BLOCK_FRAMES * m_channels);
+    }
+    m_Pool.Free(m_data);
+    m_data = NULL;
+    m_IsStreamed = true;
+  } else {
+    // the main data remains resident, so it is time to put it into the pool
+    ShareBlock(m_data, m_AllocSize);
+  }
+  return m_IsStreamed;
 }
 
 void GOSoundAudioSection::SetupStreamAlignment(
@@ -595,7 +959,30 @@ GOSampleStatistic GOSoundAudioSection::GetStatistic() {
   for (unsigned i = 0; i < m_EndSegments.size(); i++)
     size += m_EndSegments[i].end_size;
   stat.SetEndSegmentSize(size);
-  stat.SetMemorySize(size + m_AllocSize);
+  if (m_IsStreamed)
+    for (const StreamIsland &island : m_StreamIslands)
+      size += sizeof(int) * island.block_count * BLOCK_FRAMES * m_channels;
+  else
+    size += m_AllocSize;
+  stat.SetMemorySize(size);
+  stat.SetSharedSize(m_SharedSize);
+  if (!IsOneshot() && !m_IsStreamed && m_SampleCount) {
+    // what would not be loaded with the earliest ending loop only
+    unsigned earliest = 0;
+
+    for (unsigned i = 1; i < m_EndSegments.size(); i++)
+      if (m_EndSegments[i].end_pos < m_EndSegments[earliest].end_pos)
+        earliest = i;
+
+    size_t tailSize = (size_t)m_AllocSize
+      * limitedDiff(m_SampleCount, m_EndSegments[earliest].end_pos + 1)
+      / m_SampleCount;
+
+    for (unsigned i = 0; i < m_EndSegments.size(); i++)
+      if (i != earliest)
+        tailSize += m_EndSegments[i].end_size;
+    stat.SetLoopTailSize(tailSize);
+  }
   stat.SetBitsPerSample(m_BitsPerSample, m_SampleCount, m_MaxAmplitude);
 
   return stat;
@@ -11,10 +11,14 @@
 #include <assert.h>
 #include <math.h>
 
+#include <functional>
+
 #include "GOBool3.h"
 #include "GOInt.h"
+#include "GOSoundBlockCompress.h"
 #include "GOSoundCompress.h"
 #include "GOSoundResample.h"
+#include "GOSoundStreamStore.h"
 #include "GOWave.h"
 
 class GOSoundAudioSection;
@@ -71,10 +75,39 @@ public:
   };
 
 private:
-  void Compress(bool format16);
+  static constexpr unsigned BLOCK_FRAMES = GOSoundBlockCompress::BLOCK_FRAMES;
+  // the number of frames of one window of the amplitude envelope
+  static constexpr unsigned ENVELOPE_FRAMES = 4096;
+
+  /* Decoded frames of the blocks remaining resident when the main data is
+   * streamed */
+  struct StreamIsland {
+    unsigned first_block;
+    unsigned block_count;
+    // block_count * BLOCK_FRAMES interleaving frames
+    int *frames;
+  };
+
+  void Compress();
+
+  /**
+   * Lists the resident heads of the start segments of a streamed section
+   * @return false if streaming the section would not save memory
+   */
+  bool PlanStreamIslands(std::vector<StreamIsland> &islands) const;
+
+  /**
+   * Makes the main data found raw in the cache file streamed from there.
+   * Reads the islands or, for a short section, the whole main data
+   * @return false if the data could not be read
+   */
+  bool StreamFromCache();
 
   void GetMaxAmplitudeAndDerivative();
 
+  /* Fills m_Envelope from the peak amplitude of each window */
+  void BuildEnvelope(std::vector<unsigned> &peaks);
+
   void DoCrossfade(
     unsigned char *dest,
     unsigned dest_offset,
@@ -106,19 +139,54 @@ private:
   uint8_t m_channels;
 
   GOBool3 m_WaveTremulantStateFor;
-  bool m_IsCompressed;
+  /* One byte as the former compression flag, so the caches with the
+   * predictive compression remain readable */
+  GOSoundCompressionType m_CompressionType;
 
   /* Size of the section in BYTES */
   GOMemoryPool &m_Pool;
   unsigned m_AllocSize;
+  // the size of the data shared with identical sections
+  size_t m_SharedSize;
 
   unsigned m_MaxAmplitude;
   int m_MaxAbsAmplitude;
   int m_MaxAbsDerivative;
   unsigned m_ReleaseCrossfadeLength; // in ms
+  /* For each ENVELOPE_FRAMES window: the highest amplitude from the window on
+   * to the end of the section in dB below the full scale. A looped section
+   * has the peak of the whole loop after the loop start */
+  std::vector<uint8_t> m_Envelope;
+
+  /* The store the main data is moved to by MoveToStream(). If it is set, the
+   * main data is not allocated in the pool until MoveToStream() */
+  GOSoundStreamStore *p_StreamStore;
+  // whether the main data has been moved to p_StreamStore
+  bool m_IsStreamed;
+  // the file and the offset of the main data in it
+  GOSoundStreamStore::StreamFile m_StreamFile;
+  uint64_t m_StreamOffset;
+  // the heads of the start segments
+  std::vector<StreamIsland> m_StreamIslands;
 
   void ClearData();
 
+  /* Moves the block to the pool or replaces it by an identical block of
+   * another section if it exists */
+  void ShareBlock(unsigned char *&data, unsigned length);
+  /* Reads a block from the cache sharing it like ShareBlock */
+  unsigned char *ReadSharedBlock(GOCache &cache, unsigned length);
+  /* Shares the end segments and, if it remains resident, the main data */
+  void ShareData(bool isMainDataResident);
+
+  /* Converts nFrames PCM frames to a block of BLOCK_FRAMES frames. The rest of
+   * the block is filled with zeros */
+  void DecodePcmBlock(const unsigned char *pData, unsigned nFrames, int *pDst)
+    const;
+
+  /* Decodes one block of the resident main data */
+  void DecodeBlock(unsigned blockIndex, int *pDst) const;
+
   template <typename T>
   inline static int getSampleData(
     const T *data, unsigned position, uint8_t channels, uint8_t channel) {
@@ -183,7 +251,8 @@ public:
     return (a > b) ? a - b : 0;
   }
 
-  GOSoundAudioSection(GOMemoryPool &pool);
+  GOSoundAudioSection(
+    GOMemoryPool &pool, GOSoundStreamStore *pStreamStore = nullptr);
   ~GOSoundAudioSection() { ClearData(); }
 
   GOSoundReleaseAlignTable *GetReleaseAligner() const {
@@ -194,7 +263,12 @@ public:
   uint8_t GetBitsPerSample() const { return m_BitsPerSample; }
   uint8_t GetBytesPerSample() const { return m_BytesPerSample; }
   inline uint8_t GetChannels() const { return m_channels; }
-  bool IsCompressed() const { return m_IsCompressed; }
+  GOSoundCompressionType GetCompressionType() const {
+    return m_CompressionType;
+  }
+  bool IsCompressed() const {
+    return m_CompressionType != GO_COMPRESSION_NONE;
+  }
 
   inline GOBool3 GetWaveTremulantStateFor() const {
     return m_WaveTremulantStateFor;
@@ -206,6 +280,13 @@ public:
     return m_ReleaseCrossfadeLength;
   }
 
+  /**
+   * Returns the highest amplitude a stream may play from the position on. It
+   * is in the units of the decoded samples, so GetNormGain() brings it to the
+   * full scale
+   */
+  float GetRemainingAmplitude(unsigned position) const;
+
   const StartSegment &GetStartSegment(unsigned index) const {
     return m_StartSegments[index];
   }
@@ -216,6 +297,53 @@ public:
 
   const unsigned char *GetData() const { return m_data; }
 
+  inline bool IsStreamed() const { return m_IsStreamed; }
+  GOSoundStreamStore *GetStreamStore() const { return p_StreamStore; }
+
+  /* The number of BLOCK_FRAMES blocks the streamed main data consists of */
+  inline unsigned GetBlockCount() const {
+    return (m_SampleCount + BLOCK_FRAMES - 1) / BLOCK_FRAMES;
+  }
+
+  /**
+   * Returns the decoded frames of a block of a streamed section if they are
+   * resident
+   * @return the pointer to BLOCK_FRAMES interleaving frames or nullptr
+   */
+  inline const int *GetResidentBlock(unsigned blockIndex) const {
+    for (const StreamIsland &island : m_StreamIslands)
+      if (
+        blockIndex >= island.first_block
+        && blockIndex - island.first_block < island.block_count)
+        return island.frames
+          + (blockIndex - island.first_block) * m_channels * BLOCK_FRAMES;
+    return nullptr;
+  }
+
+  /* Returns the first block starting from blockIndex that is not resident */
+  unsigned GetNextStreamedBlock(unsigned blockIndex) const;
+
+  /**
+   * Reads and decodes the blocks of a streamed section from the stream file.
+   * Called by the prefetch threads
+   * @param pDst the buffer of nBlocks * GOSoundStreamStore::BLOCK_SAMPLES.
+   *   The frames of each block are placed at the beginning of its part
+   * @return false if the data could not be read
+   */
+  bool ReadStreamBlocks(
+    GOSoundStreamStore::Reader &reader,
+    unsigned firstBlock,
+    unsigned nBlocks,
+    int *pDst) const;
+
+  /**
+   * Moves the main data to the scratch file of the stream store except the
+   * heads of the start segments. Short sections, legacy compressed ones and
+   * ones that could not be written remain resident
+   * @return whether the section is streamed
+   */
+  bool MoveToStream();
+
   inline int GetSampleData(
     const unsigned char *sampleData, unsigned position, uint8_t channel) const {
     return getSampleData(
@@ -225,6 +353,25 @@ public:
   bool LoadCache(GOCache &cache);
   bool SaveCache(GOCacheWriter &cache) const;
 
+  /* Writes the first nSamples samples of the section in the section format
+   * to pDest */
+  using PcmReader = std::function<void(void *pDest, unsigned nSamples)>;
+
+  /* The samples are read by readPcm straight into the main data blob, so no
+   * intermediate copy of the pcm data is needed */
+  void Setup(
+    const GOCacheObject *pObjectFor,
+    const GOLoaderFilename *pLoaderFilename,
+    const PcmReader &readPcm,
+    GOWave::SAMPLE_FORMAT pcm_data_format,
+    unsigned pcm_data_channels,
+    unsigned pcm_data_sample_rate,
+    unsigned pcm_data_nb_samples,
+    const std::vector<GOWaveLoop> *loop_points,
+    GOBool3 waveTremulantStateFor,
+    bool compress,
+    unsigned loopCrossfadeLength,
+    unsigned releaseCrossfadeLength);
   void Setup(
     const GOCacheObject *pObjectFor,
     const GOLoaderFilename *pLoaderFilename,
@@ -250,7 +397,13 @@ public:
     unsigned position,
     unsigned channel,
     DecompressionCache *cache = nullptr) const {
-    if (!m_IsCompressed) {
+    if (m_IsStreamed) {
+      // only the resident part of a streamed section is available here
+      const int *pBlock = GetResidentBlock(position / BLOCK_FRAMES);
+
+      return pBlock ? pBlock[(position % BLOCK_FRAMES) * m_channels + channel]
+                    : 0;
+    } else if (m_CompressionType == GO_COMPRESSION_NONE) {
       return GetSampleData(m_data, position, channel);
     } else {
       DecompressionCache tmp;
@@ -259,9 +412,13 @@ public:
         InitDecompressionCache(*cache);
       }
 
-      assert(m_BitsPerSample >= 12);
-      DecompressTo(
-        *cache, position, m_data, m_channels, (m_BitsPerSample >= 20));
+      if (m_CompressionType == GO_COMPRESSION_BLOCK)
+        GOSoundBlockCompress::decodeTo(*cache, position, m_data, m_channels);
+      else {
+        assert(m_BitsPerSample >= 12);
+        DecompressTo(
+          *cache, position, m_data, m_channels, (m_BitsPerSample >= 20));
+      }
       return cache->value[channel];
     }
   }
@@ -0,0 +1,360 @@
+/*
+ * Copyright 2026 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#ifndef GOSOUNDBLOCKCOMPRESS_H_
+#define GOSOUNDBLOCKCOMPRESS_H_
+
+#include <cstdint>
+#include <cstring>
+
+#include "GOSoundCompress.h"
+#include "GOSoundResampleSimd.h"
+
+/**
+ * A lossless compression of samples in fixed-size blocks.
+ *
+ * Unlike the format of GOSoundCompress.h, each block may be decoded
+ * independently, so decoding may start at any block boundary, and all residuals
+ * of a block have the same bit width, so they are unpacked with shifts and
+ * masks without any data-dependent branches.
+ *
+ * The layout of the compressed data:
+ * - uint32_t the number of blocks
+ * - uint32_t offsets of each block from the beginning of the data
+ * - the blocks
+ * - PADDING_SIZE zero bytes for unpacking with 64-bit loads
+ *
+ * Each block contains BLOCK_FRAMES frames. For each channel there is a block
+ * header:
+ * - int32_t the first sample x[0]
+ * - int32_t the first difference x[1] - x[0]
+ * - uint8_t the bit width w of the residuals
+ * After the headers of all channels the residuals of each channel follow.
+ * The residuals are the errors of the second order prediction
+ * x[i] - (2 * x[i - 1] - x[i - 2]) in zig-zag encoding. The residual i is
+ * placed at the bit offset i * w, so the residuals of a channel occupy exactly
+ * BLOCK_FRAMES * w / 8 bytes. The residuals 0 and 1 are always 0.
+ *
+ * All values are stored in the native byte order as in GOSoundCompress.h.
+ * The last block is padded with the last sample.
+ */
+class GOSoundBlockCompress {
+public:
+  static constexpr unsigned BLOCK_FRAMES = 64;
+  static constexpr unsigned PADDING_SIZE = sizeof(uint64_t);
+  /* The widest residual that 32 bits loaded at its byte offset contain
+   * entirely. The wider ones are unpacked with the scalar loop */
+  static constexpr uint8_t MAX_GATHER_WIDTH = 25;
+
+private:
+  static constexpr unsigned CHANNEL_HEADER_SIZE
+    = sizeof(int32_t) * 2 + sizeof(uint8_t);
+
+  template <typename T> static inline T load(const unsigned char *p) {
+    T res;
+
+    memcpy(&res, p, sizeof(res));
+    return res;
+  }
+
+  template <typename T> static inline void store(unsigned char *p, T value) {
+    memcpy(p, &value, sizeof(value));
+  }
+
+  static inline uint32_t zigZag(int32_t value) {
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+  }
+
+  static inline int32_t unZigZag(uint32_t value) {
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+  }
+
+  static inline uint8_t bitWidth(uint32_t value) {
+    uint8_t res = 0;
+
+    for (; value; value >>= 1)
+      res++;
+    return res;
+  }
+
+  static inline const unsigned char *getBlockPtr(
+    const unsigned char *data, unsigned blockIndex) {
+    return data + load<uint32_t>(data + getOffsetEntryPos(blockIndex));
+  }
+
+  /**
+   * Extracts one residual
+   * @param pResiduals the packed residuals of the channel
+   * @param width the bit width of each residual
+   * @param mask the mask of width lower bits
+   * @param i the index of the residual in the block
+   */
+  static inline int32_t getResidual(
+    const unsigned char *pResiduals,
+    uint8_t width,
+    uint64_t mask,
+    unsigned i) {
+    const unsigned bitPos = i * width;
+
+    return unZigZag(
+      (load<uint64_t>(pResiduals + bitPos / 8) >> (bitPos % 8)) & mask);
+  }
+
+  /**
+   * Unpacks the residuals of one channel of a block
+   * @param pResiduals the packed residuals of the channel
+   * @param width the bit width of each residual
+   * @param pDst the array for BLOCK_FRAMES residuals
+   */
+  static inline void unpackResiduals(
+    const unsigned char *pResiduals, uint8_t width, int32_t *pDst) {
+#ifdef GO_SOUND_RESAMPLE_SIMD
+    if (
+      width <= MAX_GATHER_WIDTH
+      && GOSoundResampleSimd::getInstructionSet()
+        == GOSoundResampleSimd::IS_AVX2) {
+      unpackResidualsAvx2(pResiduals, width, pDst);
+      return;
+    }
+#endif
+    unpackResidualsScalar(pResiduals, width, pDst);
+  }
+
+public:
+  /* The portable variant of unpackResiduals(). Public for testing */
+  static inline void unpackResidualsScalar(
+    const unsigned char *pResiduals, uint8_t width, int32_t *pDst) {
+    const uint64_t mask = (uint64_t(1) << width) - 1;
+
+    for (unsigned i = 0; i < BLOCK_FRAMES; i++)
+      pDst[i] = getResidual(pResiduals, width, mask, i);
+  }
+
+#ifdef GO_SOUND_RESAMPLE_SIMD
+  /**
+   * The AVX2 variant of unpackResiduals() for width <= MAX_GATHER_WIDTH. It
+   * unpacks 8 residuals per step: gathers 32 bits at the byte offset of each
+   * residual, shifts them by the bit offset, masks and decodes the zig-zag
+   */
+  GO_TARGET_AVX2 static void unpackResidualsAvx2(
+    const unsigned char *pResiduals, uint8_t width, int32_t *pDst) {
+    const __m256i vWidth = _mm256_set1_epi32(width);
+    const __m256i mask = _mm256_set1_epi32((int32_t)((1u << width) - 1));
+    const __m256i bitOffsetMask = _mm256_set1_epi32(7);
+    const __m256i one = _mm256_set1_epi32(1);
+    __m256i index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+    for (unsigned i = 0; i < BLOCK_FRAMES; i += 8) {
+      const __m256i bitPos = _mm256_mullo_epi32(index, vWidth);
+      const __m256i bits = _mm256_i32gather_epi32(
+        (const int *)pResiduals, _mm256_srli_epi32(bitPos, 3), 1);
+      const __m256i value = _mm256_and_si256(
+        _mm256_srlv_epi32(bits, _mm256_and_si256(bitPos, bitOffsetMask)),
+        mask);
+      const __m256i residual = _mm256_xor_si256(
+        _mm256_srli_epi32(value, 1),
+        _mm256_sub_epi32(
+          _mm256_setzero_si256(), _mm256_and_si256(value, one)));
+
+      _mm256_storeu_si256((__m256i *)(pDst + i), residual);
+      index = _mm256_add_epi32(index, _mm256_set1_epi32(8));
+    }
+  }
+#endif
+
+  /**
+   * @return the number of blocks in the compressed data
+   */
+  static inline unsigned getBlockCount(const unsigned char *data) {
+    return load<uint32_t>(data);
+  }
+
+  /**
+   * @return the position of the offset of the block in the compressed data.
+   *   The offset itself is an uint32_t
+   */
+  static inline unsigned getOffsetEntryPos(unsigned blockIndex) {
+    return (blockIndex + 1) * sizeof(uint32_t);
+  }
+
+  /**
+   * Compresses the samples
+   * @param nFrames the number of frames to compress
+   * @param nChannels the number of channels
+   * @param getSample a functor returning the sample for (position, channel)
+   * @param dst the buffer of the compressed data
+   * @param dstSize the size of dst
+   * @return the size of the compressed data or 0 if the compressed data would
+   *   not fit into dstSize bytes
+   */
+  template <class GetSampleF>
+  static unsigned encode(
+    unsigned nFrames,
+    uint8_t nChannels,
+    GetSampleF getSample,
+    unsigned char *dst,
+    unsigned dstSize) {
+    const unsigned nBlocks = (nFrames + BLOCK_FRAMES - 1) / BLOCK_FRAMES;
+    unsigned pos = (nBlocks + 1) * sizeof(uint32_t);
+
+    if (pos + PADDING_SIZE > dstSize)
+      return 0;
+    store<uint32_t>(dst, nBlocks);
+    for (unsigned block = 0; block < nBlocks; block++) {
+      const unsigned blockStart = block * BLOCK_FRAMES;
+      unsigned char *pHeader = dst + pos;
+      unsigned residualsPos = pos + nChannels * CHANNEL_HEADER_SIZE;
+
+      if (residualsPos + PADDING_SIZE > dstSize)
+        return 0;
+      store<uint32_t>(dst + (block + 1) * sizeof(uint32_t), pos);
+      for (uint8_t ch = 0; ch < nChannels; ch++) {
+        int32_t x[BLOCK_FRAMES];
+        uint32_t residuals[BLOCK_FRAMES];
+        uint32_t maxResidual = 0;
+
+        for (unsigned i = 0; i < BLOCK_FRAMES; i++)
+          x[i] = blockStart + i < nFrames ? getSample(blockStart + i, ch)
+                                          : x[i - 1];
+        residuals[0] = residuals[1] = 0;
+        for (unsigned i = 2; i < BLOCK_FRAMES; i++) {
+          residuals[i] = zigZag(x[i] - 2 * x[i - 1] + x[i - 2]);
+          maxResidual |= residuals[i];
+        }
+
+        const uint8_t width = bitWidth(maxResidual);
+        const unsigned residualsSize = BLOCK_FRAMES * width / 8;
+
+        if (residualsPos + residualsSize + PADDING_SIZE > dstSize)
+          return 0;
+        store<int32_t>(pHeader, x[0]);
+        store<int32_t>(pHeader + sizeof(int32_t), x[1] - x[0]);
+        pHeader[sizeof(int32_t) * 2] = width;
+        pHeader += CHANNEL_HEADER_SIZE;
+
+        unsigned char *pResiduals = dst + residualsPos;
+
+        memset(pResiduals, 0, residualsSize);
+        for (unsigned i = 0; i < BLOCK_FRAMES; i++) {
+          const unsigned bitPos = i * width;
+          // the residual may span over 5 bytes
+          uint64_t bits = (uint64_t)residuals[i] << (bitPos % 8);
+
+          for (unsigned char *p = pResiduals + bitPos / 8; bits; bits >>= 8)
+            *(p++) |= (unsigned char)bits;
+        }
+        residualsPos += residualsSize;
+      }
+      pos = residualsPos;
+    }
+    memset(dst + pos, 0, PADDING_SIZE);
+    return pos + PADDING_SIZE;
+  }
+
+  /**
+   * Decodes one block
+   * @param data the compressed data
+   * @param blockIndex the index of the block
+   * @param nChannels the number of channels
+   * @param pDst the buffer for BLOCK_FRAMES interleaving frames
+   */
+  static inline void decodeBlock(
+    const unsigned char *data,
+    unsigned blockIndex,
+    uint8_t nChannels,
+    int *pDst) {
+    decodeBlockAt(getBlockPtr(data, blockIndex), nChannels, pDst);
+  }
+
+  /**
+   * Decodes one block that is not necessarily inside the whole compressed data
+   * @param pBlock the beginning of the block. At least PADDING_SIZE readable
+   *   bytes must follow the block
+   * @param nChannels the number of channels
+   * @param pDst the buffer for BLOCK_FRAMES interleaving frames
+   */
+  static inline void decodeBlockAt(
+    const unsigned char *pBlock, uint8_t nChannels, int *pDst) {
+    const unsigned char *pHeader = pBlock;
+    const unsigned char *pResiduals = pHeader + nChannels * CHANNEL_HEADER_SIZE;
+
+    for (uint8_t ch = 0; ch < nChannels; ch++) {
+      const uint8_t width = pHeader[sizeof(int32_t) * 2];
+      int32_t residuals[BLOCK_FRAMES];
+      int32_t x = load<int32_t>(pHeader);
+      int32_t d = 0;
+      int *pOut = pDst + ch;
+
+      unpackResiduals(pResiduals, width, residuals);
+      residuals[1] = load<int32_t>(pHeader + sizeof(int32_t));
+      *pOut = x;
+      for (unsigned i = 1; i < BLOCK_FRAMES; i++) {
+        d += residuals[i];
+        x += d;
+        pOut += nChannels;
+        *pOut = x;
+      }
+      pHeader += CHANNEL_HEADER_SIZE;
+      pResiduals += BLOCK_FRAMES * width / 8;
+    }
+  }
+
+  /**
+   * Decodes the samples sequentially up to the position. It is intended for
+   * not realtime usage with subsequent positions where decoding of whole
+   * blocks is too expensive.
+   * After the call cache.value contains the samples at the position and
+   * cache.prev contains the previous samples for continuing the prediction
+   * @param cache the decoding state. It must be initialised with
+   *   InitDecompressionCache()
+   * @param position the position of the samples to decode
+   * @param data the compressed data
+   * @param nChannels the number of channels
+   */
+  static inline void decodeTo(
+    DecompressionCache &cache,
+    unsigned position,
+    const unsigned char *data,
+    uint8_t nChannels) {
+    const unsigned blockIndex = position / BLOCK_FRAMES;
+    const unsigned char *pHeader = getBlockPtr(data, blockIndex);
+
+    if (
+      cache.ptr != pHeader || cache.position > position
+      || cache.position / BLOCK_FRAMES != blockIndex) {
+      // start the block. x[-1] is chosen for predicting x[1] without residual
+      const unsigned char *pChannelHeader = pHeader;
+
+      for (uint8_t ch = 0; ch < nChannels; ch++) {
+        cache.value[ch] = load<int32_t>(pChannelHeader);
+        cache.prev[ch]
+          = cache.value[ch] - load<int32_t>(pChannelHeader + sizeof(int32_t));
+        pChannelHeader += CHANNEL_HEADER_SIZE;
+      }
+      cache.position = blockIndex * BLOCK_FRAMES;
+      cache.ptr = pHeader;
+    }
+    while (cache.position < position) {
+      const unsigned i = ++cache.position % BLOCK_FRAMES;
+      const unsigned char *pChannelHeader = pHeader;
+      const unsigned char *pResiduals
+        = pHeader + nChannels * CHANNEL_HEADER_SIZE;
+
+      for (uint8_t ch = 0; ch < nChannels; ch++) {
+        const uint8_t width = pChannelHeader[sizeof(int32_t) * 2];
+        const int value = 2 * cache.value[ch] - cache.prev[ch]
+          + getResidual(pResiduals, width, (uint64_t(1) << width) - 1, i);
+
+        cache.prev[ch] = cache.value[ch];
+        cache.value[ch] = value;
+        pChannelHeader += CHANNEL_HEADER_SIZE;
+        pResiduals += BLOCK_FRAMES * width / 8;
+      }
+    }
+  }
+};
+
+#endif /* GOSOUNDBLOCKCOMPRESS_H_ */
@@ -13,6 +13,16 @@
 
 #include "GOSoundDefs.h"
 
+/* How the sample data of an audio section are encoded. It is stored in the
+ * cache as one byte */
+enum GOSoundCompressionType : uint8_t {
+  GO_COMPRESSION_NONE = 0,
+  // the variable length predictive format of this file
+  GO_COMPRESSION_PREDICTIVE = 1,
+  // the block format of GOSoundBlockCompress.h
+  GO_COMPRESSION_BLOCK = 2,
+};
+
 static inline int AudioReadCompressed8(const unsigned char *&ptr) {
   int val = *(const int8_t *)ptr;
   if (val & 0x01) {
@@ -1,6 +1,6 @@
 /*
  * Copyright 2006 Milan Digital Audio LLC
- * Copyright 2009-2024 GrandOrgue contributors (see AUTHORS)
+ * Copyright 2009-2026 GrandOrgue contributors (see AUTHORS)
  * License GPL-2.0 or later
  * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
  */
@@ -24,20 +24,37 @@
 #include "GOSoundRecorder.h"
 #include "GOSoundReleaseAlignTable.h"
 #include "GOSoundSampler.h"
+#include "GOSoundStreamStore.h"
+
+// the moment of receiving the midi event processed by the current thread
+static thread_local std::chrono::steady_clock::time_point t_EventTime;
+// the offset of the samplers started by the current thread in the next period
+static thread_local unsigned t_EventOffset = 0;
 
 GOSoundEngine::GOSoundEngine()
   : m_PolyphonyLimiting(true),
+    m_RenderLoad(0),
+    m_LoadPressure(0),
+    m_InaudibleLevel(0),
     m_ScaledReleases(true),
     m_ReleaseAlignmentEnabled(true),
     m_RandomizeSpeaking(true),
+    m_IsDeterministic(false),
+    m_IsSubmixBuses(true),
     m_Volume(-15),
     m_SamplesPerBuffer(1),
     m_Gain(1),
     m_SampleRate(0),
+    m_OutputSampleRate(0),
+    m_OutputSamplesPerBuffer(1),
+    m_UpsampleFactor(1),
     m_CurrentTime(1),
     m_SamplerPool(),
+    m_StreamStore(nullptr),
     m_AudioGroupCount(1),
+    m_Concurrency(1),
     m_UsedPolyphony(0),
+    m_NextSamplerSequence(0),
     m_MeterInfo(1),
     m_TremulantTasks(),
     m_WindchestTasks(),
@@ -48,6 +65,7 @@ GOSoundEngine::GOSoundEngine()
     m_HasBeenSetup(false) {
   m_SamplerPool.SetUsageLimit(2048);
   m_PolyphonySoftLimit = (m_SamplerPool.GetUsageLimit() * 3) / 4;
+  m_ReleaseLimit.store(m_PolyphonySoftLimit, std::memory_order_relaxed);
   m_ReleaseProcessor = new GOSoundReleaseTask(*this, m_AudioGroupTasks);
   Reset();
 }
@@ -78,11 +96,37 @@ void GOSoundEngine::Reset() {
     m_Scheduler.Add(m_ReleaseProcessor);
     if (m_TouchTask)
       m_Scheduler.Add(m_TouchTask.get());
+
+    // the task graph of a period: tremulants -> windchests -> audio groups ->
+    // outputs -> recorder. The releases and the memory touching do not
+    // delay the audio groups and the outputs
+    for (GOSoundWindchestTask *pWindchest : m_WindchestTasks)
+      for (GOSoundTremulantTask *pTremulant : pWindchest->GetTremulantTasks())
+        m_Scheduler.AddDependency(pWindchest, pTremulant);
+    for (GOSoundGroupTask *pGroup : m_AudioGroupTasks) {
+      for (GOSoundWindchestTask *pWindchest : m_WindchestTasks)
+        m_Scheduler.AddDependency(pGroup, pWindchest);
+      m_Scheduler.AddDependency(m_ReleaseProcessor, pGroup);
+      for (GOSoundOutputTask *pOutput : m_AudioOutputTasks)
+        m_Scheduler.AddDependency(pOutput, pGroup);
+    }
+    for (GOSoundOutputTask *pOutput : m_AudioOutputTasks) {
+      m_Scheduler.AddDependency(m_AudioRecorder, pOutput);
+      m_Scheduler.AddDependency(m_TouchTask.get(), pOutput);
+    }
   }
   m_UsedPolyphony.store(0);
+  m_RenderLoad.store(0, std::memory_order_relaxed);
+  m_LoadPressure.store(0, std::memory_order_relaxed);
+  m_ReleaseLimit.store(m_PolyphonySoftLimit, std::memory_order_relaxed);
 
   m_SamplerPool.ReturnAll();
+  if (m_StreamStore)
+    m_StreamStore->ReleaseAllSlots();
+  m_NextSamplerSequence.store(0);
   m_CurrentTime = 1;
+  m_PrevPeriodStartTime.store(0, std::memory_order_relaxed);
+  m_PeriodStartTime.store(0, std::memory_order_relaxed);
   m_Scheduler.Reset();
 }
 
@@ -94,11 +138,34 @@ void GOSoundEngine::SetVolume(int volume) {
 float GOSoundEngine::GetGain() { return m_Gain; }
 
 void GOSoundEngine::SetSamplesPerBuffer(unsigned samples_per_buffer) {
+  m_OutputSamplesPerBuffer = samples_per_buffer;
   m_SamplesPerBuffer = samples_per_buffer;
+  m_UpsampleFactor = 1;
 }
 
 void GOSoundEngine::SetSampleRate(unsigned sample_rate) {
+  m_OutputSampleRate = sample_rate;
   m_SampleRate = sample_rate;
+  m_UpsampleFactor = 1;
+}
+
+bool GOSoundEngine::SetRenderSampleRate(unsigned render_sample_rate) {
+  unsigned factor = 1;
+  bool isOk = true;
+
+  if (render_sample_rate && render_sample_rate < m_OutputSampleRate) {
+    factor = m_OutputSampleRate / render_sample_rate;
+    if (
+      m_OutputSampleRate % render_sample_rate
+      || m_OutputSamplesPerBuffer % factor) {
+      factor = 1;
+      isOk = false;
+    }
+  }
+  m_UpsampleFactor = factor;
+  m_SampleRate = m_OutputSampleRate / factor;
+  m_SamplesPerBuffer = m_OutputSamplesPerBuffer / factor;
+  return isOk;
 }
 
 void GOSoundEngine::SetInterpolationType(unsigned type) {
@@ -108,18 +175,34 @@ void GOSoundEngine::SetInterpolationType(unsigned type) {
 unsigned GOSoundEngine::GetSampleRate() { return m_SampleRate; }
 
 void GOSoundEngine::SetHardPolyphony(unsigned polyphony) {
+  // before the pool may give more samplers to the groups
+  for (GOSoundGroupTask *pGroup : m_AudioGroupTasks)
+    pGroup->ReserveVoices(polyphony);
   m_SamplerPool.SetUsageLimit(polyphony);
   m_PolyphonySoftLimit = (m_SamplerPool.GetUsageLimit() * 3) / 4;
+  m_ReleaseLimit.store(m_PolyphonySoftLimit, std::memory_order_relaxed);
+}
+
+void GOSoundEngine::SetInaudibleLevel(int level) {
+  m_InaudibleLevel = level < 0 ? powf(10.0f, level * 0.05f) : 0;
 }
 
 void GOSoundEngine::SetPolyphonyLimiting(bool limiting) {
   m_PolyphonyLimiting = limiting;
+  if (!limiting) {
+    m_LoadPressure.store(0, std::memory_order_relaxed);
+    m_ReleaseLimit.store(m_PolyphonySoftLimit, std::memory_order_relaxed);
+  }
 }
 
 unsigned GOSoundEngine::GetHardPolyphony() const {
   return m_SamplerPool.GetUsageLimit();
 }
 
+void GOSoundEngine::SetConcurrency(unsigned concurrency) {
+  m_Concurrency = std::max(concurrency, 1u);
+}
+
 void GOSoundEngine::SetAudioGroupCount(unsigned groups) {
   if (groups < 1)
     groups = 1;
@@ -127,7 +210,10 @@ void GOSoundEngine::SetAudioGroupCount(unsigned groups) {
   m_AudioGroupTasks.clear();
   for (unsigned i = 0; i < m_AudioGroupCount; i++)
     m_AudioGroupTasks.push_back(
-      new GOSoundGroupTask(*this, m_SamplesPerBuffer));
+      new GOSoundGroupTask(*this, m_SamplesPerBuffer, m_Concurrency));
+  if (m_HasBeenSetup.load())
+    for (GOSoundGroupTask *pGroup : m_AudioGroupTasks)
+      pGroup->SetupBuses(m_WindchestTasks.size());
 }
 
 unsigned GOSoundEngine::GetAudioGroupCount() { return m_AudioGroupCount; }
@@ -142,6 +228,10 @@ void GOSoundEngine::SetRandomizeSpeaking(bool enable) {
   m_RandomizeSpeaking = enable;
 }
 
+void GOSoundEngine::SetDeterministic(bool isDeterministic) {
+  m_IsDeterministic = isDeterministic;
+}
+
 float GOSoundEngine::GetRandomFactor() {
   if (m_RandomizeSpeaking) {
     const double factor = (pow(2, 1.0 / 1200.0) - 1) / (RAND_MAX / 2);
@@ -184,6 +274,7 @@ void GOSoundEngine::ClearSetup() {
   m_TremulantTasks.clear();
   m_TouchTask = NULL;
   Reset();
+  m_StreamStore = nullptr;
 }
 
 void GOSoundEngine::Setup(
@@ -202,8 +293,11 @@ void GOSoundEngine::Setup(
   for (unsigned i = 0; i < organController->GetWindchestCount(); i++)
     m_WindchestTasks.push_back(
       new GOSoundWindchestTask(*this, organController->GetWindchest(i)));
+  for (GOSoundGroupTask *pGroup : m_AudioGroupTasks)
+    pGroup->SetupBuses(m_WindchestTasks.size());
   m_TouchTask = std::unique_ptr<GOSoundTouchTask>(
     new GOSoundTouchTask(organController->GetMemoryPool()));
+  m_StreamStore = organController->GetStreamStore();
   m_HasBeenSetup.store(true);
   Reset();
 }
@@ -212,17 +306,45 @@ bool GOSoundEngine::ProcessSampler(
   float *output_buffer,
   GOSoundSampler *sampler,
   unsigned n_frames,
-  float volume) {
+  float volume,
+  const float *pEnvelope,
+  bool isToFilter) {
   float temp[n_frames * 2];
   const bool process_sampler = (sampler->time <= m_CurrentTime);
 
+  if (
+    process_sampler
+    && sampler->event_time != std::chrono::steady_clock::time_point()) {
+    // a sampler started by a midi event sounds from the moment of the event
+    sampler->start_offset = EventTimeToOffset(sampler->event_time, n_frames);
+    sampler->event_time = std::chrono::steady_clock::time_point();
+  }
+  if (process_sampler && sampler->start_offset >= n_frames) {
+    // the event has been received after the current period start
+    sampler->start_offset -= n_frames;
+    return true;
+  }
   if (process_sampler) {
+    const float loadPressure = m_LoadPressure.load(std::memory_order_relaxed);
+
+    if (
+      sampler->is_release
+      && ((loadPressure > 0
+           && sampler->fader.IsFadedBelow(loadPressure * LOAD_INAUDIBLE_FADE))
+          || IsInaudible(sampler))) {
+      // the rest of the release is not worth its render time
+      ReturnSampler(sampler);
+      return false;
+    }
+    // the releases are shortened more the higher the render load is
     if (sampler->is_release &&
         ((m_PolyphonyLimiting &&
-          m_SamplerPool.UsedSamplerCount() >= m_PolyphonySoftLimit &&
+          m_SamplerPool.UsedSamplerCount()
+            >= m_ReleaseLimit.load(std::memory_order_relaxed) &&
           m_CurrentTime - sampler->time > 172 * 16) ||
          sampler->drop_counter > 1))
-      sampler->fader.StartDecreasingVolume(MsToSamples(370));
+      sampler->fader.StartDecreasingVolume(
+        MsToSamples(370 - (unsigned)(270 * loadPressure)));
 
     /* The decoded sampler frame will contain values containing
      * sampler->pipe_section->sample_bits worth of significant bits.
@@ -232,19 +354,27 @@ bool GOSoundEngine::ProcessSampler(
      *
      *     playback gain * (2 ^ -sampler->pipe_section->sample_bits)
      */
-    if (!sampler->stream.ReadBlock(temp, n_frames))
-      sampler->p_SoundProvider = NULL;
+    const unsigned nLeadFrames = sampler->start_offset;
+    const unsigned nSoundFrames = n_frames - nLeadFrames;
 
-    sampler->fader.Process(n_frames, temp, volume);
-    if (sampler->toneBalanceFilterState.IsToApply())
-      sampler->toneBalanceFilterState.ProcessBuffer(n_frames, temp);
+    sampler->start_offset = 0;
+    if (!sampler->stream.ReadBlock(temp, nSoundFrames))
+      sampler->p_SoundProvider = NULL;
 
-    /* Add these samples to the current output buffer shifting
-     * right by the necessary amount to bring the sample gain back
-     * to unity (this value is computed in GOPipe.cpp)
+    /* Apply the gain ramp, the tremulant envelope and the tone balance filter
+     * and add the samples to the current output buffer in one pass. The gain
+     * brings the sample gain back to unity (this value is computed in
+     * GOPipe.cpp)
      */
-    for (unsigned i = 0; i < n_frames * 2; i++)
-      output_buffer[i] += temp[i];
+    sampler->fader.ProcessAndMix(
+      nSoundFrames,
+      temp,
+      output_buffer + nLeadFrames * 2,
+      volume,
+      isToFilter && sampler->toneBalanceFilterState.IsToApply()
+        ? &sampler->toneBalanceFilterState
+        : nullptr,
+      pEnvelope ? pEnvelope + nLeadFrames : nullptr);
 
     if (
       (sampler->stop && sampler->stop <= m_CurrentTime)
@@ -263,6 +393,19 @@ bool GOSoundEngine::ProcessSampler(
     return true;
 }
 
+bool GOSoundEngine::IsInaudible(const GOSoundSampler *sampler) const {
+  if (!m_InaudibleLevel || !sampler->p_SoundProvider)
+    return false;
+
+  /* The windchest volume contains the enclosures, the engine gain and the
+   * highest tremulant modulation, which may exceed 1 */
+  const float volume = sampler->fader.GetPeakVolume()
+    * (sampler->p_WindchestTask ? sampler->p_WindchestTask->GetMaxVolume()
+                                : 1);
+
+  return sampler->stream.GetRemainingAmplitude() * volume < m_InaudibleLevel;
+}
+
 void GOSoundEngine::ProcessRelease(GOSoundSampler *sampler) {
   if (sampler->stop) {
     CreateReleaseSampler(sampler);
@@ -275,6 +418,7 @@ void GOSoundEngine::ProcessRelease(GOSoundSampler *sampler) {
 }
 
 void GOSoundEngine::ReturnSampler(GOSoundSampler *sampler) {
+  sampler->stream.ReleaseStreamSlot();
   m_SamplerPool.ReturnSampler(sampler);
 }
 
@@ -292,7 +436,8 @@ void GOSoundEngine::SetAudioOutput(
       scale_factors[i * 4 + 3] = 1;
     }
     m_AudioOutputTasks.push_back(
-      new GOSoundOutputTask(2, scale_factors, m_SamplesPerBuffer));
+      new GOSoundOutputTask(
+        2, scale_factors, m_OutputSamplesPerBuffer, m_UpsampleFactor));
   }
   unsigned channels = 0;
   for (unsigned i = 0; i < audio_outputs.size(); i++) {
@@ -311,7 +456,10 @@ void GOSoundEngine::SetAudioOutput(
         scale_factors[j * m_AudioGroupCount * 2 + k] = factor;
       }
     m_AudioOutputTasks.push_back(new GOSoundOutputTask(
-      audio_outputs[i].channels, scale_factors, m_SamplesPerBuffer));
+      audio_outputs[i].channels,
+      scale_factors,
+      m_OutputSamplesPerBuffer,
+      m_UpsampleFactor));
     channels += audio_outputs[i].channels;
   }
   std::vector<GOSoundBufferItem *> outputs;
@@ -334,13 +482,13 @@ void GOSoundEngine::SetAudioRecorder(GOSoundRecorder *recorder, bool downmix) {
     for (unsigned i = 1; i < m_AudioOutputTasks.size(); i++)
       outputs.push_back(m_AudioOutputTasks[i]);
   }
-  m_AudioRecorder->SetOutputs(outputs, m_SamplesPerBuffer);
+  m_AudioRecorder->SetOutputs(outputs, m_OutputSamplesPerBuffer);
 }
 
 void GOSoundEngine::SetupReverb(GOConfig &settings) {
   for (unsigned i = 0; i < m_AudioOutputTasks.size(); i++)
     if (m_AudioOutputTasks[i])
-      m_AudioOutputTasks[i]->SetupReverb(settings);
+      m_AudioOutputTasks[i]->SetupReverb(settings, m_SampleRate);
 }
 
 unsigned GOSoundEngine::GetBufferSizeFor(
@@ -357,6 +505,8 @@ void GOSoundEngine::GetEmptyAudioOutput(
 void GOSoundEngine::GetAudioOutput(
   float *output_buffer, unsigned n_frames, unsigned audio_output, bool last) {
   if (m_HasBeenSetup.load()) {
+    if (m_IsDeterministic)
+      m_Scheduler.RunUntilComplete();
     m_AudioOutputTasks[audio_output + 1]->Finish(last);
     memcpy(
       output_buffer,
@@ -367,16 +517,87 @@ void GOSoundEngine::GetAudioOutput(
 }
 
 void GOSoundEngine::NextPeriod() {
+  FinishPeriod();
+  StartPeriod();
+}
+
+void GOSoundEngine::FinishPeriod() {
+  if (m_IsDeterministic)
+    m_Scheduler.RunUntilComplete();
   m_Scheduler.Exec();
+  if (m_PolyphonyLimiting && !m_IsDeterministic)
+    UpdateRenderLoad(m_Scheduler.GetPeriodWorkTime());
 
   m_CurrentTime += m_SamplesPerBuffer;
   unsigned used_samplers = m_SamplerPool.UsedSamplerCount();
   if (used_samplers > m_UsedPolyphony.load())
     m_UsedPolyphony.store(used_samplers);
+}
+
+void GOSoundEngine::UpdateRenderLoad(std::chrono::microseconds workTime) {
+  const float periodUs = m_SamplesPerBuffer * 1000000.0f / m_SampleRate;
+  const float load = workTime.count() / periodUs;
 
+  float renderLoad = m_RenderLoad.load(std::memory_order_relaxed);
+
+  if (load >= renderLoad)
+    renderLoad = load;
+  else
+    renderLoad += (load - renderLoad)
+      * std::min(periodUs / (LOAD_RELAX_MS * 1000.0f), 1.0f);
+
+  const float loadPressure = std::clamp(
+    (renderLoad - LOAD_HEADROOM_LIMIT) / (LOAD_OVERLOAD - LOAD_HEADROOM_LIMIT),
+    0.0f,
+    1.0f);
+
+  m_RenderLoad.store(renderLoad, std::memory_order_relaxed);
+  m_LoadPressure.store(loadPressure, std::memory_order_relaxed);
+  // down to a quarter of the soft limit at the most load pressure
+  m_ReleaseLimit.store(
+    m_PolyphonySoftLimit
+      - (unsigned)(m_PolyphonySoftLimit * 0.75f * loadPressure),
+    std::memory_order_relaxed);
+}
+
+void GOSoundEngine::StartPeriod() {
+  // the scheduler publishes them to the sound threads with the period
+  m_PrevPeriodStartTime.store(
+    m_PeriodStartTime.load(std::memory_order_relaxed),
+    std::memory_order_relaxed);
+  m_PeriodStartTime.store(
+    std::chrono::steady_clock::now().time_since_epoch().count(),
+    std::memory_order_relaxed);
   m_Scheduler.Reset();
 }
 
+void GOSoundEngine::SetEventTime(
+  std::chrono::steady_clock::time_point eventTime) {
+  t_EventTime = eventTime;
+}
+
+void GOSoundEngine::SetEventOffset(unsigned frames) {
+  t_EventOffset = std::min(frames, m_SamplesPerBuffer - 1);
+}
+
+unsigned GOSoundEngine::EventTimeToOffset(
+  std::chrono::steady_clock::time_point eventTime, unsigned nFrames) const {
+  const int64_t prevStart
+    = m_PrevPeriodStartTime.load(std::memory_order_relaxed);
+  const int64_t curStart = m_PeriodStartTime.load(std::memory_order_relaxed);
+  // both are in the steady_clock ticks, so the ratio does not depend on units
+  const int64_t periodTicks = curStart - prevStart;
+  const int64_t eventTicks = eventTime.time_since_epoch().count() - prevStart;
+
+  /* An event received during the previous period is played at the same
+   * relative position in the current one, so the latency is one period. An
+   * event processed too late for it is played at the period beginning */
+  if (!prevStart || periodTicks <= 0 || eventTicks <= 0)
+    return 0;
+  return (unsigned)std::min(
+    eventTicks * nFrames / periodTicks, 2 * (int64_t)nFrames - 1);
+}
+
 unsigned GOSoundEngine::SamplesDiffToMs(
   uint64_t fromSamples, uint64_t toSamples) const {
   return (unsigned)std::min(
@@ -423,6 +644,9 @@ GOSoundSampler *GOSoundEngine::CreateTaskSample(
         playback_gain, pSoundProvider->GetVelocityVolume(velocity));
       sampler->delay = delay_samples;
       sampler->time = start_time;
+      sampler->event_time = t_EventTime;
+      sampler->start_offset = t_EventOffset;
+      sampler->sequence = m_NextSamplerSequence.fetch_add(1);
       sampler->toneBalanceFilterState.Init(
         sampler->p_SoundProvider->GetToneBalance()->GetFilter());
       sampler->is_release = isRelease;
@@ -505,13 +729,20 @@ void GOSoundEngine::CreateReleaseSampler(GOSoundSampler *handle) {
     ? m_WindchestTasks[windchestTaskToIndex(taskId)]->GetWindchestVolume()
     : 1.0f;
 
+  // under a render load no more releases are started above the release limit
+  const bool isReleaseCapped
+    = m_LoadPressure.load(std::memory_order_relaxed) > 0
+    && m_SamplerPool.UsedSamplerCount()
+      >= m_ReleaseLimit.load(std::memory_order_relaxed);
+
   // FIXME: this is wrong... the intention is to not create a release for a
   // sample being played back with zero amplitude but this is a comparison
   // against a double. We should test against a minimum level.
-  if (vol && release_section) {
+  if (vol && release_section && !isReleaseCapped) {
     GOSoundSampler *new_sampler = m_SamplerPool.GetSampler();
     if (new_sampler != NULL) {
       new_sampler->p_SoundProvider = this_pipe;
+      new_sampler->sequence = handle->sequence;
       new_sampler->time = m_CurrentTime + 1;
       new_sampler->m_WaveTremulantStateFor
         = release_section->GetWaveTremulantStateFor();
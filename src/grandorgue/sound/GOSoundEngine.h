@@ -1,6 +1,6 @@
 /*
  * Copyright 2006 Milan Digital Audio LLC
- * Copyright 2009-2024 GrandOrgue contributors (see AUTHORS)
+ * Copyright 2009-2026 GrandOrgue contributors (see AUTHORS)
  * License GPL-2.0 or later
  * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
  */
@@ -9,6 +9,7 @@
 #define GOSOUNDENGINE_H_
 
 #include <atomic>
+#include <chrono>
 #include <vector>
 
 #include "scheduler/GOSoundScheduler.h"
@@ -20,6 +21,7 @@
 class GOWindchest;
 class GOSoundProvider;
 class GOSoundRecorder;
+class GOSoundStreamStore;
 class GOSoundGroupTask;
 class GOSoundOutputTask;
 class GOSoundReleaseTask;
@@ -38,22 +40,64 @@ typedef struct {
 class GOSoundEngine {
 private:
   static constexpr int DETACHED_RELEASE_TASK_ID = 0;
+  // the render load (the render time relative to the period duration) the
+  // polyphony starts to be reduced at and the load it is reduced most at
+  static constexpr float LOAD_HEADROOM_LIMIT = 0.7f;
+  static constexpr float LOAD_OVERLOAD = 0.95f;
+  // how long the polyphony reduction relaxes after the load has fallen
+  static constexpr unsigned LOAD_RELAX_MS = 2000;
+  // the part of its own volume a fading release is dropped below at the most
+  // load pressure
+  static constexpr float LOAD_INAUDIBLE_FADE = 0.1f;
 
   unsigned m_PolyphonySoftLimit;
   bool m_PolyphonyLimiting;
+  /* The render load of the recent periods. It follows a rise at once and
+   * relaxes in LOAD_RELAX_MS, so a CPU spike is ridden out without xruns.
+   * The load state is updated at the end of a period and read by the sound
+   * threads, so it is atomic. The relaxed order is enough: each value is used
+   * alone */
+  std::atomic<float> m_RenderLoad;
+  // 0 .. 1: how much the polyphony is reduced because of the render load
+  std::atomic<float> m_LoadPressure;
+  // the number of samplers above which the old releases are faded out
+  std::atomic_uint m_ReleaseLimit;
+  // the amplitude the releases are retired below. 0 means never
+  float m_InaudibleLevel;
   bool m_ScaledReleases;
   bool m_ReleaseAlignmentEnabled;
   bool m_RandomizeSpeaking;
+  // whether the result must not depend on the timing of the sound threads
+  bool m_IsDeterministic;
+  bool m_IsSubmixBuses;
   int m_Volume;
+  // the number of frames rendered in one period at m_SampleRate
   unsigned m_SamplesPerBuffer;
   float m_Gain;
+  // the sample rate the voices, the tremulants and the reverb are rendered at
   unsigned m_SampleRate;
+  // the sample rate and the period size of the sound device
+  unsigned m_OutputSampleRate;
+  unsigned m_OutputSamplesPerBuffer;
+  // m_OutputSampleRate / m_SampleRate
+  unsigned m_UpsampleFactor;
 
   // time in samples
   uint64_t m_CurrentTime;
+  /* The steady_clock ticks of starting the previous and the current periods.
+   * Written by the audio callback between the periods and read by the sound
+   * threads while rendering */
+  std::atomic_int64_t m_PrevPeriodStartTime;
+  std::atomic_int64_t m_PeriodStartTime;
   GOSoundSamplerPool m_SamplerPool;
+  // the stream store of the organ if the samples are streamed from disk
+  GOSoundStreamStore *m_StreamStore;
   unsigned m_AudioGroupCount;
+  // the number of the sound threads
+  unsigned m_Concurrency;
   std::atomic_uint m_UsedPolyphony;
+  // the sequence number of the next sampler started by an event
+  std::atomic_uint64_t m_NextSamplerSequence;
   std::vector<double> m_MeterInfo;
   ptr_vector<GOSoundTremulantTask> m_TremulantTasks;
   ptr_vector<GOSoundWindchestTask> m_WindchestTasks;
@@ -73,6 +117,28 @@ private:
 
   unsigned SamplesDiffToMs(uint64_t fromSamples, uint64_t toSamples) const;
 
+  /**
+   * Returns whether the release sampler will stay below m_InaudibleLevel until
+   * its end. The section envelope and the fader volume never rise in a
+   * release, unless the enclosure is opened. The tremulants are counted with
+   * their highest gain
+   */
+  bool IsInaudible(const GOSoundSampler *sampler) const;
+
+  /**
+   * Updates the load pressure and the release limit from the render time of
+   * the period just finished
+   */
+  void UpdateRenderLoad(std::chrono::microseconds workTime);
+
+  /**
+   * Returns the number of silent frames before a sampler started by a midi
+   * event begins to sound. It may exceed the period length when the event
+   * has been received after the current period start
+   */
+  unsigned EventTimeToOffset(
+    std::chrono::steady_clock::time_point eventTime, unsigned nFrames) const;
+
   /* samplerTaskId:
      -1 .. -n Tremulants
      0 (DETACHED_RELEASE_TASK_ID) detached release
@@ -122,8 +188,24 @@ public:
   void SetVolume(int volume);
   void SetSampleRate(unsigned sample_rate);
   void SetSamplesPerBuffer(unsigned sample_per_buffer);
+  /**
+   * Sets the sample rate for rendering. The output is upsampled to the sample
+   * rate of the device. Must be called after SetSampleRate() and
+   * SetSamplesPerBuffer() and before creating the tasks
+   * @param render_sample_rate the rendering sample rate. 0 means the output one
+   * @return false if the output sample rate or the output period size are not
+   *   a multiple of the render ones. Then the output sample rate is used
+   */
+  bool SetRenderSampleRate(unsigned render_sample_rate);
   void SetInterpolationType(unsigned type);
+  // returns the render sample rate
   unsigned GetSampleRate();
+  unsigned GetOutputSampleRate() const { return m_OutputSampleRate; }
+  // returns the number of frames in one period at the render sample rate
+  unsigned GetSamplesPerBuffer() const { return m_SamplesPerBuffer; }
+  // Sets the number of the sound threads. Must be called before
+  // SetAudioGroupCount()
+  void SetConcurrency(unsigned concurrency);
   void SetAudioGroupCount(unsigned groups);
   unsigned GetAudioGroupCount();
   void SetHardPolyphony(unsigned polyphony);
@@ -131,7 +213,27 @@ public:
   unsigned GetHardPolyphony() const;
   int GetVolume() const;
   void SetScaledReleases(bool enable);
+  /**
+   * Sets the level the release voices are retired below
+   * @param level in dBFS. 0 means never to retire them
+   */
+  void SetInaudibleLevel(int level);
   void SetRandomizeSpeaking(bool enable);
+  /**
+   * Makes the rendering independent of the timing of the sound threads, so
+   * the same events always produce the same output. The calling thread of
+   * GetAudioOutput() and FinishPeriod() waits for all tasks of the period
+   * instead of finishing them early. Used for offline rendering
+   */
+  void SetDeterministic(bool isDeterministic);
+  bool IsDeterministic() const { return m_IsDeterministic; }
+  /**
+   * Mixes the voices of the same windchest and tone balance, usually a rank,
+   * on a bus of the audio group. The windchest gain, the tremulants and the
+   * tone balance filter are applied once to the bus instead of to each voice
+   */
+  void SetSubmixBuses(bool isSubmixBuses) { m_IsSubmixBuses = isSubmixBuses; }
+  bool IsSubmixBuses() const { return m_IsSubmixBuses; }
   const std::vector<double> &GetMeterInfo();
   void SetAudioRecorder(GOSoundRecorder *recorder, bool downmix);
 
@@ -173,10 +275,41 @@ public:
   void GetAudioOutput(
     float *output_buffer, unsigned n_frames, unsigned audio_output, bool last);
   void NextPeriod();
+  // Completes the current period and advances the time
+  void FinishPeriod();
+  // Lets the sound threads render the next period
+  void StartPeriod();
+  /**
+   * Sets the moment of receiving the midi event that the calling thread is
+   * processing. The samplers started by the thread begin to sound at the same
+   * position within the period as the event was received, so the latency
+   * does not depend on the delay of processing the event
+   * @param eventTime the moment of receiving the event or the default time
+   *   point for starting the samplers at the period beginning
+   */
+  void SetEventTime(std::chrono::steady_clock::time_point eventTime);
+  /**
+   * Sets the position in the next period where the samplers started by the
+   * calling thread begin to sound. Used for rendering the midi files
+   * @param frames the number of frames from the period start
+   */
+  void SetEventOffset(unsigned frames);
   GOSoundScheduler &GetScheduler();
 
+  /**
+   * Renders the period of the sampler and adds it to the buffer
+   * @param volume the volume the fader of the sampler ramps to
+   * @param pEnvelope the per frame volume applied in addition or nullptr
+   * @param isToFilter whether to apply the tone balance filter of the sampler
+   * @return whether the sampler is still playing
+   */
   bool ProcessSampler(
-    float *buffer, GOSoundSampler *sampler, unsigned n_frames, float volume);
+    float *buffer,
+    GOSoundSampler *sampler,
+    unsigned n_frames,
+    float volume,
+    const float *pEnvelope = nullptr,
+    bool isToFilter = true);
   void ProcessRelease(GOSoundSampler *sampler);
   void PassSampler(GOSoundSampler *sampler);
   void ReturnSampler(GOSoundSampler *sampler);
@@ -28,10 +28,8 @@ void GOSoundFader::Setup(
 // if the external volume is changed, do it smoothly in this number of frames
 static constexpr unsigned EXTERNAL_VOLUME_CHANGE_FRAMES = 1024;
 
-void GOSoundFader::Process(
-  unsigned nFrames, float *buffer, float externalVolume) {
-  // setup process
-
+float GOSoundFader::CalcVolumeRamp(
+  unsigned nFrames, float externalVolume, float &startVolume) {
   float startTargetVolumePoint = m_LastTargetVolumePoint;
 
   // Calculate new m_LastTargetVolumePoint
@@ -97,12 +95,22 @@ void GOSoundFader::Process(
       * std::max(nFrames, EXTERNAL_VOLUME_CHANGE_FRAMES)
       / EXTERNAL_VOLUME_CHANGE_FRAMES;
 
-  float frameTotalVolume = startTargetVolumePoint * startExternalVolumePoint;
+  startVolume = startTargetVolumePoint * startExternalVolumePoint;
+  return (m_LastTargetVolumePoint == startTargetVolumePoint)
+      && (m_LastExternalVolumePoint == startExternalVolumePoint)
+    ? 0.0f
+    // changing the volume by one frame
+    : (m_LastTargetVolumePoint * m_LastExternalVolumePoint - startVolume)
+      / nFrames;
+}
 
-  // Process data
-  if (
-    (m_LastTargetVolumePoint == startTargetVolumePoint)
-    && (m_LastExternalVolumePoint == startExternalVolumePoint)) {
+void GOSoundFader::Process(
+  unsigned nFrames, float *buffer, float externalVolume) {
+  float frameTotalVolume;
+  const float frameTotalVolumeDelta
+    = CalcVolumeRamp(nFrames, externalVolume, frameTotalVolume);
+
+  if (frameTotalVolumeDelta == 0.0f) {
     // Adjust the buffer by frameTotalVolume
     for (unsigned int i = 0; i < nFrames; i++, buffer += 2) {
       buffer[0] *= frameTotalVolume;
@@ -111,10 +119,6 @@ void GOSoundFader::Process(
   } else {
     // Adjust the buffer smoothly from frameTotalVolume to
     // m_LastTargetVolumePoint * m_LastExternalVolumePoint
-    float frameTotalVolumeDelta // changing the volume by one frame
-      = (m_LastTargetVolumePoint * m_LastExternalVolumePoint - frameTotalVolume)
-      / nFrames;
-
     for (unsigned int i = 0; i < nFrames; i++, buffer += 2) {
       buffer[0] *= frameTotalVolume;
       buffer[1] *= frameTotalVolume;
@@ -122,3 +126,87 @@ void GOSoundFader::Process(
     }
   }
 }
+
+/*
+ * The voice kernel. Specialized for constant/changing volume, for presence of
+ * the filter and of the envelope, so each voice passes the period buffer only
+ * once without branches in the loop
+ */
+template <bool isVolumeChanging, bool isToFilter, bool isEnveloped>
+static inline void mix_frames(
+  unsigned nFrames,
+  const float *pSrc,
+  float *pDst,
+  float volume,
+  float volumeDelta,
+  GOSoundFilter::FilterState *pFilterState,
+  const float *pEnvelope) {
+  if constexpr (isToFilter) {
+    GOSoundFilter::FilterState::Runner filter(*pFilterState);
+
+    for (unsigned i = 0; i < nFrames; i++, pSrc += 2, pDst += 2) {
+      const float gain = isEnveloped ? volume * pEnvelope[i] : volume;
+      float left = pSrc[0] * gain;
+      float right = pSrc[1] * gain;
+
+      filter.ProcessFrame(left, right);
+      pDst[0] += left;
+      pDst[1] += right;
+      if constexpr (isVolumeChanging)
+        volume += volumeDelta;
+    }
+  } else {
+    for (unsigned i = 0; i < nFrames; i++, pSrc += 2, pDst += 2) {
+      const float gain = isEnveloped ? volume * pEnvelope[i] : volume;
+
+      pDst[0] += pSrc[0] * gain;
+      pDst[1] += pSrc[1] * gain;
+      if constexpr (isVolumeChanging)
+        volume += volumeDelta;
+    }
+  }
+}
+
+template <bool isToFilter, bool isEnveloped>
+static inline void mix_voice(
+  unsigned nFrames,
+  const float *pSrc,
+  float *pDst,
+  float volume,
+  float volumeDelta,
+  GOSoundFilter::FilterState *pFilterState,
+  const float *pEnvelope) {
+  if (volumeDelta != 0.0f)
+    mix_frames<true, isToFilter, isEnveloped>(
+      nFrames, pSrc, pDst, volume, volumeDelta, pFilterState, pEnvelope);
+  else
+    mix_frames<false, isToFilter, isEnveloped>(
+      nFrames, pSrc, pDst, volume, 0.0f, pFilterState, pEnvelope);
+}
+
+void GOSoundFader::ProcessAndMix(
+  unsigned nFrames,
+  const float *pSrc,
+  float *pDst,
+  float externalVolume,
+  GOSoundFilter::FilterState *pFilterState,
+  const float *pEnvelope) {
+  float volume;
+  const float volumeDelta = CalcVolumeRamp(nFrames, externalVolume, volume);
+
+  if (pFilterState) {
+    if (pEnvelope)
+      mix_voice<true, true>(
+        nFrames, pSrc, pDst, volume, volumeDelta, pFilterState, pEnvelope);
+    else
+      mix_voice<true, false>(
+        nFrames, pSrc, pDst, volume, volumeDelta, pFilterState, NULL);
+  } else {
+    if (pEnvelope)
+      mix_voice<false, true>(
+        nFrames, pSrc, pDst, volume, volumeDelta, NULL, pEnvelope);
+    else
+      mix_voice<false, false>(
+        nFrames, pSrc, pDst, volume, volumeDelta, NULL, NULL);
+  }
+}
@@ -10,6 +10,8 @@
 
 #include <assert.h>
 
+#include "GOSoundFilter.h"
+
 /**
  * This class is responsible for smoothly changing a volume of samples.
  *
@@ -32,7 +34,7 @@
  *   ReleseTail limitation is used
  *
  * totalVol = targetVolume * externalVolume
- * This volume is applied in the Process() call
+ * This volume is applied in the Process() or in the ProcessAndMix() call
  */
 
 class GOSoundFader {
@@ -52,6 +54,17 @@ private:
   float m_LastTargetVolumePoint;
   float m_LastExternalVolumePoint;
 
+  /**
+   * Advances the volume points for the next nFrames and calculates the total
+   * volume ramp to apply to them
+   * @param nFrames number of frames in the period
+   * @param externalVolume the external volume to reach
+   * @param startVolume returns the total volume of the first frame
+   * @return the total volume change for one frame. 0 if the volume is constant
+   */
+  float CalcVolumeRamp(
+    unsigned nFrames, float externalVolume, float &startVolume);
+
 public:
   /**
    * Setup the fader for constant volume or for increasing from 0 to
@@ -94,7 +107,45 @@ public:
 
   void Process(unsigned nFrames, float *buffer, float externalVolume);
 
+  /**
+   * Applies the volume to nFrames stereo frames of pSrc, runs the filter (if
+   * any) and adds the result to pDst. It is the same as Process() followed by
+   * FilterState::ProcessBuffer() and adding, but it passes over the buffers
+   * only once
+   * @param nFrames number of frames to process
+   * @param pSrc the source frames. It is not changed
+   * @param pDst the buffer to add the result to
+   * @param externalVolume the external volume to reach
+   * @param pFilterState the filter to apply or nullptr
+   * @param pEnvelope the volume of each frame to apply in addition, f.e. the
+   *   tremulant modulation, or nullptr
+   */
+  void ProcessAndMix(
+    unsigned nFrames,
+    const float *pSrc,
+    float *pDst,
+    float externalVolume,
+    GOSoundFilter::FilterState *pFilterState,
+    const float *pEnvelope = nullptr);
+
   bool IsSilent() const { return (m_LastTargetVolumePoint <= 0.0f); }
+
+  /* Returns the highest volume the fader may reach from now on without the
+   * external volume */
+  float GetPeakVolume() const {
+    return (m_IncreasingDeltaPerFrame > 0.0f ? m_TargetVolume
+                                             : m_LastTargetVolumePoint)
+      * m_VelocityVolume;
+  }
+
+  /**
+   * Returns whether the volume is decreasing and has fallen below the part of
+   * the target volume
+   */
+  bool IsFadedBelow(float part) const {
+    return m_DecreasingDeltaPerFrame > 0.0f
+      && m_LastTargetVolumePoint < m_TargetVolume * part;
+  }
 };
 
 #endif /* GOSOUNDFADER_H_ */
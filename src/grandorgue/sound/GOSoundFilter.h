@@ -25,17 +25,61 @@ public:
     FilterState() { Init(nullptr); }
     void Init(const GOSoundFilter *filter);
     bool IsToApply() { return p_filter && p_filter->IsToApply(); }
-    inline void ProcessBuffer(unsigned n_blocks, float *buffer) {
-      float out[2];
-      for (unsigned int i = 0; i < n_blocks; i++, buffer += 2) {
-        out[0] = p_filter->m_B0 * buffer[0] + m_state[0];
-        out[1] = p_filter->m_B0 * buffer[1] + m_state[1];
-        m_state[0] = p_filter->m_B1 * buffer[0] - p_filter->m_A1 * out[0];
-        m_state[1] = p_filter->m_B1 * buffer[1] - p_filter->m_A1 * out[1];
-
-        buffer[0] = out[0];
-        buffer[1] = out[1];
+
+    /**
+     * Adds the state of the same filter that has processed another part of the
+     * input. As the filter is linear, the sum is the state after processing
+     * the sum of the inputs
+     */
+    void Add(const FilterState &other) {
+      m_state[0] += other.m_state[0];
+      m_state[1] += other.m_state[1];
+    }
+
+    /**
+     * Processes stereo frames one by one. It keeps the coefficients and the
+     * state in local variables, so they may stay in registers while a buffer
+     * is processed. The state is written back on destruction
+     */
+    class Runner {
+    private:
+      FilterState &r_state;
+      const double m_B0;
+      const double m_B1;
+      const double m_A1;
+      float m_state0;
+      float m_state1;
+
+    public:
+      inline Runner(FilterState &state)
+        : r_state(state),
+          m_B0(state.p_filter->m_B0),
+          m_B1(state.p_filter->m_B1),
+          m_A1(state.p_filter->m_A1),
+          m_state0(state.m_state[0]),
+          m_state1(state.m_state[1]) {}
+
+      inline ~Runner() {
+        r_state.m_state[0] = m_state0;
+        r_state.m_state[1] = m_state1;
       }
+
+      inline void ProcessFrame(float &left, float &right) {
+        const float out0 = m_B0 * left + m_state0;
+        const float out1 = m_B0 * right + m_state1;
+
+        m_state0 = m_B1 * left - m_A1 * out0;
+        m_state1 = m_B1 * right - m_A1 * out1;
+        left = out0;
+        right = out1;
+      }
+    };
+
+    inline void ProcessBuffer(unsigned n_blocks, float *buffer) {
+      Runner runner(*this);
+
+      for (unsigned int i = 0; i < n_blocks; i++, buffer += 2)
+        runner.ProcessFrame(buffer[0], buffer[1]);
     }
 
   private:
@@ -44,7 +44,8 @@ GOSoundProvider::GOSoundProvider()
     m_ReleaseInfo(),
     m_VelocityVolumeBase(1),
     m_VelocityVolumeIncrement(0),
-    m_AttackSwitchCrossfadeLength(184) {
+    m_AttackSwitchCrossfadeLength(184),
+    p_StreamStore(nullptr) {
   m_Gain = 0.0f;
 }
 
@@ -74,7 +75,7 @@ bool GOSoundProvider::LoadCache(GOMemoryPool &pool, GOCache &cache) {
     if (!cache.Read(&info, sizeof(info)))
       return false;
     m_AttackInfo.push_back(info);
-    m_Attack.push_back(new GOSoundAudioSection(pool));
+    m_Attack.push_back(new GOSoundAudioSection(pool, p_StreamStore));
     if (!m_Attack[i]->LoadCache(cache))
       return false;
   }
@@ -87,11 +88,12 @@ bool GOSoundProvider::LoadCache(GOMemoryPool &pool, GOCache &cache) {
     if (!cache.Read(&info, sizeof(info)))
       return false;
     m_ReleaseInfo.push_back(info);
-    m_Release.push_back(new GOSoundAudioSection(pool));
+    m_Release.push_back(new GOSoundAudioSection(pool, p_StreamStore));
     if (!m_Release[i]->LoadCache(cache))
       return false;
   }
 
+  MoveToStream();
   return true;
 }
 
@@ -127,6 +129,15 @@ bool GOSoundProvider::SaveCache(GOCacheWriter &cache) const {
   return true;
 }
 
+void GOSoundProvider::MoveToStream() {
+  if (p_StreamStore) {
+    for (unsigned i = 0; i < m_Attack.size(); i++)
+      m_Attack[i]->MoveToStream();
+    for (unsigned i = 0; i < m_Release.size(); i++)
+      m_Release[i]->MoveToStream();
+  }
+}
+
 void GOSoundProvider::ComputeReleaseAlignmentInfo() {
   std::vector<const GOSoundAudioSection *> sections;
   for (int8_t k = BOOL3_MIN; k <= BOOL3_MAX; ++k) {
@@ -308,9 +319,17 @@ bool GOSoundProvider::CheckNotNecessaryRelease() {
 
 GOSampleStatistic GOSoundProvider::GetStatistic() {
   GOSampleStatistic stat;
+  GOSampleStatistic releaseStat;
+
   for (unsigned i = 0; i < m_Attack.size(); i++)
     stat.Cumulate(m_Attack[i]->GetStatistic());
   for (unsigned i = 0; i < m_Release.size(); i++)
-    stat.Cumulate(m_Release[i]->GetStatistic());
+    releaseStat.Cumulate(m_Release[i]->GetStatistic());
+  stat.Cumulate(releaseStat);
+  if (stat.IsValid())
+    stat.SetSections(
+      m_Attack.size(),
+      m_Release.size(),
+      releaseStat.IsValid() ? releaseStat.GetMemorySize() : 0);
   return stat;
 }
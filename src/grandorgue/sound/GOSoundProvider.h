@@ -22,6 +22,7 @@ class GOCache;
 class GOCacheWriter;
 class GOHash;
 class GOMemoryPool;
+class GOSoundStreamStore;
 
 typedef struct audio_section_stream_s audio_section_stream;
 
@@ -54,6 +55,11 @@ protected:
   float m_VelocityVolumeBase;
   float m_VelocityVolumeIncrement;
   unsigned m_AttackSwitchCrossfadeLength;
+  // where the sections are streamed from. nullptr if they are fully resident
+  GOSoundStreamStore *p_StreamStore;
+
+  /* Moves the main data of all sections to p_StreamStore if it is set */
+  void MoveToStream();
 
 public:
   static void UpdateCacheHash(GOHash &hash);
@@ -63,6 +69,11 @@ public:
 
   void ClearData();
 
+  /* Must be called before loading */
+  void SetStreamStore(GOSoundStreamStore *pStreamStore) {
+    p_StreamStore = pStreamStore;
+  }
+
   virtual bool LoadCache(GOMemoryPool &pool, GOCache &cache);
   virtual bool SaveCache(GOCacheWriter &cache) const;
 
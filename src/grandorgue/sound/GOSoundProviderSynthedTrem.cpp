@@ -1,6 +1,6 @@
 /*
  * Copyright 2006 Milan Digital Audio LLC
- * Copyright 2009-2024 GrandOrgue contributors (see AUTHORS)
+ * Copyright 2009-2026 GrandOrgue contributors (see AUTHORS)
  * License GPL-2.0 or later
  * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
  */
@@ -11,7 +11,9 @@
 #include "GOMemoryPool.h"
 #include "GOSoundAudioSection.h"
 
-GOSoundProviderSynthedTrem::GOSoundProviderSynthedTrem() { m_Gain = 1.0f; }
+GOSoundProviderSynthedTrem::GOSoundProviderSynthedTrem() : m_MaxGain(1.0f) {
+  m_Gain = 1.0f;
+}
 
 inline short SynthTrem(double amp, double angle) {
   return (short)(amp * sin(angle));
@@ -48,6 +50,9 @@ void GOSoundProviderSynthedTrem::Create(
   const double trem_param = 2 * pi / loop_samples;
   double trem_angle = 0.0;
 
+  // the tremulant voice adds its samples to 1, so the peak is below 1 + depth
+  m_MaxGain = 1.0f + amp_mod_depth / 100.0f;
+
   GOBuffer<int16_t> data(total_samples);
 
   int16_t *write_iterator = data.get();
@@ -1,6 +1,6 @@
 /*
  * Copyright 2006 Milan Digital Audio LLC
- * Copyright 2009-2023 GrandOrgue contributors (see AUTHORS)
+ * Copyright 2009-2026 GrandOrgue contributors (see AUTHORS)
  * License GPL-2.0 or later
  * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
  */
@@ -11,6 +11,9 @@
 #include "GOSoundProvider.h"
 
 class GOSoundProviderSynthedTrem : public GOSoundProvider {
+private:
+  float m_MaxGain;
+
 public:
   GOSoundProviderSynthedTrem();
 
@@ -20,6 +23,9 @@ public:
     int start_rate,
     int stop_rate,
     int amp_mod_depth);
+
+  /* The highest gain the modulation applies to the voices of the windchest */
+  float GetMaxGain() const { return m_MaxGain; }
 };
 
 #endif /* GOSOUNDPROVIDERSYNTHEDTREM_H_ */
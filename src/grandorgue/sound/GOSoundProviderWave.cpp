@@ -12,7 +12,6 @@
 
 #include "files/GOOpenedFile.h"
 
-#include "GOBuffer.h"
 #include "GOMemoryPool.h"
 #include "GOSoundAudioSection.h"
 #include "GOWave.h"
@@ -24,20 +23,11 @@ void GOSoundProviderWave::SetAmplitude(float fixed_amplitude, float gain) {
   m_Gain = fixed_amplitude * powf(10.0f, gain * 0.05f);
 }
 
-unsigned GOSoundProviderWave::GetBytesPerSample(unsigned bits_per_sample) {
-  if (bits_per_sample <= 8)
-    return 1;
-  else if (bits_per_sample <= 16)
-    return 2;
-  else
-    return 3;
-}
-
 void GOSoundProviderWave::AddAttackSection(
   GOMemoryPool &pool,
   const GOLoaderFilename &loaderFilename,
-  const char *data,
   GOWave &wave,
+  int wave_channels,
   int attack_start,
   const std::vector<GOWaveLoop> *pSrcLoops,
   GOBool3 waveTremulantStateFor,
@@ -53,6 +43,9 @@ void GOSoundProviderWave::AddAttackSection(
   std::vector<GOWaveLoop> loops;
   unsigned attack_pos = attack_start;
 
+  if (attack_pos >= wave.GetLength())
+    throw(wxString) _("Invalid attack start position");
+
   if (!pSrcLoops || pSrcLoops->size() == 0) {
     // loops have not been provided. Read them from wave
 
@@ -118,16 +111,25 @@ void GOSoundProviderWave::AddAttackSection(
   attack_info.min_attack_velocity = min_attack_velocity;
   attack_info.max_released_time = max_released_time;
   m_AttackInfo.push_back(attack_info);
-  GOSoundAudioSection *section = new GOSoundAudioSection(pool);
+  GOSoundAudioSection *section = new GOSoundAudioSection(pool, p_StreamStore);
   m_Attack.push_back(section);
   section->Setup(
     p_ObjectFor,
     &loaderFilename,
-    data + attack_pos * GetBytesPerSample(bits_per_sample) * channels,
+    [&wave, bits_per_sample, wave_channels, attack_pos](
+      void *pDest, unsigned nSamples) {
+      wave.ReadSamples(
+        pDest,
+        (GOWave::SAMPLE_FORMAT)bits_per_sample,
+        wave.GetSampleRate(),
+        wave_channels,
+        attack_pos,
+        nSamples);
+    },
     (GOWave::SAMPLE_FORMAT)bits_per_sample,
     channels,
     wave.GetSampleRate(),
-    wave.GetLength(),
+    wave.GetLength() - attack_pos,
     &loops,
     waveTremulantStateFor,
     compress,
@@ -138,8 +140,8 @@ void GOSoundProviderWave::AddAttackSection(
 void GOSoundProviderWave::AddReleaseSection(
   GOMemoryPool &pool,
   const GOLoaderFilename &loaderFilename,
-  const char *data,
   GOWave &wave,
+  int wave_channels,
   GOBool3 waveTremulantStateFor,
   unsigned max_playback_time,
   int cue_point,
@@ -167,12 +169,21 @@ void GOSoundProviderWave::AddReleaseSection(
   release_info.m_WaveTremulantStateFor = waveTremulantStateFor;
   release_info.max_playback_time = max_playback_time;
   m_ReleaseInfo.push_back(release_info);
-  GOSoundAudioSection *section = new GOSoundAudioSection(pool);
+  GOSoundAudioSection *section = new GOSoundAudioSection(pool, p_StreamStore);
   m_Release.push_back(section);
   section->Setup(
     p_ObjectFor,
     &loaderFilename,
-    data + release_offset * GetBytesPerSample(bits_per_sample) * channels,
+    [&wave, bits_per_sample, wave_channels, release_offset](
+      void *pDest, unsigned nSamples) {
+      wave.ReadSamples(
+        pDest,
+        (GOWave::SAMPLE_FORMAT)bits_per_sample,
+        wave.GetSampleRate(),
+        wave_channels,
+        release_offset,
+        nSamples);
+    },
     (GOWave::SAMPLE_FORMAT)bits_per_sample,
     channels,
     wave.GetSampleRate(),
@@ -187,7 +198,8 @@ void GOSoundProviderWave::AddReleaseSection(
 void GOSoundProviderWave::LoadPitch(GOOpenedFile *file) {
   GOWave wave;
 
-  wave.Open(file);
+  // only the sampler chunk is needed
+  wave.Open(file, false);
   m_MidiKeyNumber = wave.GetMidiNote();
   m_MidiPitchFract = wave.GetPitchFract();
 }
@@ -238,11 +250,6 @@ void GOSoundProviderWave::LoadFromOneFile(
 
     wave.Open(openedFilePtr.get());
 
-    /* allocate data to work with */
-    unsigned totalDataSize = wave.GetLength()
-      * GetBytesPerSample(bits_per_sample) * wave.GetChannels();
-    GOBuffer<char> data(totalDataSize);
-
     if (use_pitch) {
       m_MidiKeyNumber = wave.GetMidiNote();
       m_MidiPitchFract = wave.GetPitchFract();
@@ -269,18 +276,12 @@ void GOSoundProviderWave::LoadFromOneFile(
     if (bits_per_sample > wave.GetBitsPerSample())
       bits_per_sample = wave.GetBitsPerSample();
 
-    wave.ReadSamples(
-      data.get(),
-      (GOWave::SAMPLE_FORMAT)bits_per_sample,
-      wave.GetSampleRate(),
-      wave_channels);
-
     if (is_attack)
       AddAttackSection(
         pool,
         loaderFilename,
-        data.get(),
         wave,
+        wave_channels,
         attack_start,
         loops,
         waveTremulantStateFor,
@@ -299,8 +300,8 @@ void GOSoundProviderWave::LoadFromOneFile(
       AddReleaseSection(
         pool,
         loaderFilename,
-        data.get(),
         wave,
+        wave_channels,
         waveTremulantStateFor,
         max_playback_time,
         cue_point,
@@ -472,6 +473,7 @@ void GOSoundProviderWave::LoadFromMultipleFiles(
     }
 
     ComputeReleaseAlignmentInfo();
+    MoveToStream();
   } catch (...) {
     ClearData();
     throw;
@@ -67,13 +67,12 @@ public:
 private:
   // Used for error messages
   GOCacheObject *p_ObjectFor;
-  unsigned GetBytesPerSample(unsigned bits_per_sample);
 
   void AddAttackSection(
     GOMemoryPool &pool,
     const GOLoaderFilename &loaderFilename,
-    const char *data,
     GOWave &wave,
+    int wave_channels,
     int attack_start,
     const std::vector<GOWaveLoop> *pSrcLoops,
     GOBool3 waveTremulantStateFor,
@@ -89,8 +88,8 @@ private:
   void AddReleaseSection(
     GOMemoryPool &pool,
     const GOLoaderFilename &loaderFilename,
-    const char *data,
     GOWave &wave,
+    int wave_channels,
     GOBool3 waveTremulantStateFor,
     unsigned max_playback_time,
     int cue_point,
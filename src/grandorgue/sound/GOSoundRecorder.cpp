@@ -1,18 +1,24 @@
 /*
  * Copyright 2006 Milan Digital Audio LLC
- * Copyright 2009-2024 GrandOrgue contributors (see AUTHORS)
+ * Copyright 2009-2025 GrandOrgue contributors (see AUTHORS)
  * License GPL-2.0 or later
  * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
  */
 
 #include "GOSoundRecorder.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
 #include <wx/intl.h>
 #include <wx/log.h>
 
 #include "GOSoundBufferItem.h"
 #include "GOWaveTypes.h"
 #include "threading/GOMutexLocker.h"
+#include "threading/GOThread.h"
 
 #pragma pack(push, 1)
 
@@ -26,6 +32,27 @@ struct struct_WAVE {
 
 #pragma pack(pop)
 
+class GOSoundRecorder::WriterThread : public GOThread {
+private:
+  GOSoundRecorder &r_Recorder;
+
+protected:
+  void Entry() override;
+
+public:
+  WriterThread(GOSoundRecorder &recorder) : r_Recorder(recorder) {}
+};
+
+void GOSoundRecorder::WriterThread::Entry() {
+  while (!ShouldStop())
+    if (!r_Recorder.FlushRing(false))
+      // less than a chunk is ready
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  // the recording is closed: write the rest
+  while (r_Recorder.FlushRing(true))
+    ;
+}
+
 GOSoundRecorder::GOSoundRecorder()
   : m_file(),
     m_lock(),
@@ -36,7 +63,13 @@ GOSoundRecorder::GOSoundRecorder()
     m_BufferPos(0),
     m_SamplesPerBuffer(1024),
     m_Recording(false),
-    m_Buffer(0) {
+    m_Buffer(0),
+    m_IsBlocking(false),
+    m_RingSize(0),
+    m_RingWritePos(0),
+    m_RingReadPos(0),
+    m_DroppedFrames(0),
+    m_IsWriteFailed(false) {
   SetupBuffer();
 }
 
@@ -75,9 +108,24 @@ void GOSoundRecorder::Open(wxString filename) {
   }
   m_file.Write(&WAVE, sizeof(WAVE));
 
+  // a whole number of chunks holding at least RING_SECONDS
+  const uint64_t ringChunks
+    = ((uint64_t)m_SampleRate * m_Channels * m_BytesPerSample * RING_SECONDS
+       + std::max(m_BufferSize, WRITE_CHUNK) + WRITE_CHUNK - 1)
+    / WRITE_CHUNK;
+
+  m_RingSize = ringChunks * WRITE_CHUNK;
+  m_Ring.reset(new char[m_RingSize]);
+  m_RingWritePos.store(0);
+  m_RingReadPos.store(0);
+  m_DroppedFrames.store(0);
+  m_IsWriteFailed.store(false);
+  m_BufferPos = 0;
+  m_Writer.reset(new WriterThread(*this));
+  m_Writer->Start();
+
   GOMutexLocker lock(m_Mutex);
   m_Recording = true;
-  m_BufferPos = 0;
 }
 
 bool GOSoundRecorder::IsOpen() { return m_Recording; }
@@ -90,6 +138,21 @@ void GOSoundRecorder::Close() {
   }
   if (!m_file.IsOpened())
     return;
+  // the writer thread flushes the ring before exiting
+  m_Writer->Stop();
+  m_Writer.reset();
+  m_Ring.reset();
+  if (m_IsWriteFailed.load())
+    wxLogError(_("Unable to write the recording to the disk"));
+
+  const uint64_t droppedFrames = m_DroppedFrames.load();
+
+  if (droppedFrames)
+    wxLogWarning(
+      _("Audio recording: %.1f s of audio were dropped because the disk was "
+        "too slow."),
+      (double)droppedFrames / m_SampleRate);
+
   struct_WAVE WAVE = generateHeader(m_BufferPos);
   m_file.Seek(0);
   m_file.Write(&WAVE, sizeof(WAVE));
@@ -169,6 +232,44 @@ template <class T> void GOSoundRecorder::ConvertData() {
   }
 }
 
+bool GOSoundRecorder::PutToRing() {
+  const uint64_t writePos = m_RingWritePos.load(std::memory_order_relaxed);
+
+  if (
+    writePos + m_BufferSize
+    > m_RingReadPos.load(std::memory_order_acquire) + m_RingSize)
+    return false;
+
+  const uint64_t offset = writePos % m_RingSize;
+  const unsigned firstPart
+    = (unsigned)std::min<uint64_t>(m_BufferSize, m_RingSize - offset);
+
+  memcpy(m_Ring.get() + offset, m_Buffer, firstPart);
+  memcpy(m_Ring.get(), m_Buffer + firstPart, m_BufferSize - firstPart);
+  m_RingWritePos.store(writePos + m_BufferSize, std::memory_order_release);
+  return true;
+}
+
+bool GOSoundRecorder::FlushRing(bool isAll) {
+  const uint64_t readPos = m_RingReadPos.load(std::memory_order_relaxed);
+  const uint64_t offset = readPos % m_RingSize;
+  // write at most up to the ring end, so the chunks stay aligned in the ring
+  const uint64_t length = std::min(
+    m_RingWritePos.load(std::memory_order_acquire) - readPos,
+    std::min<uint64_t>(m_RingSize - offset, WRITE_CHUNK));
+
+  if (!length || (!isAll && length < WRITE_CHUNK))
+    return false;
+  if (
+    !m_IsWriteFailed.load(std::memory_order_relaxed)
+    && m_file.Write(m_Ring.get() + offset, length) == length)
+    m_BufferPos += length;
+  else
+    m_IsWriteFailed.store(true, std::memory_order_relaxed);
+  m_RingReadPos.store(readPos + length, std::memory_order_release);
+  return true;
+}
+
 unsigned GOSoundRecorder::GetGroup() { return AUDIORECORDER; }
 
 unsigned GOSoundRecorder::GetCost() { return 0; }
@@ -200,8 +301,13 @@ void GOSoundRecorder::Run(GOSoundThread *thread) {
     ConvertData<float>();
     break;
   }
-  m_file.Write(m_Buffer, m_BufferSize);
-  m_BufferPos += m_BufferSize;
+
+  bool isPut;
+
+  while (!(isPut = PutToRing()) && m_IsBlocking)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  if (!isPut)
+    m_DroppedFrames.fetch_add(m_SamplesPerBuffer, std::memory_order_relaxed);
   m_Done = true;
 }
 
@@ -1,6 +1,6 @@
 /*
  * Copyright 2006 Milan Digital Audio LLC
- * Copyright 2009-2024 GrandOrgue contributors (see AUTHORS)
+ * Copyright 2009-2025 GrandOrgue contributors (see AUTHORS)
  * License GPL-2.0 or later
  * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
  */
@@ -12,6 +12,8 @@
 #include <wx/string.h>
 
 #include <atomic>
+#include <cstdint>
+#include <memory>
 #include <vector>
 
 #include "sound/scheduler/GOSoundTask.h"
@@ -20,8 +22,23 @@
 class GOSoundBufferItem;
 struct struct_WAVE;
 
+/**
+ * Records the mixed output to a wav file.
+ *
+ * The audio threads only convert the period and copy it into a preallocated
+ * ring. A writer thread flushes the ring to the file in large chunks, so a
+ * slow disk never stalls the audio output: if the ring is full, the period is
+ * dropped and counted instead.
+ */
 class GOSoundRecorder : public GOSoundTask {
 private:
+  class WriterThread;
+
+  // the file is written in chunks of this size
+  static constexpr unsigned WRITE_CHUNK = 256 * 1024;
+  // how long the writer thread may lag behind the audio
+  static constexpr unsigned RING_SECONDS = 10;
+
   wxFile m_file;
   GOMutex m_lock;
   GOMutex m_Mutex;
@@ -37,7 +54,21 @@ private:
   std::vector<GOSoundBufferItem *> m_Outputs;
   char *m_Buffer;
 
+  // wait for the writer thread instead of dropping the periods
+  bool m_IsBlocking;
+  std::unique_ptr<char[]> m_Ring;
+  uint64_t m_RingSize;
+  // the total bytes put into the ring and written from it
+  std::atomic_uint64_t m_RingWritePos;
+  std::atomic_uint64_t m_RingReadPos;
+  std::atomic_uint64_t m_DroppedFrames;
+  std::atomic_bool m_IsWriteFailed;
+  std::unique_ptr<WriterThread> m_Writer;
+
   void SetupBuffer();
+  bool PutToRing();
+  /* Writes the data from the ring. Called by the writer thread */
+  bool FlushRing(bool isAll);
   template <class T> void ConvertData();
   struct_WAVE generateHeader(unsigned datasize);
 
@@ -53,6 +84,10 @@ public:
   void SetBytesPerSample(unsigned value);
   void SetOutputs(
     std::vector<GOSoundBufferItem *> outputs, unsigned samples_per_buffer);
+  /* Never drops periods, f.e. for rendering offline */
+  void SetBlocking(bool isBlocking) { m_IsBlocking = isBlocking; }
+  /* The number of frames dropped since Open because the disk was too slow */
+  uint64_t GetDroppedFrames() const { return m_DroppedFrames.load(); }
 
   unsigned GetGroup();
   unsigned GetCost();
@@ -88,6 +88,19 @@ public:
       m_fraction &= UPSAMPLE_MASK;
     }
 
+    /**
+     * Calculates the source index after the position is advanced for the given
+     * number of target samples
+     * @param nTargetSamples the number of target samples
+     * @return the source index
+     */
+    inline unsigned GetIndexAfter(unsigned nTargetSamples) const {
+      return m_index
+        + unsigned(
+          (m_fraction + uint64_t(nTargetSamples) * m_FractionIncrement)
+          >> UPSAMPLE_BITS);
+    }
+
     /**
      * Calculates the target samples length from given source position to the
      * end index
@@ -123,6 +136,10 @@ public:
    */
   template <uint8_t nChannels> struct FloatingSampleVector {
     static constexpr uint8_t m_NChannels = nChannels;
+    /* Whether the vector exposes its samples in memory with GetCurrentPtr().
+     * The SIMD resamplers load such vectors directly instead of calling
+     * NextSample() for each sample */
+    static constexpr bool HAS_SAMPLE_PTR = false;
   };
 
   /**
@@ -160,6 +177,10 @@ public:
     }
 
   public:
+    typedef SampleT SampleType;
+
+    static constexpr bool HAS_SAMPLE_PTR = true;
+
     /**
      * Construct the vector with some start pointer.
      * @param ptr a pointer to the first (0 left) sample
@@ -185,6 +206,12 @@ public:
       p_CurrPtr += nChannels;
       return res;
     }
+
+    /**
+     * @return the pointer to the current sample. After Seek(index, 0) it
+     *   points to nChannels * vector length interleaving samples
+     */
+    inline const SampleT *GetCurrentPtr() const { return p_CurrPtr; }
   };
 
   /**
@@ -203,6 +230,9 @@ public:
     const SampleT *p_EndPtr;
 
   public:
+    // the samples must not be read bypassing the bounds check
+    static constexpr bool HAS_SAMPLE_PTR = false;
+
     /**
      * Constructs the vector with the start pointer and the length of the
      * memory region
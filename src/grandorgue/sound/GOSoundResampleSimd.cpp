@@ -0,0 +1,38 @@
+/*
+ * Copyright 2026 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#include "GOSoundResampleSimd.h"
+
+static GOSoundResampleSimd::InstructionSet detect_instruction_set() {
+  GOSoundResampleSimd::InstructionSet res = GOSoundResampleSimd::IS_SCALAR;
+
+#ifdef GO_SOUND_RESAMPLE_SIMD
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    res = GOSoundResampleSimd::IS_AVX2;
+  else if (__builtin_cpu_supports("sse4.1"))
+    res = GOSoundResampleSimd::IS_SSE41;
+#endif
+  return res;
+}
+
+GOSoundResampleSimd::InstructionSet GOSoundResampleSimd::getInstructionSet() {
+  static const InstructionSet instructionSet = detect_instruction_set();
+
+  return instructionSet;
+}
+
+const char *GOSoundResampleSimd::getInstructionSetName(
+  InstructionSet instructionSet) {
+  switch (instructionSet) {
+  case IS_SSE41:
+    return "SSE4.1";
+  case IS_AVX2:
+    return "AVX2";
+  default:
+    return "scalar";
+  }
+}
@@ -0,0 +1,364 @@
+/*
+ * Copyright 2026 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#ifndef GOSOUNDRESAMPLESIMD_H_
+#define GOSOUNDRESAMPLESIMD_H_
+
+#include <cstdint>
+#include <type_traits>
+
+#include "GOSoundResample.h"
+
+/*
+ * The SIMD kernels are compiled with the function target attributes, so the
+ * rest of the program keeps the baseline instruction set and the best kernel
+ * is selected at runtime. It is possible only with gcc-compatible compilers
+ * on x86
+ */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define GO_SOUND_RESAMPLE_SIMD 1
+#endif
+
+#ifdef GO_SOUND_RESAMPLE_SIMD
+#include <immintrin.h>
+
+#define GO_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define GO_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+/**
+ * Vectorized variants of GOSoundResample::LinearResampler and
+ * GOSoundResample::PolyphaseResampler. They have the same interface, so they
+ * may be used as the ResamplerT parameter of GOSoundStream::DecodeBlock.
+ *
+ * The sample vectors having HAS_SAMPLE_PTR with 8, 16 or 32 bit integer
+ * samples are loaded and converted to float directly with SIMD instructions.
+ * All other vectors are gathered sample by sample with NextSample() and only
+ * the scalar production is vectorized.
+ */
+class GOSoundResampleSimd {
+public:
+  enum InstructionSet {
+    IS_SCALAR = 0,
+    IS_SSE41 = 1,
+    IS_AVX2 = 2,
+  };
+
+  /**
+   * Detects the best instruction set supported by the CPU. The detection is
+   * performed only once
+   * @return the instruction set to use for resampling
+   */
+  static InstructionSet getInstructionSet();
+
+  static const char *getInstructionSetName(InstructionSet instructionSet);
+
+#ifdef GO_SOUND_RESAMPLE_SIMD
+private:
+  /**
+   * Whether the samples of the vector may be loaded directly from memory
+   */
+  template <class SampleVectorT> static constexpr bool isDirectLoadable() {
+    if constexpr (SampleVectorT::HAS_SAMPLE_PTR) {
+      typedef typename SampleVectorT::SampleType SampleT;
+
+      return !std::is_floating_point_v<SampleT>
+        && (sizeof(SampleT) == 1 || sizeof(SampleT) == 2 || sizeof(SampleT) == 4);
+    } else
+      return false;
+  }
+
+  /**
+   * Fills pDst with nPoints continous samples of each channel starting from
+   * the index position. The samples of each channel are placed continously
+   */
+  template <class SampleVectorT, unsigned nPoints>
+  static inline void gatherVector(
+    SampleVectorT &sV, unsigned index, float *pDst) {
+    for (uint8_t ch = 0; ch < SampleVectorT::m_NChannels; ch++) {
+      sV.Seek(index, ch);
+      for (unsigned j = 0; j < nPoints; j++)
+        *(pDst++) = sV.NextSample();
+    }
+  }
+
+  /**
+   * Converts four continous integer samples to floats
+   */
+  template <class SampleT>
+  GO_TARGET_SSE41 static inline __m128 load4(const SampleT *p) {
+    __m128i v;
+
+    if constexpr (sizeof(SampleT) == 1) {
+      int32_t packed;
+
+      __builtin_memcpy(&packed, p, sizeof(packed));
+      v = _mm_cvtepi8_epi32(_mm_cvtsi32_si128(packed));
+    } else if constexpr (sizeof(SampleT) == 2)
+      v = _mm_cvtepi16_epi32(_mm_loadl_epi64((const __m128i *)p));
+    else
+      v = _mm_loadu_si128((const __m128i *)p);
+    return _mm_cvtepi32_ps(v);
+  }
+
+  /**
+   * Converts eight continous integer samples to floats
+   */
+  template <class SampleT>
+  GO_TARGET_AVX2 static inline __m256 load8(const SampleT *p) {
+    __m256i v;
+
+    if constexpr (sizeof(SampleT) == 1)
+      v = _mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i *)p));
+    else if constexpr (sizeof(SampleT) == 2)
+      v = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)p));
+    else
+      v = _mm256_loadu_si256((const __m256i *)p);
+    return _mm256_cvtepi32_ps(v);
+  }
+
+  /**
+   * Loads eight samples of each channel into v
+   */
+  template <class SampleVectorT>
+  GO_TARGET_SSE41 static inline void loadVector8(
+    SampleVectorT &sV,
+    unsigned index,
+    __m128 (&v)[SampleVectorT::m_NChannels][2]) {
+    constexpr uint8_t nChannels = SampleVectorT::m_NChannels;
+
+    if constexpr (isDirectLoadable<SampleVectorT>()) {
+      sV.Seek(index, 0);
+
+      const auto *p = sV.GetCurrentPtr();
+
+      if constexpr (nChannels == 1) {
+        v[0][0] = load4(p);
+        v[0][1] = load4(p + 4);
+      } else {
+        for (unsigned k = 0; k < 2; k++, p += 8) {
+          const __m128 a = load4(p);
+          const __m128 b = load4(p + 4);
+
+          v[0][k] = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+          v[1][k] = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        }
+      }
+    } else {
+      alignas(16) float buf[nChannels * 8];
+
+      gatherVector<SampleVectorT, 8>(sV, index, buf);
+      for (uint8_t ch = 0; ch < nChannels; ch++) {
+        v[ch][0] = _mm_load_ps(buf + ch * 8);
+        v[ch][1] = _mm_load_ps(buf + ch * 8 + 4);
+      }
+    }
+  }
+
+  template <class SampleVectorT>
+  GO_TARGET_AVX2 static inline void loadVector8(
+    SampleVectorT &sV, unsigned index, __m256 (&v)[SampleVectorT::m_NChannels]) {
+    constexpr uint8_t nChannels = SampleVectorT::m_NChannels;
+
+    if constexpr (isDirectLoadable<SampleVectorT>()) {
+      sV.Seek(index, 0);
+
+      const auto *p = sV.GetCurrentPtr();
+
+      if constexpr (nChannels == 1)
+        v[0] = load8(p);
+      else {
+        const __m256 a = load8(p);
+        const __m256 b = load8(p + 8);
+
+        // the shuffles work in 128-bit lanes, so the 64-bit parts are in the
+        // 0, 2, 1, 3 order after them
+        v[0] = _mm256_castpd_ps(_mm256_permute4x64_pd(
+          _mm256_castps_pd(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0))),
+          _MM_SHUFFLE(3, 1, 2, 0)));
+        v[1] = _mm256_castpd_ps(_mm256_permute4x64_pd(
+          _mm256_castps_pd(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1))),
+          _MM_SHUFFLE(3, 1, 2, 0)));
+      }
+    } else {
+      alignas(32) float buf[nChannels * 8];
+
+      gatherVector<SampleVectorT, 8>(sV, index, buf);
+      for (uint8_t ch = 0; ch < nChannels; ch++)
+        v[ch] = _mm256_load_ps(buf + ch * 8);
+    }
+  }
+
+  /**
+   * Stores one output frame. lr contains the left result in the element 0 and
+   * the right result in the element 1
+   */
+  template <uint8_t nOutChannels>
+  GO_TARGET_SSE41 static inline void storeFrame(float *&pOut, __m128 lr) {
+    if constexpr (nOutChannels == 2)
+      _mm_storel_pi((__m64 *)pOut, lr);
+    else {
+      // copy the calculated sample to all channels as the scalar version does
+      const float r = _mm_cvtss_f32(_mm_shuffle_ps(lr, lr, 1));
+
+      pOut[0] = _mm_cvtss_f32(lr);
+      for (uint8_t ch = 1; ch < nOutChannels; ch++)
+        pOut[ch] = r;
+    }
+    pOut += nOutChannels;
+  }
+
+  template <unsigned nPoints> class CoefsHolder {
+  protected:
+    // precalculated coefficients for each resampling position fraction
+    const float (&r_coefs)[GOSoundResample::UPSAMPLE_FACTOR][nPoints];
+
+    inline CoefsHolder(
+      const float (&coefs)[GOSoundResample::UPSAMPLE_FACTOR][nPoints])
+      : r_coefs(coefs) {}
+
+  public:
+    static constexpr unsigned VECTOR_LENGTH = nPoints;
+  };
+
+public:
+  /**
+   * The linear resampler. The both channels of a stereo frame are calculated
+   * with one SIMD multiplication. Used for SSE4.1 and AVX2 because the vector
+   * is too short for profiting from wider registers
+   */
+  class LinearResamplerSse41
+    : public CoefsHolder<GOSoundResample::LINEAR_POINTS> {
+  public:
+    inline LinearResamplerSse41(const GOSoundResample &r)
+      : CoefsHolder<GOSoundResample::LINEAR_POINTS>(r.m_LinearCoefs) {}
+
+    template <class SampleVectorT, uint8_t nOutChannels>
+    GO_TARGET_SSE41 void ResampleBlock(
+      GOSoundResample::ResamplingPosition &resamplingPos,
+      SampleVectorT &sV,
+      float *pOut,
+      unsigned nOutSamples) const {
+      constexpr uint8_t nChannels = SampleVectorT::m_NChannels;
+
+      for (unsigned i = 0; i < nOutSamples; i++, resamplingPos.Inc()) {
+        const float(&coefs)[GOSoundResample::LINEAR_POINTS]
+          = r_coefs[resamplingPos.GetFraction()];
+        __m128 lr;
+
+        if constexpr (nChannels == 2) {
+          __m128 s; // l0 r0 l1 r1
+
+          if constexpr (isDirectLoadable<SampleVectorT>()) {
+            sV.Seek(resamplingPos.GetIndex(), 0);
+            s = load4(sV.GetCurrentPtr());
+          } else {
+            alignas(16) float buf[4];
+
+            gatherVector<SampleVectorT, 2>(sV, resamplingPos.GetIndex(), buf);
+            s = _mm_setr_ps(buf[0], buf[2], buf[1], buf[3]);
+          }
+
+          const __m128 c = _mm_setr_ps(coefs[0], coefs[0], coefs[1], coefs[1]);
+          const __m128 p = _mm_mul_ps(s, c);
+
+          lr = _mm_add_ps(p, _mm_movehl_ps(p, p));
+        } else {
+          sV.Seek(resamplingPos.GetIndex(), 0);
+
+          const float s0 = sV.NextSample();
+          const float s1 = sV.NextSample();
+
+          lr = _mm_set1_ps(s0 * coefs[0] + s1 * coefs[1]);
+        }
+        storeFrame<nOutChannels>(pOut, lr);
+      }
+    }
+  };
+
+  /**
+   * The polyphase resampler with two 4-float SSE registers per channel
+   */
+  class PolyphaseResamplerSse41
+    : public CoefsHolder<GOSoundResample::POLYPHASE_POINTS> {
+  public:
+    inline PolyphaseResamplerSse41(const GOSoundResample &r)
+      : CoefsHolder<GOSoundResample::POLYPHASE_POINTS>(r.m_PolyphaseCoefs) {}
+
+    template <class SampleVectorT, uint8_t nOutChannels>
+    GO_TARGET_SSE41 void ResampleBlock(
+      GOSoundResample::ResamplingPosition &resamplingPos,
+      SampleVectorT &sV,
+      float *pOut,
+      unsigned nOutSamples) const {
+      static_assert(VECTOR_LENGTH == 8);
+      constexpr uint8_t nChannels = SampleVectorT::m_NChannels;
+
+      for (unsigned i = 0; i < nOutSamples; i++, resamplingPos.Inc()) {
+        const float *pCoefs = r_coefs[resamplingPos.GetFraction()];
+        const __m128 c0 = _mm_loadu_ps(pCoefs);
+        const __m128 c1 = _mm_loadu_ps(pCoefs + 4);
+        __m128 v[nChannels][2];
+
+        loadVector8(sV, resamplingPos.GetIndex(), v);
+
+        const __m128 pl
+          = _mm_add_ps(_mm_mul_ps(v[0][0], c0), _mm_mul_ps(v[0][1], c1));
+        const __m128 pr = nChannels == 2
+          ? _mm_add_ps(
+            _mm_mul_ps(v[nChannels - 1][0], c0),
+            _mm_mul_ps(v[nChannels - 1][1], c1))
+          : pl;
+        // l01 l23 r01 r23
+        const __m128 h = _mm_hadd_ps(pl, pr);
+
+        // l r l r
+        storeFrame<nOutChannels>(pOut, _mm_hadd_ps(h, h));
+      }
+    }
+  };
+
+  /**
+   * The polyphase resampler with one 8-float AVX register per channel
+   */
+  class PolyphaseResamplerAvx2
+    : public CoefsHolder<GOSoundResample::POLYPHASE_POINTS> {
+  public:
+    inline PolyphaseResamplerAvx2(const GOSoundResample &r)
+      : CoefsHolder<GOSoundResample::POLYPHASE_POINTS>(r.m_PolyphaseCoefs) {}
+
+    template <class SampleVectorT, uint8_t nOutChannels>
+    GO_TARGET_AVX2 void ResampleBlock(
+      GOSoundResample::ResamplingPosition &resamplingPos,
+      SampleVectorT &sV,
+      float *pOut,
+      unsigned nOutSamples) const {
+      static_assert(VECTOR_LENGTH == 8);
+      constexpr uint8_t nChannels = SampleVectorT::m_NChannels;
+
+      for (unsigned i = 0; i < nOutSamples; i++, resamplingPos.Inc()) {
+        const __m256 c = _mm256_loadu_ps(r_coefs[resamplingPos.GetFraction()]);
+        __m256 v[nChannels];
+
+        loadVector8(sV, resamplingPos.GetIndex(), v);
+
+        const __m256 pl = _mm256_mul_ps(v[0], c);
+        const __m256 pr
+          = nChannels == 2 ? _mm256_mul_ps(v[nChannels - 1], c) : pl;
+        // l01 l23 r01 r23 | l45 l67 r45 r67
+        const __m256 h = _mm256_hadd_ps(pl, pr);
+        const __m128 s = _mm_add_ps(
+          _mm256_castps256_ps128(h), _mm256_extractf128_ps(h, 1));
+
+        // l r l r
+        storeFrame<nOutChannels>(pOut, _mm_hadd_ps(s, s));
+      }
+    }
+  };
+#endif /* GO_SOUND_RESAMPLE_SIMD */
+};
+
+#endif /* GOSOUNDRESAMPLESIMD_H_ */
@@ -32,7 +32,8 @@ void GOSoundReverb::Cleanup() {
   }
 }
 
-void GOSoundReverb::Setup(GOConfig &settings) {
+void GOSoundReverb::Setup(
+  GOConfig &settings, unsigned sampleRate, unsigned samplesPerBuffer) {
   Cleanup();
 
   if (!settings.ReverbEnabled())
@@ -41,7 +42,7 @@ void GOSoundReverb::Setup(GOConfig &settings) {
   m_engine.clear();
   for (unsigned i = 0; i < m_channels; i++)
     m_engine.push_back(new Convproc());
-  unsigned val = settings.SamplesPerBuffer();
+  unsigned val = samplesPerBuffer;
   if (val < Convproc::MINPART)
     val = Convproc::MINPART;
   if (val > Convproc::MAXPART)
@@ -54,7 +55,7 @@ void GOSoundReverb::Setup(GOConfig &settings) {
             1,
             1,
             1000000,
-            settings.SamplesPerBuffer(),
+            samplesPerBuffer,
             val,
             Convproc::MAXPART,
             1))
@@ -85,33 +86,33 @@ void GOSoundReverb::Setup(GOConfig &settings) {
     /*
     wxLogMessage(
       "GOSoundReverb::Setup before resample: offset=%u, len=%u, "
-      "wav.GetSampleRate()=%u, settings.SampleRate()=%u",
+      "wav.GetSampleRate()=%u, sampleRate=%u",
       offset,
       len,
       wav.GetSampleRate(),
-      settings.SampleRate());
+      sampleRate);
      */
-    if (wav.GetSampleRate() != settings.SampleRate()) {
+    if (wav.GetSampleRate() != sampleRate) {
       GOSoundResample resample;
 
       float *new_data = resample.NewResampledMono(
-        data, len, wav.GetSampleRate(), settings.SampleRate());
+        data, len, wav.GetSampleRate(), sampleRate);
       if (!new_data)
         throw(wxString) _("Resampling failed");
       free(data);
       data = new_data;
-      offset = (offset * settings.SampleRate()) / (float)wav.GetSampleRate();
+      offset = (offset * sampleRate) / (float)wav.GetSampleRate();
     }
     /*
     wxLogMessage(
       "GOSoundReverb::Setup after resample: offset=%u, len=%u, "
-      "wav.GetSampleRate()=%u, settings.SampleRate()=%u",
+      "wav.GetSampleRate()=%u, sampleRate=%u",
       offset,
       len,
       wav.GetSampleRate(),
-      settings.SampleRate());
+      sampleRate);
      */
-    unsigned delay = (settings.SampleRate() * settings.ReverbDelay()) / 1000;
+    unsigned delay = (sampleRate * settings.ReverbDelay()) / 1000;
     for (unsigned i = 0; i < m_channels; i++) {
       float *d = data + offset;
       unsigned l = len - offset;
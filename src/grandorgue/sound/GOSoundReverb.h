@@ -24,7 +24,14 @@ public:
   virtual ~GOSoundReverb();
 
   void Reset();
-  void Setup(GOConfig &settings);
+  /**
+   * Loads the impulse response and prepares the convolution engines
+   * @param settings the reverb settings
+   * @param sampleRate the sample rate of the processed buffers
+   * @param samplesPerBuffer the number of frames in the processed buffers
+   */
+  void Setup(
+    GOConfig &settings, unsigned sampleRate, unsigned samplesPerBuffer);
 
   void Process(float *output_buffer, unsigned n_frames);
 };
@@ -8,6 +8,8 @@
 #ifndef GOSOUNDSAMPLER_H_
 #define GOSOUNDSAMPLER_H_
 
+#include <chrono>
+
 #include "GOBool3.h"
 #include "GOSoundFader.h"
 #include "GOSoundFilter.h"
@@ -26,6 +28,15 @@ struct GOSoundSampler {
   GOSoundFader fader;
   GOSoundFilter::FilterState toneBalanceFilterState;
   uint64_t time;
+  /* the number of the event that has started the sampler. The samplers
+   * continuing the same pipe sound inherit it */
+  uint64_t sequence;
+  /* the moment of receiving the midi event that has started the sampler or
+   * the default time point if the moment is not known */
+  std::chrono::steady_clock::time_point event_time;
+  /* the number of silent frames before the sampler begins to sound in the
+   * first period it is processed */
+  unsigned start_offset;
   unsigned velocity;
   unsigned delay;
   /* current index of the current block into this sample */
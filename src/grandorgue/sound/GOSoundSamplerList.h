@@ -51,6 +51,29 @@ public:
     } while (true);
   }
 
+  /**
+   * Adds a chain of samplers linked with next with one atomic operation
+   * @param first the first sampler of the chain
+   * @param last the last sampler of the chain
+   * @param count the number of samplers in the chain
+   */
+  void PutChain(GOSoundSampler *first, GOSoundSampler *last, unsigned count) {
+    do {
+      GOSoundSampler *current = m_PutList;
+      last->next = current;
+      if (m_PutList.compare_exchange_strong(current, first)) {
+        m_PutCount.fetch_add(count);
+        return;
+      }
+    } while (true);
+  }
+
+  /**
+   * Takes all samplers available with Get() at once
+   * @return the first sampler of the chain linked with next
+   */
+  GOSoundSampler *TakeAll() { return m_GetList.exchange(nullptr); }
+
   unsigned GetCount() { return m_PutCount; }
 
   void Move() {
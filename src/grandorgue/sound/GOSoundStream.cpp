@@ -7,10 +7,14 @@
 
 #include "GOSoundStream.h"
 
+#include <algorithm>
+#include <climits>
+
 #include <wx/log.h>
 
 #include "GOSoundAudioSection.h"
 #include "GOSoundReleaseAlignTable.h"
+#include "GOSoundResampleSimd.h"
 
 /* Block reading functions */
 
@@ -23,92 +27,134 @@ public:
       (SampleT *)stream.ptr) {}
 };
 
-template <bool format16, uint8_t nChannels>
-class GOSoundStream::StreamCacheWindow
-  : public GOSoundResample::FloatingSampleVector<nChannels> {
+template <uint8_t nChannels>
+class GOSoundStream::StreamDecodeAheadWindow
+  : public GOSoundResample::PtrSampleVector<int, int, nChannels> {
 private:
-  DecompressionCache &r_cache;
-  uint8_t m_ChannelN;
-  enum { PREV, VALUE, ZERO } m_curr;
+  // the index of the first frame in the decode buffer
+  unsigned m_FromIndex;
 
 public:
-  inline StreamCacheWindow(GOSoundStream &stream) : r_cache(stream.cache) {}
+  inline StreamDecodeAheadWindow(GOSoundStream &stream)
+    : GOSoundResample::PtrSampleVector<int, int, nChannels>(
+      stream.m_DecodeBuffer),
+      m_FromIndex(stream.cache.position - stream.m_DecodedFrames) {}
 
   inline void Seek(unsigned index, uint8_t channelN) {
-    while (r_cache.position <= index + 1) {
-      DecompressionStep(r_cache, nChannels, format16);
-    }
-    m_ChannelN = channelN;
-    m_curr = PREV;
+    GOSoundResample::PtrSampleVector<int, int, nChannels>::Seek(
+      index - m_FromIndex, channelN);
+  }
+};
+
+template <uint8_t nChannels>
+class GOSoundStream::StreamBlockWindow
+  : public GOSoundResample::PtrSampleVector<int, int, nChannels> {
+private:
+  static constexpr unsigned BLOCK_FRAMES = GOSoundBlockCompress::BLOCK_FRAMES;
+  static constexpr unsigned BLOCK_SAMPLES = nChannels * BLOCK_FRAMES;
+
+  static_assert(
+    MAX_WINDOW_LEN <= BLOCK_FRAMES,
+    "a window must fit into two subsequent blocks");
+
+  const unsigned char *p_data;
+  unsigned m_BlockCount;
+  int *p_buffer;
+  unsigned &r_BlockIndex;
+
+  inline void DecodeBlockTo(unsigned blockIndex, int *pDst) {
+    if (blockIndex < m_BlockCount)
+      GOSoundBlockCompress::decodeBlock(p_data, blockIndex, nChannels, pDst);
+    else
+      memset(pDst, 0, sizeof(int) * BLOCK_SAMPLES);
   }
 
-  inline int NextSample() {
-    int res;
+public:
+  inline StreamBlockWindow(GOSoundStream &stream)
+    : GOSoundResample::PtrSampleVector<int, int, nChannels>(
+      stream.m_DecodeBuffer),
+      p_data(stream.ptr),
+      m_BlockCount(GOSoundBlockCompress::getBlockCount(stream.ptr)),
+      p_buffer(stream.m_DecodeBuffer),
+      r_BlockIndex(stream.m_BlockBufferIndex) {}
 
-    if (m_curr == PREV) {
-      res = r_cache.prev[m_ChannelN];
-      m_curr = VALUE;
-    } else if (m_curr == VALUE) {
-      res = r_cache.value[m_ChannelN];
-      m_curr = ZERO;
-    } else
-      res = 0;
-    return res;
+  inline void Seek(unsigned index, uint8_t channelN) {
+    const unsigned blockIndex = index / BLOCK_FRAMES;
+
+    if (blockIndex != r_BlockIndex) {
+      if (r_BlockIndex != UINT_MAX && blockIndex == r_BlockIndex + 1)
+        // the second block has already been decoded
+        memcpy(
+          p_buffer, p_buffer + BLOCK_SAMPLES, sizeof(int) * BLOCK_SAMPLES);
+      else
+        DecodeBlockTo(blockIndex, p_buffer);
+      DecodeBlockTo(blockIndex + 1, p_buffer + BLOCK_SAMPLES);
+      r_BlockIndex = blockIndex;
+    }
+    GOSoundResample::PtrSampleVector<int, int, nChannels>::Seek(
+      index % BLOCK_FRAMES, channelN);
   }
 };
 
-template <bool format16, unsigned windowLen, uint8_t nChannels>
-class GOSoundStream::StreamCacheReadAheadWindow
+/* Takes the blocks of a streamed section from its resident heads or from the
+ * ring filled by the prefetch threads */
+template <uint8_t nChannels>
+class GOSoundStream::StreamRingWindow
   : public GOSoundResample::PtrSampleVector<int, int, nChannels> {
 private:
-  static constexpr unsigned WINDOW_SAMPLES = nChannels * windowLen;
-  static constexpr unsigned BUFFER_SAMPLES = WINDOW_SAMPLES * 2;
-
-  DecompressionCache &r_cache;
-  int *p_begin;
-  int *p_end;
+  static constexpr unsigned BLOCK_FRAMES = GOSoundBlockCompress::BLOCK_FRAMES;
+  static constexpr unsigned BLOCK_SAMPLES = nChannels * BLOCK_FRAMES;
+
+  static_assert(
+    MAX_WINDOW_LEN <= BLOCK_FRAMES,
+    "a window must fit into two subsequent blocks");
+
+  const GOSoundAudioSection &r_Section;
+  GOSoundStreamStore::Slot *p_Slot;
+  unsigned m_BlockCount;
+  int *p_buffer;
+  unsigned &r_BlockIndex;
+
+  inline void FetchBlockTo(unsigned blockIndex, int *pDst) {
+    const int *pResident = r_Section.GetResidentBlock(blockIndex);
+
+    if (pResident)
+      memcpy(pDst, pResident, sizeof(int) * BLOCK_SAMPLES);
+    else if (
+      blockIndex >= m_BlockCount || !p_Slot
+      || !p_Slot->ReadBlock(blockIndex, nChannels, pDst))
+      // a block not read in time is played as silence
+      memset(pDst, 0, sizeof(int) * BLOCK_SAMPLES);
+  }
 
 public:
-  inline StreamCacheReadAheadWindow(GOSoundStream &stream)
+  inline StreamRingWindow(GOSoundStream &stream)
     : GOSoundResample::PtrSampleVector<int, int, nChannels>(
-      stream.m_ReadAheadBuffer),
-      r_cache(stream.cache),
-      p_begin(stream.m_ReadAheadBuffer),
-      p_end(p_begin + BUFFER_SAMPLES) {}
+      stream.m_DecodeBuffer),
+      r_Section(*stream.audio_section),
+      p_Slot(stream.p_StreamSlot),
+      m_BlockCount(stream.audio_section->GetBlockCount()),
+      p_buffer(stream.m_DecodeBuffer),
+      r_BlockIndex(stream.m_BlockBufferIndex) {}
 
   inline void Seek(unsigned index, uint8_t channelN) {
-    unsigned readAheadIndexTo = index + windowLen;
-
-    if (r_cache.position < readAheadIndexTo) {
-      unsigned writePosition = std::max(r_cache.position, index);
-      // pWrite1 points somewhere in the first half of the buffer
-      int *pWrite1 = p_begin + nChannels * (writePosition % windowLen);
-      // pWrite2 points somewhere in the second half of the buffer
-      int *pWrite2 = pWrite1 + WINDOW_SAMPLES;
-
-      while (r_cache.position < readAheadIndexTo) {
-        DecompressionStep(r_cache, nChannels, format16);
-
-        /* fill the read ahead buffer. If r_cache.position > index we assume
-          that the previous samples already present */
-        if (r_cache.position >= index) {
-          const int *pRead = r_cache.value;
-
-          for (uint8_t i = nChannels; i > 0; i--)
-            *(pWrite1++) = *(pWrite2++) = *(pRead++);
-          /* because stream.m_ReadAheadBuffer is a ring buffer of a double
-           * windowLen, pWrite2 may move out of the buffer. Reset it to the
-           * buffer begin, so pWrite pointers would swap */
-          if (pWrite2 >= p_end)
-            pWrite2 -= BUFFER_SAMPLES;
-        }
-      }
+    const unsigned blockIndex = index / BLOCK_FRAMES;
+
+    if (blockIndex != r_BlockIndex) {
+      if (p_Slot)
+        // the prefetch threads read ahead of this block
+        p_Slot->Request(blockIndex);
+      if (r_BlockIndex != UINT_MAX && blockIndex == r_BlockIndex + 1)
+        // the second block has already been fetched
+        memcpy(
+          p_buffer, p_buffer + BLOCK_SAMPLES, sizeof(int) * BLOCK_SAMPLES);
+      else
+        FetchBlockTo(blockIndex, p_buffer);
+      FetchBlockTo(blockIndex + 1, p_buffer + BLOCK_SAMPLES);
+      r_BlockIndex = blockIndex;
     }
-    /* Now the ring buffer contains windowLen continous samples in the positions
-     * from index % windowLen to index % windowLen + windowLen. So use Seek of
-     * the parent class */
     GOSoundResample::PtrSampleVector<int, int, nChannels>::Seek(
-      index % windowLen, channelN);
+      index % BLOCK_FRAMES, channelN);
   }
 };
 
@@ -125,125 +171,200 @@ void GOSoundStream::DecodeBlock(float *pOut, unsigned nOutSamples) {
     m_ResamplingPos, w, pOut, nOutSamples);
 }
 
-GOSoundStream::DecodeBlockFunction GOSoundStream::getDecodeBlockFunction(
+template <bool format16, uint8_t nChannels>
+void GOSoundStream::FillDecodeBuffer(unsigned index, unsigned decodeTo) {
+  const unsigned decodedFrom = cache.position - m_DecodedFrames;
+
+  assert(index >= decodedFrom);
+  if (index > decodedFrom) {
+    const unsigned nDrop = std::min(index - decodedFrom, m_DecodedFrames);
+
+    m_DecodedFrames -= nDrop;
+    memmove(
+      m_DecodeBuffer,
+      m_DecodeBuffer + nChannels * nDrop,
+      sizeof(int) * nChannels * m_DecodedFrames);
+    // skip the frames before index if any
+    while (cache.position < index)
+      DecompressionStep(cache, nChannels, format16);
+  }
+
+  int *pWrite = m_DecodeBuffer + nChannels * m_DecodedFrames;
+
+  decodeTo = std::min(decodeTo, index + DECODE_BUFFER_FRAMES);
+  while (cache.position < decodeTo) {
+    DecompressionStep(cache, nChannels, format16);
+    for (uint8_t ch = 0; ch < nChannels; ch++)
+      *(pWrite++) = cache.value[ch];
+  }
+  m_DecodedFrames = cache.position - index;
+}
+
+template <class ResamplerT, bool format16, uint8_t nChannels>
+void GOSoundStream::DecodeAheadBlock(float *pOut, unsigned nOutSamples) {
+  constexpr unsigned windowLen = ResamplerT::VECTOR_LENGTH;
+  ResamplerT resampler(*resample);
+
+  while (nOutSamples > 0) {
+    const unsigned index = m_ResamplingPos.GetIndex();
+
+    /* Decode the source span required for the rest of the period. Don't decode
+     * after the transition position: the end segment is used there */
+    FillDecodeBuffer<format16, nChannels>(
+      index,
+      std::min(
+        m_ResamplingPos.GetIndexAfter(nOutSamples - 1) + windowLen,
+        transition_position - 1 + windowLen));
+
+    StreamDecodeAheadWindow<nChannels> w(*this);
+    // the number of target samples which windows are in the decode buffer
+    const unsigned nSamples = std::min(
+      nOutSamples,
+      m_ResamplingPos.AvailableTargetSamples(cache.position - windowLen + 1));
+
+    if (!nSamples) {
+      // a broken segment or a truncated decode must not stall the audio thread
+      BreakStream(pOut, nOutSamples);
+      break;
+    }
+    resampler.template ResampleBlock<StreamDecodeAheadWindow<nChannels>, 2>(
+      m_ResamplingPos, w, pOut, nSamples);
+    pOut += 2 * nSamples;
+    nOutSamples -= nSamples;
+  }
+}
+
+void GOSoundStream::BreakStream(float *pOut, unsigned nOutSamples) {
+  std::fill(pOut, pOut + 2 * nOutSamples, 0.0f);
+  // ReadBlock() finishes the stream at the next iteration
+  m_NextStartSegmentIndex = -1;
+  m_ResamplingPos.SetIndex(std::max(m_ResamplingPos.GetIndex(), end_pos));
+}
+
+template <class ResamplerT>
+GOSoundStream::DecodeBlockFunction GOSoundStream::getDecodeAheadFunction(
+  uint8_t channels, uint8_t bits_per_sample) {
+  assert(bits_per_sample >= 12);
+  if (channels == 1)
+    return bits_per_sample >= 20
+      ? &GOSoundStream::DecodeAheadBlock<ResamplerT, true, 1>
+      : &GOSoundStream::DecodeAheadBlock<ResamplerT, false, 1>;
+  else if (channels == 2)
+    return bits_per_sample >= 20
+      ? &GOSoundStream::DecodeAheadBlock<ResamplerT, true, 2>
+      : &GOSoundStream::DecodeAheadBlock<ResamplerT, false, 2>;
+
+  assert(0 && "unsupported decoder configuration");
+  return NULL;
+}
+
+template <class PolyphaseResamplerT, class LinearResamplerT>
+GOSoundStream::DecodeBlockFunction GOSoundStream::getDecodeBlockFunctionFor(
   uint8_t channels,
   uint8_t bits_per_sample,
-  bool compressed,
+  GOSoundCompressionType compression,
   GOSoundResample::InterpolationType interpolation,
+  bool is_streamed,
   bool is_end) {
-  if (compressed && !is_end) {
+  if (is_streamed && !is_end) {
     if (interpolation == GOSoundResample::GO_POLYPHASE_INTERPOLATION) {
-      if (channels == 1) {
-        if (bits_per_sample >= 20)
-          return &GOSoundStream::DecodeBlock<
-            GOSoundResample::PolyphaseResampler,
-            StreamCacheReadAheadWindow<
-              true,
-              GOSoundResample::PolyphaseResampler::VECTOR_LENGTH,
-              1>>;
-
-        assert(bits_per_sample >= 12);
+      if (channels == 1)
         return &GOSoundStream::DecodeBlock<
-          GOSoundResample::PolyphaseResampler,
-          StreamCacheReadAheadWindow<
-            false,
-            GOSoundResample::PolyphaseResampler::VECTOR_LENGTH,
-            1>>;
-      } else if (channels == 2) {
-        if (bits_per_sample >= 20)
-          return &GOSoundStream::DecodeBlock<
-            GOSoundResample::PolyphaseResampler,
-            StreamCacheReadAheadWindow<
-              true,
-              GOSoundResample::PolyphaseResampler::VECTOR_LENGTH,
-              2>>;
-
-        assert(bits_per_sample >= 12);
+          PolyphaseResamplerT,
+          StreamRingWindow<1>>;
+      else if (channels == 2)
         return &GOSoundStream::DecodeBlock<
-          GOSoundResample::PolyphaseResampler,
-          StreamCacheReadAheadWindow<
-            false,
-            GOSoundResample::PolyphaseResampler::VECTOR_LENGTH,
-            2>>;
-      }
+          PolyphaseResamplerT,
+          StreamRingWindow<2>>;
     } else {
-      if (channels == 1) {
-        if (bits_per_sample >= 20)
-          return &GOSoundStream::DecodeBlock<
-            GOSoundResample::LinearResampler,
-            StreamCacheWindow<true, 1>>;
-
-        assert(bits_per_sample >= 12);
+      if (channels == 1)
         return &GOSoundStream::DecodeBlock<
-          GOSoundResample::LinearResampler,
-          StreamCacheWindow<false, 1>>;
-      } else if (channels == 2) {
-        if (bits_per_sample >= 20)
-          return &GOSoundStream::DecodeBlock<
-            GOSoundResample::LinearResampler,
-            StreamCacheWindow<true, 2>>;
-
-        assert(bits_per_sample >= 12);
+          LinearResamplerT,
+          StreamRingWindow<1>>;
+      else if (channels == 2)
         return &GOSoundStream::DecodeBlock<
-          GOSoundResample::LinearResampler,
-          StreamCacheWindow<false, 2>>;
-      }
+          LinearResamplerT,
+          StreamRingWindow<2>>;
     }
+  } else if (compression == GO_COMPRESSION_BLOCK && !is_end) {
+    if (interpolation == GOSoundResample::GO_POLYPHASE_INTERPOLATION) {
+      if (channels == 1)
+        return &GOSoundStream::DecodeBlock<
+          PolyphaseResamplerT,
+          StreamBlockWindow<1>>;
+      else if (channels == 2)
+        return &GOSoundStream::DecodeBlock<
+          PolyphaseResamplerT,
+          StreamBlockWindow<2>>;
+    } else {
+      if (channels == 1)
+        return &GOSoundStream::DecodeBlock<
+          LinearResamplerT,
+          StreamBlockWindow<1>>;
+      else if (channels == 2)
+        return &GOSoundStream::DecodeBlock<
+          LinearResamplerT,
+          StreamBlockWindow<2>>;
+    }
+  } else if (compression == GO_COMPRESSION_PREDICTIVE && !is_end) {
+    return interpolation == GOSoundResample::GO_POLYPHASE_INTERPOLATION
+      ? getDecodeAheadFunction<PolyphaseResamplerT>(channels, bits_per_sample)
+      : getDecodeAheadFunction<LinearResamplerT>(channels, bits_per_sample);
   } else {
     if (interpolation == GOSoundResample::GO_POLYPHASE_INTERPOLATION) {
       if (channels == 1) {
         if (bits_per_sample <= 8)
           return &GOSoundStream::DecodeBlock<
-            GOSoundResample::PolyphaseResampler,
+            PolyphaseResamplerT,
             StreamPtrWindow<GOInt8, 1>>;
         if (bits_per_sample <= 16)
           return &GOSoundStream::DecodeBlock<
-            GOSoundResample::PolyphaseResampler,
+            PolyphaseResamplerT,
             StreamPtrWindow<GOInt16, 1>>;
         if (bits_per_sample <= 24)
           return &GOSoundStream::DecodeBlock<
-            GOSoundResample::PolyphaseResampler,
+            PolyphaseResamplerT,
             StreamPtrWindow<GOInt24, 1>>;
       } else if (channels == 2) {
         if (bits_per_sample <= 8)
           return &GOSoundStream::DecodeBlock<
-            GOSoundResample::PolyphaseResampler,
+            PolyphaseResamplerT,
             StreamPtrWindow<GOInt8, 2>>;
         if (bits_per_sample <= 16)
           return &GOSoundStream::DecodeBlock<
-            GOSoundResample::PolyphaseResampler,
+            PolyphaseResamplerT,
             StreamPtrWindow<GOInt16, 2>>;
         if (bits_per_sample <= 24)
           return &GOSoundStream::DecodeBlock<
-            GOSoundResample::PolyphaseResampler,
+            PolyphaseResamplerT,
             StreamPtrWindow<GOInt24, 2>>;
       }
     } else {
       if (channels == 1) {
         if (bits_per_sample <= 8)
           return &GOSoundStream::DecodeBlock<
-            GOSoundResample::LinearResampler,
+            LinearResamplerT,
             StreamPtrWindow<GOInt8, 1>>;
         if (bits_per_sample <= 16)
           return &GOSoundStream::DecodeBlock<
-            GOSoundResample::LinearResampler,
+            LinearResamplerT,
             StreamPtrWindow<GOInt16, 1>>;
         if (bits_per_sample <= 24)
           return &GOSoundStream::DecodeBlock<
-            GOSoundResample::LinearResampler,
+            LinearResamplerT,
             StreamPtrWindow<GOInt24, 1>>;
       } else if (channels == 2) {
         if (bits_per_sample <= 8)
           return &GOSoundStream::DecodeBlock<
-            GOSoundResample::LinearResampler,
+            LinearResamplerT,
             StreamPtrWindow<GOInt8, 2>>;
         if (bits_per_sample <= 16)
           return &GOSoundStream::DecodeBlock<
-            GOSoundResample::LinearResampler,
+            LinearResamplerT,
             StreamPtrWindow<GOInt16, 2>>;
         if (bits_per_sample <= 24)
           return &GOSoundStream::DecodeBlock<
-            GOSoundResample::LinearResampler,
+            LinearResamplerT,
             StreamPtrWindow<GOInt24, 2>>;
       }
     }
@@ -253,6 +374,57 @@ GOSoundStream::DecodeBlockFunction GOSoundStream::getDecodeBlockFunction(
   return NULL;
 }
 
+GOSoundStream::DecodeBlockFunction GOSoundStream::getDecodeBlockFunction(
+  uint8_t channels,
+  uint8_t bits_per_sample,
+  GOSoundCompressionType compression,
+  GOSoundResample::InterpolationType interpolation,
+  bool is_streamed,
+  bool is_end) {
+  switch (GOSoundResampleSimd::getInstructionSet()) {
+#ifdef GO_SOUND_RESAMPLE_SIMD
+  case GOSoundResampleSimd::IS_AVX2:
+    return getDecodeBlockFunctionFor<
+      GOSoundResampleSimd::PolyphaseResamplerAvx2,
+      GOSoundResampleSimd::LinearResamplerSse41>(
+      channels,
+      bits_per_sample,
+      compression,
+      interpolation,
+      is_streamed,
+      is_end);
+  case GOSoundResampleSimd::IS_SSE41:
+    return getDecodeBlockFunctionFor<
+      GOSoundResampleSimd::PolyphaseResamplerSse41,
+      GOSoundResampleSimd::LinearResamplerSse41>(
+      channels,
+      bits_per_sample,
+      compression,
+      interpolation,
+      is_streamed,
+      is_end);
+#endif
+  default:
+    return getDecodeBlockFunctionFor<
+      GOSoundResample::PolyphaseResampler,
+      GOSoundResample::LinearResampler>(
+      channels,
+      bits_per_sample,
+      compression,
+      interpolation,
+      is_streamed,
+      is_end);
+  }
+}
+
+void GOSoundStream::AcquireStreamSlot(unsigned startIndex) {
+  // without a free slot the voice plays only the resident head
+  p_StreamSlot = audio_section->IsStreamed()
+    ? audio_section->GetStreamStore()->AcquireSlot(
+      audio_section, startIndex / GOSoundBlockCompress::BLOCK_FRAMES)
+    : nullptr;
+}
+
 void GOSoundStream::InitStream(
   const GOSoundResample *pResample,
   const GOSoundAudioSection *pSection,
@@ -275,18 +447,23 @@ void GOSoundStream::InitStream(
   decode_call = getDecodeBlockFunction(
     pSection->GetChannels(),
     pSection->GetBitsPerSample(),
-    pSection->IsCompressed(),
+    pSection->GetCompressionType(),
     interpolation,
+    pSection->IsStreamed(),
     false);
   end_decode_call = getDecodeBlockFunction(
     pSection->GetChannels(),
     pSection->GetBitsPerSample(),
-    pSection->IsCompressed(),
+    pSection->GetCompressionType(),
     interpolation,
+    pSection->IsStreamed(),
     true);
   end_pos = end.end_pos;
   cache = start.cache;
   cache.ptr = audio_section->GetData() + (intptr_t)cache.ptr;
+  m_BlockBufferIndex = UINT_MAX;
+  m_DecodedFrames = 0;
+  AcquireStreamSlot(start.start_offset);
 }
 
 void GOSoundStream::InitAlignedStream(
@@ -326,18 +503,27 @@ void GOSoundStream::InitAlignedStream(
   decode_call = getDecodeBlockFunction(
     pSection->GetChannels(),
     pSection->GetBitsPerSample(),
-    pSection->IsCompressed(),
+    pSection->GetCompressionType(),
     interpolation,
+    pSection->IsStreamed(),
     false);
   end_decode_call = getDecodeBlockFunction(
     pSection->GetChannels(),
     pSection->GetBitsPerSample(),
-    pSection->IsCompressed(),
+    pSection->GetCompressionType(),
     interpolation,
+    pSection->IsStreamed(),
     true);
   end_pos = end.end_pos;
   cache = start.cache;
   cache.ptr = audio_section->GetData() + (intptr_t)cache.ptr;
+  m_BlockBufferIndex = UINT_MAX;
+  m_DecodedFrames = 0;
+  AcquireStreamSlot(startIndex);
+}
+
+float GOSoundStream::GetRemainingAmplitude() const {
+  return audio_section->GetRemainingAmplitude(m_ResamplingPos.GetIndex());
 }
 
 bool GOSoundStream::ReadBlock(float *buffer, unsigned int n_blocks) {
@@ -388,6 +574,7 @@ bool GOSoundStream::ReadBlock(float *buffer, unsigned int n_blocks) {
 
       cache = next->cache;
       cache.ptr = audio_section->GetData() + (intptr_t)cache.ptr;
+      m_DecodedFrames = 0;
       transition_position = next_end->transition_offset;
       end_pos = next_end->end_pos;
       end_ptr = next_end->end_ptr;
@@ -428,20 +615,51 @@ void GOSoundStream::GetHistory(
   if (pos >= transition_position)
     for (unsigned i = 0; i < BLOCK_HISTORY; i++)
       for (uint8_t j = 0; j < nChannels; j++)
-        history[i][j] = audio_section->GetSampleData(
-          end_ptr, pos - transition_position + i, j);
-  else if (!audio_section->IsCompressed())
+        // end_ptr is a virtual pointer, so it is addressed with pos
+        history[i][j] = audio_section->GetSampleData(end_ptr, pos + i, j);
+  else if (!audio_section->IsStreamed() && !audio_section->IsCompressed())
     for (unsigned i = 0; i < BLOCK_HISTORY; i++)
       for (uint8_t j = 0; j < nChannels; j++)
         history[i][j] = audio_section->GetSampleData(ptr, pos + i, j);
-  else {
+  else if (
+    audio_section->IsStreamed()
+    || audio_section->GetCompressionType() == GO_COMPRESSION_BLOCK) {
+    // a streamed section is decoded into the block buffer as well
+    if (
+      m_BlockBufferIndex != UINT_MAX
+      && pos >= m_BlockBufferIndex * GOSoundBlockCompress::BLOCK_FRAMES
+      && pos + BLOCK_HISTORY
+        <= (m_BlockBufferIndex + 2) * GOSoundBlockCompress::BLOCK_FRAMES) {
+      // the history is already decoded in the block buffer
+      const int *pFrame = m_DecodeBuffer
+        + nChannels
+          * (pos - m_BlockBufferIndex * GOSoundBlockCompress::BLOCK_FRAMES);
+
+      for (unsigned i = 0; i < BLOCK_HISTORY; i++, pFrame += nChannels)
+        for (uint8_t j = 0; j < nChannels; j++)
+          history[i][j] = pFrame[j];
+    } else
+      for (unsigned i = 0; i < BLOCK_HISTORY; i++)
+        for (uint8_t j = 0; j < nChannels; j++)
+          history[i][j] = audio_section->GetSample(pos + i, j);
+  } else {
+    const unsigned decodedFrom = cache.position - m_DecodedFrames;
     DecompressionCache tmpCache = cache;
 
     for (unsigned i = 0; i < BLOCK_HISTORY; i++) {
-      for (uint8_t j = 0; j < nChannels; j++)
-        history[i][j] = tmpCache.value[j];
-      DecompressionStep(
-        tmpCache, nChannels, audio_section->GetBitsPerSample() >= 20);
+      const unsigned index = pos + i;
+
+      if (index >= decodedFrom && index < cache.position)
+        // the frame is already decoded
+        for (uint8_t j = 0; j < nChannels; j++)
+          history[i][j] = m_DecodeBuffer[(index - decodedFrom) * nChannels + j];
+      else {
+        while (tmpCache.position <= index)
+          DecompressionStep(
+            tmpCache, nChannels, audio_section->GetBitsPerSample() >= 20);
+        for (uint8_t j = 0; j < nChannels; j++)
+          history[i][j] = tmpCache.value[j];
+      }
     }
   }
 }
@@ -8,8 +8,10 @@
 #ifndef GOSOUNDSTREAM_H
 #define GOSOUNDSTREAM_H
 
+#include "GOSoundBlockCompress.h"
 #include "GOSoundCompress.h"
 #include "GOSoundResample.h"
+#include "GOSoundStreamStore.h"
 
 class GOSoundAudioSection;
 
@@ -20,16 +22,20 @@ private:
   static constexpr unsigned MAX_WINDOW_LEN = GOSoundResample::POLYPHASE_POINTS;
   /* Maximum number of audio chanels in the source samples */
   static constexpr unsigned MAX_INPUT_CHANNELS = 2;
+  /* Number of frames in m_DecodeBuffer */
+  static constexpr unsigned DECODE_BUFFER_FRAMES
+    = GOSoundBlockCompress::BLOCK_FRAMES * 2;
 
   const GOSoundAudioSection *audio_section;
   const GOSoundResample *resample;
 
   template <class SampleT, uint8_t nChannels> class StreamPtrWindow;
 
-  template <bool format16, uint8_t nChannels> class StreamCacheWindow;
+  template <uint8_t nChannels> class StreamDecodeAheadWindow;
 
-  template <bool format16, unsigned windowLen, uint8_t nChannels>
-  class StreamCacheReadAheadWindow;
+  template <uint8_t nChannels> class StreamBlockWindow;
+
+  template <uint8_t nChannels> class StreamRingWindow;
 
   typedef void (GOSoundStream::*DecodeBlockFunction)(
     float *pOut, unsigned nOutSamples);
@@ -61,10 +67,24 @@ private:
   /* for decoding compressed format */
   DecompressionCache cache;
 
-  /* A ring buffer for resampling of compressed samples. It has double
-   * MAX_WINDOW_LEN length for having a continous memory region of
-   * MAX_WINDOW_LEN samples */
-  int m_ReadAheadBuffer[MAX_INPUT_CHANNELS * MAX_WINDOW_LEN * 2];
+  /* Decoded samples of a compressed audio section:
+   * - for the block compression it contains two subsequent blocks, so any
+   *   MAX_WINDOW_LEN samples starting in the first block are continous
+   * - for the predictive compression it contains m_DecodedFrames frames just
+   *   before cache.position */
+  int m_DecodeBuffer[MAX_INPUT_CHANNELS * DECODE_BUFFER_FRAMES];
+  // The index of the first block in m_DecodeBuffer. UINT_MAX if it is empty
+  unsigned m_BlockBufferIndex;
+  // The number of frames in m_DecodeBuffer decoded with the predictive format
+  unsigned m_DecodedFrames;
+
+  /* The ring the blocks of a streamed section are read from. nullptr if the
+   * section is resident or all slots are in use */
+  GOSoundStreamStore::Slot *p_StreamSlot;
+
+  /* Acquires a stream slot if the section is streamed. The previous slot is
+   * not released because it belongs to the sampler the stream was copied to */
+  void AcquireStreamSlot(unsigned startIndex);
 
   /* The block decode functions should provide whatever the normal resolution of
    * the audio is. The fade engine should ensure that this data is always
@@ -72,11 +92,42 @@ private:
   template <class ResamplerT, class WindowT>
   void DecodeBlock(float *pOut, unsigned nOutSamples);
 
+  /* Decodes the frames of the predictive format from index up to decodeTo
+   * into m_DecodeBuffer. The frames before index are dropped */
+  template <bool format16, uint8_t nChannels>
+  void FillDecodeBuffer(unsigned index, unsigned decodeTo);
+
+  /* Decodes the predictive format in chunks of m_DecodeBuffer ahead of the
+   * resampler, so the resampler processes the continous decoded samples */
+  template <class ResamplerT, bool format16, uint8_t nChannels>
+  void DecodeAheadBlock(float *pOut, unsigned nOutSamples);
+
+  /* Fills nOutSamples stereo samples with silence and moves the stream to its
+   * end, so ReadBlock() finishes it */
+  void BreakStream(float *pOut, unsigned nOutSamples);
+
+  template <class ResamplerT>
+  static DecodeBlockFunction getDecodeAheadFunction(
+    uint8_t channels, uint8_t bits_per_sample);
+
+  /* Selects the decode function using the given resampler implementations */
+  template <class PolyphaseResamplerT, class LinearResamplerT>
+  static DecodeBlockFunction getDecodeBlockFunctionFor(
+    uint8_t channels,
+    uint8_t bits_per_sample,
+    GOSoundCompressionType compression,
+    GOSoundResample::InterpolationType interpolation,
+    bool is_streamed,
+    bool is_end);
+
+  /* Selects the decode function using the fastest resampler implementations
+   * supported by the CPU */
   static DecodeBlockFunction getDecodeBlockFunction(
     uint8_t channels,
     uint8_t bits_per_sample,
-    bool compressed,
+    GOSoundCompressionType compression,
     GOSoundResample::InterpolationType interpolation,
+    bool is_streamed,
     bool is_end);
 
   void GetHistory(int history[BLOCK_HISTORY][MAX_OUTPUT_CHANNELS]) const;
@@ -98,6 +149,18 @@ public:
 
   /* Read an audio buffer from an audio section stream */
   bool ReadBlock(float *buffer, unsigned int n_blocks);
+
+  /* Returns the highest amplitude the stream may play from the current
+   * position on, in the units of the decoded samples */
+  float GetRemainingAmplitude() const;
+
+  /* Returns the stream slot when the sampler is not used anymore */
+  void ReleaseStreamSlot() {
+    if (p_StreamSlot) {
+      p_StreamSlot->Release();
+      p_StreamSlot = nullptr;
+    }
+  }
 };
 
 #endif /* GOSOUNDSTREAM_H */
@@ -0,0 +1,329 @@
+/*
+ * Copyright 2006 Milan Digital Audio LLC
+ * Copyright 2009-2025 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#include "GOSoundStreamStore.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <wx/filefn.h>
+#include <wx/intl.h>
+#include <wx/log.h>
+
+#include "threading/GOMutexLocker.h"
+#include "threading/GOThread.h"
+
+#include "GOSoundAudioSection.h"
+
+class GOSoundStreamStore::PrefetchThread : public GOThread {
+private:
+  GOSoundStreamStore &r_Store;
+  unsigned m_FirstSlot;
+  unsigned m_SlotStep;
+  Reader m_Reader;
+  std::vector<int> m_Buffer;
+
+protected:
+  void Entry() override;
+
+public:
+  PrefetchThread(GOSoundStreamStore &store, unsigned index, unsigned count)
+    : r_Store(store),
+      m_FirstSlot(index),
+      m_SlotStep(count),
+      m_Reader(store),
+      m_Buffer(SLOT_BLOCKS * BLOCK_SAMPLES) {}
+};
+
+void GOSoundStreamStore::PrefetchThread::Entry() {
+  while (!ShouldStop()) {
+    // a request arriving during the pass is not missed
+    const unsigned signal
+      = r_Store.m_PrefetchSignal.load(std::memory_order_acquire);
+    unsigned nRead = 0;
+
+    for (unsigned i = m_FirstSlot; i < r_Store.m_SlotCount; i += m_SlotStep)
+      nRead += r_Store.m_Slots[i].Prefetch(m_Reader, m_Buffer.data());
+    if (nRead)
+      r_Store.m_BlocksRead.fetch_add(nRead, std::memory_order_relaxed);
+    else
+      // nothing to read: wait until a voice advances
+      r_Store.WaitForRequest(signal, this);
+  }
+}
+
+const unsigned char *GOSoundStreamStore::Reader::Read(
+  StreamFile file, uint64_t offset, unsigned length) {
+  wxFile &f = m_Files[file];
+
+  if (!f.IsOpened() && !f.Open(r_Store.m_Paths[file], wxFile::read))
+    return nullptr;
+  if (m_Buffer.size() < length)
+    m_Buffer.resize(length);
+  if (
+    f.Seek(offset) == wxInvalidOffset
+    || f.Read(m_Buffer.data(), length) != (ssize_t)length)
+    return nullptr;
+  return m_Buffer.data();
+}
+
+GOSoundStreamStore::Slot::Slot()
+  : p_Store(nullptr),
+    m_IsInUse(false),
+    p_Section(nullptr),
+    m_Generation(0),
+    m_RequestedBlock(0),
+    m_FetchCount(0),
+    m_UnderrunCount(0) {
+  for (std::atomic_uint64_t &tag : m_Tags)
+    tag.store(INVALID_TAG);
+}
+
+unsigned GOSoundStreamStore::Slot::Prefetch(Reader &reader, int *pBuffer) {
+  const unsigned generation = m_Generation.load(std::memory_order_acquire);
+  const GOSoundAudioSection *pSection
+    = p_Section.load(std::memory_order_acquire);
+  const unsigned requested = m_RequestedBlock.load(std::memory_order_relaxed);
+  unsigned nRead = 0;
+
+  // the slot might be acquired by another voice in the meantime
+  if (!pSection || m_Generation.load(std::memory_order_acquire) != generation)
+    return 0;
+
+  /* Read only the blocks within SLOT_BLOCKS from the first streamed one, so
+   * they do not overwrite each other in the ring */
+  const unsigned from = pSection->GetNextStreamedBlock(requested);
+  const unsigned to = std::min(from + SLOT_BLOCKS, pSection->GetBlockCount());
+  auto isToRead = [&](unsigned blockIndex) {
+    return !pSection->GetResidentBlock(blockIndex)
+      && m_Tags[blockIndex % SLOT_BLOCKS].load(std::memory_order_relaxed)
+      != makeTag(generation, blockIndex);
+  };
+
+  for (unsigned blockIndex = from; blockIndex < to;) {
+    if (!isToRead(blockIndex)) {
+      blockIndex++;
+      continue;
+    }
+
+    // read the whole run of the missing blocks at once
+    unsigned runEnd = blockIndex + 1;
+
+    while (runEnd < to && isToRead(runEnd))
+      runEnd++;
+    if (!pSection->ReadStreamBlocks(
+          reader, blockIndex, runEnd - blockIndex, pBuffer))
+      break;
+    for (unsigned i = blockIndex; i < runEnd; i++) {
+      std::atomic_uint64_t &tag = m_Tags[i % SLOT_BLOCKS];
+
+      tag.store(INVALID_TAG, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+      memcpy(
+        m_Frames[i % SLOT_BLOCKS],
+        pBuffer + (i - blockIndex) * BLOCK_SAMPLES,
+        sizeof(m_Frames[0]));
+      tag.store(makeTag(generation, i), std::memory_order_release);
+    }
+    nRead += runEnd - blockIndex;
+    blockIndex = runEnd;
+  }
+  return nRead;
+}
+
+bool GOSoundStreamStore::Slot::ReadBlock(
+  unsigned blockIndex, uint8_t nChannels, int *pDst) {
+  const uint64_t expectedTag = makeTag(
+    m_Generation.load(std::memory_order_relaxed), blockIndex);
+  std::atomic_uint64_t &tag = m_Tags[blockIndex % SLOT_BLOCKS];
+  bool isRead = tag.load(std::memory_order_acquire) == expectedTag;
+
+  if (isRead) {
+    memcpy(
+      pDst,
+      m_Frames[blockIndex % SLOT_BLOCKS],
+      sizeof(int) * nChannels * BLOCK_FRAMES);
+    // the block might be overwritten during copying
+    std::atomic_thread_fence(std::memory_order_acquire);
+    isRead = tag.load(std::memory_order_relaxed) == expectedTag;
+  }
+  // only the owning voice updates the counters
+  m_FetchCount.store(
+    m_FetchCount.load(std::memory_order_relaxed) + 1,
+    std::memory_order_relaxed);
+  if (!isRead)
+    m_UnderrunCount.store(
+      m_UnderrunCount.load(std::memory_order_relaxed) + 1,
+      std::memory_order_relaxed);
+  return isRead;
+}
+
+GOSoundStreamStore::GOSoundStreamStore(
+  const wxString &scratchPath,
+  unsigned headLength,
+  unsigned slotCount,
+  unsigned threadCount)
+  : m_HeadLength(headLength),
+    m_IsScratchFailed(false),
+    m_ScratchSize(0),
+    m_Slots(new Slot[slotCount]),
+    m_SlotCount(slotCount),
+    m_NextSlot(0),
+    m_BlocksRead(0),
+    m_PrefetchSignal(0),
+    m_WaitingCount(0),
+    m_PrefetchCondition(m_WaitMutex) {
+  m_Paths[STREAM_FILE_SCRATCH] = scratchPath;
+  for (unsigned i = 0; i < slotCount; i++)
+    m_Slots[i].p_Store = this;
+  for (unsigned i = 0; i < threadCount; i++) {
+    PrefetchThread *pThread = new PrefetchThread(*this, i, threadCount);
+
+    m_Threads.push_back(pThread);
+    pThread->Start();
+  }
+}
+
+GOSoundStreamStore::~GOSoundStreamStore() {
+  const Statistic stat = GetStatistic();
+
+  for (unsigned i = 0; i < m_Threads.size(); i++)
+    m_Threads[i]->MarkForStop();
+  {
+    GOMutexLocker lock(m_WaitMutex);
+
+    m_PrefetchSignal.fetch_add(1);
+    m_PrefetchCondition.Broadcast();
+  }
+  for (unsigned i = 0; i < m_Threads.size(); i++)
+    m_Threads[i]->Wait();
+  m_Threads.clear();
+  if (stat.m_Underruns)
+    wxLogWarning(
+      _("Sample streaming: %llu of %llu blocks were not read from disk in "
+        "time. Consider increasing the resident head length."),
+      (unsigned long long)stat.m_Underruns,
+      (unsigned long long)stat.m_BlockFetches);
+  for (wxFile &file : m_Files)
+    if (file.IsOpened())
+      file.Close();
+  if (wxFileExists(m_Paths[STREAM_FILE_SCRATCH]))
+    wxRemoveFile(m_Paths[STREAM_FILE_SCRATCH]);
+}
+
+void GOSoundStreamStore::NotifyPrefetch() {
+  m_PrefetchSignal.fetch_add(1, std::memory_order_release);
+  // a waiter increments m_WaitingCount before checking m_PrefetchSignal, so
+  // either it sees the new signal or we see it waiting
+  if (m_WaitingCount.load()) {
+    GOMutexLocker lock(m_WaitMutex);
+
+    m_PrefetchCondition.Broadcast();
+  }
+}
+
+void GOSoundStreamStore::WaitForRequest(unsigned signal, GOThread *pThread) {
+  GOMutexLocker lock(m_WaitMutex);
+
+  m_WaitingCount.fetch_add(1);
+  if (m_PrefetchSignal.load() == signal && !pThread->ShouldStop())
+    m_PrefetchCondition.WaitOrStop(nullptr, pThread);
+  m_WaitingCount.fetch_sub(1);
+}
+
+bool GOSoundStreamStore::SetCacheFile(const wxString &path) {
+  GOMutexLocker locker(m_FileMutex);
+  wxFile &file = m_Files[STREAM_FILE_CACHE];
+
+  if (!file.IsOpened() && file.Open(path, wxFile::read))
+    m_Paths[STREAM_FILE_CACHE] = path;
+  return file.IsOpened();
+}
+
+bool GOSoundStreamStore::Append(
+  const void *data, size_t length, uint64_t &offset) {
+  GOMutexLocker locker(m_FileMutex);
+  wxFile &file = m_Files[STREAM_FILE_SCRATCH];
+  const wxString &path = m_Paths[STREAM_FILE_SCRATCH];
+
+  if (!file.IsOpened() && !m_IsScratchFailed) {
+    if (
+      !file.Create(path, true) || !file.Close()
+      || !file.Open(path, wxFile::read_write)) {
+      // the sections remain resident
+      m_IsScratchFailed = true;
+      wxLogError(_("Unable to create the stream file %s"), path);
+    }
+  }
+
+  bool res = file.IsOpened() && file.Seek(m_ScratchSize) != wxInvalidOffset
+    && file.Write(data, length) == length;
+
+  if (res) {
+    offset = m_ScratchSize;
+    m_ScratchSize += length;
+  }
+  return res;
+}
+
+bool GOSoundStreamStore::ReadBack(
+  StreamFile file, uint64_t offset, void *data, size_t length) {
+  GOMutexLocker locker(m_FileMutex);
+  wxFile &f = m_Files[file];
+
+  return f.IsOpened() && f.Seek(offset) != wxInvalidOffset
+    && f.Read(data, length) == (ssize_t)length;
+}
+
+GOSoundStreamStore::Slot *GOSoundStreamStore::AcquireSlot(
+  const GOSoundAudioSection *section, unsigned blockIndex) {
+  const unsigned start = m_NextSlot.load(std::memory_order_relaxed);
+
+  for (unsigned i = 0; i < m_SlotCount; i++) {
+    const unsigned index = (start + i) % m_SlotCount;
+    Slot &slot = m_Slots[index];
+    bool wasInUse = false;
+
+    if (
+      !slot.m_IsInUse.load(std::memory_order_relaxed)
+      && slot.m_IsInUse.compare_exchange_strong(
+        wasInUse, true, std::memory_order_acquire)) {
+      slot.p_Section.store(section, std::memory_order_relaxed);
+      slot.m_RequestedBlock.store(blockIndex, std::memory_order_relaxed);
+      // publishes the section to the prefetch threads
+      slot.m_Generation.fetch_add(1, std::memory_order_release);
+      m_NextSlot.store(index + 1, std::memory_order_relaxed);
+      NotifyPrefetch();
+      return &slot;
+    }
+  }
+  return nullptr;
+}
+
+void GOSoundStreamStore::ReleaseAllSlots() {
+  for (unsigned i = 0; i < m_SlotCount; i++)
+    m_Slots[i].Release();
+}
+
+GOSoundStreamStore::Statistic GOSoundStreamStore::GetStatistic() const {
+  Statistic stat;
+
+  stat.m_StreamedSize = m_ScratchSize;
+  stat.m_BlocksRead = m_BlocksRead.load(std::memory_order_relaxed);
+  stat.m_BlockFetches = 0;
+  stat.m_Underruns = 0;
+  stat.m_SlotsInUse = 0;
+  for (unsigned i = 0; i < m_SlotCount; i++) {
+    const Slot &slot = m_Slots[i];
+
+    stat.m_BlockFetches += slot.m_FetchCount.load(std::memory_order_relaxed);
+    stat.m_Underruns += slot.m_UnderrunCount.load(std::memory_order_relaxed);
+    if (slot.m_IsInUse.load(std::memory_order_relaxed))
+      stat.m_SlotsInUse++;
+  }
+  return stat;
+}
@@ -0,0 +1,221 @@
+/*
+ * Copyright 2006 Milan Digital Audio LLC
+ * Copyright 2009-2025 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#ifndef GOSOUNDSTREAMSTORE_H
+#define GOSOUNDSTREAMSTORE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <wx/file.h>
+#include <wx/string.h>
+
+#include "ptrvector.h"
+#include "threading/GOCondition.h"
+#include "threading/GOMutex.h"
+
+#include "GOSoundBlockCompress.h"
+
+class GOSoundAudioSection;
+
+/**
+ * Keeps the main data of the audio sections on disk when the sample streaming
+ * is enabled.
+ *
+ * The main data of the sections loaded from a complete cache is streamed from
+ * the cache file itself. The sections loaded from the sample files or from
+ * .orgue archives are not addressable by blocks there, so their main data is
+ * appended to a scratch file next to the cache file. Only the heads of the
+ * start segments remain resident (see GOSoundAudioSection::MoveToStream).
+ *
+ * Each streamed voice owns a Slot. It is a ring of SLOT_BLOCKS decoded blocks
+ * that the prefetch threads fill ahead of the position the voice has
+ * requested. The audio threads never wait for the disk: a block missing in the
+ * ring is played as silence and counted as an underrun. The prefetch threads
+ * sleep until a voice requests a new block.
+ */
+class GOSoundStreamStore {
+public:
+  // the files the main data is streamed from
+  enum StreamFile : uint8_t {
+    STREAM_FILE_SCRATCH,
+    STREAM_FILE_CACHE,
+    STREAM_FILE_COUNT
+  };
+
+
+  static constexpr unsigned BLOCK_FRAMES = GOSoundBlockCompress::BLOCK_FRAMES;
+  static constexpr unsigned MAX_CHANNELS = 2;
+  static constexpr unsigned BLOCK_SAMPLES = MAX_CHANNELS * BLOCK_FRAMES;
+  // the number of blocks read ahead of the position of each streamed voice
+  static constexpr unsigned SLOT_BLOCKS = 64;
+
+  /* Reads the stream files with own file handles */
+  class Reader {
+  private:
+    const GOSoundStreamStore &r_Store;
+    wxFile m_Files[STREAM_FILE_COUNT];
+    std::vector<unsigned char> m_Buffer;
+
+  public:
+    Reader(const GOSoundStreamStore &store) : r_Store(store) {}
+
+    /**
+     * Reads length bytes from the offset of the stream file. The file is
+     * opened on the first read
+     * @return pointer to the data valid until the next call or nullptr
+     */
+    const unsigned char *Read(
+      StreamFile file, uint64_t offset, unsigned length);
+  };
+
+  class Slot {
+  private:
+    friend class GOSoundStreamStore;
+
+    static constexpr uint64_t INVALID_TAG = UINT64_MAX;
+
+    GOSoundStreamStore *p_Store;
+    std::atomic_bool m_IsInUse;
+    std::atomic<const GOSoundAudioSection *> p_Section;
+    // increased on each acquiring, so the data of a previous owner is ignored
+    std::atomic_uint m_Generation;
+    // the first block the voice still needs
+    std::atomic_uint m_RequestedBlock;
+    // the number of block reads and underruns of the ring
+    std::atomic_uint64_t m_FetchCount;
+    std::atomic_uint64_t m_UnderrunCount;
+    // generation and block index of the data at each ring position
+    std::atomic_uint64_t m_Tags[SLOT_BLOCKS];
+    int m_Frames[SLOT_BLOCKS][BLOCK_SAMPLES];
+
+    static uint64_t makeTag(unsigned generation, unsigned blockIndex) {
+      return ((uint64_t)generation << 32) | blockIndex;
+    }
+
+    /* Decodes the missing blocks ahead of the requested one.
+     * Called by a prefetch thread */
+    unsigned Prefetch(Reader &reader, int *pBuffer);
+
+  public:
+    Slot();
+
+    /* Tells which block the voice needs now. Called by the audio threads */
+    void Request(unsigned blockIndex) {
+      if (m_RequestedBlock.load(std::memory_order_relaxed) != blockIndex) {
+        m_RequestedBlock.store(blockIndex, std::memory_order_relaxed);
+        p_Store->NotifyPrefetch();
+      }
+    }
+
+    /**
+     * Copies the decoded block from the ring. Called by the audio threads
+     * @return false and counts an underrun if the block has not been read yet
+     */
+    bool ReadBlock(unsigned blockIndex, uint8_t nChannels, int *pDst);
+
+    void Release() {
+      p_Section.store(nullptr, std::memory_order_release);
+      m_IsInUse.store(false, std::memory_order_release);
+    }
+  };
+
+  struct Statistic {
+    // the size of the data copied to the scratch file
+    uint64_t m_StreamedSize;
+    uint64_t m_BlocksRead;
+    uint64_t m_BlockFetches;
+    uint64_t m_Underruns;
+    unsigned m_SlotsInUse;
+  };
+
+private:
+  class PrefetchThread;
+
+  wxString m_Paths[STREAM_FILE_COUNT];
+  unsigned m_HeadLength;
+
+  GOMutex m_FileMutex;
+  wxFile m_Files[STREAM_FILE_COUNT]; // guarded by m_FileMutex
+  // whether creating the scratch file has failed
+  bool m_IsScratchFailed; // guarded by m_FileMutex
+  uint64_t m_ScratchSize; // guarded by m_FileMutex
+
+  std::unique_ptr<Slot[]> m_Slots;
+  unsigned m_SlotCount;
+  std::atomic_uint m_NextSlot;
+  std::atomic_uint64_t m_BlocksRead;
+  ptr_vector<PrefetchThread> m_Threads;
+
+  // is incremented on each new request to the prefetch threads
+  std::atomic_uint m_PrefetchSignal;
+  // the number of the prefetch threads waiting for a request
+  std::atomic_uint m_WaitingCount;
+  GOMutex m_WaitMutex;
+  GOCondition m_PrefetchCondition;
+
+  /* Wakes up the prefetch threads. Locks only when some of them sleep */
+  void NotifyPrefetch();
+
+  /* Sleeps until m_PrefetchSignal differs from signal or the thread stops */
+  void WaitForRequest(unsigned signal, GOThread *pThread);
+
+public:
+  /**
+   * Starts the prefetch threads
+   * @param scratchPath the scratch file. It is created on the first Append()
+   *   and removed on destruction
+   * @param headLength the length of the resident head of each section in ms
+   * @param slotCount the maximal number of voices streamed at the same time
+   * @param threadCount the number of the prefetch threads
+   */
+  GOSoundStreamStore(
+    const wxString &scratchPath,
+    unsigned headLength,
+    unsigned slotCount,
+    unsigned threadCount);
+  ~GOSoundStreamStore();
+
+  unsigned GetHeadLength() const { return m_HeadLength; }
+
+  /**
+   * Lets the sections loaded from the cache stream their main data from the
+   * cache file. Must be called before loading them. The cache file must not
+   * be rewritten while the store exists
+   * @return false if the cache file could not be opened
+   */
+  bool SetCacheFile(const wxString &path);
+
+  /* Whether the sections are streamed from the cache file */
+  bool IsCacheFileUsed() const { return !m_Paths[STREAM_FILE_CACHE].IsEmpty(); }
+
+  /**
+   * Appends the data to the scratch file. Called by the loader threads
+   * @param offset the offset of the data in the scratch file
+   * @return false if the data could not be written
+   */
+  bool Append(const void *data, size_t length, uint64_t &offset);
+
+  /* Reads back the streamed data, f.e. for writing the cache */
+  bool ReadBack(StreamFile file, uint64_t offset, void *data, size_t length);
+
+  /**
+   * Finds a free slot for streaming the section. Called by the audio threads
+   * @param blockIndex the first block the voice will play
+   * @return nullptr if all slots are in use
+   */
+  Slot *AcquireSlot(const GOSoundAudioSection *section, unsigned blockIndex);
+
+  /* Makes all slots free. The voices must not be played anymore */
+  void ReleaseAllSlots();
+
+  Statistic GetStatistic() const;
+};
+
+#endif /* GOSOUNDSTREAMSTORE_H */
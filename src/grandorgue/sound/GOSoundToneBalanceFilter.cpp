@@ -9,6 +9,7 @@
 #include <cmath>
 
 void GOSoundToneBalanceFilter::Init(int8_t value) {
+  m_value = value;
   if (value == 0)
     m_filter.Init(GOSoundFilter::FilterType::TYPE_NONE, 0);
   else {
@@ -13,12 +13,15 @@
 class GOSoundToneBalanceFilter {
 public:
   void Init(int8_t value);
+  /* The providers with the same value have the same filter */
+  int8_t GetValue() const { return m_value; }
   const GOSoundFilter *GetFilter() const { return &m_filter; }
   void SetFilterSamplerate(unsigned samplerate) {
     m_filter.SetSamplerate(samplerate);
   }
 
 private:
+  int8_t m_value = 0;
   GOSoundFilter m_filter;
 };
 
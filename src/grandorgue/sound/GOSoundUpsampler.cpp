@@ -0,0 +1,100 @@
+/*
+ * Copyright 2026 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#include "GOSoundUpsampler.h"
+
+#include <algorithm>
+#include <math.h>
+
+/* The Kaiser window parameter. 12.5 gives the stopband attenuation of about
+ * 120 dB. With TAPS_PER_PHASE taps the transition band is about +-0.125 of the
+ * source Nyquist frequency around the cutoff */
+static constexpr double KAISER_BETA = 12.5;
+
+/* The modified Bessel function of the first kind of order 0 */
+static double bessel_i0(double x) {
+  const double q = x * x * 0.25;
+  double term = 1.0;
+  double sum = 1.0;
+
+  for (unsigned k = 1; term > sum * 1e-17; k++) {
+    term *= q / ((double)k * k);
+    sum += term;
+  }
+  return sum;
+}
+
+GOSoundUpsampler::GOSoundUpsampler(unsigned factor, unsigned channels)
+  : m_Factor(std::max(factor, 1u)),
+    m_Channels(channels),
+    m_Coefs(m_Factor * TAPS_PER_PHASE),
+    m_History(m_Channels * TAPS_PER_PHASE * 2),
+    m_HistoryPos(0) {
+  const unsigned length = m_Factor * TAPS_PER_PHASE;
+  const double center = (length - 1) * 0.5;
+  // the cutoff at the source Nyquist frequency in cycles per target sample
+  const double fc = 0.5 / m_Factor;
+  const double windowNorm = 1.0 / bessel_i0(KAISER_BETA);
+  std::vector<double> coefs(length);
+  std::vector<double> phaseSums(m_Factor, 0.0);
+
+  for (unsigned n = 0; n < length; n++) {
+    const double t = n - center;
+    const double x = 2 * M_PI * fc * t;
+    const double sinc = t == 0 ? 1.0 : sin(x) / x;
+    const double r = t / (length * 0.5);
+    const double window
+      = bessel_i0(KAISER_BETA * sqrt(1.0 - r * r)) * windowNorm;
+
+    coefs[n] = sinc * window;
+    phaseSums[n % m_Factor] += coefs[n];
+  }
+  for (unsigned n = 0; n < length; n++) {
+    const unsigned phase = n % m_Factor;
+    const unsigned tap = n / m_Factor;
+
+    /* Each phase has the unity gain at DC, so the phases do not differ in
+     * level, which would produce images of DC */
+    m_Coefs[phase * TAPS_PER_PHASE + (TAPS_PER_PHASE - 1 - tap)]
+      = coefs[n] / phaseSums[phase];
+  }
+}
+
+void GOSoundUpsampler::Reset() {
+  std::fill(m_History.begin(), m_History.end(), 0.0f);
+  m_HistoryPos = 0;
+}
+
+void GOSoundUpsampler::Process(
+  const float *pIn, unsigned nInFrames, float *pOut) {
+  const unsigned outStep = m_Channels * m_Factor;
+
+  for (unsigned i = 0; i < nInFrames; i++) {
+    for (unsigned ch = 0; ch < m_Channels; ch++) {
+      float *pHistory = m_History.data() + ch * TAPS_PER_PHASE * 2;
+
+      pHistory[m_HistoryPos] = pHistory[m_HistoryPos + TAPS_PER_PHASE]
+        = pIn[ch];
+    }
+    m_HistoryPos = (m_HistoryPos + 1) % TAPS_PER_PHASE;
+    for (unsigned ch = 0; ch < m_Channels; ch++) {
+      // TAPS_PER_PHASE last frames in the time order
+      const float *pWindow
+        = m_History.data() + ch * TAPS_PER_PHASE * 2 + m_HistoryPos;
+
+      for (unsigned phase = 0; phase < m_Factor; phase++) {
+        const float *pCoefs = m_Coefs.data() + phase * TAPS_PER_PHASE;
+        float sum = 0.0f;
+
+        for (unsigned j = 0; j < TAPS_PER_PHASE; j++)
+          sum += pCoefs[j] * pWindow[j];
+        pOut[phase * m_Channels + ch] = sum;
+      }
+    }
+    pIn += m_Channels;
+    pOut += outStep;
+  }
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright 2026 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#ifndef GOSOUNDUPSAMPLER_H
+#define GOSOUNDUPSAMPLER_H
+
+#include <vector>
+
+/**
+ * Converts an interleaving multichannel stream to a sample rate that is an
+ * integer multiple of the source one.
+ * It uses a polyphase Kaiser windowed sinc interpolation filter with the cutoff
+ * at the source Nyquist frequency. The passband is flat within 0.001 dB up to
+ * 5/6 of the source Nyquist frequency (20 kHz at 48 kHz), and the images of it
+ * are at least 120 dB down. The band between is the transition band of the
+ * filter.
+ */
+class GOSoundUpsampler {
+public:
+  // the number of source frames used for calculating of one target frame
+  static constexpr unsigned TAPS_PER_PHASE = 64;
+
+private:
+  unsigned m_Factor;
+  unsigned m_Channels;
+  /* m_Factor phases of TAPS_PER_PHASE coefficients. The coefficients of each
+   * phase are in the reverse order, so they are multiplied to the history in
+   * the time order */
+  std::vector<float> m_Coefs;
+  /* The last TAPS_PER_PHASE source frames of each channel. It is a ring buffer
+   * of the double length, so the last frames are always continous */
+  std::vector<float> m_History;
+  unsigned m_HistoryPos;
+
+public:
+  /**
+   * @param factor the ratio of the target sample rate to the source one
+   * @param channels the number of channels
+   */
+  GOSoundUpsampler(unsigned factor, unsigned channels);
+
+  unsigned GetFactor() const { return m_Factor; }
+
+  /**
+   * Clears the history, so the next output starts from silence
+   */
+  void Reset();
+
+  /**
+   * Converts a block
+   * @param pIn the source frames
+   * @param nInFrames the number of source frames
+   * @param pOut the buffer for nInFrames * factor target frames
+   */
+  void Process(const float *pIn, unsigned nInFrames, float *pOut);
+};
+
+#endif /* GOSOUNDUPSAMPLER_H */
@@ -0,0 +1,59 @@
+/*
+ * Copyright 2026 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#ifndef GOSOUNDBACKOFF_H
+#define GOSOUNDBACKOFF_H
+
+#include <thread>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#endif
+
+/**
+ * A bounded backoff for waiting for other sound threads without blocking in
+ * the OS, so the audio callback may use it.
+ * Each Pause() first spins on the CPU twice as long as the previous one, then
+ * it yields the CPU to other threads. After MAX_PAUSES pauses Pause() returns
+ * false: a sound thread may sleep then, and the audio callback continues
+ * yielding
+ */
+class GOSoundBackoff {
+private:
+  // the last pause spinning on the CPU spins 2^(SPIN_PAUSES - 1) times
+  static constexpr unsigned SPIN_PAUSES = 7;
+  static constexpr unsigned MAX_PAUSES = SPIN_PAUSES + 32;
+
+  unsigned m_PauseCount = 0;
+
+  static void Relax() {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    _mm_pause();
+#elif defined(__GNUC__) && (defined(__aarch64__) || defined(__arm__))
+    __asm__ __volatile__("yield");
+#endif
+  }
+
+public:
+  void Reset() { m_PauseCount = 0; }
+
+  /**
+   * Waits a little
+   * @return false if the backoff has reached its bound
+   */
+  bool Pause() {
+    if (m_PauseCount < SPIN_PAUSES)
+      for (unsigned i = 0; i < 1u << m_PauseCount; i++)
+        Relax();
+    else
+      std::this_thread::yield();
+    if (m_PauseCount < MAX_PAUSES)
+      m_PauseCount++;
+    return m_PauseCount < MAX_PAUSES;
+  }
+};
+
+#endif /* GOSOUNDBACKOFF_H */
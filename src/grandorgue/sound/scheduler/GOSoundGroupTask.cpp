@@ -1,35 +1,113 @@
 /*
  * Copyright 2006 Milan Digital Audio LLC
- * Copyright 2009-2024 GrandOrgue contributors (see AUTHORS)
+ * Copyright 2009-2026 GrandOrgue contributors (see AUTHORS)
  * License GPL-2.0 or later
  * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
  */
 
 #include "GOSoundGroupTask.h"
 
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include "GOSoundBackoff.h"
 #include "GOSoundWindchestTask.h"
 #include "sound/GOSoundEngine.h"
+#include "sound/GOSoundProvider.h"
 #include "threading/GOMutexLocker.h"
 
+static inline uint64_t make_ticket(uint32_t generation, unsigned index) {
+  return ((uint64_t)generation << 32) | index;
+}
+
+static inline uint32_t ticket_generation(uint64_t ticket) {
+  return (uint32_t)(ticket >> 32);
+}
+
+/**
+ * Takes the next index from the ticket if it belongs to the generation and the
+ * index is less than the limit
+ */
+static bool claim_ticket(
+  std::atomic_uint64_t &ticket,
+  uint32_t generation,
+  unsigned limit,
+  unsigned &index) {
+  uint64_t value = ticket.load();
+
+  do {
+    if (ticket_generation(value) != generation || (uint32_t)value >= limit)
+      return false;
+  } while (!ticket.compare_exchange_weak(value, value + 1));
+  index = (uint32_t)value;
+  return true;
+}
+
+/**
+ * The order of the voices that does not depend on the threads
+ */
+static bool is_voice_before(const GOSoundSampler *a, const GOSoundSampler *b) {
+  return a->sequence != b->sequence ? a->sequence < b->sequence
+                                    : a->time < b->time;
+}
+
+static constexpr uint32_t NO_BUS_KEY = UINT32_MAX;
+
+/**
+ * The voices with the same windchest task and tone balance share a bus
+ */
+static uint32_t bus_key(const GOSoundSampler *sampler) {
+  return sampler->p_WindchestTask && sampler->p_SoundProvider
+    ? ((uint32_t)sampler->m_SamplerTaskId << 8)
+      | (uint8_t)sampler->p_SoundProvider->GetToneBalance()->GetValue()
+    : NO_BUS_KEY;
+}
+
 GOSoundGroupTask::GOSoundGroupTask(
-  GOSoundEngine &sound_engine, unsigned samples_per_buffer)
+  GOSoundEngine &sound_engine,
+  unsigned samples_per_buffer,
+  unsigned concurrency)
   : GOSoundBufferItem(samples_per_buffer, 2),
     m_engine(sound_engine),
-    m_Condition(m_Mutex),
-    m_ActiveCount(0),
+    m_ReleaseStart(0),
+    m_ChunkCount(0),
+    m_NextChunk(0),
+    m_NextSlot(0),
+    // one more slot for the audio callback thread
+    m_SlotCount(concurrency + 1),
+    m_SlotBuffers(concurrency * samples_per_buffer * 2),
+    m_BusBuffers((concurrency + 1) * samples_per_buffer * 2),
+    m_SlotChunks(m_SlotCount),
+    m_WaitingSlot(-1),
+    m_IsDeterministic(false),
+    m_UsedSlotCount(0),
+    m_FinishedSlots(0),
     m_Done(0),
-    m_Stop(false) {}
+    m_Stop(false) {
+  ReserveVoices(m_engine.GetHardPolyphony());
+}
 
 void GOSoundGroupTask::Reset() {
-  GOMutexLocker locker(m_Mutex);
-  m_Done.store(0);
-  m_ActiveCount.store(0);
+  GOSoundBackoff backoff;
+  unsigned state = m_Done.load();
+
+  // a control thread may be changing the voices. It is short, so spin
+  while (state == 4 || !m_Done.compare_exchange_weak(state, 0))
+    if (state == 4) {
+      backoff.Pause();
+      state = m_Done.load();
+    }
   m_Stop.store(false);
 }
 
 void GOSoundGroupTask::Clear() {
   m_Active.Clear();
   m_Release.Clear();
+  for (Bus &bus : m_Buses)
+    ResetBus(bus);
 }
 
 void GOSoundGroupTask::Add(GOSoundSampler *sampler) {
@@ -39,13 +117,212 @@ void GOSoundGroupTask::Add(GOSoundSampler *sampler) {
     m_Active.Put(sampler);
 }
 
-void GOSoundGroupTask::ProcessList(
-  GOSoundSamplerList &list, bool toDropOld, float *output_buffer) {
-  GOSoundSampler *sampler;
+unsigned GOSoundGroupTask::GetGroup() { return AUDIOGROUP; }
+
+unsigned GOSoundGroupTask::GetCost() {
+  return m_Active.GetCount() + m_Release.GetCount();
+}
+
+bool GOSoundGroupTask::GetRepeat() { return true; }
+
+void GOSoundGroupTask::ResetBus(Bus &bus) {
+  bus.m_FilterState.Init(nullptr);
+  bus.m_LastVolume = -1;
+}
+
+GOSoundGroupTask::Bus *GOSoundGroupTask::FindBus(
+  const GOSoundSampler *sampler) {
+  // the sampler task id of a windchest is the windchest task index
+  const unsigned first
+    = (unsigned)sampler->m_SamplerTaskId * BUSES_PER_WINDCHEST;
+  const int8_t toneBalance
+    = sampler->p_SoundProvider->GetToneBalance()->GetValue();
+  Bus *pFree = nullptr;
+
+  if (first >= m_Buses.size())
+    return nullptr;
+  for (unsigned i = first; i < first + BUSES_PER_WINDCHEST; i++) {
+    Bus &bus = m_Buses[i];
+
+    if (bus.m_LastVolume >= 0) {
+      if (bus.m_ToneBalance == toneBalance)
+        return &bus;
+    } else if (!pFree)
+      pFree = &bus;
+  }
+  if (pFree)
+    pFree->m_ToneBalance = toneBalance;
+  return pFree;
+}
+
+void GOSoundGroupTask::AddChunks(unsigned begin, unsigned end) {
+  for (unsigned i = begin; i < end; i += VOICE_CHUNK_SIZE)
+    m_Chunks.push_back(
+      {i, std::min(i + VOICE_CHUNK_SIZE, end), nullptr, {}});
+}
+
+void GOSoundGroupTask::AddBusChunks(unsigned begin, unsigned end) {
+  // the voices are sorted by the bus key
+  while (begin < end) {
+    const uint32_t key = bus_key(m_Voices[begin]);
+    unsigned runEnd = begin + 1;
+
+    while (runEnd < end && bus_key(m_Voices[runEnd]) == key)
+      runEnd++;
+    Bus *pBus = key != NO_BUS_KEY ? FindBus(m_Voices[begin]) : nullptr;
+
+    if (!pBus) {
+      AddChunks(begin, runEnd);
+      begin = runEnd;
+      continue;
+    }
+
+    Bus &bus = *pBus;
+    bool isFirst = !bus.m_IsUsed;
+
+    if (isFirst) {
+      const GOSoundSampler *sampler = m_Voices[begin];
+      GOSoundWindchestTask *windchest = sampler->p_WindchestTask;
+      const float volume = windchest->GetVolume();
+
+      // ramp from the last windchest volume like GOSoundFader does
+      bus.m_IsUsed = true;
+      bus.p_Filter = sampler->p_SoundProvider->GetToneBalance()->GetFilter();
+      bus.p_Envelope = windchest->GetEnvelope();
+      bus.m_Volume = bus.m_LastVolume < 0 ? volume : bus.m_LastVolume;
+      bus.m_VolumeDelta = (volume - bus.m_Volume) / m_SamplesPerBuffer;
+      bus.m_LastVolume = volume;
+    }
+    for (unsigned i = begin; i < runEnd; i += VOICE_CHUNK_SIZE) {
+      Chunk chunk = {i, std::min(i + VOICE_CHUNK_SIZE, runEnd), &bus, {}};
+
+      chunk.m_FilterState.Init(bus.p_Filter);
+      if (isFirst)
+        chunk.m_FilterState.Add(bus.m_FilterState);
+      isFirst = false;
+      m_Chunks.push_back(chunk);
+    }
+    begin = runEnd;
+  }
+}
+
+void GOSoundGroupTask::StartPeriod() {
+  const uint32_t generation = ticket_generation(m_NextChunk.load()) + 1;
+  [[maybe_unused]] const size_t voiceCapacity = m_Voices.capacity();
+  [[maybe_unused]] const size_t chunkCapacity = m_Chunks.capacity();
+
+  m_Active.Move();
+  m_Release.Move();
+  m_Voices.clear();
+  for (GOSoundSampler *sampler = m_Active.TakeAll(); sampler;
+       sampler = sampler->next)
+    m_Voices.push_back(sampler);
+  m_ReleaseStart = m_Voices.size();
+  for (GOSoundSampler *sampler = m_Release.TakeAll(); sampler;
+       sampler = sampler->next)
+    m_Voices.push_back(sampler);
+  m_IsDeterministic = m_engine.IsDeterministic();
+  m_Chunks.clear();
+  if (m_engine.IsSubmixBuses()) {
+    /* group the voices by bus. In the deterministic mode also order them
+     * within a bus, as the threads return the voices to the lists in any
+     * order */
+    auto isBefore = [this](const GOSoundSampler *a, const GOSoundSampler *b) {
+      const uint32_t keyA = bus_key(a);
+      const uint32_t keyB = bus_key(b);
+
+      return keyA != keyB ? keyA < keyB
+                          : m_IsDeterministic && is_voice_before(a, b);
+    };
+
+    std::sort(m_Voices.begin(), m_Voices.begin() + m_ReleaseStart, isBefore);
+    std::sort(m_Voices.begin() + m_ReleaseStart, m_Voices.end(), isBefore);
+    for (Bus &bus : m_Buses)
+      bus.m_IsUsed = false;
+    AddBusChunks(0, m_ReleaseStart);
+    AddBusChunks(m_ReleaseStart, m_Voices.size());
+    for (Bus &bus : m_Buses)
+      if (!bus.m_IsUsed)
+        // no voices: the bus starts again from silence and becomes free
+        ResetBus(bus);
+  } else {
+    if (m_IsDeterministic) {
+      // the threads return the voices to the lists in any order
+      std::sort(
+        m_Voices.begin(), m_Voices.begin() + m_ReleaseStart, is_voice_before);
+      std::sort(
+        m_Voices.begin() + m_ReleaseStart, m_Voices.end(), is_voice_before);
+    }
+    AddChunks(0, m_Voices.size());
+  }
+  m_ChunkCount = m_Chunks.size();
+  // ReserveVoices() must have been called for the hard polyphony
+  assert(m_Voices.capacity() == voiceCapacity);
+  assert(m_Chunks.capacity() == chunkCapacity);
+  if (m_IsDeterministic) {
+    m_UsedSlotCount = std::min(m_SlotCount, m_ChunkCount);
+    m_FinishedSlots.store(0);
+  }
+  m_WaitingSlot.store(-1);
+  m_NextSlot.store(make_ticket(generation, 0));
+  // publishes the voices to the threads
+  m_NextChunk.store(make_ticket(generation, 0));
+  if (m_ChunkCount)
+    m_Done.store(1);
+  else {
+    std::fill(m_Buffer, m_Buffer + m_SamplesPerBuffer * 2, 0.0f);
+    m_Done.store(2);
+  }
+}
+
+void GOSoundGroupTask::MixBus(
+  Chunk &chunk, const float *pBusBuffer, float *output_buffer) {
+  const Bus &bus = *chunk.p_Bus;
+  const float *pEnvelope = bus.p_Envelope;
+  float volume = bus.m_Volume;
+
+  if (chunk.m_FilterState.IsToApply()) {
+    GOSoundFilter::FilterState::Runner filter(chunk.m_FilterState);
+
+    for (unsigned i = 0; i < m_SamplesPerBuffer;
+         i++, pBusBuffer += 2, output_buffer += 2) {
+      const float gain = pEnvelope ? volume * pEnvelope[i] : volume;
+      float left = pBusBuffer[0] * gain;
+      float right = pBusBuffer[1] * gain;
+
+      filter.ProcessFrame(left, right);
+      output_buffer[0] += left;
+      output_buffer[1] += right;
+      volume += bus.m_VolumeDelta;
+    }
+  } else {
+    for (unsigned i = 0; i < m_SamplesPerBuffer;
+         i++, pBusBuffer += 2, output_buffer += 2) {
+      const float gain = pEnvelope ? volume * pEnvelope[i] : volume;
+
+      output_buffer[0] += pBusBuffer[0] * gain;
+      output_buffer[1] += pBusBuffer[1] * gain;
+      volume += bus.m_VolumeDelta;
+    }
+  }
+}
+
+void GOSoundGroupTask::RenderChunk(
+  unsigned chunkIndex, float *output_buffer, float *pBusBuffer) {
+  Chunk &chunk = m_Chunks[chunkIndex];
+  // the voices to keep are returned to the lists once per chunk
+  GOSoundSampler *kept[2] = {nullptr, nullptr};
+  GOSoundSampler *keptLast[2] = {nullptr, nullptr};
+  unsigned keptCount[2] = {0, 0};
+
+  if (chunk.p_Bus)
+    std::fill(pBusBuffer, pBusBuffer + m_SamplesPerBuffer * 2, 0.0f);
+  for (unsigned i = chunk.m_Begin; i < chunk.m_End; i++) {
+    GOSoundSampler *const sampler = m_Voices[i];
 
-  while ((sampler = list.Get())) {
     if (
-      toDropOld && m_Stop.load() && sampler->time + 2000 < m_engine.GetTime()) {
+      i >= m_ReleaseStart && m_Stop.load()
+      && sampler->time + 2000 < m_engine.GetTime()) {
       if (sampler->drop_counter++ > 3) {
         m_engine.ReturnSampler(sampler);
         continue;
@@ -54,107 +331,201 @@ void GOSoundGroupTask::ProcessList(
     sampler->drop_counter = 0;
 
     GOSoundWindchestTask *const windchest = sampler->p_WindchestTask;
+    // the windchest gain and the filter of a bus are applied in MixBus
+    const bool isKept = chunk.p_Bus
+      ? m_engine.ProcessSampler(
+        pBusBuffer, sampler, m_SamplesPerBuffer, 1.0f, nullptr, false)
+      : windchest
+        && m_engine.ProcessSampler(
+          output_buffer,
+          sampler,
+          m_SamplesPerBuffer,
+          windchest->GetVolume(),
+          windchest->GetEnvelope());
 
-    if (
-      windchest
-      && m_engine.ProcessSampler(
-        output_buffer, sampler, m_SamplesPerBuffer, windchest->GetVolume()))
-      Add(sampler);
+    if (isKept) {
+      const unsigned list = sampler->is_release ? 1 : 0;
+
+      sampler->next = kept[list];
+      kept[list] = sampler;
+      if (!keptLast[list])
+        keptLast[list] = sampler;
+      keptCount[list]++;
+    }
   }
+  if (kept[0])
+    m_Active.PutChain(kept[0], keptLast[0], keptCount[0]);
+  if (kept[1])
+    m_Release.PutChain(kept[1], keptLast[1], keptCount[1]);
+  if (chunk.p_Bus)
+    MixBus(chunk, pBusBuffer, output_buffer);
 }
 
-unsigned GOSoundGroupTask::GetGroup() { return AUDIOGROUP; }
-
-unsigned GOSoundGroupTask::GetCost() {
-  return m_Active.GetCount() + m_Release.GetCount();
+void GOSoundGroupTask::FinishBuses() {
+  // the filter state of a bus is the sum of the states of its chunks
+  for (Bus &bus : m_Buses)
+    if (bus.m_IsUsed)
+      bus.m_FilterState.Init(bus.p_Filter);
+  for (const Chunk &chunk : m_Chunks)
+    if (chunk.p_Bus)
+      chunk.p_Bus->m_FilterState.Add(chunk.m_FilterState);
 }
 
-bool GOSoundGroupTask::GetRepeat() { return true; }
+void GOSoundGroupTask::MergeSlot(unsigned slot) {
+  unsigned nChunks = m_SlotChunks[slot];
 
-void GOSoundGroupTask::Run(GOSoundThread *pThread) {
-  if (m_Done.load() == 3) // has already processed in this period
-    return;
-  {
-    GOMutexLocker locker(
-      m_Mutex, false, "GOSoundGroupTask::Run.beforeProcess", pThread);
-
-    if (!locker.IsLocked())
-      return;
-
-    if (m_Done.load() == 0) // the first thread entered to Run()
-    {
-      m_Active.Move();
-      m_Release.Move();
-      m_Done.store(1); // there are some thteads in Run()
-    } else {
-      if (!m_Active.Peek() && !m_Release.Peek())
-        return;
+  // sum the slots pairwise as the threads finish, like a reduction tree
+  while (nChunks < m_ChunkCount) {
+    int other = -1;
+
+    if (m_WaitingSlot.compare_exchange_strong(other, (int)slot))
+      return; // the thread finishing later will sum this slot
+    if (other >= 0 && m_WaitingSlot.compare_exchange_strong(other, -1)) {
+      // keep the lower slot, so the sum usually ends in m_Buffer
+      const unsigned dst = std::min(slot, (unsigned)other);
+      const float *src = GetSlotBuffer(std::max(slot, (unsigned)other));
+      float *pDst = GetSlotBuffer(dst);
+
+      for (unsigned i = 0; i < m_SamplesPerBuffer * 2; i++)
+        pDst[i] += src[i];
+      nChunks += m_SlotChunks[other];
+      m_SlotChunks[dst] = nChunks;
+      slot = dst;
     }
-    m_ActiveCount.fetch_add(1);
   }
 
-  // several threads may process the same list in parallel helping each other
-  // at first, they fill their's own buffer instances
-  float buffer[m_SamplesPerBuffer * 2];
-
-  memset(buffer, 0, m_SamplesPerBuffer * 2 * sizeof(float));
-  ProcessList(m_Active, false, buffer);
-  ProcessList(m_Release, true, buffer);
-
-  {
-    GOMutexLocker locker(
-      m_Mutex, false, "GOSoundGroupTask::Run.afterProcess", pThread);
-
-    if (locker.IsLocked()) {
-      if (m_Done.load() == 1)
-      // The first thread is finished. Assign the result to the common buffer
-      {
-        memcpy(m_Buffer, buffer, m_SamplesPerBuffer * 2 * sizeof(float));
-        m_Done.store(2); // some thread has already finished
-      } else
-      // not the first thread. Add the result to the common buffer
-      {
-        for (unsigned i = 0; i < m_SamplesPerBuffer * 2; i++)
-          m_Buffer[i] += buffer[i];
+  // this slot contains all chunks
+  if (slot)
+    memcpy(
+      m_Buffer, GetSlotBuffer(slot), m_SamplesPerBuffer * 2 * sizeof(float));
+  FinishBuses();
+  m_Done.store(2);
+}
+
+void GOSoundGroupTask::RenderChunks() {
+  const uint32_t generation = ticket_generation(m_NextChunk.load());
+  unsigned slot;
+  unsigned chunk;
+
+  if (
+    !claim_ticket(m_NextSlot, generation, m_SlotCount, slot)
+    || !claim_ticket(m_NextChunk, generation, m_ChunkCount, chunk))
+    return;
+
+  // several threads render the chunks in parallel, each to its own slot
+  float *buffer = GetSlotBuffer(slot);
+  unsigned nChunks = 0;
+
+  std::fill(buffer, buffer + m_SamplesPerBuffer * 2, 0.0f);
+  do {
+    RenderChunk(chunk, buffer, GetBusBuffer(slot));
+    nChunks++;
+  } while (claim_ticket(m_NextChunk, generation, m_ChunkCount, chunk));
+  m_SlotChunks[slot] = nChunks;
+  MergeSlot(slot);
+}
+
+void GOSoundGroupTask::RenderSlots() {
+  const uint32_t generation = ticket_generation(m_NextChunk.load());
+  unsigned slot;
+
+  while (claim_ticket(m_NextSlot, generation, m_UsedSlotCount, slot)) {
+    float *buffer = GetSlotBuffer(slot);
+
+    std::fill(buffer, buffer + m_SamplesPerBuffer * 2, 0.0f);
+    for (unsigned chunk = slot; chunk < m_ChunkCount; chunk += m_UsedSlotCount)
+      RenderChunk(chunk, buffer, GetBusBuffer(slot));
+    if (m_FinishedSlots.fetch_add(1) + 1 == m_UsedSlotCount) {
+      // the last finished thread sums the slots in the fixed order
+      for (unsigned i = 1; i < m_UsedSlotCount; i++) {
+        const float *src = GetSlotBuffer(i);
+
+        for (unsigned j = 0; j < m_SamplesPerBuffer * 2; j++)
+          m_Buffer[j] += src[j];
       }
-    }
-    if (m_ActiveCount.fetch_sub(1) <= 1) {
-      // the last thread
-      m_Done.store(3); // all threads have finished processing this period
-      m_Condition.Broadcast();
+      FinishBuses();
+      m_Done.store(2);
     }
   }
 }
 
+void GOSoundGroupTask::Run(GOSoundThread *pThread) {
+  unsigned state = 0;
+
+  // the first thread entered to Run() starts the period
+  if (m_Done.compare_exchange_strong(state, 3)) {
+    StartPeriod();
+    state = m_Done.load();
+  }
+  if (state == 1) {
+    if (m_IsDeterministic)
+      RenderSlots();
+    else
+      RenderChunks();
+  }
+}
+
 void GOSoundGroupTask::Exec() {
-  m_Stop.store(true);
-  Run();
+  // the voices must not be rendered any more when the next period starts
+  Finish(true);
 }
 
 void GOSoundGroupTask::Finish(bool stop, GOSoundThread *pThread) {
+  GOSoundBackoff backoff;
+
   if (stop)
     m_Stop.store(true);
   Run(pThread);
-  if (m_Done.load() == 3)
-    return;
+  /* Wait for the threads rendering the last chunks. The audio callback calls
+   * it, so it spins and yields instead of sleeping */
+  while (m_Done.load() != 2 && (pThread == nullptr || !pThread->ShouldStop()))
+    if (m_Done.load() == 0)
+      // a control thread has kept the period from starting
+      Run(pThread);
+    else
+      backoff.Pause();
+}
 
-  {
-    GOMutexLocker locker(m_Mutex, false, "GOSoundGroupTask::Finish", pThread);
+unsigned GOSoundGroupTask::LockPeriod() {
+  GOSoundBackoff backoff;
+  unsigned state = m_Done.load();
 
-    while (locker.IsLocked() && m_Done.load() != 3
-           && (pThread == nullptr || !pThread->ShouldStop()))
-      m_Condition.WaitOrStop("GOSoundGroupTask::Finish", pThread);
-  }
+  // the threads rendering the period access the vectors without m_Mutex
+  do {
+    while (state == 1 || state == 3) {
+      if (!backoff.Pause())
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+      state = m_Done.load();
+    }
+  } while (!m_Done.compare_exchange_weak(state, 4));
+  return state;
 }
 
 void GOSoundGroupTask::WaitAndClear() {
   GOMutexLocker locker(m_Mutex, false, "ClearAndWait::WaitAndClear");
+  const unsigned state = LockPeriod();
 
-  // wait for no threads are inside Run()
-  while (m_Done.load() > 0 && m_Done.load() < 3)
-    m_Condition.WaitOrStop("ClearAndWait::ClearAndWait", NULL);
-
-  // Now it is safe to clear because m_Mutex is locked and no other threads can
-  // enter in Run()
+  // Now it is safe to clear because no other threads can start a period
   Clear();
+  UnlockPeriod(state);
+}
+
+void GOSoundGroupTask::ReserveVoices(unsigned count) {
+  GOMutexLocker locker(m_Mutex, false, "GOSoundGroupTask::ReserveVoices");
+  const unsigned state = LockPeriod();
+
+  /* A group never has more voices than the sampler pool has ever allocated.
+   * The pool does not free the samplers when its limit is lowered, so the
+   * vectors never shrink. Each chunk has at least one voice */
+  m_Voices.reserve(count);
+  m_Chunks.reserve(count);
+  UnlockPeriod(state);
+}
+
+void GOSoundGroupTask::SetupBuses(unsigned windchestTaskCount) {
+  GOMutexLocker locker(m_Mutex, false, "GOSoundGroupTask::SetupBuses");
+  const unsigned state = LockPeriod();
+
+  m_Buses.assign(windchestTaskCount * BUSES_PER_WINDCHEST, Bus());
+  UnlockPeriod(state);
 }
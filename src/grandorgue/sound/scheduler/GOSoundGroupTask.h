@@ -1,6 +1,6 @@
 /*
  * Copyright 2006 Milan Digital Audio LLC
- * Copyright 2009-2024 GrandOrgue contributors (see AUTHORS)
+ * Copyright 2009-2026 GrandOrgue contributors (see AUTHORS)
  * License GPL-2.0 or later
  * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
  */
@@ -9,40 +9,145 @@
 #define GOSOUNDGROUPTASK_H
 
 #include <atomic>
+#include <cstdint>
+#include <vector>
 
 #include "GOSoundThread.h"
 #include "sound/GOSoundBufferItem.h"
+#include "sound/GOSoundFilter.h"
 #include "sound/GOSoundSamplerList.h"
 #include "sound/scheduler/GOSoundTask.h"
-#include "threading/GOCondition.h"
 #include "threading/GOMutex.h"
 
 class GOSoundEngine;
+class GOSoundWindchestTask;
 
 class GOSoundGroupTask : public GOSoundTask, public GOSoundBufferItem {
 private:
+  // the number of voices rendered by a thread at once
+  static constexpr unsigned VOICE_CHUNK_SIZE = 8;
+  /* The number of different tone balance values of a windchest that have
+   * their own buses. The voices of other values are mixed directly */
+  static constexpr unsigned BUSES_PER_WINDCHEST = 8;
+  /* The voices of the same windchest and tone balance are summed before the
+   * windchest gain, the tremulants and the filter are applied to the sum */
+  struct Bus {
+    GOSoundFilter::FilterState m_FilterState;
+    // the windchest volume at the end of the last period or -1 if the bus
+    // is free
+    float m_LastVolume = -1;
+    int8_t m_ToneBalance = 0;
+    // the state of the current period
+    bool m_IsUsed = false;
+    const GOSoundFilter *p_Filter = nullptr;
+    float m_Volume = 0;
+    float m_VolumeDelta = 0;
+    const float *p_Envelope = nullptr;
+  };
+
+  struct Chunk {
+    unsigned m_Begin;
+    unsigned m_End;
+    // nullptr if the voices are mixed directly
+    Bus *p_Bus;
+    /* The filter state of the bus after this chunk. Only the first chunk of a
+     * bus starts from the bus state, the others start from silence */
+    GOSoundFilter::FilterState m_FilterState;
+  };
+
   GOSoundEngine &m_engine;
   GOSoundSamplerList m_Active;
   GOSoundSamplerList m_Release;
+  // serializes the control threads changing the voices
   GOMutex m_Mutex;
-  GOCondition m_Condition;
 
-  // the number of threads are processing the samples
-  std::atomic_uint m_ActiveCount;
+  /* The voices of the current period. The voices since m_ReleaseStart are
+   * taken from m_Release. The threads render them by chunks of
+   * VOICE_CHUNK_SIZE voices. Both vectors are reserved for the hard polyphony
+   * with ReserveVoices() */
+  std::vector<GOSoundSampler *> m_Voices;
+  unsigned m_ReleaseStart;
+  std::vector<Chunk> m_Chunks;
+  unsigned m_ChunkCount;
+  /* BUSES_PER_WINDCHEST buses for each windchest task. It is allocated by
+   * SetupBuses(), so the audio threads only look the buses up */
+  std::vector<Bus> m_Buses;
+  // (generation << 32) | the index of the next chunk to render
+  std::atomic_uint64_t m_NextChunk;
+  // (generation << 32) | the index of the next free accumulator slot
+  std::atomic_uint64_t m_NextSlot;
+
+  /* Each thread rendering the chunks accumulates them in its own slot. The
+   * slot 0 is m_Buffer, the other slots are in m_SlotBuffers */
+  unsigned m_SlotCount;
+  std::vector<float> m_SlotBuffers;
+  // each slot sums the voices of a bus chunk in its own buffer
+  std::vector<float> m_BusBuffers;
+  // the number of chunks accumulated in each slot
+  std::vector<unsigned> m_SlotChunks;
+  // a slot waiting for being summed with another one or -1
+  std::atomic_int m_WaitingSlot;
+  /* In the deterministic mode each slot renders the fixed chunks and the slots
+   * are summed in their order when all of them are ready */
+  bool m_IsDeterministic;
+  unsigned m_UsedSlotCount;
+  std::atomic_uint m_FinishedSlots;
 
   // processing state
-  //   0 - no threads are processing the samples
-  //   1 - some threads are processing the samples and none has finished
-  //   2 - some thread has finished processing samples but not all
-  //   3 - all threads have finished processing samples
+  //   0 - the period has not started yet
+  //   1 - the threads are rendering the chunks
+  //   2 - all chunks have been rendered and summed in m_Buffer
+  //   3 - a thread is starting the period
+  //   4 - a control thread is changing the voices, see LockPeriod()
   std::atomic_uint m_Done;
   std::atomic_bool m_Stop;
 
-  void ProcessList(
-    GOSoundSamplerList &list, bool toDropOld, float *output_buffer);
+  float *GetSlotBuffer(unsigned slot) {
+    return slot ? &m_SlotBuffers[(slot - 1) * m_SamplesPerBuffer * 2]
+                : m_Buffer;
+  }
+
+  float *GetBusBuffer(unsigned slot) {
+    return &m_BusBuffers[slot * m_SamplesPerBuffer * 2];
+  }
+
+  void ResetBus(Bus &bus);
+  /* Returns the bus of the windchest and the tone balance of the sampler.
+   * Assigns a free bus if there is no one. Returns nullptr if all buses of the
+   * windchest are used by other tone balance values */
+  Bus *FindBus(const GOSoundSampler *sampler);
+  void AddChunks(unsigned begin, unsigned end);
+  void AddBusChunks(unsigned begin, unsigned end);
+  void StartPeriod();
+  void MixBus(Chunk &chunk, const float *pBusBuffer, float *output_buffer);
+  /* Renders the voices of the chunk to output_buffer or, if the chunk has a
+   * bus, to pBusBuffer and then mixes the bus to output_buffer */
+  void RenderChunk(
+    unsigned chunkIndex, float *output_buffer, float *pBusBuffer);
+  void FinishBuses();
+  void RenderChunks();
+  void RenderSlots();
+  void MergeSlot(unsigned slot);
+  /**
+   * Waits until no thread is rendering the period and keeps them from
+   * starting it. Must be called with m_Mutex locked and not from the audio
+   * threads
+   * @return the state to restore with UnlockPeriod()
+   */
+  unsigned LockPeriod();
+  void UnlockPeriod(unsigned state) { m_Done.store(state); }
 
 public:
-  GOSoundGroupTask(GOSoundEngine &sound_engine, unsigned samples_per_buffer);
+  /**
+   * @param sound_engine the engine
+   * @param samples_per_buffer the number of frames in a period
+   * @param concurrency the maximum number of threads rendering the group in
+   *   parallel
+   */
+  GOSoundGroupTask(
+    GOSoundEngine &sound_engine,
+    unsigned samples_per_buffer,
+    unsigned concurrency = 1);
 
   unsigned GetGroup();
   unsigned GetCost();
@@ -55,6 +160,18 @@ public:
   void Clear();
   void Add(GOSoundSampler *sampler);
   void WaitAndClear();
+  /**
+   * Reserves the voice arrays for up to count voices, so StartPeriod() never
+   * allocates. Waits until the current period has been rendered. Must not be
+   * called from the audio threads
+   */
+  void ReserveVoices(unsigned count);
+  /**
+   * Allocates the buses for windchestTaskCount windchest tasks. Waits until
+   * the current period has been rendered. Must not be called from the audio
+   * threads
+   */
+  void SetupBuses(unsigned windchestTaskCount);
 };
 
 #endif
@@ -1,27 +1,34 @@
 /*
  * Copyright 2006 Milan Digital Audio LLC
- * Copyright 2009-2024 GrandOrgue contributors (see AUTHORS)
+ * Copyright 2009-2026 GrandOrgue contributors (see AUTHORS)
  * License GPL-2.0 or later
  * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
  */
 
 #include "GOSoundOutputTask.h"
 
+#include "GOSoundBackoff.h"
 #include "GOSoundThread.h"
 #include "sound/GOSoundReverb.h"
-#include "threading/GOMutexLocker.h"
 
 GOSoundOutputTask::GOSoundOutputTask(
   unsigned channels,
   std::vector<float> scale_factors,
-  unsigned samples_per_buffer)
+  unsigned samples_per_buffer,
+  unsigned upsample_factor)
   : GOSoundBufferItem(samples_per_buffer, channels),
     m_ScaleFactors(scale_factors),
     m_Outputs(),
     m_OutputCount(0),
     m_MeterInfo(channels),
     m_Reverb(0),
-    m_Done(false) {
+    m_RenderSamplesPerBuffer(samples_per_buffer / upsample_factor),
+    m_RenderBuffer(
+      upsample_factor > 1 ? m_RenderSamplesPerBuffer * channels : 0),
+    m_Upsampler(upsample_factor, channels),
+    m_Done(0),
+    m_Stop(false),
+    m_IsToResetMeters(false) {
   m_Reverb = new GOSoundReverb(m_Channels);
 }
 
@@ -36,15 +43,21 @@ void GOSoundOutputTask::SetOutputs(std::vector<GOSoundBufferItem *> outputs) {
 }
 
 void GOSoundOutputTask::Run(GOSoundThread *pThread) {
-  if (m_Done.load())
-    return;
-  GOMutexLocker locker(m_Mutex, false, "GOSoundOutputTask::Run", pThread);
+  unsigned state = 0;
 
-  if (m_Done.load() || !locker.IsLocked())
+  // only the first thread entered to Run() mixes the period
+  if (!m_Done.compare_exchange_strong(state, 1))
     return;
+  if (m_IsToResetMeters.exchange(false))
+    std::fill(m_MeterInfo.begin(), m_MeterInfo.end(), 0.0f);
+
+  /* Mix the groups at the render sample rate. Without upsampling it is the
+   * output buffer itself */
+  const bool isToUpsample = m_Upsampler.GetFactor() > 1;
+  float *const mixBuffer = isToUpsample ? m_RenderBuffer.data() : m_Buffer;
 
-  /* initialise the output buffer */
-  std::fill(m_Buffer, m_Buffer + m_SamplesPerBuffer * m_Channels, 0.0f);
+  /* initialise the mix buffer */
+  std::fill(mixBuffer, mixBuffer + m_RenderSamplesPerBuffer * m_Channels, 0.0f);
 
   for (unsigned i = 0; i < m_Channels; i++) {
     for (unsigned j = 0; j < m_OutputCount; j++) {
@@ -54,16 +67,23 @@ void GOSoundOutputTask::Run(GOSoundThread *pThread) {
 
       float *this_buff = m_Outputs[j / 2]->m_Buffer;
       m_Outputs[j / 2]->Finish(m_Stop.load(), pThread);
-      if (pThread && pThread->ShouldStop())
+      if (pThread && pThread->ShouldStop()) {
+        // another thread may mix the period
+        m_Done.store(0);
         return;
+      }
 
-      for (unsigned k = i, l = j % 2; k < m_SamplesPerBuffer * m_Channels;
+      for (unsigned k = i, l = j % 2;
+           k < m_RenderSamplesPerBuffer * m_Channels;
            k += m_Channels, l += 2)
-        m_Buffer[k] += factor * this_buff[l];
+        mixBuffer[k] += factor * this_buff[l];
     }
   }
 
-  m_Reverb->Process(m_Buffer, m_SamplesPerBuffer);
+  m_Reverb->Process(mixBuffer, m_RenderSamplesPerBuffer);
+
+  if (isToUpsample)
+    m_Upsampler.Process(mixBuffer, m_RenderSamplesPerBuffer, m_Buffer);
 
   /* Clamp the output */
   const float CLAMP_MIN = -1.0f;
@@ -79,32 +99,37 @@ void GOSoundOutputTask::Run(GOSoundThread *pThread) {
       c = 0;
   }
 
-  m_Done.store(true);
+  m_Done.store(2);
 }
 
-void GOSoundOutputTask::Exec() { Run(); }
+void GOSoundOutputTask::Exec() { Finish(false); }
 
 void GOSoundOutputTask::Finish(bool stop, GOSoundThread *pThread) {
+  GOSoundBackoff backoff;
+
   if (stop)
     m_Stop.store(true);
-  if (!m_Done.load())
-    Run(pThread);
+  Run(pThread);
+  /* Wait for another thread mixing the period. The audio callback calls it, so
+   * it spins and yields instead of sleeping */
+  while (m_Done.load() != 2 && (pThread == nullptr || !pThread->ShouldStop()))
+    if (m_Done.load() == 0)
+      // the other thread has stopped
+      Run(pThread);
+    else
+      backoff.Pause();
 }
 
 void GOSoundOutputTask::Clear() {
   m_Reverb->Reset();
+  m_Upsampler.Reset();
   ResetMeterInfo();
 }
 
-void GOSoundOutputTask::ResetMeterInfo() {
-  GOMutexLocker locker(m_Mutex);
-  for (unsigned i = 0; i < m_MeterInfo.size(); i++)
-    m_MeterInfo[i] = 0;
-}
+void GOSoundOutputTask::ResetMeterInfo() { m_IsToResetMeters.store(true); }
 
 void GOSoundOutputTask::Reset() {
-  GOMutexLocker locker(m_Mutex);
-  m_Done.store(false);
+  m_Done.store(0);
   m_Stop.store(false);
 }
 
@@ -114,8 +139,9 @@ unsigned GOSoundOutputTask::GetCost() { return 0; }
 
 bool GOSoundOutputTask::GetRepeat() { return false; }
 
-void GOSoundOutputTask::SetupReverb(GOConfig &settings) {
-  m_Reverb->Setup(settings);
+void GOSoundOutputTask::SetupReverb(
+  GOConfig &settings, unsigned renderSampleRate) {
+  m_Reverb->Setup(settings, renderSampleRate, m_RenderSamplesPerBuffer);
 }
 
 const std::vector<float> &GOSoundOutputTask::GetMeterInfo() {
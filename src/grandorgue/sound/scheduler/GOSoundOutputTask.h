@@ -1,6 +1,6 @@
 /*
  * Copyright 2006 Milan Digital Audio LLC
- * Copyright 2009-2024 GrandOrgue contributors (see AUTHORS)
+ * Copyright 2009-2026 GrandOrgue contributors (see AUTHORS)
  * License GPL-2.0 or later
  * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
  */
@@ -12,8 +12,8 @@
 #include <vector>
 
 #include "sound/GOSoundBufferItem.h"
+#include "sound/GOSoundUpsampler.h"
 #include "sound/scheduler/GOSoundTask.h"
-#include "threading/GOMutex.h"
 
 class GOSoundReverb;
 class GOConfig;
@@ -25,15 +25,33 @@ private:
   unsigned m_OutputCount;
   std::vector<float> m_MeterInfo;
   GOSoundReverb *m_Reverb;
-  GOMutex m_Mutex;
-  std::atomic_bool m_Done;
+  // the number of frames rendered in one period before upsampling
+  unsigned m_RenderSamplesPerBuffer;
+  // the mix at the render sample rate. Used only when upsampling
+  std::vector<float> m_RenderBuffer;
+  GOSoundUpsampler m_Upsampler;
+  // processing state
+  //   0 - the period has not been mixed yet
+  //   1 - a thread is mixing the period
+  //   2 - the period has been mixed to m_Buffer
+  std::atomic_uint m_Done;
   std::atomic_bool m_Stop;
+  // the meters are reset by the thread mixing the next period
+  std::atomic_bool m_IsToResetMeters;
 
 public:
+  /**
+   * @param channels the number of output channels
+   * @param scale_factors the gains of the audio groups for each channel
+   * @param samples_per_buffer the number of output frames in one period
+   * @param upsample_factor the ratio of the output sample rate to the render
+   *   one. The outputs and the reverb run at the render sample rate
+   */
   GOSoundOutputTask(
     unsigned channels,
     std::vector<float> scale_factors,
-    unsigned samples_per_buffer);
+    unsigned samples_per_buffer,
+    unsigned upsample_factor = 1);
   ~GOSoundOutputTask();
 
   void SetOutputs(std::vector<GOSoundBufferItem *> outputs);
@@ -48,7 +66,7 @@ public:
   void Clear();
   void Reset();
 
-  void SetupReverb(GOConfig &settings);
+  void SetupReverb(GOConfig &settings, unsigned renderSampleRate);
 
   const std::vector<float> &GetMeterInfo();
   void ResetMeterInfo();
@@ -1,27 +1,134 @@
 /*
  * Copyright 2006 Milan Digital Audio LLC
- * Copyright 2009-2024 GrandOrgue contributors (see AUTHORS)
+ * Copyright 2009-2026 GrandOrgue contributors (see AUTHORS)
  * License GPL-2.0 or later
  * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
  */
 
 #include "GOSoundScheduler.h"
 
+#include <algorithm>
+#include <thread>
+#include <unordered_map>
+
+#include "sound/scheduler/GOSoundBackoff.h"
 #include "sound/scheduler/GOSoundTask.h"
+#include "sound/scheduler/GOSoundThread.h"
 #include "threading/GOMutexLocker.h"
 
+static inline uint64_t make_counter(uint32_t generation, uint32_t count) {
+  return ((uint64_t)generation << 32) | count;
+}
+
+static inline uint32_t counter_generation(uint64_t counter) {
+  return (uint32_t)(counter >> 32);
+}
+
+static inline uint32_t counter_value(uint64_t counter) {
+  return (uint32_t)counter;
+}
+
+/**
+ * Decrements the counter if it belongs to the generation
+ * @return true if the counter has reached zero with this call
+ */
+static bool decrement_counter(
+  std::atomic_uint64_t &counter, uint32_t generation) {
+  uint64_t value = counter.load();
+
+  do {
+    if (counter_generation(value) != generation || !counter_value(value))
+      return false;
+  } while (!counter.compare_exchange_weak(value, value - 1));
+  return counter_value(value) == 1;
+}
+
+static inline int64_t now_ticks() {
+  return std::chrono::steady_clock::now().time_since_epoch().count();
+}
+
+static inline std::chrono::microseconds time_since(int64_t ticks) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::duration(now_ticks() - ticks));
+}
+
+// a work item contains the node index and the generation of the period
+static inline uint64_t make_item(unsigned nodeIndex, uint32_t generation) {
+  return make_counter(generation, nodeIndex);
+}
+
 GOSoundScheduler::GOSoundScheduler()
   : m_Work(),
-    m_Tasks(),
+    m_Dependencies(),
+    m_IsGraphChanged(false),
+    m_Generation(0),
+    m_PendingBlocked(0),
+    m_PendingNodes(0),
+    m_PeriodStartTime(0),
+    m_PeriodWorkTime(0),
     m_IsNotGivingWork(false),
-    m_ItemCount(0),
-    m_RepeatCount(0) {}
+    m_IsLocked(false),
+    m_UserCount(0),
+    m_RepeatCount(0),
+    m_WorkSignal(0),
+    m_RunningCount(0),
+    m_WaitingCount(0),
+    m_WorkSemaphore(0) {}
 
 GOSoundScheduler::~GOSoundScheduler() {
   GOMutexLocker lock(m_Mutex);
   Lock();
 }
 
+void GOSoundScheduler::Lock() {
+  GOSoundBackoff backoff;
+
+  m_IsLocked.store(true);
+  // wait until no thread accesses m_Nodes and m_Queues. They leave quickly,
+  // but a preempted one may keep us waiting longer
+  while (m_UserCount.load())
+    if (!backoff.Pause())
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+}
+
+bool GOSoundScheduler::Enter() {
+  m_UserCount.fetch_add(1);
+  if (m_IsLocked.load()) {
+    Leave();
+    return false;
+  }
+  return true;
+}
+
+void GOSoundScheduler::NotifyWork() {
+  m_WorkSignal.fetch_add(1);
+  // a waiter increments m_WaitingCount before checking m_WorkSignal, so
+  // either it sees the new signal or we see it waiting
+  const unsigned nWaiting = m_WaitingCount.exchange(0);
+
+  if (nWaiting)
+    m_WorkSemaphore.release(nWaiting);
+}
+
+void GOSoundScheduler::WaitForWork(unsigned signal, GOSoundThread *pThread) {
+  m_WaitingCount.fetch_add(1);
+  if (m_WorkSignal.load() != signal || m_IsNotGivingWork.load()) {
+    unsigned nWaiting = m_WaitingCount.load();
+
+    // withdraw unless a notifier has already counted us
+    while (nWaiting
+           && !m_WaitingCount.compare_exchange_weak(nWaiting, nWaiting - 1))
+      ;
+    if (nWaiting)
+      return;
+    // the notifier has released the semaphore for us, so take it back
+  }
+  // a thread stopping while it is counted leaves one spurious wakeup
+  while (!m_WorkSemaphore.try_acquire_for(STOP_CHECK_INTERVAL)
+         && !pThread->ShouldStop())
+    ;
+}
+
 void GOSoundScheduler::SetRepeatCount(unsigned count) {
   m_RepeatCount = count;
   GOMutexLocker lock(m_Mutex);
@@ -30,28 +137,99 @@ void GOSoundScheduler::SetRepeatCount(unsigned count) {
   Unlock();
 }
 
+void GOSoundScheduler::SetWorkerCount(unsigned count) {
+  GOMutexLocker lock(m_Mutex);
+  Lock();
+  m_Queues.clear();
+  // and the start queue
+  for (unsigned i = 0; i <= count; i++)
+    m_Queues.push_back(new GOSoundWorkQueue());
+  Update();
+  Unlock();
+}
+
 void GOSoundScheduler::Clear() {
   GOMutexLocker lock(m_Mutex);
   Lock();
   m_Work.clear();
+  m_Dependencies.clear();
   Update();
   Unlock();
 }
 
 void GOSoundScheduler::Update() {
-  m_Tasks.clear();
+  std::unordered_map<GOSoundTask *, unsigned> nodeIndices;
+  unsigned runCount = 0;
+
+  // invalidate the work items of the old graph
+  m_Generation.fetch_add(1);
+  m_Nodes.clear();
   SortList(m_Work);
-  for (unsigned i = 0; i < m_Work.size();) {
-    unsigned cnt = 1;
-    while (i + cnt < m_Work.size()
-           && m_Work[i]->GetGroup() == m_Work[i + cnt]->GetGroup())
-      cnt++;
-    unsigned rcnt = m_Work[i]->GetRepeat() ? m_RepeatCount : 1;
-    for (unsigned j = 0; j < rcnt; j++)
-      for (unsigned k = 0; k < cnt; k++)
-        m_Tasks.push_back(&m_Work[i + k]);
-    i += cnt;
+  for (GOSoundTask *pTask : m_Work)
+    if (pTask) {
+      // a repeatable task may be helped by all threads
+      const unsigned nRuns = pTask->GetRepeat()
+        ? std::max({m_RepeatCount, (unsigned)m_Queues.size(), 1u})
+        : 1;
+
+      nodeIndices[pTask] = m_Nodes.size();
+      m_Nodes.push_back(new Node(pTask, nRuns));
+      runCount += nRuns;
+    }
+  for (const auto &dependency : m_Dependencies) {
+    auto taskIt = nodeIndices.find(dependency.first);
+    auto inputIt = nodeIndices.find(dependency.second);
+
+    if (taskIt != nodeIndices.end() && inputIt != nodeIndices.end()) {
+      m_Nodes[inputIt->second]->m_Dependents.push_back(taskIt->second);
+      m_Nodes[taskIt->second]->m_InputCount++;
+    }
+  }
+  /* A queue may receive all runs of a period and some stale items of the
+   * previous one that its owner has not taken yet, so a push never fails */
+  for (unsigned i = 0; i < m_Queues.size(); i++)
+    m_Queues[i]->SetCapacity(runCount * 2 + 1);
+  m_IsGraphChanged = false;
+  // the period of the old graph will never complete
+  NotifyWork();
+}
+
+void GOSoundScheduler::PushNode(
+  unsigned nodeIndex, uint32_t generation, unsigned queueIndex) {
+  GOSoundWorkQueue &queue = *m_Queues[queueIndex];
+
+  // the other threads steal the copies of a repeatable task
+  for (unsigned i = 0; i < m_Nodes[nodeIndex]->m_RunCount; i++)
+    queue.Push(make_item(nodeIndex, generation));
+}
+
+void GOSoundScheduler::StartPeriod() {
+  const uint32_t generation = m_Generation.fetch_add(1) + 1;
+  unsigned nBlocked = 0;
+
+  /* Only the owners may remove the items from the queues of the sound
+   * threads. The stale items there are skipped by the generation */
+  if (m_Queues.size())
+    m_Queues[GetStartQueueIndex()]->Clear();
+  for (unsigned i = 0; i < m_Nodes.size(); i++) {
+    Node &node = *m_Nodes[i];
+
+    node.m_PendingInputs.store(make_counter(generation, node.m_InputCount));
+    node.m_PendingRuns.store(make_counter(generation, node.m_RunCount));
+    if (node.m_InputCount)
+      nBlocked++;
   }
+  m_PendingBlocked.store(make_counter(generation, nBlocked));
+  m_PendingNodes.store(make_counter(generation, m_Nodes.size()));
+  m_PeriodStartTime.store(now_ticks());
+  if (!m_Nodes.size())
+    m_PeriodWorkTime.store(make_counter(generation, 0));
+  if (m_Queues.size())
+    for (unsigned i = 0; i < m_Nodes.size(); i++)
+      if (!m_Nodes[i]->m_InputCount)
+        PushNode(i, generation, GetStartQueueIndex());
+  // the threads still waiting in the previous period
+  NotifyWork();
 }
 
 void GOSoundScheduler::AddList(
@@ -64,10 +242,16 @@ void GOSoundScheduler::Add(GOSoundTask *item) {
     return;
   item->Clear();
   GOMutexLocker lock(m_Mutex);
-  Lock();
   AddList(item, m_Work);
-  Update();
-  Unlock();
+  m_IsGraphChanged = true;
+}
+
+void GOSoundScheduler::AddDependency(GOSoundTask *item, GOSoundTask *input) {
+  if (!item || !input)
+    return;
+  GOMutexLocker lock(m_Mutex);
+  m_Dependencies.emplace_back(item, input);
+  m_IsGraphChanged = true;
 }
 
 void GOSoundScheduler::RemoveList(
@@ -79,7 +263,21 @@ void GOSoundScheduler::RemoveList(
 
 void GOSoundScheduler::Remove(GOSoundTask *item) {
   GOMutexLocker lock(m_Mutex);
+  Lock();
   RemoveList(item, m_Work);
+  m_Dependencies.erase(
+    std::remove_if(
+      m_Dependencies.begin(),
+      m_Dependencies.end(),
+      [item](const auto &dependency) {
+        return dependency.first == item || dependency.second == item;
+      }),
+    m_Dependencies.end());
+  // the node remains in the graph for passing the completion to dependents
+  for (unsigned i = 0; i < m_Nodes.size(); i++)
+    if (m_Nodes[i]->p_task == item)
+      m_Nodes[i]->p_task = nullptr;
+  Unlock();
 }
 
 bool GOSoundScheduler::CompareItem(GOSoundTask *a, GOSoundTask *b) {
@@ -112,10 +310,30 @@ void GOSoundScheduler::ResetList(std::vector<GOSoundTask *> &list) {
       list[i]->Reset();
 }
 
+void GOSoundScheduler::WaitForRunningTasks() {
+  GOSoundBackoff backoff;
+
+  /* A thread either has been counted before the generation changed or it sees
+   * the new generation and does not take the items of the previous period.
+   * The tasks of the previous period have completed with Exec(), so the
+   * counted threads return from them at once */
+  while (m_RunningCount.load())
+    backoff.Pause();
+}
+
 void GOSoundScheduler::Reset() {
   GOMutexLocker lock(m_Mutex);
+
+  if (m_IsGraphChanged) {
+    Lock();
+    Update();
+    Unlock();
+  }
+  // no task of the previous period may run after it has been reset
+  m_Generation.fetch_add(1);
+  WaitForRunningTasks();
   ResetList(m_Work);
-  m_NextItem.exchange(0);
+  StartPeriod();
 }
 
 void GOSoundScheduler::ExecList(std::vector<GOSoundTask *> &list) {
@@ -129,16 +347,132 @@ void GOSoundScheduler::Exec() {
   ExecList(m_Work);
 }
 
-GOSoundTask *GOSoundScheduler::GetNextGroup() {
-  do {
-    if (m_IsNotGivingWork.load()) {
-      return nullptr;
+bool GOSoundScheduler::TakeItem(unsigned workerIndex, uint64_t &item) {
+  const unsigned nQueues = m_Queues.size();
+
+  if (workerIndex >= nQueues)
+    return false;
+  if (m_Queues[workerIndex]->Pop(item))
+    return true;
+  for (unsigned i = 1; i < nQueues; i++)
+    if (m_Queues[(workerIndex + i) % nQueues]->Steal(item))
+      return true;
+  return false;
+}
+
+void GOSoundScheduler::CompleteItem(uint64_t item, unsigned workerIndex) {
+  const uint32_t generation = counter_generation(item);
+  Node &node = *m_Nodes[counter_value(item)];
+
+  if (decrement_counter(node.m_PendingRuns, generation)) {
+    bool isChanged = false;
+
+    for (unsigned dependentIndex : node.m_Dependents)
+      if (decrement_counter(
+            m_Nodes[dependentIndex]->m_PendingInputs, generation)) {
+        // push before decrementing m_PendingBlocked, so the other threads do
+        // not stop looking for work before the dependent appears
+        PushNode(dependentIndex, generation, workerIndex);
+        decrement_counter(m_PendingBlocked, generation);
+        isChanged = true;
+      }
+    if (decrement_counter(m_PendingNodes, generation)) {
+      const auto workTime = time_since(m_PeriodStartTime.load());
+
+      m_PeriodWorkTime.store(make_counter(
+        generation,
+        (uint32_t)std::min<int64_t>(workTime.count(), UINT32_MAX)));
+      isChanged = true;
     }
-    unsigned next = m_NextItem.fetch_add(1);
-    if (next >= m_ItemCount)
-      return nullptr;
-    GOSoundTask *item = *m_Tasks[next];
-    if (item)
-      return item;
-  } while (true);
+    if (isChanged)
+      NotifyWork();
+  }
+}
+
+bool GOSoundScheduler::RunNextTask(
+  unsigned workerIndex, GOSoundThread *pThread) {
+  GOSoundBackoff backoff;
+
+  while (!m_IsNotGivingWork.load() && !(pThread && pThread->ShouldStop())) {
+    // read before looking for work, so no notification is missed
+    const unsigned signal = m_WorkSignal.load();
+
+    if (!Enter())
+      return false;
+
+    // counted before reading the generation, see WaitForRunningTasks()
+    m_RunningCount.fetch_add(1);
+
+    const uint32_t generation = m_Generation.load();
+    uint64_t item;
+    const bool isFound = TakeItem(workerIndex, item);
+    // an item of the previous period
+    const bool isStale = isFound && counter_generation(item) != generation;
+    GOSoundTask *pTask = nullptr;
+    bool isWaiting = false;
+
+    if (isFound && !isStale)
+      pTask = m_Nodes[counter_value(item)]->p_task;
+    else if (!isFound) {
+      const uint64_t blocked = m_PendingBlocked.load();
+
+      isWaiting
+        = counter_generation(blocked) == generation && counter_value(blocked);
+    }
+    Leave();
+
+    if (isFound && !isStale) {
+      if (pTask)
+        pTask->Run(pThread);
+      if (Enter()) {
+        CompleteItem(item, workerIndex);
+        Leave();
+      }
+      m_RunningCount.fetch_sub(1);
+      return true;
+    }
+    m_RunningCount.fetch_sub(1);
+    if (isStale)
+      continue;
+    if (!isWaiting)
+      return false;
+    // some task is running and will make its dependents runnable soon
+    if (!backoff.Pause() && pThread) {
+      WaitForWork(signal, pThread);
+      backoff.Reset();
+    }
+  }
+  return false;
+}
+
+void GOSoundScheduler::RunUntilComplete() {
+  GOSoundBackoff backoff;
+
+  while (!m_IsNotGivingWork.load()) {
+    if (!Enter())
+      return;
+
+    const uint32_t generation = m_Generation.load();
+    const uint64_t pending = m_PendingNodes.load();
+    const bool isComplete = !m_Queues.size()
+      || counter_generation(pending) != generation || !counter_value(pending);
+    const unsigned queueIndex = isComplete ? 0 : GetStartQueueIndex();
+
+    Leave();
+    if (isComplete)
+      return;
+    if (RunNextTask(queueIndex, nullptr))
+      backoff.Reset();
+    else
+      // the last tasks are still running in the sound threads
+      backoff.Pause();
+  }
+}
+
+std::chrono::microseconds GOSoundScheduler::GetPeriodWorkTime() const {
+  const uint64_t workTime = m_PeriodWorkTime.load();
+
+  if (counter_generation(workTime) == m_Generation.load())
+    return std::chrono::microseconds(counter_value(workTime));
+  return time_since(m_PeriodStartTime.load());
 }
@@ -1,6 +1,6 @@
 /*
  * Copyright 2006 Milan Digital Audio LLC
- * Copyright 2009-2024 GrandOrgue contributors (see AUTHORS)
+ * Copyright 2009-2026 GrandOrgue contributors (see AUTHORS)
  * License GPL-2.0 or later
  * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
  */
@@ -8,26 +8,133 @@
 #ifndef GOSOUNDSCHEDULER_H
 #define GOSOUNDSCHEDULER_H
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <semaphore>
+#include <utility>
 #include <vector>
 
+#include "ptrvector.h"
 #include "threading/GOMutex.h"
 
+#include "GOSoundWorkQueue.h"
+
 class GOSoundTask;
+class GOSoundThread;
 
+/**
+ * Distributes the tasks of a period among the sound threads.
+ *
+ * The tasks form a graph: a task becomes runnable only when all its inputs
+ * (see AddDependency()) have completed in this period. The runnable tasks are
+ * put to the work-stealing queues of the threads. A thread takes the tasks
+ * from its own queue and steals from the queues of other threads when its own
+ * one is empty, so no thread waits for the inputs inside a task. Only the
+ * owner pushes to a queue: the tasks without inputs are pushed to the start
+ * queue owned by the thread starting the periods, and the tasks made runnable
+ * by a thread are pushed to its own queue.
+ *
+ * A repeatable task is run m_RepeatCount times in a period by different
+ * threads, and it is completed when all of these runs have returned.
+ *
+ * A thread that has found no runnable task while some tasks are still waiting
+ * for their inputs spins and yields with a bounded backoff. Then a sound
+ * thread sleeps on a semaphore until new work is pushed or the period state
+ * changes. The audio callback only releases the semaphore and never sleeps on
+ * it.
+ *
+ * Each period has a generation number. The counters of the graph contain the
+ * generation, so a task of the previous period that returns after Reset() does
+ * not affect the new period.
+ */
 class GOSoundScheduler {
 private:
+  // how often a sleeping sound thread checks whether it should stop
+  static constexpr std::chrono::milliseconds STOP_CHECK_INTERVAL{100};
+
+  struct Node {
+    GOSoundTask *p_task;
+    // the number of Run() calls in a period
+    unsigned m_RunCount;
+    unsigned m_InputCount;
+    // indices of the nodes having this one as an input
+    std::vector<unsigned> m_Dependents;
+    // (generation << 32) | the number of inputs not completed yet
+    std::atomic_uint64_t m_PendingInputs;
+    // (generation << 32) | the number of runs not returned yet
+    std::atomic_uint64_t m_PendingRuns;
+
+    Node(GOSoundTask *pTask, unsigned runCount)
+      : p_task(pTask),
+        m_RunCount(runCount),
+        m_InputCount(0),
+        m_PendingInputs(0),
+        m_PendingRuns(0) {}
+  };
+
   std::vector<GOSoundTask *> m_Work;
-  std::vector<GOSoundTask **> m_Tasks;
-  // if GetNextGroup() always returns nullptr
+  // pairs of (task, input)
+  std::vector<std::pair<GOSoundTask *, GOSoundTask *>> m_Dependencies;
+  bool m_IsGraphChanged;
+
+  ptr_vector<Node> m_Nodes;
+  // the queues of the sound threads and the start queue as the last one
+  ptr_vector<GOSoundWorkQueue> m_Queues;
+  std::atomic_uint m_Generation;
+  // (generation << 32) | the number of nodes waiting for their inputs
+  std::atomic_uint64_t m_PendingBlocked;
+  // (generation << 32) | the number of nodes not completed yet
+  std::atomic_uint64_t m_PendingNodes;
+  // steady_clock ticks. Set before the tasks of the period are pushed
+  std::atomic_int64_t m_PeriodStartTime;
+  // (generation << 32) | microseconds from the period start until the sound
+  // threads completed its last node
+  std::atomic_uint64_t m_PeriodWorkTime;
+
+  // if RunNextTask() always returns false
   std::atomic_bool m_IsNotGivingWork;
-  std::atomic_uint m_NextItem;
-  std::atomic_uint m_ItemCount;
+  // m_Nodes and m_Queues are being changed
+  std::atomic_bool m_IsLocked;
+  // the number of threads accessing m_Nodes and m_Queues
+  std::atomic_uint m_UserCount;
   unsigned m_RepeatCount;
   GOMutex m_Mutex;
+  // incremented when new work is pushed or the period state changes
+  std::atomic_uint m_WorkSignal;
+  // the number of threads taking or running a task
+  std::atomic_uint m_RunningCount;
+  // the number of sound threads sleeping in WaitForWork() and not notified yet
+  std::atomic_uint m_WaitingCount;
+  std::counting_semaphore<> m_WorkSemaphore;
+
+  void Lock();
+  void Unlock() { m_IsLocked.store(false); }
+  bool Enter();
+  void Leave() { m_UserCount.fetch_sub(1); }
+
+  // wakes up the threads sleeping in WaitForWork(). Never blocks
+  void NotifyWork();
+  /**
+   * Sleeps until NotifyWork() is called. Returns immediately if it has been
+   * called since m_WorkSignal had the value signal. Only sound threads may
+   * call it
+   */
+  void WaitForWork(unsigned signal, GOSoundThread *pThread);
+  /**
+   * Waits until the threads have returned from the tasks they took before the
+   * generation changed. Spins and yields, so the audio callback may call it
+   */
+  void WaitForRunningTasks();
+  // the start queue is owned by the thread starting the periods
+  unsigned GetStartQueueIndex() const { return m_Queues.size() - 1; }
 
-  void Lock() { m_ItemCount.store(0); }
-  void Unlock() { m_ItemCount.store(m_Tasks.size()); }
   void Update();
+  void StartPeriod();
+  // pushes all runs of the node to the queue owned by the calling thread
+  void PushNode(unsigned nodeIndex, uint32_t generation, unsigned queueIndex);
+  bool TakeItem(unsigned workerIndex, uint64_t &item);
+  void CompleteItem(uint64_t item, unsigned workerIndex);
 
   bool CompareItem(GOSoundTask *a, GOSoundTask *b);
   void SortList(std::vector<GOSoundTask *> &list);
@@ -41,17 +148,56 @@ public:
   ~GOSoundScheduler();
 
   void SetRepeatCount(unsigned count);
+  /**
+   * Creates the work queues of count sound threads and the start queue. Must
+   * be called before starting the threads
+   */
+  void SetWorkerCount(unsigned count);
 
   void Clear();
   void Reset();
   void Exec();
   void Add(GOSoundTask *item);
   void Remove(GOSoundTask *item);
+  /**
+   * Makes the task runnable in a period only after the input has completed.
+   * Both tasks must be added with Add(). Takes effect since the next Reset()
+   */
+  void AddDependency(GOSoundTask *item, GOSoundTask *input);
 
-  void PauseGivingWork() { m_IsNotGivingWork.store(true); }
+  void PauseGivingWork() {
+    m_IsNotGivingWork.store(true);
+    NotifyWork();
+  }
   void ResumeGivingWork() { m_IsNotGivingWork.store(false); }
 
-  GOSoundTask *GetNextGroup();
+  /**
+   * Runs one runnable task of the current period. If there is no runnable task
+   * but some tasks are still waiting for their inputs then it waits for the
+   * work and steals it as soon as it appears.
+   * @param workerIndex the index of the queue owned by the calling thread
+   * @param pThread the calling sound thread or nullptr. Only a sound thread
+   *   may sleep while waiting for the work
+   * @return false if there is no more work for the thread in this period
+   */
+  bool RunNextTask(unsigned workerIndex, GOSoundThread *pThread);
+
+  /**
+   * Runs the tasks of the current period in the calling thread together with
+   * the sound threads and returns when all tasks of the period have completed,
+   * so the result does not depend on the timing of the threads. Returns
+   * immediately if there are no sound threads or giving work is paused.
+   * Never sleeps. Must be called by the thread starting the periods, as it
+   * uses the start queue
+   */
+  void RunUntilComplete();
+
+  /**
+   * Returns how long the current period has been rendered: from its start
+   * until the sound threads completed its last task, or until now if they
+   * have not completed it. Used for measuring the render load
+   */
+  std::chrono::microseconds GetPeriodWorkTime() const;
 };
 
 #endif
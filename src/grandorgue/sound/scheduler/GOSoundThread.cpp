@@ -1,6 +1,6 @@
 /*
  * Copyright 2006 Milan Digital Audio LLC
- * Copyright 2009-2024 GrandOrgue contributors (see AUTHORS)
+ * Copyright 2009-2026 GrandOrgue contributors (see AUTHORS)
  * License GPL-2.0 or later
  * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
  */
@@ -10,14 +10,15 @@
 #include <wx/log.h>
 
 #include "GOSoundScheduler.h"
-#include "sound/scheduler/GOSoundTask.h"
 #include "threading/GOMutexLocker.h"
 #include <unistd.h>
 
-GOSoundThread::GOSoundThread(GOSoundScheduler *scheduler)
+GOSoundThread::GOSoundThread(GOSoundScheduler *scheduler, unsigned workerIndex)
   : GOThread(),
     m_Scheduler(scheduler),
-    m_Condition(m_Mutex),
+    m_WorkerIndex(workerIndex),
+    m_WakeupSemaphore(0),
+    m_IsWakeupPending(false),
     m_IdleStateReachedCondition(m_Mutex),
     m_IsIdle(false) {
   wxLogDebug(wxT("Create Thread"));
@@ -28,23 +29,27 @@ void GOSoundThread::Entry() {
     bool shouldStop = false;
 
     do {
-      GOSoundTask *next = m_Scheduler->GetNextGroup();
-
-      if (next == NULL)
+      if (!m_Scheduler->RunNextTask(m_WorkerIndex, this))
         break;
-      next->Run(this);
       shouldStop = ShouldStop();
     } while (!shouldStop);
 
     if (shouldStop)
       break;
 
+    {
+      GOMutexLocker lock(m_Mutex, false, "GOSoundThread::Entry", this);
+      if (!lock.IsLocked() || ShouldStop())
+        break;
+      m_IsIdle = true;
+      m_IdleStateReachedCondition.Broadcast();
+    }
+    m_WakeupSemaphore.acquire();
+    // the next Wakeup() releases the semaphore again
+    m_IsWakeupPending.store(false);
+
     GOMutexLocker lock(m_Mutex, false, "GOSoundThread::Entry", this);
-    if (!lock.IsLocked() || ShouldStop())
-      break;
-    m_IsIdle = true;
-    m_IdleStateReachedCondition.Broadcast();
-    if (!m_Condition.WaitOrStop("GOSoundThread::Entry"))
+    if (!lock.IsLocked())
       break;
     m_IsIdle = false;
   }
@@ -61,7 +66,12 @@ void GOSoundThread::WaitForIdle() {
 
 void GOSoundThread::Run() { Start(); }
 
-void GOSoundThread::Wakeup() { m_Condition.Signal(); }
+void GOSoundThread::Wakeup() {
+  // the period has been started before, so the thread either is still looking
+  // for work or takes the pending release
+  if (!m_IsWakeupPending.exchange(true))
+    m_WakeupSemaphore.release();
+}
 
 void GOSoundThread::Delete() {
   MarkForStop();
@@ -1,6 +1,6 @@
 /*
  * Copyright 2006 Milan Digital Audio LLC
- * Copyright 2009-2023 GrandOrgue contributors (see AUTHORS)
+ * Copyright 2009-2026 GrandOrgue contributors (see AUTHORS)
  * License GPL-2.0 or later
  * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
  */
@@ -8,6 +8,9 @@
 #ifndef GOSOUNDTHREAD_H
 #define GOSOUNDTHREAD_H
 
+#include <atomic>
+#include <semaphore>
+
 #include "threading/GOCondition.h"
 #include "threading/GOMutex.h"
 #include "threading/GOThread.h"
@@ -17,22 +20,28 @@ class GOSoundScheduler;
 class GOSoundThread : public GOThread {
 private:
   GOSoundScheduler *m_Scheduler;
+  // the index of the work queue of this thread in the scheduler
+  unsigned m_WorkerIndex;
 
   GOMutex m_Mutex;
-  GOCondition m_Condition;
+  /* The thread sleeps on it between the periods. Wakeup() is called from the
+   * audio callback, so it only releases the semaphore, and only once until
+   * the thread has woken up */
+  std::binary_semaphore m_WakeupSemaphore;
+  std::atomic_bool m_IsWakeupPending;
   GOCondition m_IdleStateReachedCondition;
-  // whether the thread sleeps and waits for waking up with m_Condition
+  // whether the thread sleeps and waits for waking up with m_WakeupSemaphore
   bool m_IsIdle; // guarded by m_Mutex
 
   void Entry();
 
 public:
-  GOSoundThread(GOSoundScheduler *scheduler);
+  GOSoundThread(GOSoundScheduler *scheduler, unsigned workerIndex);
 
   /*
    * === Prerequisites ===
    * During the execution the following must be true:
-   * 1. m_Scheduler->GetNextGroup() always returns nullptr
+   * 1. m_Scheduler->RunNextTask() always returns false
    * 2. thread is running and is not marked to be stopped
    *
    * === Result ===
@@ -42,6 +51,7 @@ public:
   void WaitForIdle();
   void Run();
   void Delete();
+  // Never blocks, so it may be called from the audio callback
   void Wakeup();
 };
 
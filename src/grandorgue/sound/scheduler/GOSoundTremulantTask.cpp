@@ -14,6 +14,8 @@ GOSoundTremulantTask::GOSoundTremulantTask(
   GOSoundEngine &sound_engine, unsigned samples_per_buffer)
   : m_engine(sound_engine),
     m_Volume(0),
+    m_Envelope(samples_per_buffer, 1.0f),
+    m_IsModulating(false),
     m_SamplesPerBuffer(samples_per_buffer),
     m_Done(false) {}
 
@@ -46,13 +48,17 @@ void GOSoundTremulantTask::Run(GOSoundThread *thread) {
   m_Samplers.Move();
   if (m_Samplers.Peek() == NULL) {
     m_Volume = 1;
+    m_IsModulating = false;
     m_Done = true;
     return;
   }
 
+  // the tremulant voices add their modulation to 1 in the right channel
   float output_buffer[m_SamplesPerBuffer * 2];
-  std::fill(output_buffer, output_buffer + m_SamplesPerBuffer * 2, 0.0f);
-  output_buffer[2 * m_SamplesPerBuffer - 1] = 1.0f;
+  for (unsigned i = 0; i < m_SamplesPerBuffer; i++) {
+    output_buffer[2 * i] = 0.0f;
+    output_buffer[2 * i + 1] = 1.0f;
+  }
   for (GOSoundSampler *sampler = m_Samplers.Get(); sampler;
        sampler = m_Samplers.Get()) {
     bool keep;
@@ -62,7 +68,10 @@ void GOSoundTremulantTask::Run(GOSoundThread *thread) {
     if (keep)
       m_Samplers.Put(sampler);
   }
-  m_Volume = output_buffer[2 * m_SamplesPerBuffer - 1];
+  for (unsigned i = 0; i < m_SamplesPerBuffer; i++)
+    m_Envelope[i] = output_buffer[2 * i + 1];
+  m_Volume = m_Envelope[m_SamplesPerBuffer - 1];
+  m_IsModulating = true;
   m_Done = true;
 }
 
@@ -8,6 +8,8 @@
 #ifndef GOSOUNDTREMULANTTASK_H
 #define GOSOUNDTREMULANTTASK_H
 
+#include <vector>
+
 #include "sound/GOSoundSamplerList.h"
 #include "sound/scheduler/GOSoundTask.h"
 #include "threading/GOMutex.h"
@@ -20,6 +22,10 @@ private:
   GOSoundSamplerList m_Samplers;
   GOMutex m_Mutex;
   float m_Volume;
+  // the volume of each frame of the period
+  std::vector<float> m_Envelope;
+  // false if no tremulant voice is playing, so the volume is constant 1
+  bool m_IsModulating;
   unsigned m_SamplesPerBuffer;
   bool m_Done;
 
@@ -37,11 +43,19 @@ public:
   void Clear();
   void Add(GOSoundSampler *sampler);
 
+  /* The volume at the end of the period */
   float GetVolume() {
     if (!m_Done)
       Run();
     return m_Volume;
   }
+
+  /* The volume of each frame of the period or nullptr if it is constant 1 */
+  const float *GetEnvelope() {
+    if (!m_Done)
+      Run();
+    return m_IsModulating ? m_Envelope.data() : nullptr;
+  }
 };
 
 #endif
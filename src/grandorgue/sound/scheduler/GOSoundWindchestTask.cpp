@@ -1,12 +1,14 @@
 /*
  * Copyright 2006 Milan Digital Audio LLC
- * Copyright 2009-2024 GrandOrgue contributors (see AUTHORS)
+ * Copyright 2009-2026 GrandOrgue contributors (see AUTHORS)
  * License GPL-2.0 or later
  * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
  */
 
 #include "GOSoundWindchestTask.h"
 
+#include <algorithm>
+
 #include "sound/GOSoundEngine.h"
 #include "threading/GOMutexLocker.h"
 
@@ -16,12 +18,16 @@ GOSoundWindchestTask::GOSoundWindchestTask(
   GOSoundEngine &soundEngine, GOWindchest *pWindchest)
   : r_engine(soundEngine),
     m_volume(0),
+    m_MaxTremulantGain(1.0f),
+    m_IsModulated(false),
     m_done(false),
     p_windchest(pWindchest) {}
 
 void GOSoundWindchestTask::Init(
   ptr_vector<GOSoundTremulantTask> &tremulantTasks) {
   m_pTremulantTasks.clear();
+  m_envelope.resize(r_engine.GetSamplesPerBuffer());
+  m_MaxTremulantGain = p_windchest ? p_windchest->GetMaxTremulantGain() : 1.0f;
   if (p_windchest)
     for (unsigned i = 0; i < p_windchest->GetTremulantCount(); i++)
       m_pTremulantTasks.push_back(
@@ -40,13 +46,26 @@ void GOSoundWindchestTask::Run(GOSoundThread *pThread) {
 
     if (!m_done.load()) {
       float volume = r_engine.GetGain();
+      bool isModulated = false;
 
       if (p_windchest) {
         volume *= p_windchest->GetVolume();
-        for (unsigned i = 0; i < m_pTremulantTasks.size(); i++)
-          volume *= m_pTremulantTasks[i]->GetVolume();
+        for (GOSoundTremulantTask *pTremulant : m_pTremulantTasks) {
+          const float *pEnvelope = pTremulant->GetEnvelope();
+
+          if (!pEnvelope)
+            continue;
+          if (isModulated)
+            for (unsigned i = 0; i < m_envelope.size(); i++)
+              m_envelope[i] *= pEnvelope[i];
+          else
+            std::copy(
+              pEnvelope, pEnvelope + m_envelope.size(), m_envelope.begin());
+          isModulated = true;
+        }
       }
       m_volume = volume;
+      m_IsModulated = isModulated;
       m_done.store(true);
     }
   }
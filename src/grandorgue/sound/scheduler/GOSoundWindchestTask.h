@@ -1,6 +1,6 @@
 /*
  * Copyright 2006 Milan Digital Audio LLC
- * Copyright 2009-2024 GrandOrgue contributors (see AUTHORS)
+ * Copyright 2009-2026 GrandOrgue contributors (see AUTHORS)
  * License GPL-2.0 or later
  * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
  */
@@ -9,6 +9,7 @@
 #define GOSOUNDWINDCHESTTASK_H
 
 #include <atomic>
+#include <vector>
 
 #include "ptrvector.h"
 
@@ -25,6 +26,11 @@ private:
   GOSoundEngine &r_engine;
   GOMutex m_mutex;
   float m_volume;
+  // the highest value m_envelope may ever have
+  float m_MaxTremulantGain;
+  // the product of the tremulant envelopes of the period
+  std::vector<float> m_envelope;
+  bool m_IsModulated;
   std::atomic_bool m_done;
   GOWindchest *p_windchest;
   std::vector<GOSoundTremulantTask *> m_pTremulantTasks;
@@ -42,15 +48,38 @@ public:
   void Reset() override;
   void Init(ptr_vector<GOSoundTremulantTask> &tremulantTasks);
 
+  const std::vector<GOSoundTremulantTask *> &GetTremulantTasks() const {
+    return m_pTremulantTasks;
+  }
+
   float GetWindchestVolume() const {
     return p_windchest ? p_windchest->GetVolume() : 1;
   }
 
+  /* The volume without the tremulants. The voice fader smooths its changes */
   float GetVolume() {
     if (!m_done.load())
       Run();
     return m_volume;
   }
+
+  /**
+   * The highest volume a voice may get from the windchest, including any
+   * tremulant modulation. Unlike GetVolume() it does not change with the
+   * tremulants turned on or off
+   */
+  float GetMaxVolume() { return GetVolume() * m_MaxTremulantGain; }
+
+  /**
+   * The tremulant modulation of each frame of the period. It is applied to the
+   * voices in addition to GetVolume()
+   * @return nullptr if no tremulant is modulating the windchest
+   */
+  const float *GetEnvelope() {
+    if (!m_done.load())
+      Run();
+    return m_IsModulated ? m_envelope.data() : nullptr;
+  }
 };
 
 #endif
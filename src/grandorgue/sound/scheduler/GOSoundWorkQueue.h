@@ -0,0 +1,138 @@
+/*
+ * Copyright 2026 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#ifndef GOSOUNDWORKQUEUE_H
+#define GOSOUNDWORKQUEUE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+/**
+ * A lock-free work-stealing deque (Chase-Lev) of one sound thread.
+ * Only the owner pushes the items. It pushes and takes them at the bottom (the
+ * last pushed first), so it continues with the work it has just made runnable.
+ * The other threads steal from the top by advancing it with a CAS, so a thread
+ * preempted in the middle of an operation never keeps the others waiting.
+ * The capacity is fixed, so Push() never allocates memory in the audio
+ * threads.
+ */
+class GOSoundWorkQueue {
+private:
+  std::unique_ptr<std::atomic_uint64_t[]> m_Items;
+  // the capacity minus 1. The capacity is a power of 2
+  int64_t m_Mask;
+  // the next item to steal
+  std::atomic_int64_t m_Top;
+  // the next free position. m_Top <= m_Bottom except inside Pop()
+  std::atomic_int64_t m_Bottom;
+
+  std::atomic_uint64_t &At(int64_t pos) { return m_Items[pos & m_Mask]; }
+
+public:
+  GOSoundWorkQueue() : m_Mask(-1), m_Top(0), m_Bottom(0) {}
+
+  /**
+   * Empties the queue and changes its capacity to at least the given one.
+   * Must not be called concurrently with other methods
+   */
+  void SetCapacity(unsigned capacity) {
+    unsigned size = 1;
+
+    while (size < capacity)
+      size *= 2;
+    m_Items.reset(new std::atomic_uint64_t[size]);
+    m_Mask = size - 1;
+    m_Top.store(0);
+    m_Bottom.store(0);
+  }
+
+  /**
+   * Adds the item to the bottom. Used by the owner of the queue only
+   * @return false if the queue is full
+   */
+  bool Push(uint64_t item) {
+    const int64_t bottom = m_Bottom.load(std::memory_order_relaxed);
+    const int64_t top = m_Top.load(std::memory_order_acquire);
+
+    if (bottom - top > m_Mask)
+      return false;
+    At(bottom).store(item, std::memory_order_relaxed);
+    // publishes the item before the new bottom
+    m_Bottom.store(bottom + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Takes the last pushed item. Used by the owner of the queue only
+   * @return false if the queue is empty
+   */
+  bool Pop(uint64_t &item) {
+    const int64_t bottom = m_Bottom.load(std::memory_order_relaxed) - 1;
+
+    // reserve the bottom item before looking at the top, so a thief either
+    // sees the reservation or we see its steal
+    m_Bottom.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    int64_t top = m_Top.load(std::memory_order_relaxed);
+    bool isPopped = false;
+
+    if (top < bottom) {
+      item = At(bottom).load(std::memory_order_relaxed);
+      return true;
+    }
+    if (top == bottom) {
+      // the last item: race with the thieves for it
+      item = At(bottom).load(std::memory_order_relaxed);
+      isPopped = m_Top.compare_exchange_strong(
+        top,
+        top + 1,
+        std::memory_order_seq_cst,
+        std::memory_order_relaxed);
+    }
+    m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+    return isPopped;
+  }
+
+  /**
+   * Takes the first pushed item. Used by the other threads
+   * @return false if the queue is empty
+   */
+  bool Steal(uint64_t &item) {
+    int64_t top = m_Top.load(std::memory_order_acquire);
+
+    while (true) {
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+
+      const int64_t bottom = m_Bottom.load(std::memory_order_acquire);
+
+      if (top >= bottom)
+        return false;
+      item = At(top).load(std::memory_order_relaxed);
+      // another thief or the owner may have taken the item. Then retry with
+      // the new top, so false always means that the queue was empty
+      if (m_Top.compare_exchange_strong(
+            top,
+            top + 1,
+            std::memory_order_seq_cst,
+            std::memory_order_relaxed))
+        return true;
+    }
+  }
+
+  /**
+   * Removes all items. Used by the owner of the queue only
+   */
+  void Clear() {
+    uint64_t item;
+
+    while (Pop(item))
+      ;
+  }
+};
+
+#endif /* GOSOUNDWORKQUEUE_H */
@@ -7,10 +7,22 @@
 #include <cstdio>
 #include <iostream>
 
+#include "GOTestArchiveIndex.h"
+#include "GOTestAudioSectionEnvelope.h"
+#include "GOTestBlockCompress.h"
+#include "GOTestCacheIndex.h"
+#include "GOTestCachePacking.h"
 #include "GOTestCollection.h"
 #include "GOTestDrawStop.h"
+#include "GOTestMemoryBudgetPlanner.h"
+#include "GOTestMemoryPoolShare.h"
+#include "GOTestMidiRoutes.h"
 #include "GOTestOrganModel.h"
+#include "GOTestSoundStream.h"
+#include "GOTestSoundTremulantGain.h"
+#include "GOTestSoundWorkQueue.h"
 #include "GOTestSwitch.h"
+#include "GOTestUpsampler.h"
 #include "GOTestWindchest.h"
 
 int main() {
@@ -22,9 +34,21 @@ int main() {
   */
 
   /* Instantiate all the test classes here */
+  GOTestArchiveIndex testArchiveIndex;
+  GOTestAudioSectionEnvelope testAudioSectionEnvelope;
+  GOTestBlockCompress testBlockCompress;
+  GOTestCacheIndex testCacheIndex;
+  GOTestCachePacking testCachePacking;
   GOTestDrawStop testDrawStop;
+  GOTestMemoryBudgetPlanner testMemoryBudgetPlanner;
+  GOTestMemoryPoolShare testMemoryPoolShare;
+  GOTestMidiRoutes testMidiRoutes;
   GOTestOrganModel testOrganModel;
+  GOTestSoundStream testSoundStream;
+  GOTestSoundTremulantGain testSoundTremulantGain;
+  GOTestSoundWorkQueue testSoundWorkQueue;
   GOTestSwitch testSwitch;
+  GOTestUpsampler testUpsampler;
   GOTestWindchest testWindchest;
   /* end of instanciation */
   GOTestResultCollection test_result_collection;
@@ -0,0 +1,148 @@
+/*
+ * Copyright 2026 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#include "GOTestArchiveIndex.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include <wx/filefn.h>
+#include <wx/filename.h>
+
+#include "archive/GOArchive.h"
+#include "archive/GOArchiveIndex.h"
+#include "archive/GOArchiveWriter.h"
+#include "files/GOOpenedFile.h"
+
+#include "GOBuffer.h"
+
+static constexpr unsigned N_ENTRIES = 100;
+
+static wxString entry_name(unsigned i) {
+  return wxString::Format(wxT("pipes/rank%u/%03u.wav"), i % 7, i);
+}
+
+GOTestArchiveIndex::~GOTestArchiveIndex() {}
+
+std::string GOTestArchiveIndex::GetName() { return name; }
+
+void GOTestArchiveIndex::TestHashName() {
+  // the index files of the previous runs must remain valid
+  GOAssert(
+    GOArchiveIndex::HashName(wxT("a")) == 0xaf63dc4c8601ec8cULL,
+    "The name hash is not FNV-1a");
+  GOAssert(
+    GOArchiveIndex::HashName(wxT("pipes/a.wav"))
+      != GOArchiveIndex::HashName(wxT("pipes/A.wav")),
+    "The name hash ignores the case");
+}
+
+void GOTestArchiveIndex::TestCollisions() {
+  std::vector<GOArchiveEntry> entries(N_ENTRIES);
+  std::vector<GOArchiveNameHash> nameIndex;
+
+  for (unsigned i = 0; i < N_ENTRIES; i++) {
+    entries[i].name = entry_name(i);
+    entries[i].offset = i;
+    entries[i].len = 1;
+  }
+  GOArchiveIndex::BuildNameIndex(entries, nameIndex);
+  GOAssert(nameIndex.size() == N_ENTRIES, "Wrong size of the name index");
+  for (unsigned i = 1; i < nameIndex.size(); i++)
+    GOAssert(
+      nameIndex[i - 1].hash <= nameIndex[i].hash,
+      "The name index is not sorted");
+  for (unsigned i = 0; i < N_ENTRIES; i++) {
+    const GOArchiveEntry *pEntry
+      = GOArchiveIndex::FindEntry(entries, nameIndex, entry_name(i));
+
+    GOAssert(pEntry && pEntry->offset == i, "An entry is not found");
+  }
+  GOAssert(
+    !GOArchiveIndex::FindEntry(entries, nameIndex, wxT("pipes/none.wav")),
+    "A missing entry is found");
+
+  /* Make the entries 10 and 20 have the hash of the entry 30, so all three
+   * are checked by the name */
+  const uint64_t hash = GOArchiveIndex::HashName(entry_name(30));
+
+  for (GOArchiveNameHash &e : nameIndex)
+    if (e.entry == 10 || e.entry == 20)
+      e.hash = hash;
+  std::sort(
+    nameIndex.begin(),
+    nameIndex.end(),
+    [](const GOArchiveNameHash &a, const GOArchiveNameHash &b) {
+      return a.hash < b.hash;
+    });
+
+  const GOArchiveEntry *pEntry
+    = GOArchiveIndex::FindEntry(entries, nameIndex, entry_name(30));
+
+  GOAssert(
+    pEntry && pEntry->offset == 30,
+    "An entry is not found among the colliding hashes");
+}
+
+void GOTestArchiveIndex::TestArchive() {
+  const wxString cacheDir
+    = wxFileName::CreateTempFileName(wxT("GOTestArchive"));
+  const wxString path = cacheDir + wxT(".orgue");
+
+  // a directory for the index files instead of the temporary file
+  wxRemoveFile(cacheDir);
+  GOAssert(wxMkdir(cacheDir), "Unable to create the index directory");
+  {
+    GOArchiveWriter writer;
+
+    GOAssert(writer.Open(path), "Unable to create the archive");
+    for (unsigned i = 0; i < N_ENTRIES; i++) {
+      GOBuffer<uint8_t> content(i + 1);
+
+      memset(content.get(), i, content.GetSize());
+      GOAssert(writer.Add(entry_name(i), content), "Unable to add an entry");
+    }
+    GOAssert(writer.Close(), "Unable to write the archive");
+  }
+
+  // the first opening builds the name index, and the second one reads it
+  for (unsigned pass = 0; pass < 2; pass++) {
+    const std::string passStr = pass ? " (index file)" : " (built)";
+    GOArchive archive(cacheDir);
+
+    GOAssert(archive.OpenArchive(path), "Unable to open the archive" + passStr);
+    for (unsigned i = 0; i < N_ENTRIES; i++) {
+      const wxString entryName = entry_name(i);
+
+      GOAssert(
+        archive.containsFile(entryName), "An entry is not found" + passStr);
+
+      std::unique_ptr<GOOpenedFile> file(archive.OpenFile(entryName));
+      GOBuffer<uint8_t> content;
+
+      GOAssert(
+        file->Open() && file->ReadContent(content)
+          && content.GetSize() == i + 1 && content.get()[i] == (uint8_t)i,
+        "Wrong content of an entry" + passStr);
+      file->Close();
+    }
+    GOAssert(
+      !archive.containsFile(wxT("pipes/none.wav"))
+        && !archive.containsFile(wxT("PIPES/rank0/000.wav")),
+      "A missing entry is found" + passStr);
+    archive.Close();
+  }
+  wxRemoveFile(path);
+  wxFileName::Rmdir(cacheDir, wxPATH_RMDIR_RECURSIVE);
+}
+
+void GOTestArchiveIndex::run() {
+  TestHashName();
+  TestCollisions();
+  TestArchive();
+}
@@ -0,0 +1,27 @@
+/*
+ * Copyright 2026 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+#ifndef GOTESTARCHIVEINDEX_H
+#define GOTESTARCHIVEINDEX_H
+
+#include "GOTest.h"
+
+class GOTestArchiveIndex : public GOTest {
+
+private:
+  std::string name = "GOTestArchiveIndex";
+
+  void TestHashName();
+  void TestCollisions();
+  void TestArchive();
+
+public:
+  GOTestArchiveIndex() { name = "GOTestArchiveIndex"; }
+  virtual ~GOTestArchiveIndex();
+  virtual void run();
+  std::string GetName();
+};
+
+#endif
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2026 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#include "GOTestMemoryPoolShare.h"
+
+#include <cstring>
+#include <vector>
+
+#include "GOMemoryPool.h"
+
+// the blocks are loaded N_COPIES times each
+static constexpr unsigned N_BLOCKS = 8;
+static constexpr unsigned N_COPIES = 8;
+static constexpr size_t BLOCK_LENGTH = 256 * 1024;
+
+GOTestMemoryPoolShare::~GOTestMemoryPoolShare() {}
+
+std::string GOTestMemoryPoolShare::GetName() { return name; }
+
+void GOTestMemoryPoolShare::run() {
+  GOMemoryPool pool;
+  std::vector<char *> blocks;
+  unsigned nShared = 0;
+  size_t residentBefore = 0;
+  const bool isResidentKnown = pool.GetResidentSize(residentBefore);
+
+  for (unsigned i = 0; i < N_BLOCKS * N_COPIES; i++) {
+    char *data = (char *)pool.Alloc(BLOCK_LENGTH, false);
+    bool isShared;
+
+    GOAssert(data, "Unable to allocate a block");
+    memset(data, 1 + i % N_BLOCKS, BLOCK_LENGTH);
+    data = (char *)pool.MoveToPoolShared(data, BLOCK_LENGTH, isShared);
+    GOAssert(data, "Unable to move a block to the pool");
+    GOAssert(
+      data[0] == 1 + i % N_BLOCKS && data[BLOCK_LENGTH - 1] == data[0],
+      "A block is shared with a different one");
+    if (isShared)
+      nShared++;
+    blocks.push_back(data);
+  }
+  GOAssert(
+    nShared == N_BLOCKS * (N_COPIES - 1), "Wrong number of the shared blocks");
+
+  // only one copy of each block has taken the pool memory
+  const size_t allLength = N_BLOCKS * N_COPIES * BLOCK_LENGTH;
+  size_t usedSize = 0;
+  size_t freedSize = 0;
+
+  for (const GOMemoryPool::ArenaStatistic &stat : pool.GetArenaStatistics()) {
+    usedSize += stat.m_UsedSize;
+    freedSize += stat.m_FreedSize;
+  }
+  GOAssert(
+    usedSize == N_BLOCKS * BLOCK_LENGTH && !freedSize,
+    "The shared blocks take the pool memory");
+
+  size_t residentAfter = 0;
+
+  if (isResidentKnown && pool.GetResidentSize(residentAfter))
+    GOAssert(
+      residentAfter - residentBefore < allLength / 2,
+      "The shared blocks take the resident memory");
+
+  // a shared block remains until its last owner frees it
+  for (unsigned i = 0; i < N_BLOCKS * (N_COPIES - 1); i++)
+    pool.Free(blocks[i]);
+
+  const unsigned last = N_BLOCKS * N_COPIES - 1;
+
+  GOAssert(
+    blocks[last][0] == 1 + last % N_BLOCKS,
+    "A shared block is freed before its last owner");
+  for (unsigned i = N_BLOCKS * (N_COPIES - 1); i < blocks.size(); i++)
+    pool.Free(blocks[i]);
+
+  // the blocks copied from a temporary buffer are shared the same way
+  std::vector<char> buffer(BLOCK_LENGTH, 1);
+  bool isShared;
+  char *copy = (char *)pool.CopyToPoolShared(
+    buffer.data(), BLOCK_LENGTH, isShared);
+
+  GOAssert(copy && !isShared, "Unable to copy a block to the pool");
+  GOAssert(
+    copy != buffer.data() && copy[BLOCK_LENGTH - 1] == 1,
+    "A block is not copied to the pool");
+
+  char *sharedCopy = (char *)pool.CopyToPoolShared(
+    buffer.data(), BLOCK_LENGTH, isShared);
+
+  GOAssert(
+    sharedCopy == copy && isShared,
+    "A copied block is not shared with an identical one");
+  pool.Free(sharedCopy);
+  pool.Free(copy);
+}
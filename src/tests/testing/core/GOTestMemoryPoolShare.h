@@ -0,0 +1,23 @@
+/*
+ * Copyright 2026 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+#ifndef GOTESTMEMORYPOOLSHARE_H
+#define GOTESTMEMORYPOOLSHARE_H
+
+#include "GOTest.h"
+
+class GOTestMemoryPoolShare : public GOTest {
+
+private:
+  std::string name = "GOTestMemoryPoolShare";
+
+public:
+  GOTestMemoryPoolShare() { name = "GOTestMemoryPoolShare"; }
+  virtual ~GOTestMemoryPoolShare();
+  virtual void run();
+  std::string GetName();
+};
+
+#endif
@@ -0,0 +1,183 @@
+/*
+ * Copyright 2026 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#include "GOTestCacheIndex.h"
+
+#include <cstring>
+#include <vector>
+
+#include <wx/file.h>
+#include <wx/filename.h>
+#include <wx/wfstream.h>
+
+#include "loader/cache/GOCache.h"
+#include "loader/cache/GOCacheIndex.h"
+#include "loader/cache/GOCacheWriter.h"
+#include "model/GOCacheObject.h"
+
+#include "GOHash.h"
+#include "GOMemoryPool.h"
+
+namespace {
+
+// a cache object that only has a setting
+class TestCacheObject : public GOCacheObject {
+private:
+  wxString m_title = wxT("TestCacheObject");
+
+protected:
+  void Initialize() override {}
+  void LoadData(const GOFileStore &fileStore, GOMemoryPool &pool) override {}
+  bool LoadCache(GOMemoryPool &pool, GOCache &cache) override { return true; }
+
+public:
+  int m_setting = 0;
+
+  bool SaveCache(GOCacheWriter &cache) const override { return true; }
+  void UpdateHash(GOHash &hash) const override { hash.Update(m_setting); }
+  const wxString &GetLoadTitle() const override { return m_title; }
+};
+
+GOHashType make_key(int value) {
+  GOHash hash;
+
+  hash.Update(value);
+  return hash.getHash();
+}
+
+bool is_same_key(const GOHashType &key1, const GOHashType &key2) {
+  return !memcmp(&key1, &key2, sizeof(key1));
+}
+
+} // namespace
+
+GOTestCacheIndex::~GOTestCacheIndex() {}
+
+std::string GOTestCacheIndex::GetName() { return name; }
+
+void GOTestCacheIndex::TestCacheKey() {
+  TestCacheObject obj1;
+  TestCacheObject obj2;
+
+  obj1.m_setting = 1;
+  obj2.m_setting = 1;
+  GOAssert(
+    is_same_key(obj1.GetCacheKey(), obj2.GetCacheKey()),
+    "The objects with the same settings have different cache keys");
+  obj2.m_setting = 2;
+  GOAssert(
+    !is_same_key(obj1.GetCacheKey(), obj2.GetCacheKey()),
+    "The cache key does not change with the settings");
+}
+
+void GOTestCacheIndex::TestFindObjects() {
+  GOCacheIndex index;
+
+  // the cache of the objects 2, 4, 1, 1 and 5
+  index.Add(make_key(2), 10);
+  index.Add(make_key(4), 20);
+  index.Add(make_key(1), 30);
+  index.Add(make_key(1), 40);
+  index.Add(make_key(5), 50);
+
+  // the object 3 is new and the third object 1 has no record left
+  const std::vector<GOHashType> keys
+    = {make_key(1), make_key(2), make_key(1), make_key(3), make_key(1)};
+  const std::vector<GOCacheIndex::Match> matches = index.FindObjects(keys);
+
+  GOAssert(matches.size() == 3, "Wrong number of objects found in the cache");
+  GOAssert(
+    matches[0].m_ObjectIndex == 1 && matches[0].m_offset == 10,
+    "The object 2 is not found at its offset");
+  GOAssert(
+    matches[1].m_ObjectIndex == 0 && matches[1].m_offset == 30,
+    "The first object 1 is not found at the first record");
+  GOAssert(
+    matches[2].m_ObjectIndex == 2 && matches[2].m_offset == 40,
+    "The second object 1 is not found at the second record");
+  GOAssert(
+    GOCacheIndex().FindObjects(keys).empty(),
+    "Objects are found in an empty cache");
+}
+
+void GOTestCacheIndex::TestReadWrite(bool isCompressed) {
+  const std::string mode = isCompressed ? " (compressed)" : "";
+  const wxString path = wxFileName::CreateTempFileName(wxT("GOTestCache"));
+  const std::vector<int> payload = {7, 8, 9};
+  GOCacheIndex index;
+
+  {
+    wxFileOutputStream file(path);
+    GOCacheWriter writer(file, isCompressed);
+
+    GOAssert(writer.WriteHeader(), "Unable to write the cache header" + mode);
+    for (int value : payload) {
+      index.Add(make_key(value), writer.GetPos());
+      writer.Write(&value, sizeof(value));
+    }
+    GOAssert(index.Write(writer), "Unable to write the cache index" + mode);
+    writer.Close();
+  }
+
+  GOMemoryPool pool;
+  GOCacheIndex readIndex;
+
+  {
+    wxFile file(path);
+    GOCache reader(file, pool, false);
+
+    GOAssert(reader.ReadHeader(), "Wrong cache header" + mode);
+    GOAssert(readIndex.Read(reader), "Unable to read the cache index" + mode);
+    GOAssert(
+      readIndex.GetNRecords() == payload.size(),
+      "Wrong number of records read" + mode);
+
+    const std::vector<GOCacheIndex::Match> matches
+      = readIndex.FindObjects({make_key(9), make_key(7)});
+
+    GOAssert(matches.size() == 2, "Wrong number of objects read" + mode);
+    for (const GOCacheIndex::Match &match : matches) {
+      const int expected = match.m_ObjectIndex ? 7 : 9;
+      int value = 0;
+
+      GOAssert(
+        reader.Seek(match.m_offset) && reader.Read(&value, sizeof(value))
+          && value == expected,
+        "Wrong object data at the offset read" + mode);
+    }
+    reader.Close();
+  }
+
+  // a cache without the table must be rejected
+  {
+    wxFileOutputStream file(path);
+    GOCacheWriter writer(file, isCompressed);
+
+    writer.WriteHeader();
+    writer.Write(payload.data(), sizeof(int));
+    writer.Close();
+  }
+  {
+    wxFile file(path);
+    GOCache reader(file, pool, false);
+
+    GOAssert(
+      reader.ReadHeader() && !readIndex.Read(reader),
+      "A cache without the index is accepted" + mode);
+    GOAssert(
+      readIndex.GetNRecords() == 0,
+      "Records remain after a failed reading" + mode);
+    reader.Close();
+  }
+  wxRemoveFile(path);
+}
+
+void GOTestCacheIndex::run() {
+  TestCacheKey();
+  TestFindObjects();
+  TestReadWrite(false);
+  TestReadWrite(true);
+}
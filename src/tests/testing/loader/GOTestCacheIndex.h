@@ -0,0 +1,27 @@
+/*
+ * Copyright 2026 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+#ifndef GOTESTCACHEINDEX_H
+#define GOTESTCACHEINDEX_H
+
+#include "GOTest.h"
+
+class GOTestCacheIndex : public GOTest {
+
+private:
+  std::string name = "GOTestCacheIndex";
+
+  void TestCacheKey();
+  void TestFindObjects();
+  void TestReadWrite(bool isCompressed);
+
+public:
+  GOTestCacheIndex() { name = "GOTestCacheIndex"; }
+  virtual ~GOTestCacheIndex();
+  virtual void run();
+  std::string GetName();
+};
+
+#endif
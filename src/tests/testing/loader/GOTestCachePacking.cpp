@@ -0,0 +1,125 @@
+/*
+ * Copyright 2026 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#include "GOTestCachePacking.h"
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include <wx/file.h>
+#include <wx/filename.h>
+#include <wx/wfstream.h>
+
+#include "loader/cache/GOCache.h"
+#include "loader/cache/GOCacheWriter.h"
+
+#include "GOMemoryPool.h"
+
+static constexpr unsigned BLOCK_LENGTH = 65536;
+
+GOTestCachePacking::~GOTestCachePacking() {}
+
+std::string GOTestCachePacking::GetName() { return name; }
+
+void GOTestCachePacking::TestRoundTrip(bool isCompressed) {
+  const std::string mode = isCompressed ? " (compressed)" : "";
+  const wxString path = wxFileName::CreateTempFileName(wxT("GOTestCache"));
+  std::mt19937 rng(1);
+  // a block that is packed well and a block that is not packed at all
+  std::vector<unsigned char> smooth(BLOCK_LENGTH);
+  std::vector<unsigned char> noise(BLOCK_LENGTH);
+  const int marker = 0x12345678;
+
+  for (unsigned i = 0; i < BLOCK_LENGTH; i++) {
+    smooth[i] = (unsigned char)(i / 256);
+    noise[i] = (unsigned char)rng();
+  }
+
+  uint64_t fileLength;
+
+  {
+    wxFileOutputStream file(path);
+    GOCacheWriter writer(file, isCompressed);
+
+    GOAssert(writer.WriteHeader(), "Unable to write the cache header" + mode);
+    GOAssert(
+      writer.WriteBlock(smooth.data(), BLOCK_LENGTH)
+        && writer.WriteBlock(noise.data(), BLOCK_LENGTH)
+        && writer.WriteBlock(smooth.data(), BLOCK_LENGTH, false)
+        && writer.Write(&marker, sizeof(marker)),
+      "Unable to write the cache blocks" + mode);
+    fileLength = writer.GetPos();
+    writer.Close();
+  }
+  if (isCompressed)
+    GOAssert(
+      fileLength < 3 * BLOCK_LENGTH,
+      "The compressed cache is not shorter than the data");
+
+  GOMemoryPool pool;
+  std::vector<unsigned char> buffer(BLOCK_LENGTH);
+  uint64_t filePos = 0;
+
+  {
+    wxFile file(path);
+    GOCache reader(file, pool, false);
+
+    GOAssert(reader.ReadHeader(), "Wrong cache header" + mode);
+    // a packed block can only be unpacked
+    GOAssert(
+      reader.SkipRawBlock(BLOCK_LENGTH, filePos) != isCompressed,
+      "Wrong skipping of the packed block" + mode);
+    if (!isCompressed)
+      reader.Seek(0);
+    GOAssert(
+      reader.ReadBlock(buffer.data(), BLOCK_LENGTH) && buffer == smooth,
+      "Wrong unpacking of the smooth block" + mode);
+
+    unsigned char *pData = (unsigned char *)reader.ReadBlock(BLOCK_LENGTH);
+
+    GOAssert(
+      pData && !memcmp(pData, noise.data(), BLOCK_LENGTH),
+      "Wrong reading of the noise block" + mode);
+    if (pData)
+      pool.Free(pData);
+    GOAssert(
+      reader.SkipRawBlock(BLOCK_LENGTH, filePos),
+      "Unable to skip the unpacked block" + mode);
+
+    int value = 0;
+
+    GOAssert(
+      reader.Read(&value, sizeof(value)) && value == marker,
+      "Wrong position after the skipped block" + mode);
+    uint64_t endPos;
+
+    GOAssert(
+      !reader.SkipRawBlock(BLOCK_LENGTH, endPos),
+      "A block is skipped beyond the end of the cache" + mode);
+    reader.Close();
+  }
+
+  // the unpacked block must be readable directly from the cache file
+  {
+    wxFile file(path);
+
+    GOAssert(
+      file.Seek(filePos) != wxInvalidOffset,
+      "Wrong position of the unpacked block" + mode);
+    buffer.assign(BLOCK_LENGTH, 0);
+    GOAssert(
+      file.Read(buffer.data(), BLOCK_LENGTH) == BLOCK_LENGTH
+        && buffer == smooth,
+      "Wrong data of the unpacked block in the file" + mode);
+  }
+  wxRemoveFile(path);
+}
+
+void GOTestCachePacking::run() {
+  TestRoundTrip(false);
+  TestRoundTrip(true);
+}
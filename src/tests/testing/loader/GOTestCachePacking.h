@@ -0,0 +1,25 @@
+/*
+ * Copyright 2026 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+#ifndef GOTESTCACHEPACKING_H
+#define GOTESTCACHEPACKING_H
+
+#include "GOTest.h"
+
+class GOTestCachePacking : public GOTest {
+
+private:
+  std::string name = "GOTestCachePacking";
+
+  void TestRoundTrip(bool isCompressed);
+
+public:
+  GOTestCachePacking() { name = "GOTestCachePacking"; }
+  virtual ~GOTestCachePacking();
+  virtual void run();
+  std::string GetName();
+};
+
+#endif
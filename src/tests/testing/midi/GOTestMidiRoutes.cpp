@@ -0,0 +1,172 @@
+/*
+ * Copyright 2026 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#include "GOTestMidiRoutes.h"
+
+#include <vector>
+
+#include "midi/elements/GOMidiReceiver.h"
+#include "midi/events/GOMidiEvent.h"
+#include "midi/events/GOMidiRoute.h"
+
+static const GOMidiEvent::MidiType ROUTED_TYPES[] = {
+  GOMidiEvent::MIDI_NOTE,
+  GOMidiEvent::MIDI_AFTERTOUCH,
+  GOMidiEvent::MIDI_CTRL_CHANGE,
+};
+
+static void add_pattern(
+  GOMidiReceiver &receiver,
+  GOMidiReceiverMessageType type,
+  unsigned device,
+  int channel,
+  int key,
+  int lowValue = 0,
+  int highValue = 127,
+  int lowKey = 0,
+  int highKey = 0) {
+  GOMidiReceiverEventPattern &pattern
+    = receiver.GetEvent(receiver.AddNewEvent());
+
+  pattern.type = type;
+  pattern.deviceId = device;
+  pattern.channel = channel;
+  pattern.key = key;
+  pattern.low_value = lowValue;
+  pattern.high_value = highValue;
+  pattern.low_key = lowKey;
+  pattern.high_key = highKey;
+}
+
+static bool is_routed(
+  const std::vector<GOMidiRoute> &routes, const GOMidiEvent &e) {
+  for (const GOMidiRoute &route : routes)
+    if (
+      route.type == e.GetMidiType()
+      && (route.device == 0 || route.device == e.GetDevice())
+      && (route.channel == -1 || route.channel == e.GetChannel())
+      && (route.key == -1 || route.key == e.GetKey()))
+      return true;
+  return false;
+}
+
+GOTestMidiRoutes::~GOTestMidiRoutes() {}
+
+/*
+ * Every note, aftertouch and control change event the receiver matches must
+ * be covered by one of its routes, and the routes must leave out some events,
+ * otherwise the index is useless
+ */
+void GOTestMidiRoutes::CheckRoutes(
+  GOMidiReceiver &receiver, const std::string &caseStr) {
+  std::vector<GOMidiRoute> routes;
+
+  GOAssert(receiver.GetRoutes(routes), "No routes for " + caseStr);
+
+  unsigned nMatched = 0;
+  unsigned nSkipped = 0;
+  GOTime time = 0;
+
+  for (GOMidiEvent::MidiType type : ROUTED_TYPES)
+    for (unsigned device = 1; device <= 2; device++)
+      for (int channel = 1; channel <= 16; channel++)
+        for (int key = 0; key <= 127; key++)
+          for (int value : {0, 1, 64, 126, 127}) {
+            GOMidiEvent e;
+
+            e.SetMidiType(type);
+            e.SetDevice(device);
+            e.SetChannel(channel);
+            e.SetKey(key);
+            e.SetValue(value);
+            // the events are far enough apart for the debouncing
+            time += 1000;
+            e.SetTime(time);
+
+            const bool isRouted = is_routed(routes, e);
+
+            if (receiver.Match(e) != MIDI_MATCH_NONE) {
+              GOAssert(
+                isRouted,
+                "An unrouted event matches for " + caseStr + ": type "
+                  + std::to_string(type) + ", device "
+                  + std::to_string(device) + ", channel "
+                  + std::to_string(channel) + ", key " + std::to_string(key)
+                  + ", value " + std::to_string(value));
+              nMatched++;
+            }
+            if (!isRouted)
+              nSkipped++;
+          }
+  GOAssert(nMatched > 0, "No event matches for " + caseStr);
+  GOAssert(nSkipped > 0, "The routes cover all events for " + caseStr);
+}
+
+void GOTestMidiRoutes::TestManual() {
+  GOMidiReceiver receiver(MIDI_RECV_MANUAL);
+
+  add_pattern(receiver, MIDI_M_NOTE, 0, 1, 0, 1, 127, 36, 96);
+  add_pattern(receiver, MIDI_M_NOTE_SHORT_OCTAVE, 2, 3, 0, 1, 127, 24, 60);
+  // a transposing pattern for any channel
+  add_pattern(receiver, MIDI_M_NOTE_NO_VELOCITY, 1, -1, 12, 1, 127, 0, 20);
+  add_pattern(receiver, MIDI_M_NOTE_NORMAL, 0, 4, 0, 127, 1, 100, 140);
+  CheckRoutes(receiver, "a manual");
+}
+
+void GOTestMidiRoutes::TestEnclosure() {
+  GOMidiReceiver receiver(MIDI_RECV_ENCLOSURE);
+
+  add_pattern(receiver, MIDI_M_CTRL_CHANGE, 1, 3, 7);
+  add_pattern(receiver, MIDI_M_CTRL_CHANGE, 0, -1, 11, 127, 0);
+  // not a routed event type
+  add_pattern(receiver, MIDI_M_NRPN, 0, 3, 7);
+  CheckRoutes(receiver, "an enclosure");
+}
+
+void GOTestMidiRoutes::TestDrawstop() {
+  GOMidiReceiver receiver(MIDI_RECV_DRAWSTOP);
+
+  add_pattern(receiver, MIDI_M_NOTE, 0, 2, 40, 0, 1);
+  add_pattern(receiver, MIDI_M_NOTE_ON_OFF, 1, 5, 41);
+  add_pattern(receiver, MIDI_M_NOTE_FIXED_OFF, 0, 2, 42, 64, 127);
+  add_pattern(receiver, MIDI_M_CTRL_CHANGE_ON_OFF, 0, -1, 80);
+  add_pattern(receiver, MIDI_M_CTRL_CHANGE_FIXED, 2, 1, 81, 1, 126);
+  add_pattern(receiver, MIDI_M_CTRL_CHANGE_FIXED_ON, 0, 6, 82, 0, 64);
+  add_pattern(receiver, MIDI_M_CTRL_BIT, 0, 7, 20, 3);
+  add_pattern(receiver, MIDI_M_PGM_CHANGE, 0, 1, 5);
+  CheckRoutes(receiver, "a drawstop");
+}
+
+void GOTestMidiRoutes::TestSysexSetup() {
+  GOMidiReceiver receiver(MIDI_RECV_BUTTON);
+  std::vector<GOMidiRoute> routes;
+  GOMidiEvent setup;
+
+  add_pattern(receiver, MIDI_M_NOTE, 0, 1, 60);
+  receiver.SetElementID(5);
+  setup.SetMidiType(GOMidiEvent::MIDI_SYSEX_GO_SETUP);
+  setup.SetDevice(1);
+  setup.SetKey(5);
+  setup.SetChannel(2);
+  setup.SetValue(10);
+  receiver.Match(setup);
+  GOAssert(
+    !receiver.GetRoutes(routes),
+    "A receiver set up with sysex must receive all events");
+  receiver.PreparePlayback();
+  GOAssert(
+    receiver.GetRoutes(routes),
+    "The sysex setup must be forgotten in PreparePlayback");
+}
+
+void GOTestMidiRoutes::run() {
+  TestManual();
+  TestEnclosure();
+  TestDrawstop();
+  TestSysexSetup();
+}
+
+std::string GOTestMidiRoutes::GetName() { return name; }
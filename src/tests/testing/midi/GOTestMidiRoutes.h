@@ -0,0 +1,31 @@
+/*
+ * Copyright 2026 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+#ifndef GOTESTMIDIROUTES_H
+#define GOTESTMIDIROUTES_H
+
+#include "GOTest.h"
+
+class GOMidiReceiver;
+
+class GOTestMidiRoutes : public GOTest {
+
+private:
+  std::string name = "GOTestMidiRoutes";
+
+  void CheckRoutes(GOMidiReceiver &receiver, const std::string &caseStr);
+  void TestManual();
+  void TestEnclosure();
+  void TestDrawstop();
+  void TestSysexSetup();
+
+public:
+  GOTestMidiRoutes() { name = "GOTestMidiRoutes"; }
+  virtual ~GOTestMidiRoutes();
+  virtual void run();
+  std::string GetName();
+};
+
+#endif
@@ -0,0 +1,148 @@
+/*
+ * Copyright 2026 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#include "GOTestMemoryBudgetPlanner.h"
+
+#include "model/pipe-config/GOMemoryBudgetPlanner.h"
+
+#include "GOSampleStatistic.h"
+
+static constexpr size_t MB = 1024 * 1024;
+
+using Settings = GOMemoryBudgetPlanner::Settings;
+
+// all loops, attacks and releases are loaded
+static const Settings FULL_24 = {24, false, 2, true, true};
+static const Settings FULL_16 = {16, false, 1, true, true};
+
+static GOSampleStatistic make_stat(
+  size_t memorySize,
+  unsigned attacks,
+  unsigned releases,
+  size_t releaseSize,
+  size_t loopTailSize) {
+  GOSampleStatistic stat;
+
+  stat.SetMemorySize(memorySize);
+  stat.SetSections(attacks, releases, releaseSize);
+  stat.SetLoopTailSize(loopTailSize);
+  return stat;
+}
+
+static bool is_near(size_t size, double expected) {
+  return size > expected * 0.999 && size < expected * 1.001;
+}
+
+GOTestMemoryBudgetPlanner::~GOTestMemoryBudgetPlanner() {}
+
+std::string GOTestMemoryBudgetPlanner::GetName() { return name; }
+
+void GOTestMemoryBudgetPlanner::FillPlanner(GOMemoryBudgetPlanner &planner) {
+  // 0: a big rank and 1: a small rank with one attack and one release
+  planner.AddRank(nullptr, make_stat(100 * MB, 1, 1, 0, 0), FULL_24);
+  planner.AddRank(nullptr, make_stat(10 * MB, 1, 1, 0, 0), FULL_24);
+  // 2: a rank with 2 attacks, 4 releases and loop tails
+  planner.AddRank(
+    nullptr, make_stat(30 * MB, 2, 4, 20 * MB, 4 * MB), FULL_16);
+  // a rank without samples is skipped
+  planner.AddRank(nullptr, GOSampleStatistic(), FULL_16);
+}
+
+void GOTestMemoryBudgetPlanner::TestNoChanges() {
+  GOMemoryBudgetPlanner planner;
+
+  FillPlanner(planner);
+  GOAssert(planner.GetRankCount() == 3, "A rank without samples is planned");
+  GOAssert(
+    planner.GetCurrentSize() == 140 * MB, "Wrong current size of the ranks");
+  GOAssert(
+    planner.Plan(140 * MB, true) && planner.GetPlannedSize() == 140 * MB,
+    "The ranks fitting into the target are reduced");
+  for (unsigned i = 0; i < planner.GetRankCount(); i++)
+    GOAssert(
+      planner.GetPlannedSettings(i) == (i < 2 ? FULL_24 : FULL_16),
+      "The settings of a rank fitting into the target are changed");
+}
+
+void GOTestMemoryBudgetPlanner::TestCompression() {
+  GOMemoryBudgetPlanner planner;
+
+  FillPlanner(planner);
+  // compressing the biggest rank is enough
+  GOAssert(planner.Plan(110 * MB, true), "The target is not reached");
+  GOAssert(
+    planner.GetPlannedSettings(0) == Settings({24, true, 2, true, true}),
+    "The biggest rank is not compressed");
+  GOAssert(
+    is_near(planner.GetPlannedSize(0), 60.0 * MB),
+    "Wrong estimated size of the compressed rank");
+  GOAssert(
+    planner.GetPlannedSettings(1) == FULL_24
+      && planner.GetPlannedSettings(2) == FULL_16,
+    "More ranks are reduced than needed");
+  GOAssert(
+    planner.GetPlannedSize() <= 110 * MB
+      && planner.GetPlannedSize() == planner.GetPlannedSize(0) + 40 * MB,
+    "Wrong planned size");
+}
+
+void GOTestMemoryBudgetPlanner::TestBits() {
+  GOMemoryBudgetPlanner planner;
+
+  /* Without compression, 20 bits take as much memory as 24 bits, so the
+   * single releases of the rank 2 and then 16 bits of the rank 0 follow */
+  FillPlanner(planner);
+  GOAssert(planner.Plan(110 * MB, false), "The target is not reached");
+  GOAssert(
+    planner.GetPlannedSettings(2) == Settings({16, false, 1, true, false}),
+    "The single release is not chosen before 16 bits");
+  GOAssert(
+    planner.GetPlannedSettings(0) == Settings({16, false, 2, true, true}),
+    "The biggest rank is not reduced to 16 bits");
+  GOAssert(
+    planner.GetPlannedSettings(1) == FULL_24,
+    "The small rank is reduced although the target is reached");
+  GOAssert(
+    is_near(planner.GetPlannedSize(2), 15.0 * MB),
+    "Wrong estimated size of the single release");
+}
+
+void GOTestMemoryBudgetPlanner::TestUnreachable() {
+  GOMemoryBudgetPlanner planner;
+
+  FillPlanner(planner);
+  GOAssert(!planner.Plan(MB, true), "An unreachable target is reported met");
+  GOAssert(
+    planner.GetPlannedSettings(0) == Settings({12, true, 2, true, true})
+      && planner.GetPlannedSettings(1) == Settings({12, true, 2, true, true}),
+    "Not all reductions are applied to the ranks without sections");
+  GOAssert(
+    planner.GetPlannedSettings(2) == Settings({12, true, 0, false, false}),
+    "Not all reductions are applied to the rank with sections");
+
+  /* The rank 2 keeps one of 2 attacks without the loop tails and one of 4
+   * releases. 12 compressed bits take 0.9 of 2 bytes of 16 bits */
+  GOAssert(
+    is_near(planner.GetPlannedSize(2), (5 - 2 + 5) * MB * 0.45),
+    "Wrong estimated size of the fully reduced rank");
+  GOAssert(
+    planner.GetPlannedSize()
+      == planner.GetPlannedSize(0) + planner.GetPlannedSize(1)
+        + planner.GetPlannedSize(2),
+    "The planned size is not the sum of the ranks");
+
+  // a new plan starts from the current settings
+  GOAssert(
+    planner.Plan(140 * MB, true) && planner.GetPlannedSettings(2) == FULL_16,
+    "A new plan keeps the reductions of the previous one");
+}
+
+void GOTestMemoryBudgetPlanner::run() {
+  TestNoChanges();
+  TestCompression();
+  TestBits();
+  TestUnreachable();
+}
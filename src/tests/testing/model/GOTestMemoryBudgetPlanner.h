@@ -0,0 +1,31 @@
+/*
+ * Copyright 2026 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+#ifndef GOTESTMEMORYBUDGETPLANNER_H
+#define GOTESTMEMORYBUDGETPLANNER_H
+
+#include "GOTest.h"
+
+class GOMemoryBudgetPlanner;
+
+class GOTestMemoryBudgetPlanner : public GOTest {
+
+private:
+  std::string name = "GOTestMemoryBudgetPlanner";
+
+  void FillPlanner(GOMemoryBudgetPlanner &planner);
+  void TestNoChanges();
+  void TestCompression();
+  void TestBits();
+  void TestUnreachable();
+
+public:
+  GOTestMemoryBudgetPlanner() { name = "GOTestMemoryBudgetPlanner"; }
+  virtual ~GOTestMemoryBudgetPlanner();
+  virtual void run();
+  std::string GetName();
+};
+
+#endif
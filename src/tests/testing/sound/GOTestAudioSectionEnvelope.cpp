@@ -0,0 +1,118 @@
+/*
+ * Copyright 2026 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#include "GOTestAudioSectionEnvelope.h"
+
+#include <math.h>
+
+#include "GOMemoryPool.h"
+#include "GOWaveLoop.h"
+#include "sound/GOSoundAudioSection.h"
+
+// the same as GOSoundAudioSection::ENVELOPE_FRAMES
+static constexpr unsigned WINDOW_FRAMES = 4096;
+static constexpr unsigned N_WINDOWS = 4;
+static constexpr unsigned SAMPLE_RATE = 48000;
+
+/* Returns mono 16 bit samples with the peak amplitudes[i] in the window i */
+static std::vector<int16_t> make_samples(const std::vector<int> &amplitudes) {
+  std::vector<int16_t> samples(amplitudes.size() * WINDOW_FRAMES);
+
+  for (unsigned i = 0; i < samples.size(); i++) {
+    const int amplitude = amplitudes[i / WINDOW_FRAMES];
+
+    // a triangle wave, so the peak is reached once per 64 frames
+    samples[i] = (int16_t)(amplitude * (abs((int)(i % 64) - 32) - 16) / 16);
+  }
+  return samples;
+}
+
+GOTestAudioSectionEnvelope::~GOTestAudioSectionEnvelope() {}
+
+std::string GOTestAudioSectionEnvelope::GetName() { return name; }
+
+void GOTestAudioSectionEnvelope::CheckEnvelope(
+  const GOSoundAudioSection &section,
+  const std::vector<int> &expectedPeaks,
+  const std::string &what) {
+  // the envelope is kept in whole dB
+  const float maxRatio = powf(10.0f, 0.05f);
+
+  for (unsigned i = 0; i < expectedPeaks.size(); i++) {
+    const std::string window = what + " window " + std::to_string(i);
+    const float expected = expectedPeaks[i];
+
+    // at the beginning and at the end of the window
+    for (unsigned pos : {i * WINDOW_FRAMES, (i + 1) * WINDOW_FRAMES - 1}) {
+      const float amplitude = section.GetRemainingAmplitude(pos);
+
+      GOAssert(
+        amplitude >= expected, "The envelope is underestimated in " + window);
+      GOAssert(
+        expected ? amplitude < expected * maxRatio : amplitude < 1.0f,
+        "The envelope is overestimated in " + window);
+    }
+  }
+}
+
+void GOTestAudioSectionEnvelope::TestOneshot() {
+  GOMemoryPool pool;
+  GOSoundAudioSection section(pool);
+  // the third window is louder than the second one
+  const std::vector<int16_t> samples = make_samples({8000, 500, 2000, 0});
+
+  section.Setup(
+    nullptr,
+    nullptr,
+    samples.data(),
+    GOWave::SF_SIGNEDSHORT_16,
+    1,
+    SAMPLE_RATE,
+    samples.size(),
+    nullptr,
+    BOOL3_DEFAULT,
+    false,
+    0,
+    0);
+  GOAssert(section.IsOneshot(), "The section is not a oneshot");
+  // the peak from the window on to the end
+  CheckEnvelope(section, {8000, 2000, 2000, 0}, "the oneshot");
+  GOAssert(
+    section.GetRemainingAmplitude(N_WINDOWS * WINDOW_FRAMES * 2) < 1.0f,
+    "The envelope is not silent after the end");
+}
+
+void GOTestAudioSectionEnvelope::TestLooped() {
+  GOMemoryPool pool;
+  GOSoundAudioSection section(pool);
+  const std::vector<int16_t> samples = make_samples({8000, 300, 3000, 100});
+  // from the second window to the fourth one
+  const std::vector<GOWaveLoop> loops
+    = {{WINDOW_FRAMES + 100, 3 * WINDOW_FRAMES + 2000}};
+
+  section.Setup(
+    nullptr,
+    nullptr,
+    samples.data(),
+    GOWave::SF_SIGNEDSHORT_16,
+    1,
+    SAMPLE_RATE,
+    samples.size(),
+    &loops,
+    BOOL3_DEFAULT,
+    false,
+    0,
+    0);
+  GOAssert(!section.IsOneshot(), "The section is not looped");
+  /* The quiet end of the loop may be followed by its loud part, so all
+   * windows of the loop have the peak of the whole loop */
+  CheckEnvelope(section, {8000, 3000, 3000, 3000}, "the looped section");
+}
+
+void GOTestAudioSectionEnvelope::run() {
+  TestOneshot();
+  TestLooped();
+}
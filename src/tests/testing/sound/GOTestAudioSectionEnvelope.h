@@ -0,0 +1,36 @@
+/*
+ * Copyright 2026 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+#ifndef GOTESTAUDIOSECTIONENVELOPE_H
+#define GOTESTAUDIOSECTIONENVELOPE_H
+
+#include <vector>
+
+#include "GOTest.h"
+
+class GOSoundAudioSection;
+
+class GOTestAudioSectionEnvelope : public GOTest {
+
+private:
+  std::string name = "GOTestAudioSectionEnvelope";
+
+  /* Checks that the remaining amplitude of each window is not below the
+   * expected peak and is less than 1 dB above it */
+  void CheckEnvelope(
+    const GOSoundAudioSection &section,
+    const std::vector<int> &expectedPeaks,
+    const std::string &what);
+  void TestOneshot();
+  void TestLooped();
+
+public:
+  GOTestAudioSectionEnvelope() { name = "GOTestAudioSectionEnvelope"; }
+  virtual ~GOTestAudioSectionEnvelope();
+  virtual void run();
+  std::string GetName();
+};
+
+#endif
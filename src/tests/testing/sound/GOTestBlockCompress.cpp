@@ -0,0 +1,141 @@
+/*
+ * Copyright 2026 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#include "GOTestBlockCompress.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "sound/GOSoundBlockCompress.h"
+
+static constexpr unsigned BLOCK_FRAMES = GOSoundBlockCompress::BLOCK_FRAMES;
+
+GOTestBlockCompress::~GOTestBlockCompress() {}
+
+void GOTestBlockCompress::TestUnpack() {
+  std::mt19937 rng(1);
+
+  for (unsigned width = 0; width <= 32; width++) {
+    const uint32_t mask = width < 32 ? (1u << width) - 1 : ~0u;
+    std::vector<unsigned char> packed(
+      BLOCK_FRAMES * width / 8 + GOSoundBlockCompress::PADDING_SIZE, 0);
+    uint32_t values[BLOCK_FRAMES];
+    int32_t residuals[BLOCK_FRAMES];
+
+    for (unsigned i = 0; i < BLOCK_FRAMES; i++)
+      values[i] = rng() & mask;
+    // the extreme values must survive too
+    values[1] = mask;
+    values[BLOCK_FRAMES - 1] = mask;
+    for (unsigned i = 0; i < BLOCK_FRAMES; i++) {
+      const unsigned bitPos = i * width;
+      uint64_t bits = (uint64_t)values[i] << (bitPos % 8);
+
+      for (unsigned char *p = packed.data() + bitPos / 8; bits; bits >>= 8)
+        *(p++) |= (unsigned char)bits;
+    }
+
+    const std::string widthStr = std::to_string(width);
+
+    GOSoundBlockCompress::unpackResidualsScalar(
+      packed.data(), width, residuals);
+    for (unsigned i = 0; i < BLOCK_FRAMES; i++) {
+      const int32_t expected
+        = (int32_t)(values[i] >> 1) ^ -(int32_t)(values[i] & 1);
+
+      GOAssert(
+        residuals[i] == expected,
+        "Wrong scalar unpacking of the width " + widthStr);
+    }
+#ifdef GO_SOUND_RESAMPLE_SIMD
+    if (
+      width <= GOSoundBlockCompress::MAX_GATHER_WIDTH
+      && GOSoundResampleSimd::getInstructionSet()
+        == GOSoundResampleSimd::IS_AVX2) {
+      int32_t simdResiduals[BLOCK_FRAMES];
+
+      GOSoundBlockCompress::unpackResidualsAvx2(
+        packed.data(), width, simdResiduals);
+      for (unsigned i = 0; i < BLOCK_FRAMES; i++)
+        GOAssert(
+          simdResiduals[i] == residuals[i],
+          "Wrong AVX2 unpacking of the width " + widthStr);
+    }
+#endif
+  }
+}
+
+void GOTestBlockCompress::TestRoundTrip(unsigned nFrames, uint8_t nChannels) {
+  std::mt19937 rng(nFrames);
+  std::vector<int> samples(nFrames * nChannels);
+
+  /* The amplitude grows from silence up to 2^29, so the blocks have all bit
+   * widths of the residuals, and the last block is partial */
+  for (unsigned i = 0; i < nFrames; i++) {
+    const unsigned bits = i * 30 / nFrames;
+
+    for (uint8_t ch = 0; ch < nChannels; ch++)
+      samples[i * nChannels + ch] = bits
+        ? (int)(rng() & ((1u << bits) - 1)) - (1 << (bits - 1))
+        : 0;
+  }
+
+  std::vector<unsigned char> data(
+    nFrames * nChannels * sizeof(int) * 2 + 1024);
+  const unsigned size = GOSoundBlockCompress::encode(
+    nFrames,
+    nChannels,
+    [&](unsigned pos, uint8_t ch) { return samples[pos * nChannels + ch]; },
+    data.data(),
+    data.size());
+  const unsigned nBlocks = GOSoundBlockCompress::getBlockCount(data.data());
+  const std::string caseStr = std::to_string(nFrames) + " frames of "
+    + std::to_string(nChannels) + " channels";
+
+  GOAssert(size > 0, "Encoding failed for " + caseStr);
+  GOAssert(
+    nBlocks == (nFrames + BLOCK_FRAMES - 1) / BLOCK_FRAMES,
+    "Wrong block count for " + caseStr);
+
+  std::vector<int> frames(BLOCK_FRAMES * nChannels);
+
+  for (unsigned block = 0; block < nBlocks; block++) {
+    GOSoundBlockCompress::decodeBlock(
+      data.data(), block, nChannels, frames.data());
+    for (unsigned i = 0; i < BLOCK_FRAMES; i++) {
+      // the padding repeats the last frame
+      const unsigned pos = std::min(block * BLOCK_FRAMES + i, nFrames - 1);
+
+      for (uint8_t ch = 0; ch < nChannels; ch++)
+        GOAssert(
+          frames[i * nChannels + ch] == samples[pos * nChannels + ch],
+          "decodeBlock mismatch at " + std::to_string(pos) + " for "
+            + caseStr);
+    }
+  }
+
+  DecompressionCache cache;
+
+  InitDecompressionCache(cache);
+  for (unsigned pos = 0; pos < nFrames; pos++) {
+    GOSoundBlockCompress::decodeTo(cache, pos, data.data(), nChannels);
+    for (uint8_t ch = 0; ch < nChannels; ch++)
+      GOAssert(
+        cache.value[ch] == samples[pos * nChannels + ch],
+        "decodeTo mismatch at " + std::to_string(pos) + " for " + caseStr);
+  }
+}
+
+void GOTestBlockCompress::run() {
+  TestUnpack();
+  TestRoundTrip(BLOCK_FRAMES * 40 + 17, 1);
+  TestRoundTrip(BLOCK_FRAMES * 40 + 63, 2);
+  TestRoundTrip(BLOCK_FRAMES * 8, 2);
+  TestRoundTrip(5, 2);
+}
+
+std::string GOTestBlockCompress::GetName() { return name; }
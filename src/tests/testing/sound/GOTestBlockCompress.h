@@ -0,0 +1,26 @@
+/*
+ * Copyright 2026 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+#ifndef GOTESTBLOCKCOMPRESS_H
+#define GOTESTBLOCKCOMPRESS_H
+
+#include "GOTest.h"
+
+class GOTestBlockCompress : public GOTest {
+
+private:
+  std::string name = "GOTestBlockCompress";
+
+  void TestUnpack();
+  void TestRoundTrip(unsigned nFrames, uint8_t nChannels);
+
+public:
+  GOTestBlockCompress() { name = "GOTestBlockCompress"; }
+  virtual ~GOTestBlockCompress();
+  virtual void run();
+  std::string GetName();
+};
+
+#endif
@@ -0,0 +1,143 @@
+/*
+ * Copyright 2026 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#include "GOTestSoundStream.h"
+
+#include <vector>
+
+#include <wx/string.h>
+
+#include "GOMemoryPool.h"
+#include "GOWaveLoop.h"
+#include "sound/GOSoundAudioSection.h"
+#include "sound/GOSoundResample.h"
+#include "sound/GOSoundStream.h"
+
+static constexpr unsigned N_FRAMES = 8192;
+static constexpr unsigned SAMPLE_RATE = 48000;
+static constexpr unsigned PERIOD_FRAMES = 1024;
+
+static std::vector<int16_t> make_samples() {
+  std::vector<int16_t> samples(N_FRAMES);
+
+  // a triangle wave that is never silent for long
+  for (unsigned i = 0; i < N_FRAMES; i++)
+    samples[i] = (int16_t)(1000 * (abs((int)(i % 64) - 32) - 16) + 500);
+  return samples;
+}
+
+static void setup_section(
+  GOSoundAudioSection &section,
+  const std::vector<int16_t> &samples,
+  const std::vector<GOWaveLoop> *pLoops) {
+  section.Setup(
+    nullptr,
+    nullptr,
+    samples.data(),
+    GOWave::SF_SIGNEDSHORT_16,
+    1,
+    SAMPLE_RATE,
+    samples.size(),
+    pLoops,
+    BOOL3_DEFAULT,
+    false,
+    0,
+    0);
+}
+
+// plays the section at its own sample rate
+static void init_stream(
+  GOSoundStream &stream,
+  const GOSoundResample &resample,
+  const GOSoundAudioSection &section) {
+  stream.InitStream(
+    &resample,
+    &section,
+    GOSoundResample::GO_POLYPHASE_INTERPOLATION,
+    1.0f / SAMPLE_RATE);
+}
+
+/* Reads nPeriods periods from the stream. Returns the number of the periods
+ * read before the stream finished and whether any of them was not silent */
+static unsigned read_periods(
+  GOSoundStream &stream, unsigned nPeriods, bool &isSounding) {
+  std::vector<float> buffer(PERIOD_FRAMES * 2);
+  unsigned nRead = 0;
+
+  isSounding = false;
+  while (nRead < nPeriods && stream.ReadBlock(buffer.data(), PERIOD_FRAMES)) {
+    for (float value : buffer)
+      if (value != 0.0f)
+        isSounding = true;
+    nRead++;
+  }
+  return nRead;
+}
+
+GOTestSoundStream::~GOTestSoundStream() {}
+
+std::string GOTestSoundStream::GetName() { return name; }
+
+void GOTestSoundStream::TestOneshot() {
+  GOMemoryPool pool;
+  GOSoundAudioSection section(pool);
+  GOSoundResample resample;
+  GOSoundStream stream;
+  const std::vector<int16_t> samples = make_samples();
+  bool isSounding;
+
+  setup_section(section, samples, nullptr);
+  init_stream(stream, resample, section);
+
+  const unsigned nRead = read_periods(stream, 100, isSounding);
+
+  GOAssert(isSounding, "The oneshot stream is silent");
+  // the last period ends just at the end of the section
+  GOAssert(
+    nRead == N_FRAMES / PERIOD_FRAMES,
+    "The oneshot stream has not finished at its end");
+}
+
+void GOTestSoundStream::TestZeroLengthLoop() {
+  GOMemoryPool pool;
+  GOSoundAudioSection section(pool);
+  GOSoundResample resample;
+  GOSoundStream stream;
+  const std::vector<int16_t> samples = make_samples();
+  // the first loop has no samples and is ignored
+  const std::vector<GOWaveLoop> loops = {{1000, 1000}, {2000, 6000}};
+  bool isSounding;
+
+  setup_section(section, samples, &loops);
+  GOAssert(!section.IsOneshot(), "The valid loop is lost");
+  init_stream(stream, resample, section);
+  // much longer than the section
+  GOAssert(
+    read_periods(stream, 100, isSounding) == 100,
+    "The looped stream has finished");
+  GOAssert(isSounding, "The looped stream is silent");
+}
+
+void GOTestSoundStream::TestOnlyZeroLengthLoop() {
+  GOMemoryPool pool;
+  GOSoundAudioSection section(pool);
+  const std::vector<int16_t> samples = make_samples();
+  const std::vector<GOWaveLoop> loops = {{1000, 1000}};
+  bool isThrown = false;
+
+  try {
+    setup_section(section, samples, &loops);
+  } catch (const wxString &) {
+    isThrown = true;
+  }
+  GOAssert(isThrown, "A section without valid loops is accepted");
+}
+
+void GOTestSoundStream::run() {
+  TestOneshot();
+  TestZeroLengthLoop();
+  TestOnlyZeroLengthLoop();
+}
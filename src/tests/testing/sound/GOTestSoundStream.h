@@ -0,0 +1,27 @@
+/*
+ * Copyright 2026 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+#ifndef GOTESTSOUNDSTREAM_H
+#define GOTESTSOUNDSTREAM_H
+
+#include "GOTest.h"
+
+class GOTestSoundStream : public GOTest {
+
+private:
+  std::string name = "GOTestSoundStream";
+
+  void TestOneshot();
+  void TestZeroLengthLoop();
+  void TestOnlyZeroLengthLoop();
+
+public:
+  GOTestSoundStream() { name = "GOTestSoundStream"; }
+  virtual ~GOTestSoundStream();
+  virtual void run();
+  std::string GetName();
+};
+
+#endif
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2026 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#include "GOTestSoundTremulantGain.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "GOMemoryPool.h"
+#include "sound/GOSoundAudioSection.h"
+#include "sound/GOSoundProviderSynthedTrem.h"
+#include "sound/GOSoundResample.h"
+#include "sound/GOSoundStream.h"
+
+// the sample rate of the synthesized tremulants
+static constexpr unsigned SAMPLE_RATE = 44100;
+static constexpr unsigned PERIOD_FRAMES = 1024;
+// the tremulant period in ms and its start and stop rates
+static constexpr int TREM_PERIOD = 160;
+static constexpr int TREM_RATE = 20;
+// the velocity the engine starts the tremulant voices with
+static constexpr unsigned TREM_VELOCITY = 0x7f;
+
+GOTestSoundTremulantGain::~GOTestSoundTremulantGain() {}
+
+std::string GOTestSoundTremulantGain::GetName() { return name; }
+
+void GOTestSoundTremulantGain::TestDepth(int ampModDepth) {
+  GOMemoryPool pool;
+  GOSoundProviderSynthedTrem trem;
+  GOSoundResample resample;
+  GOSoundStream stream;
+
+  trem.Create(pool, TREM_PERIOD, TREM_RATE, TREM_RATE, ampModDepth);
+
+  const GOSoundAudioSection *pAttack = trem.GetAttack(TREM_VELOCITY, 0);
+
+  GOAssert(pAttack, "The tremulant has no attack");
+  stream.InitStream(
+    &resample,
+    pAttack,
+    GOSoundResample::GO_POLYPHASE_INTERPOLATION,
+    1.0f / SAMPLE_RATE);
+
+  // the tremulant voice adds its samples to 1 like GOSoundTremulantTask
+  const float gain = trem.GetGain() * pAttack->GetNormGain()
+    * trem.GetVelocityVolume(TREM_VELOCITY);
+  std::vector<float> buffer(PERIOD_FRAMES * 2);
+  float maxEnvelope = 1.0f;
+
+  // the start and several tremulant periods
+  for (unsigned i = 0; i < SAMPLE_RATE / PERIOD_FRAMES; i++) {
+    GOAssert(
+      stream.ReadBlock(buffer.data(), PERIOD_FRAMES),
+      "The tremulant has stopped");
+    for (unsigned j = 0; j < PERIOD_FRAMES; j++)
+      maxEnvelope = std::max(maxEnvelope, 1.0f + buffer[2 * j + 1] * gain);
+  }
+
+  const float maxGain = trem.GetMaxGain();
+
+  // the voices get louder than without the tremulant, so IsInaudible() needs
+  // the bound not to retire an audible release
+  GOAssert(
+    maxEnvelope > 1.0f + ampModDepth / 200.0f,
+    "The tremulant does not raise the volume");
+  GOAssert(maxEnvelope <= maxGain, "The tremulant exceeds its highest gain");
+  GOAssert(
+    maxGain - maxEnvelope < 0.01f, "The highest tremulant gain is too loose");
+}
+
+void GOTestSoundTremulantGain::run() {
+  TestDepth(1);
+  TestDepth(25);
+  TestDepth(100);
+}
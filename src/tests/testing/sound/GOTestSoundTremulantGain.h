@@ -0,0 +1,25 @@
+/*
+ * Copyright 2026 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+#ifndef GOTESTSOUNDTREMULANTGAIN_H
+#define GOTESTSOUNDTREMULANTGAIN_H
+
+#include "GOTest.h"
+
+class GOTestSoundTremulantGain : public GOTest {
+
+private:
+  std::string name = "GOTestSoundTremulantGain";
+
+  void TestDepth(int ampModDepth);
+
+public:
+  GOTestSoundTremulantGain() { name = "GOTestSoundTremulantGain"; }
+  virtual ~GOTestSoundTremulantGain();
+  virtual void run();
+  std::string GetName();
+};
+
+#endif
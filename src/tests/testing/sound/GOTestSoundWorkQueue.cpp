@@ -0,0 +1,104 @@
+/*
+ * Copyright 2026 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#include "GOTestSoundWorkQueue.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "sound/scheduler/GOSoundWorkQueue.h"
+
+static constexpr unsigned N_THIEVES = 3;
+static constexpr unsigned N_ITEMS = 200000;
+static constexpr unsigned CAPACITY = 64;
+
+GOTestSoundWorkQueue::~GOTestSoundWorkQueue() {}
+
+std::string GOTestSoundWorkQueue::GetName() { return name; }
+
+void GOTestSoundWorkQueue::TestOrder() {
+  GOSoundWorkQueue queue;
+  uint64_t item = 0;
+  bool isFull = false;
+
+  queue.SetCapacity(5);
+  // the capacity is rounded up to a power of 2
+  for (uint64_t i = 1; i <= 8; i++)
+    GOAssert(queue.Push(i), "Cannot push the item " + std::to_string(i));
+  GOAssert(!queue.Push(9), "The item is pushed to the full queue");
+  GOAssert(queue.Pop(item) && item == 8, "The owner does not get the last");
+  GOAssert(queue.Steal(item) && item == 1, "A thief does not get the first");
+  queue.Clear();
+  GOAssert(!queue.Pop(item), "The cleared queue is not empty for the owner");
+  GOAssert(!queue.Steal(item), "The cleared queue is not empty for a thief");
+  // the positions wrap around the buffer
+  for (uint64_t i = 0; i < 20; i++) {
+    isFull = isFull || !queue.Push(i);
+    isFull = isFull || !queue.Push(i + 100);
+    GOAssert(
+      queue.Steal(item) && item == i,
+      "The wrapped item is not stolen in order");
+    GOAssert(
+      queue.Pop(item) && item == i + 100,
+      "The wrapped item is not popped in order");
+  }
+  GOAssert(!isFull, "The queue becomes full when it wraps around");
+}
+
+void GOTestSoundWorkQueue::TestConcurrentSteal() {
+  GOSoundWorkQueue queue;
+  std::unique_ptr<std::atomic_uint[]> takeCounts(
+    new std::atomic_uint[N_ITEMS]);
+  std::atomic_bool isPushing(true);
+  std::vector<std::thread> thieves;
+
+  for (unsigned i = 0; i < N_ITEMS; i++)
+    takeCounts[i].store(0);
+  queue.SetCapacity(CAPACITY);
+  for (unsigned i = 0; i < N_THIEVES; i++)
+    thieves.emplace_back([&]() {
+      uint64_t item;
+
+      while (true) {
+        const bool wasPushing = isPushing.load();
+
+        if (queue.Steal(item))
+          takeCounts[item].fetch_add(1);
+        else if (!wasPushing)
+          break;
+      }
+    });
+  for (unsigned i = 0; i < N_ITEMS; i++) {
+    uint64_t item;
+
+    // make room when the thieves are slower
+    while (!queue.Push(i))
+      if (queue.Pop(item))
+        takeCounts[item].fetch_add(1);
+    // the owner takes every third item and races with the thieves for the last
+    if (i % 3 == 2 && queue.Pop(item))
+      takeCounts[item].fetch_add(1);
+  }
+  isPushing.store(false);
+  for (std::thread &thief : thieves)
+    thief.join();
+
+  unsigned nWrong = 0;
+
+  for (unsigned i = 0; i < N_ITEMS; i++)
+    if (takeCounts[i].load() != 1)
+      nWrong++;
+  GOAssert(
+    !nWrong,
+    std::to_string(nWrong) + " items are not taken exactly once");
+}
+
+void GOTestSoundWorkQueue::run() {
+  TestOrder();
+  TestConcurrentSteal();
+}
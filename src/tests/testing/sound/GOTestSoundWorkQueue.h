@@ -0,0 +1,26 @@
+/*
+ * Copyright 2026 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+#ifndef GOTESTSOUNDWORKQUEUE_H
+#define GOTESTSOUNDWORKQUEUE_H
+
+#include "GOTest.h"
+
+class GOTestSoundWorkQueue : public GOTest {
+
+private:
+  std::string name = "GOTestSoundWorkQueue";
+
+  void TestOrder();
+  void TestConcurrentSteal();
+
+public:
+  GOTestSoundWorkQueue() { name = "GOTestSoundWorkQueue"; }
+  virtual ~GOTestSoundWorkQueue();
+  virtual void run();
+  std::string GetName();
+};
+
+#endif
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2026 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#include "GOTestUpsampler.h"
+
+#include <math.h>
+
+#include <algorithm>
+#include <complex>
+#include <vector>
+
+#include "sound/GOSoundUpsampler.h"
+
+static constexpr double SOURCE_RATE = 48000;
+// the analysis length: 10 Hz bins, so the tones below have whole periods
+static constexpr unsigned N_FRAMES = 4800;
+static constexpr double BIN_HZ = SOURCE_RATE / N_FRAMES;
+// the frames the filter needs for settling
+static constexpr unsigned N_WARMUP = GOSoundUpsampler::TAPS_PER_PHASE;
+static constexpr double AMPLITUDE = 0.5;
+static constexpr double PASSBAND_HZ = 20000;
+static constexpr double MAX_RIPPLE_DB = 0.001;
+static constexpr double MAX_IMAGE_DB = -120;
+
+/* Upsamples a sine of the frequency. Returns the target frames after the
+ * warmup */
+static std::vector<float> upsample_sine(unsigned factor, double frequency) {
+  GOSoundUpsampler upsampler(factor, 1);
+  std::vector<float> in(N_WARMUP + N_FRAMES);
+  std::vector<float> out(in.size() * factor);
+
+  for (unsigned i = 0; i < in.size(); i++)
+    in[i] = AMPLITUDE * sin(2 * M_PI * frequency * i / SOURCE_RATE);
+  upsampler.Process(in.data(), in.size(), out.data());
+  return std::vector<float>(out.begin() + N_WARMUP * factor, out.end());
+}
+
+/* Returns the level of the frequency in the target frames in dB relative to
+ * AMPLITUDE. The frequency must be a multiple of BIN_HZ, so there is no
+ * leakage from the other ones */
+static double level_db(
+  const std::vector<float> &frames, unsigned factor, double frequency) {
+  std::complex<double> sum = 0;
+
+  for (unsigned i = 0; i < frames.size(); i++)
+    sum += (double)frames[i]
+      * std::polar(1.0, -2 * M_PI * frequency * i / (SOURCE_RATE * factor));
+
+  const double amplitude = 2 * std::abs(sum) / frames.size();
+
+  return 20 * log10(std::max(amplitude / AMPLITUDE, 1e-20));
+}
+
+GOTestUpsampler::~GOTestUpsampler() {}
+
+std::string GOTestUpsampler::GetName() { return name; }
+
+void GOTestUpsampler::TestDc(unsigned factor) {
+  GOSoundUpsampler upsampler(factor, 2);
+  std::vector<float> in((N_WARMUP + 100) * 2, (float)AMPLITUDE);
+  std::vector<float> out(in.size() * factor);
+  float maxError = 0;
+
+  upsampler.Process(in.data(), in.size() / 2, out.data());
+  for (unsigned i = N_WARMUP * 2 * factor; i < out.size(); i++)
+    maxError = std::max(maxError, fabsf(out[i] - (float)AMPLITUDE));
+  // all phases have the same gain, so DC has no images
+  GOAssert(
+    maxError < 1e-6f,
+    "The DC level is not kept with the factor " + std::to_string(factor));
+}
+
+void GOTestUpsampler::TestSweep(unsigned factor) {
+  const std::string factorStr = std::to_string(factor);
+  const double targetNyquist = SOURCE_RATE * factor / 2;
+  double maxRipple = 0;
+  double maxImage = -300;
+
+  // a stepped sine sweep over the passband
+  for (double f = 20; f < PASSBAND_HZ * 1.25; f *= 1.25) {
+    const double frequency
+      = std::min(round(f / BIN_HZ) * BIN_HZ, PASSBAND_HZ);
+    const std::vector<float> frames = upsample_sine(factor, frequency);
+
+    maxRipple
+      = std::max(maxRipple, fabs(level_db(frames, factor, frequency)));
+    // the images are around each multiple of the source rate
+    for (unsigned m = 1; m < factor; m++)
+      for (double image :
+           {m * SOURCE_RATE - frequency, m * SOURCE_RATE + frequency})
+        if (image < targetNyquist)
+          maxImage = std::max(maxImage, level_db(frames, factor, image));
+  }
+  GOAssert(
+    maxRipple < MAX_RIPPLE_DB,
+    "The passband is not flat with the factor " + factorStr + ": "
+      + std::to_string(maxRipple) + " dB");
+  GOAssert(
+    maxImage < MAX_IMAGE_DB,
+    "The images are not suppressed with the factor " + factorStr + ": "
+      + std::to_string(maxImage) + " dB");
+}
+
+void GOTestUpsampler::run() {
+  for (unsigned factor : {2u, 4u}) {
+    TestDc(factor);
+    TestSweep(factor);
+  }
+}
@@ -0,0 +1,26 @@
+/*
+ * Copyright 2026 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+#ifndef GOTESTUPSAMPLER_H
+#define GOTESTUPSAMPLER_H
+
+#include "GOTest.h"
+
+class GOTestUpsampler : public GOTest {
+
+private:
+  std::string name = "GOTestUpsampler";
+
+  void TestDc(unsigned factor);
+  void TestSweep(unsigned factor);
+
+public:
+  GOTestUpsampler() { name = "GOTestUpsampler"; }
+  virtual ~GOTestUpsampler();
+  virtual void run();
+  std::string GetName();
+};
+
+#endif
@@ -0,0 +1,345 @@
+/*
+ * Copyright 2006 Milan Digital Audio LLC
+ * Copyright 2009-2025 GrandOrgue contributors (see AUTHORS)
+ * License GPL-2.0 or later
+ * (https://www.gnu.org/licenses/old-licenses/gpl-2.0.html).
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include <wx/app.h>
+#include <wx/cmdline.h>
+#include <wx/filename.h>
+#include <wx/image.h>
+#include <wx/intl.h>
+#include <wx/stopwatch.h>
+#include <wx/thread.h>
+
+#include "config/GOConfig.h"
+#include "midi/GOMidiMap.h"
+#include "midi/GOMidiPlayerContent.h"
+#include "midi/events/GOMidiEvent.h"
+#include "midi/files/GOMidiFileReader.h"
+#include "sound/GOSoundEngine.h"
+#include "sound/GOSoundRecorder.h"
+#include "sound/scheduler/GOSoundThread.h"
+
+#include "GOOrgan.h"
+#include "GOOrganController.h"
+#include "go_limits.h"
+
+/* A period with all samples below this level is treated as silence when the
+ * releases after the last midi event are rendered */
+static const float SILENCE_LEVEL = 1e-5f;
+
+class GOOfflineRenderApp : public wxApp {
+private:
+  static const wxCmdLineEntryDesc m_cmdLineDesc[];
+
+  wxString m_InstanceName;
+  wxString m_OdfPath;
+  wxString m_MidiPath;
+  wxString m_WavPath;
+  unsigned m_Threads;
+  unsigned m_MaxTailSeconds;
+
+  bool Render();
+
+public:
+  GOOfflineRenderApp();
+  bool OnInit();
+  int OnRun();
+  void OnInitCmdLine(wxCmdLineParser &parser);
+  bool OnCmdLineParsed(wxCmdLineParser &parser);
+};
+
+DECLARE_APP(GOOfflineRenderApp)
+IMPLEMENT_APP_CONSOLE(GOOfflineRenderApp)
+
+const wxCmdLineEntryDesc GOOfflineRenderApp::m_cmdLineDesc[] = {
+  {wxCMD_LINE_SWITCH,
+   wxTRANSLATE("h"),
+   wxTRANSLATE("help"),
+   wxTRANSLATE("displays help on the command line parameters"),
+   wxCMD_LINE_VAL_NONE,
+   wxCMD_LINE_OPTION_HELP},
+  {wxCMD_LINE_OPTION,
+   wxTRANSLATE("i"),
+   wxTRANSLATE("instance"),
+   wxTRANSLATE("use the settings of the specified GrandOrgue instance"),
+   wxCMD_LINE_VAL_STRING,
+   wxCMD_LINE_PARAM_OPTIONAL},
+  {wxCMD_LINE_OPTION,
+   wxTRANSLATE("t"),
+   wxTRANSLATE("threads"),
+   wxTRANSLATE("number of the sound threads (default: the number of CPUs)"),
+   wxCMD_LINE_VAL_NUMBER,
+   wxCMD_LINE_PARAM_OPTIONAL},
+  {wxCMD_LINE_OPTION,
+   wxTRANSLATE("r"),
+   wxTRANSLATE("release-tail"),
+   wxTRANSLATE(
+     "maximum seconds rendered after the last midi event (default: 10)"),
+   wxCMD_LINE_VAL_NUMBER,
+   wxCMD_LINE_PARAM_OPTIONAL},
+  {wxCMD_LINE_PARAM,
+   NULL,
+   NULL,
+   wxTRANSLATE("organ definition file"),
+   wxCMD_LINE_VAL_STRING,
+   wxCMD_LINE_OPTION_MANDATORY},
+  {wxCMD_LINE_PARAM,
+   NULL,
+   NULL,
+   wxTRANSLATE("midi file"),
+   wxCMD_LINE_VAL_STRING,
+   wxCMD_LINE_OPTION_MANDATORY},
+  {wxCMD_LINE_PARAM,
+   NULL,
+   NULL,
+   wxTRANSLATE("output wav file"),
+   wxCMD_LINE_VAL_STRING,
+   wxCMD_LINE_OPTION_MANDATORY},
+  {wxCMD_LINE_NONE}};
+
+GOOfflineRenderApp::GOOfflineRenderApp()
+  : m_InstanceName(),
+    m_OdfPath(),
+    m_MidiPath(),
+    m_WavPath(),
+    m_Threads(1),
+    m_MaxTailSeconds(10) {}
+
+void GOOfflineRenderApp::OnInitCmdLine(wxCmdLineParser &parser) {
+  parser.SetLogo(wxT("GrandOrgueOfflineRender"));
+  parser.SetDesc(m_cmdLineDesc);
+}
+
+bool GOOfflineRenderApp::OnCmdLineParsed(wxCmdLineParser &parser) {
+  wxString instance;
+  long value;
+
+  if (parser.Found(wxT("i"), &instance))
+    m_InstanceName = wxT("-") + instance;
+  m_Threads = wxThread::GetCPUCount() > 0 ? wxThread::GetCPUCount() : 1;
+  if (parser.Found(wxT("t"), &value)) {
+    if (value < 1 || value > MAX_CPU) {
+      wxLogError(wxT("Invalid number of threads: %ld"), value);
+      return false;
+    }
+    m_Threads = value;
+  }
+  if (parser.Found(wxT("r"), &value)) {
+    if (value < 0) {
+      wxLogError(wxT("Invalid release tail: %ld"), value);
+      return false;
+    }
+    m_MaxTailSeconds = value;
+  }
+
+  wxFileName odf(parser.GetParam(0));
+
+  odf.MakeAbsolute();
+  m_OdfPath = odf.GetFullPath();
+  m_MidiPath = parser.GetParam(1);
+  m_WavPath = parser.GetParam(2);
+  return true;
+}
+
+bool GOOfflineRenderApp::OnInit() {
+  wxLog *logger = new wxLogStream(&std::cout);
+  wxLog::SetActiveTarget(logger);
+  wxLog::SetLogLevel(wxLOG_Status);
+  wxImage::AddHandler(new wxJPEGHandler);
+  wxImage::AddHandler(new wxGIFHandler);
+  wxImage::AddHandler(new wxPNGHandler);
+  wxImage::AddHandler(new wxBMPHandler);
+  wxImage::AddHandler(new wxICOHandler);
+
+  return wxApp::OnInit();
+}
+
+bool GOOfflineRenderApp::Render() {
+  GOConfig settings(m_InstanceName);
+
+  settings.Load();
+  // the settings are not flushed, so this does not change the user settings
+  settings.Concurrency(m_Threads);
+  settings.LoadConcurrency(m_Threads);
+
+  GOOrganController *organController = new GOOrganController(settings, true);
+  wxStopWatch loadWatch;
+  const wxString loadError = organController->Load(
+    nullptr, GOOrgan(m_OdfPath), wxEmptyString, false);
+
+  if (!loadError.IsEmpty()) {
+    wxLogError(wxT("Failed to load %s: %s"), m_OdfPath, loadError);
+    delete organController;
+    return false;
+  }
+  wxLogMessage(wxT("Loaded %s in %ld ms"), m_OdfPath, (long)loadWatch.Time());
+
+  GOMidiMap &midiMap = settings.GetMidiMap();
+  GOMidiPlayerContent content;
+
+  {
+    GOMidiFileReader reader(midiMap);
+
+    if (
+      !reader.Open(m_MidiPath)
+      || !content.Load(
+        reader,
+        midiMap,
+        organController->GetODFManualCount() - 1,
+        organController->GetFirstManualIndex() == 0)
+      || !reader.Close()) {
+      wxLogError(wxT("Failed to load %s"), m_MidiPath);
+      delete organController;
+      return false;
+    }
+  }
+
+  const unsigned audioGroupCount = settings.GetAudioGroups().size();
+  const unsigned outputFrames = settings.SamplesPerBuffer();
+  GOSoundEngine *engine = new GOSoundEngine();
+  GOSoundRecorder recorder;
+  std::vector<GOAudioOutputConfiguration> engineConfig(1);
+
+  // one stereo output with all audio groups mixed
+  engineConfig[0].channels = 2;
+  engineConfig[0].scale_factors.resize(2);
+  for (unsigned i = 0; i < 2; i++) {
+    std::vector<float> &scaleFactors = engineConfig[0].scale_factors[i];
+
+    scaleFactors.resize(audioGroupCount * 2);
+    for (unsigned j = 0; j < audioGroupCount * 2; j++)
+      scaleFactors[j] = j % 2 == i ? 0 : -121;
+  }
+
+  engine->SetSamplesPerBuffer(outputFrames);
+  engine->SetSampleRate(settings.SampleRate());
+  if (!engine->SetRenderSampleRate(settings.RenderSampleRate()))
+    wxLogWarning(
+      wxT("The render sample rate %u is not compatible with the sample rate "
+          "%u and %u samples per buffer. The sample rate is used for "
+          "rendering"),
+      settings.RenderSampleRate(),
+      settings.SampleRate(),
+      outputFrames);
+  // the polyphony management depends on the timing of the sound threads
+  engine->SetPolyphonyLimiting(false);
+  engine->SetHardPolyphony(settings.PolyphonyLimit());
+  engine->SetScaledReleases(settings.ScaleRelease());
+  // the randomized tuning would make the output differ from run to run
+  engine->SetRandomizeSpeaking(false);
+  engine->SetSubmixBuses(settings.SubmixBuses());
+  engine->SetInaudibleLevel(settings.InaudibleLevel());
+  engine->SetDeterministic(true);
+  engine->SetInterpolationType(settings.m_InterpolationType());
+  engine->SetConcurrency(m_Threads);
+  engine->SetAudioGroupCount(audioGroupCount);
+  engine->SetVolume(organController->GetVolume());
+  recorder.SetBytesPerSample(settings.WaveFormatBytesPerSample());
+  // rendering must not lose periods to a slow disk
+  recorder.SetBlocking(true);
+  recorder.SetSampleRate(engine->GetOutputSampleRate());
+  engine->SetAudioOutput(engineConfig);
+  engine->SetupReverb(settings);
+  engine->SetAudioRecorder(&recorder, false);
+  engine->GetScheduler().SetWorkerCount(m_Threads);
+  engine->Setup(organController, settings.ReleaseConcurrency());
+  organController->PreparePlayback(engine, nullptr, &recorder);
+
+  std::vector<GOSoundThread *> threads;
+
+  for (unsigned i = 0; i < m_Threads; i++) {
+    threads.push_back(new GOSoundThread(&engine->GetScheduler(), i));
+    threads.back()->Run();
+  }
+
+  // complete the period started by Setup() before the recording
+  engine->FinishPeriod();
+  recorder.Open(m_WavPath);
+
+  bool isOk = recorder.IsOpen();
+
+  if (isOk) {
+    const unsigned renderRate = engine->GetSampleRate();
+    const unsigned renderFrames = engine->GetSamplesPerBuffer();
+    const unsigned deviceId
+      = midiMap.GetDeviceIdByLogicalName(_("GrandOrgue MIDI Player"));
+    std::vector<float> buffer(outputFrames * 2);
+    bool hasEvent = content.IsLoaded();
+    uint64_t periodStart = 0; // in frames at renderRate
+    uint64_t tailFrames = 0;
+    wxStopWatch renderWatch;
+
+    content.Reset();
+    while (true) {
+      const uint64_t periodEnd = periodStart + renderFrames;
+
+      // play the events of the period at their positions within it
+      while (hasEvent) {
+        GOMidiEvent e = content.GetCurrentEvent();
+        const uint64_t eventFrame
+          = (uint64_t)e.GetTime().GetValue() * renderRate / 1000;
+
+        if (eventFrame >= periodEnd)
+          break;
+        e.SetDevice(deviceId);
+        e.SetAllowedToReload(false);
+        engine->SetEventOffset(
+          eventFrame > periodStart ? eventFrame - periodStart : 0);
+        organController->ProcessMidi(e);
+        hasEvent = content.Next();
+      }
+      engine->SetEventOffset(0);
+
+      engine->StartPeriod();
+      for (GOSoundThread *thread : threads)
+        thread->Wakeup();
+      engine->GetAudioOutput(buffer.data(), outputFrames, 0, true);
+      engine->FinishPeriod();
+      periodStart = periodEnd;
+
+      if (!hasEvent) {
+        float peak = 0;
+
+        for (float sample : buffer)
+          peak = std::max(peak, fabsf(sample));
+        tailFrames += renderFrames;
+        if (
+          peak < SILENCE_LEVEL
+          || tailFrames >= (uint64_t)m_MaxTailSeconds * renderRate)
+          break;
+      }
+    }
+    recorder.Close();
+
+    const double renderSeconds = renderWatch.Time() / 1000.0;
+    const double audioSeconds = (double)periodStart / renderRate;
+
+    wxLogMessage(
+      wxT("Rendered %.1f s of audio in %.1f s with %u threads: %.1fx real "
+          "time"),
+      audioSeconds,
+      renderSeconds,
+      m_Threads,
+      renderSeconds > 0 ? audioSeconds / renderSeconds : 0.0);
+  }
+
+  for (GOSoundThread *thread : threads) {
+    thread->Delete();
+    delete thread;
+  }
+  organController->Abort();
+  engine->ClearSetup();
+  delete engine;
+  delete organController;
+  return isOk;
+}
+
+int GOOfflineRenderApp::OnRun() { return Render() ? 0 : 1; }